@@ -0,0 +1,76 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <recycle/shared_pool.hpp>
+
+#include <ecaludp/raw_memory.h>
+
+namespace
+{
+  // Same lock policy as the buffer pools of the library
+  struct buffer_pool_lock_policy_
+  {
+    using mutex_type = std::mutex;
+    using lock_type  = std::lock_guard<mutex_type>;
+  };
+
+  using buffer_pool = recycle::shared_pool<ecaludp::RawMemory, buffer_pool_lock_policy_>;
+
+  // Shared by all threads of a benchmark run
+  buffer_pool& shared_buffer_pool()
+  {
+    static buffer_pool pool;
+    return pool;
+  }
+}
+
+// Allocating a datagram buffer from a pool shared by all threads and giving it
+// back again, like the receive loops do for every datagram
+static void BM_BufferPoolAllocateRelease(benchmark::State& state)
+{
+  const auto size = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state)
+  {
+    auto buffer = shared_buffer_pool().allocate();
+    buffer->resize(size);
+    benchmark::DoNotOptimize(buffer->data());
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_BufferPoolAllocateRelease)->ArgName("size")->Arg(1500)->Arg(65536)->ThreadRange(1, 8)->UseRealTime();
+
+// Baseline without a pool: A new buffer for every datagram
+static void BM_BufferMakeShared(benchmark::State& state)
+{
+  const auto size = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state)
+  {
+    auto buffer = std::make_shared<ecaludp::RawMemory>(size);
+    benchmark::DoNotOptimize(buffer->data());
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_BufferMakeShared)->ArgName("size")->Arg(1500)->Arg(65536)->ThreadRange(1, 8)->UseRealTime();
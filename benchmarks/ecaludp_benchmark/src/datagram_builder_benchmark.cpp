@@ -0,0 +1,49 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <protocol/datagram_builder_v5.h>
+
+// Fragmentation of a single message. Only the headers are created, the
+// payload is referenced by the datagram list, so the cost should mostly
+// depend on the number of datagrams.
+static void BM_CreateDatagramList(benchmark::State& state)
+{
+  const auto message_size      = static_cast<size_t>(state.range(0));
+  const auto max_datagram_size = static_cast<size_t>(state.range(1));
+
+  const std::vector<char> message(message_size, 'a');
+
+  size_t datagram_count = 0;
+  for (auto _ : state)
+  {
+    auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, max_datagram_size, {'E', 'C', 'A', 'L'});
+    datagram_count = datagram_list.size();
+    benchmark::DoNotOptimize(datagram_list.data());
+  }
+
+  state.counters["datagrams"] = static_cast<double>(datagram_count);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(message_size));
+}
+BENCHMARK(BM_CreateDatagramList)
+  ->ArgNames({"message_size", "max_datagram_size"})
+  ->ArgsProduct({{64, 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024}, {508, 1448, 8972, 65507}});
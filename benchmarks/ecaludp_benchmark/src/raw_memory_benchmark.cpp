@@ -0,0 +1,80 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ecaludp/raw_memory.h>
+
+namespace
+{
+  constexpr size_t datagram_payload_size = 1448;
+}
+
+// Growing a new RawMemory datagram by datagram, like a message that is
+// appended to without knowing its final size
+static void BM_RawMemoryResize(benchmark::State& state)
+{
+  const auto size = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state)
+  {
+    ecaludp::RawMemory memory;
+    for (size_t current_size = datagram_payload_size; current_size < size; current_size += datagram_payload_size)
+      memory.resize(current_size);
+    memory.resize(size);
+    benchmark::DoNotOptimize(memory.data());
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_RawMemoryResize)->ArgName("size")->RangeMultiplier(16)->Range(1024, 16 * 1024 * 1024);
+
+// The same growth pattern, but with the final size reserved upfront
+static void BM_RawMemoryReserveResize(benchmark::State& state)
+{
+  const auto size = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state)
+  {
+    ecaludp::RawMemory memory;
+    memory.reserve(size);
+    for (size_t current_size = datagram_payload_size; current_size < size; current_size += datagram_payload_size)
+      memory.resize(current_size);
+    memory.resize(size);
+    benchmark::DoNotOptimize(memory.data());
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_RawMemoryReserveResize)->ArgName("size")->RangeMultiplier(16)->Range(1024, 16 * 1024 * 1024);
+
+// Resizing a RawMemory that is reused, i.e. already has enough capacity.
+// This is what happens to buffers that come back from a pool.
+static void BM_RawMemoryResizeReused(benchmark::State& state)
+{
+  const auto size = static_cast<size_t>(state.range(0));
+
+  ecaludp::RawMemory memory(size);
+  for (auto _ : state)
+  {
+    memory.resize(0);
+    memory.resize(size);
+    benchmark::DoNotOptimize(memory.data());
+  }
+}
+BENCHMARK(BM_RawMemoryResizeReused)->ArgName("size")->RangeMultiplier(16)->Range(1024, 16 * 1024 * 1024);
@@ -0,0 +1,118 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/error.h>
+#include <ecaludp/raw_memory.h>
+
+#include <protocol/datagram_builder_v5.h>
+#include <protocol/datagram_description.h>
+#include <protocol/reassembly_v5.h>
+
+namespace
+{
+  enum class FragmentOrder : int64_t
+  {
+    IN_ORDER = 0,
+    REVERSED = 1,
+    RANDOM   = 2,
+  };
+
+  std::shared_ptr<ecaludp::RawMemory> to_binary_buffer(const ecaludp::DatagramDescription& datagram_description)
+  {
+    auto buffer = std::make_shared<ecaludp::RawMemory>();
+    buffer->resize(datagram_description.size());
+
+    size_t current_pos = 0;
+    for (const auto& asio_buffer : datagram_description.asio_buffer_list_)
+    {
+      std::memcpy(buffer->data() + current_pos, asio_buffer.data(), asio_buffer.size());
+      current_pos += asio_buffer.size();
+    }
+
+    return buffer;
+  }
+}
+
+// Reassembly of a single message from datagrams that have been received in
+// the given order. The datagrams are created once and handed to the
+// reassembly in every iteration; the reassembly only reads from them.
+static void BM_ReassemblyHandleDatagram(benchmark::State& state)
+{
+  const auto message_size      = static_cast<size_t>(state.range(0));
+  const auto max_datagram_size = static_cast<size_t>(state.range(1));
+  const auto order             = static_cast<FragmentOrder>(state.range(2));
+
+  const std::vector<char> message(message_size, 'a');
+  const auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, max_datagram_size, {'E', 'C', 'A', 'L'});
+
+  std::vector<std::shared_ptr<ecaludp::RawMemory>> datagrams;
+  datagrams.reserve(datagram_list.size());
+  for (const auto& datagram : datagram_list)
+    datagrams.push_back(to_binary_buffer(datagram));
+
+  switch (order)
+  {
+  case FragmentOrder::REVERSED:
+    std::reverse(datagrams.begin(), datagrams.end());
+    state.SetLabel("reversed");
+    break;
+  case FragmentOrder::RANDOM:
+    std::shuffle(datagrams.begin(), datagrams.end(), std::mt19937(42));
+    state.SetLabel("random");
+    break;
+  default:
+    state.SetLabel("in order");
+    break;
+  }
+
+  auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>(asio::ip::make_address("127.0.0.1"), 1234);
+
+  ecaludp::v5::Reassembly reassembly;
+
+  for (auto _ : state)
+  {
+    std::shared_ptr<ecaludp::OwningBuffer> reassembled_message;
+    for (const auto& datagram : datagrams)
+    {
+      ecaludp::Error error = ecaludp::Error::OK;
+      reassembled_message = reassembly.handle_datagram(datagram, sender_endpoint, error);
+    }
+
+    if (!reassembled_message || (reassembled_message->size() != message_size))
+    {
+      state.SkipWithError("Message has not been reassembled");
+      break;
+    }
+    benchmark::DoNotOptimize(reassembled_message->data());
+  }
+
+  state.counters["datagrams"] = static_cast<double>(datagrams.size());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(message_size));
+}
+BENCHMARK(BM_ReassemblyHandleDatagram)
+  ->ArgNames({"message_size", "max_datagram_size", "order"})
+  ->ArgsProduct({{64, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024}, {1448, 65507}, {0, 1, 2}});
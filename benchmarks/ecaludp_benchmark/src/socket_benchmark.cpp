@@ -0,0 +1,69 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/socket.h>
+
+// Sends a message to a socket on the loopback interface and receives it again
+// with the same socket, i.e. the time includes fragmentation, both syscalls
+// per datagram and the reassembly. The messages are limited to 64 KiB, so
+// all fragments fit into the default receive buffer and none get lost.
+static void BM_SocketLoopbackRoundTrip(benchmark::State& state)
+{
+  const auto message_size = static_cast<size_t>(state.range(0));
+
+  asio::io_context io_context;
+  ecaludp::Socket  socket(io_context, {'E', 'C', 'A', 'L'});
+
+  socket.open(asio::ip::udp::v4());
+  socket.set_option(asio::socket_base::receive_buffer_size(4 * 1024 * 1024));
+  socket.set_option(asio::socket_base::send_buffer_size(4 * 1024 * 1024));
+  socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0));
+
+  const auto destination = socket.local_endpoint();
+
+  const std::vector<char> message(message_size, 'a');
+  asio::ip::udp::endpoint sender_endpoint;
+
+  for (auto _ : state)
+  {
+    asio::error_code ec;
+    socket.send_to({asio::buffer(message)}, destination, 0, ec);
+    if (ec)
+    {
+      state.SkipWithError(ec.message().c_str());
+      break;
+    }
+
+    auto received_message = socket.receive_from(sender_endpoint, 0, ec);
+    if (ec || !received_message || (received_message->size() != message_size))
+    {
+      state.SkipWithError("Message has not been received");
+      break;
+    }
+    benchmark::DoNotOptimize(received_message->data());
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(message_size));
+}
+BENCHMARK(BM_SocketLoopbackRoundTrip)->ArgName("message_size")->Arg(64)->Arg(1024)->Arg(16 * 1024)->Arg(64 * 1024)->UseRealTime();
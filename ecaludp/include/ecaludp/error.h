@@ -38,11 +38,18 @@ namespace ecaludp
       DUPLICATE_DATAGRAM,
       MALFORMED_DATAGRAM,
       MALFORMED_REASSEMBLED_MESSAGE,
+      REASSEMBLY_LIMIT_EXCEEDED,
 
       // NPCAP socket specific errors
       NPCAP_NOT_INITIALIZED,
       NOT_BOUND,
       SOCKET_CLOSED,
+
+      // Replay specific errors
+      END_OF_FILE,
+
+      // Simulation specific errors
+      NO_PENDING_DATAGRAMS,
     };
 
   //////////////////////////////////////////
@@ -79,12 +86,19 @@ namespace ecaludp
       case DUPLICATE_DATAGRAM:                    return "Duplicate datagram";                            break;
       case MALFORMED_DATAGRAM:                    return "Malformed datagram";                            break;
       case MALFORMED_REASSEMBLED_MESSAGE:         return "Malformed reassembled message";                 break;
+      case REASSEMBLY_LIMIT_EXCEEDED:             return "Reassembly limit exceeded";                     break;
 
       // NPCAP socket specific errors
       case NPCAP_NOT_INITIALIZED:                 return "Npcap not initialized";                         break;
       case NOT_BOUND:                             return "Socket not bound";                              break;
       case SOCKET_CLOSED:                         return "Socket closed";                                 break;
 
+      // Replay specific errors
+      case END_OF_FILE:                           return "End of file";                                   break;
+
+      // Simulation specific errors
+      case NO_PENDING_DATAGRAMS:                  return "No pending datagrams";                          break;
+
       default:                                    return "Unknown error";
       }
     }
@@ -99,6 +113,11 @@ namespace ecaludp
       return message_;
     }
 
+    inline ErrorCode GetErrorCode() const
+    {
+      return error_code_;
+    }
+
   //////////////////////////////////////////
   // Operators
   //////////////////////////////////////////
@@ -0,0 +1,39 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  /**
+   * @brief A fragmented message that has not been completed, yet
+   */
+  struct IncompleteMessage
+  {
+    asio::ip::udp::endpoint              sender_endpoint;
+    int32_t                              message_id          {0};
+    uint32_t                             received_fragments  {0};
+    uint32_t                             total_fragments     {0};    ///< 0, if the fragment info has not been received, yet
+    uint32_t                             total_size_bytes    {0};    ///< 0, if the fragment info has not been received, yet
+    std::size_t                          buffered_bytes      {0};    ///< Payload bytes of the received fragments
+    std::chrono::steady_clock::duration  age                 {0};    ///< Time since the last fragment has been received
+  };
+}
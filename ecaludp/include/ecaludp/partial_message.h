@@ -0,0 +1,54 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/owning_buffer.h>
+
+namespace ecaludp
+{
+  /**
+   * @brief Why a message has been delivered incompletely
+   */
+  enum class PartialMessageReason
+  {
+    EXPIRED,      ///< No fragment has been received for the max reassembly age
+    EVICTED,      ///< Dropped to stay within the buffered bytes limits
+    ABANDONED,    ///< Dropped by the abandonment heuristics
+  };
+
+  /**
+   * @brief A fragmented message that has been dropped before it was complete
+   *
+   * The payload has the full size of the message. The ranges of the fragments
+   * that have not been received are filled with zeros.
+   */
+  struct PartialMessage
+  {
+    std::shared_ptr<ecaludp::OwningBuffer> payload;
+    asio::ip::udp::endpoint                sender_endpoint;
+    int32_t                                message_id          {0};
+    PartialMessageReason                   reason              {PartialMessageReason::EXPIRED};
+    std::size_t                            fragment_size       {0};    ///< Payload bytes of all fragments but the last one, i.e. fragment i starts at i * fragment_size
+    std::vector<bool>                      received_fragments;         ///< One entry per fragment
+  };
+}
@@ -0,0 +1,69 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecaludp
+{
+  /**
+   * @brief Decides which incomplete message is dropped when the reassembly
+   *        exceeds one of its byte limits
+   */
+  enum class ReassemblyEvictionPolicy
+  {
+    LEAST_RECENTLY_USED,    ///< The message that has not received a fragment for the longest time
+    LARGEST_FIRST,          ///< The message that buffers the most bytes
+  };
+
+  /**
+   * @brief Limits for the memory held by incomplete messages
+   *
+   * All byte limits refer to the payload of the buffered fragments. 0 means
+   * unlimited, which is the default for all of them.
+   *
+   * The abandonment heuristics drop messages that will most likely never be
+   * completed, long before the max reassembly age has passed. They rely on
+   * senders sending the fragments of a message in order and one message
+   * after another, which is what ecaludp senders do, unless multiple threads
+   * send through the same socket at the same time. Both are disabled by
+   * default.
+   */
+  struct ReassemblyLimits
+  {
+    std::size_t                          max_buffered_bytes            {0};      ///< Of all incomplete messages together
+    std::size_t                          max_buffered_bytes_per_sender {0};      ///< Of the incomplete messages of one sender endpoint
+    std::size_t                          max_message_size              {0};      ///< Larger messages are dropped as soon as their size is known
+    ReassemblyEvictionPolicy             eviction_policy               {ReassemblyEvictionPolicy::LEAST_RECENTLY_USED};
+
+    bool                                 abandon_superseded_messages   {false};  ///< Drop the incomplete messages of a sender, when a message that it started sending afterwards has been completed
+    std::chrono::steady_clock::duration  max_fragment_gap_age          {0};      ///< Drop messages that miss a fragment before the last received one for longer than that. 0 = disabled
+  };
+
+  /**
+   * @brief Counts the incomplete messages that have been dropped because of the ReassemblyLimits
+   */
+  struct ReassemblyEvictionCounters
+  {
+    uint64_t evicted_messages  {0};       ///< Dropped to stay within max_buffered_bytes or max_buffered_bytes_per_sender
+    uint64_t evicted_bytes     {0};       ///< Buffered bytes of the evicted messages
+    uint64_t rejected_messages {0};       ///< Dropped because they exceeded the max_message_size
+    uint64_t abandoned_messages{0};       ///< Dropped by the abandonment heuristics
+    uint64_t abandoned_bytes   {0};       ///< Buffered bytes of the abandoned messages
+  };
+}
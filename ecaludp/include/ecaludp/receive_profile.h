@@ -0,0 +1,107 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecaludp
+{
+  /**
+   * @brief The stages of the receive path that are measured in profiling builds
+   */
+  enum class ReceiveStage : std::size_t
+  {
+    RECEIVE_SYSCALL,      ///< Receive calls that ecaludp issues itself (sync receive_from() and UDP GRO). Includes the time spent waiting for data.
+    HEADER_CHECK,         ///< Checking the size and magic bytes of each datagram
+    REASSEMBLY_LOOKUP,    ///< Finding or creating the incomplete message of a fragment
+    REASSEMBLY_COPY,      ///< Copying the fragments of a complete message into one buffer
+    POOL_ALLOCATE,        ///< Getting buffers from the pools, including growing them
+    POOL_RELEASE,         ///< Removing messages from the reassembly, which gives their datagram buffers back to the pool
+    USER_CALLBACK,        ///< Completion handlers of async_receive_from()
+  };
+
+  constexpr std::size_t receive_stage_count = 7;
+
+  inline const char* to_string(ReceiveStage stage)
+  {
+    switch (stage)
+    {
+    case ReceiveStage::RECEIVE_SYSCALL:   return "receive syscall";
+    case ReceiveStage::HEADER_CHECK:      return "header check";
+    case ReceiveStage::REASSEMBLY_LOOKUP: return "reassembly lookup";
+    case ReceiveStage::REASSEMBLY_COPY:   return "reassembly copy";
+    case ReceiveStage::POOL_ALLOCATE:     return "pool allocate";
+    case ReceiveStage::POOL_RELEASE:      return "pool release";
+    case ReceiveStage::USER_CALLBACK:     return "user callback";
+    }
+    return "unknown";
+  }
+
+  /**
+   * @brief Durations of one receive stage in ticks
+   *
+   * The durations are counted in power-of-two buckets: buckets[i] holds the
+   * number of durations in [2^i, 2^(i+1)) ticks, bucket 0 also holds the
+   * durations of 0 ticks.
+   */
+  struct StageHistogram
+  {
+    uint64_t                  count       {0};
+    uint64_t                  total_ticks {0};
+    uint64_t                  max_ticks   {0};
+    std::array<uint64_t, 64>  buckets     {};
+
+    double mean_ticks() const
+    {
+      return (count > 0 ? static_cast<double>(total_ticks) / static_cast<double>(count) : 0.0);
+    }
+
+    /**
+     * @brief Returns the upper bound of the bucket that contains the given percentile (0..100)
+     */
+    uint64_t ticks_at_percentile(double percentile) const
+    {
+      const auto target = static_cast<uint64_t>(static_cast<double>(count) * percentile / 100.0);
+
+      uint64_t accumulated = 0;
+      for (std::size_t i = 0; i < buckets.size(); ++i)
+      {
+        accumulated += buckets[i];
+        if ((accumulated > 0) && (accumulated >= target))
+          return (i < 63 ? (uint64_t(1) << (i + 1)) - 1 : max_ticks);
+      }
+      return max_ticks;
+    }
+  };
+
+  /**
+   * @brief Where a socket spends its time while receiving
+   *
+   * Only available, if ecaludp has been built with ECALUDP_ENABLE_PROFILING.
+   * On x86 the ticks are CPU cycles read with rdtsc, otherwise nanoseconds of
+   * the steady clock. ticks_per_second converts them to wall clock time.
+   */
+  struct ReceiveProfile
+  {
+    std::array<StageHistogram, receive_stage_count> stages;
+    bool                                            ticks_are_cpu_cycles {false};
+    double                                          ticks_per_second     {0.0};
+
+    const StageHistogram& operator[](ReceiveStage stage) const { return stages[static_cast<std::size_t>(stage)]; }
+  };
+}
@@ -18,8 +18,10 @@
 #include <array>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <asio.hpp> // IWYU pragma: keep
@@ -27,18 +29,19 @@
 // IWYU pragma: begin_exports
 #include <ecaludp/ecaludp_export.h>
 #include <ecaludp/error.h>
+#include <ecaludp/incomplete_message.h>
 #include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
 #include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+#include <ecaludp/receive_profile.h>
 // IWYU pragma: end_exports
 
 namespace ecaludp
 {
-  namespace v5
-  {
-    class Reassembly;
-  }
-
-  class recycle_shared_pool;
+  class ReceiveEngine;
+  class SendQueue;
+  class TokenBucket;
 
   class Socket
   {
@@ -81,7 +84,7 @@ namespace ecaludp
     void connect(const asio::ip::udp::endpoint& peer_endpoint)                                   { socket_.connect(peer_endpoint); }
     asio::error_code connect(const asio::ip::udp::endpoint& peer_endpoint, asio::error_code& ec) { socket_.connect(peer_endpoint, ec); return ec; }
 
-    const asio::any_io_executor& get_executor()                                                  { return socket_.get_executor(); }
+    asio::any_io_executor get_executor()                                                         { return socket_.get_executor(); }
 
     template<typename GettableSocketOption>
     void get_option(GettableSocketOption& option)                                                { socket_.get_option(option); }
@@ -142,6 +145,28 @@ namespace ecaludp
       return send_to(std::vector<asio::const_buffer>{buffer}, destination, flags, ec);
     }
 
+    /**
+     * @brief Sends the same message to multiple destinations
+     * 
+     * The message is only fragmented once. The resulting datagrams are then
+     * sent to every destination. On Linux, all datagrams for all destinations
+     * are handed to the kernel with as few sendmmsg() calls as possible.
+     * 
+     * @return The number of bytes sent to all destinations, including headers
+     */
+    ECALUDP_EXPORT std::size_t send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                      , const std::vector<asio::ip::udp::endpoint>& destinations
+                                      , asio::socket_base::message_flags flags
+                                      , asio::error_code& ec);
+
+    inline std::size_t send_to(const asio::const_buffer& buffer
+                              , const std::vector<asio::ip::udp::endpoint>& destinations
+                              , asio::socket_base::message_flags flags
+                              , asio::error_code& ec)
+    {
+      return send_to(std::vector<asio::const_buffer>{buffer}, destinations, flags, ec);
+    }
+
     ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
                                     , const asio::ip::udp::endpoint& destination
                                     , const std::function<void(asio::error_code)>& completion_handler);
@@ -153,12 +178,158 @@ namespace ecaludp
       async_send_to(std::vector<asio::const_buffer>{buffer}, destination, completion_handler);
     }
 
+    /**
+     * @brief Asynchronously sends the same message to multiple destinations
+     * 
+     * The message is only fragmented once. The completion handler is called
+     * once after the message has been sent to all destinations, or as soon as
+     * the first error occurred.
+     */
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const std::vector<asio::ip::udp::endpoint>& destinations
+                                    , const std::function<void(asio::error_code)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const std::vector<asio::ip::udp::endpoint>& destinations
+                            , const std::function<void(asio::error_code)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destinations, completion_handler);
+    }
+
+    /**
+     * @brief Asynchronously sends the message and reports what has been sent
+     * 
+     * Besides the error, the completion handler receives the number of bytes
+     * handed to the kernel (including the ecaludp headers) and the number of
+     * datagrams, both summed up over all destinations. If an error occurred,
+     * they cover everything that has been sent before.
+     */
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint& destination
+                                    , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const asio::ip::udp::endpoint& destination
+                            , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destination, completion_handler);
+    }
+
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const std::vector<asio::ip::udp::endpoint>& destinations
+                                    , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const std::vector<asio::ip::udp::endpoint>& destinations
+                            , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destinations, completion_handler);
+    }
+
     ECALUDP_EXPORT void set_max_udp_datagram_size(std::size_t max_udp_datagram_size);
     ECALUDP_EXPORT std::size_t get_max_udp_datagram_size() const;
 
+    /**
+     * @brief Limits the number of messages in the async send queue
+     * 
+     * All messages passed to async_send_to() are queued and sent in order. If
+     * the queue already contains the given amount of messages, async_send_to()
+     * fails with asio::error::no_buffer_space. 0 (the default) means unlimited.
+     */
+    ECALUDP_EXPORT void set_max_send_queue_size(std::size_t max_queued_messages);
+    ECALUDP_EXPORT std::size_t get_max_send_queue_size() const;
+
+    /**
+     * @brief Sets how many datagrams may be handed to the OS at once by the async send queue
+     * 
+     * The datagrams are sent as a non-blocking burst. Only if the socket
+     * would block, the send queue waits for the socket to become writable.
+     * Default is 64.
+     */
+    ECALUDP_EXPORT void set_max_datagrams_in_flight(std::size_t max_datagrams_in_flight);
+    ECALUDP_EXPORT std::size_t get_max_datagrams_in_flight() const;
+
+    /**
+     * @brief Sets a high water mark for the async send queue
+     * 
+     * The callback is called with true, when the amount of queued bytes
+     * (including headers) reaches the high water mark and with false, when it
+     * falls below it again. The callback may be called from any thread that
+     * calls async_send_to() or runs the io_context. 0 disables the callback.
+     */
+    ECALUDP_EXPORT void set_send_queue_high_water_mark(std::size_t high_water_mark_bytes, const std::function<void(bool)>& high_water_mark_callback);
+
+    ECALUDP_EXPORT std::size_t get_send_queue_bytes() const;
+    ECALUDP_EXPORT std::size_t get_send_queue_messages() const;
+
+    /**
+     * @brief Paces all outgoing datagrams with a token bucket
+     * 
+     * Large messages are then spread over time instead of being sent as one
+     * big burst of datagrams, which receivers with small socket buffers may
+     * not be able to handle. The pacing applies to send_to() (which blocks
+     * accordingly) and async_send_to() (which uses a timer on the io_context).
+     * 
+     * @param rate_bytes_per_second The sustained send rate including headers. 0 disables pacing (default).
+     * @param burst_bytes           The amount of bytes that may be sent back-to-back
+     */
+    ECALUDP_EXPORT void set_send_rate_limit(std::size_t rate_bytes_per_second, std::size_t burst_bytes);
+    ECALUDP_EXPORT std::size_t get_send_rate_limit() const;
+    ECALUDP_EXPORT std::size_t get_send_burst_size() const;
+
+    /**
+     * @brief Sends large messages with MSG_ZEROCOPY from async_send_to()
+     * 
+     * On Linux, messages (including headers) of at least the given size are
+     * then sent without copying the payload into the kernel. Instead, the
+     * kernel pins the pages of the user buffer. The completion handler is
+     * only called after the kernel has reported that it doesn't need the
+     * memory anymore, so the buffers must be kept alive until then (as with
+     * any asio async operation).
+     * 
+     * Zerocopy sending only pays off for large messages, as pinning the
+     * pages and handling the completion notifications are not free. A good
+     * starting point is 256 KiB. If the kernel does not support zerocopy
+     * sending, the payload is copied as usual. Has no effect on send_to()
+     * and on other platforms.
+     * 
+     * @param zerocopy_threshold_bytes The minimum message size. 0 disables zerocopy sending (default).
+     */
+    ECALUDP_EXPORT void set_zerocopy_threshold(std::size_t zerocopy_threshold_bytes);
+    ECALUDP_EXPORT std::size_t get_zerocopy_threshold() const;
+
+    /**
+     * @brief Enables UDP generic segmentation offload (GSO) for send_to()
+     * 
+     * On Linux, the fragments of a large message are then handed to the
+     * kernel in chunks of up to 64 fragments per message, which the kernel
+     * or the network device cuts into the actual datagrams. This saves many
+     * syscalls and a large amount of per-datagram work in the network stack.
+     * 
+     * If the kernel does not support GSO or rejects a message (e.g. because
+     * the max_udp_datagram_size exceeds the path MTU), the regular send path
+     * is used. Has no effect on other platforms or on async_send_to().
+     * Disabled by default.
+     */
+    ECALUDP_EXPORT void set_udp_gso_enabled(bool enabled);
+    ECALUDP_EXPORT bool is_udp_gso_enabled() const;
+
     ECALUDP_EXPORT void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
     ECALUDP_EXPORT std::chrono::steady_clock::duration get_max_reassembly_age() const;
 
+    /**
+     * @brief Limits the memory that incomplete messages may hold
+     * 
+     * A burst of large messages with lost fragments (or a single bogus
+     * fragment info) can otherwise make the reassembly buffer huge amounts
+     * of memory for the max reassembly age. When the buffered bytes exceed a
+     * limit, incomplete messages are evicted according to the eviction
+     * policy. Messages larger than the max message size are dropped as soon
+     * as their size is known. All limits are unlimited by default.
+     */
+    ECALUDP_EXPORT void set_reassembly_limits(const ecaludp::ReassemblyLimits& limits);
+    ECALUDP_EXPORT ecaludp::ReassemblyLimits get_reassembly_limits() const;
+
   /////////////////////////////////////////////////////////////////
   // Receiving
   /////////////////////////////////////////////////////////////////
@@ -170,24 +341,146 @@ namespace ecaludp
     ECALUDP_EXPORT void async_receive_from(asio::ip::udp::endpoint& sender_endpoint
                                   , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler);
 
+    /**
+     * @brief Enables UDP generic receive offload (GRO) for receiving
+     * 
+     * On Linux, the kernel then coalesces consecutive datagrams of the same
+     * size (e.g. the fragments of a big message) into one buffer, so a
+     * single receive call returns many datagrams at once. The datagrams are
+     * split again and handed to the reassembly without copying them.
+     * 
+     * Note that messages received that way are views into the coalesced
+     * buffer, so they keep the entire buffer alive.
+     * 
+     * GRO is enabled on the socket when the next receive operation starts,
+     * so this should be set before starting to receive. If the kernel does
+     * not support GRO, the regular receive path is used. Has no effect on
+     * other platforms. Disabled by default.
+     */
+    ECALUDP_EXPORT void set_udp_gro_enabled(bool enabled);
+    ECALUDP_EXPORT bool is_udp_gro_enabled() const;
+
+    /**
+     * @brief Returns all fragmented messages that have not been completed, yet
+     * 
+     * Shows what the reassembly currently holds, e.g. to find out why a
+     * receiver consumes a lot of memory. Can be called from any thread while
+     * receiving. Receiving only pauses while the state is copied, so polling
+     * it once per second is fine.
+     */
+    ECALUDP_EXPORT std::vector<ecaludp::IncompleteMessage> get_reassembly_snapshot() const;
+
+    /**
+     * @brief Returns how many incomplete messages have been dropped because of the reassembly limits
+     */
+    ECALUDP_EXPORT ecaludp::ReassemblyEvictionCounters get_reassembly_eviction_counters() const;
+
+    /**
+     * @brief Delivers messages that could not be completed to the given callback
+     * 
+     * For payloads that tolerate loss (e.g. video frames or point clouds),
+     * a message with a few missing fragments is better than no message at
+     * all. When an incomplete message expires, is evicted or is abandoned
+     * (see set_reassembly_limits()), it is handed to the callback with the
+     * missing fragments filled with zeros and a list of the received
+     * fragments. Messages whose fragment info has been lost cannot be
+     * delivered.
+     * 
+     * The callback is called by the thread that receives, i.e. from
+     * receive_from() or the thread running the io_context, before the
+     * message that is being received is returned. An empty function
+     * disables the partial delivery, which is the default.
+     */
+    ECALUDP_EXPORT void set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback);
+
   private:
     void receive_next_datagram_from(asio::ip::udp::endpoint& sender_endpoint
                                   , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler);
 
-    std::shared_ptr<ecaludp::OwningBuffer> handle_datagram(const std::shared_ptr<ecaludp::RawMemory>& buffer
-                                                          , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
-                                                          , ecaludp::Error& error);
+    void receive_next_datagram_with_udp_gro_from(asio::ip::udp::endpoint& sender_endpoint
+                                                , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler);
+
+    bool is_udp_gro_active();
+
+    std::shared_ptr<ecaludp::OwningBuffer> handle_pending_udp_gro_segments(asio::ip::udp::endpoint& sender_endpoint);
+
+#ifdef ECALUDP_PROFILING_ENABLED
+  /////////////////////////////////////////////////////////////////
+  // Profiling
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Returns how long the stages of the receive path took so far
+     * 
+     * Only available if ecaludp has been built with ECALUDP_ENABLE_PROFILING.
+     * Can be called from any thread while receiving, e.g. once per second.
+     */
+    ECALUDP_EXPORT ecaludp::ReceiveProfile get_receive_profile() const;
+
+    /**
+     * @brief Clears the receive profile. Samples recorded concurrently may get lost.
+     */
+    ECALUDP_EXPORT void reset_receive_profile();
+#endif // ECALUDP_PROFILING_ENABLED
+
+  /////////////////////////////////////////////////////////////////
+  // Recording
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Starts appending all received datagrams to a pcap file
+     * 
+     * Each datagram is recorded as it has been received, i.e. before the
+     * magic bytes are checked, together with the sender endpoint and the
+     * time of reception. The file can be analyzed with Wireshark or replayed
+     * with the replay of the ecaludp_perftool.
+     * 
+     * The datagrams are handed to a background thread that writes them to
+     * the file, so receiving never waits for the disk. If the disk can't
+     * keep up, datagrams are left out of the recording (see
+     * get_recording_dropped_datagrams()). Only IPv4 traffic is recorded.
+     * 
+     * Must not be called while a receive operation is in progress, just like
+     * stop_recording().
+     */
+    ECALUDP_EXPORT bool start_recording(const std::string& file_path, ecaludp::Error& error);
+    ECALUDP_EXPORT void stop_recording();
+    ECALUDP_EXPORT bool is_recording() const;
+
+    /**
+     * @brief Returns the number of datagrams that have been left out of the current recording
+     */
+    ECALUDP_EXPORT uint64_t get_recording_dropped_datagrams() const;
 
   /////////////////////////////////////////////////////////////////
   // Member Variables
   /////////////////////////////////////////////////////////////////
   private:
+    enum class OffloadSupport
+    {
+      UNKNOWN,
+      SUPPORTED,
+      UNSUPPORTED,
+    };
+
     asio::ip::udp::socket                     socket_;
-    std::unique_ptr<recycle_shared_pool>      datagram_buffer_pool_;
-    std::unique_ptr<ecaludp::v5::Reassembly>  reassembly_v5_;
+    std::unique_ptr<ecaludp::ReceiveEngine>   receive_engine_;
+    std::unique_ptr<ecaludp::TokenBucket>     send_rate_limiter_;
+    std::unique_ptr<ecaludp::SendQueue>       send_queue_;
 
     std::array<char, 4>                       magic_header_bytes_;
     std::size_t                               max_udp_datagram_size_;
-    std::chrono::steady_clock::duration       max_reassembly_age_;
+
+    bool                                      udp_gso_enabled_;
+    OffloadSupport                            udp_gso_support_;       ///< Whether the kernel supports GSO. Checked on first use.
+
+    bool                                      udp_gro_enabled_;
+    OffloadSupport                            udp_gro_support_;       ///< Whether GRO has been enabled on the socket. Checked on first use.
+
+    // A coalesced GRO buffer that may still contain unhandled datagrams
+    std::shared_ptr<ecaludp::RawMemory>       udp_gro_buffer_;
+    std::size_t                               udp_gro_buffer_offset_;
+    std::size_t                               udp_gro_segment_size_;
+    std::shared_ptr<asio::ip::udp::endpoint>  udp_gro_sender_endpoint_;
   };
 }
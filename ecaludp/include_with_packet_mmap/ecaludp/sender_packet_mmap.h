@@ -0,0 +1,154 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <asio.hpp>
+
+// IWYU pragma: begin_exports
+#include <ecaludp/ecaludp_export.h>
+// IWYU pragma: end_exports
+
+namespace ecaludp
+{
+  class PacketMmapTransmitter;
+
+  /**
+   * @brief A sender that writes complete Ethernet / IPv4 / UDP frames to a
+   *        memory mapped PACKET_TX_RING (Linux only)
+   *
+   * Messages are fragmented exactly like with the ecaludp::Socket. The
+   * fragments are written to the ring as frames and the kernel is told to
+   * send all pending frames with a single syscall. This makes it possible to
+   * generate a lot more traffic than with one sendto() per datagram, e.g.
+   * for stress-testing receivers.
+   *
+   * As the frames bypass the IP stack, there is no routing: all frames are
+   * sent on the interface that owns the bound address (e.g. the loopback
+   * interface or a veth interface). The destination MAC address of unicast
+   * traffic is taken from the ARP table of the kernel, so there must already
+   * be an entry for the destination. The UDP checksum is not set.
+   *
+   * Frames sent on the loopback interface to 127.0.0.0/8 are not delivered
+   * to regular sockets, as the kernel doesn't accept these addresses from
+   * incoming frames. Capturing receivers (e.g. ecaludp::SocketPacketMmap)
+   * receive them, though.
+   *
+   * Sending requires CAP_NET_RAW.
+   */
+  class SenderPacketMmap
+  {
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT SenderPacketMmap(std::array<char, 4> magic_header_bytes);
+
+    // Destructor
+    ECALUDP_EXPORT ~SenderPacketMmap();
+
+    // Disable copy constructor and assignment operator
+    SenderPacketMmap(const SenderPacketMmap&)             = delete;
+    SenderPacketMmap& operator=(const SenderPacketMmap&)  = delete;
+
+    // Disable move constructor and assignment operator
+    SenderPacketMmap(SenderPacketMmap&&)            = delete;
+    SenderPacketMmap& operator=(SenderPacketMmap&&) = delete;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Sets the maximum UDP payload size of each fragment. Must be called
+     *        before bind(), as the frames of the ring are sized accordingly.
+     */
+    ECALUDP_EXPORT bool set_max_udp_datagram_size(std::size_t max_udp_datagram_size);
+    ECALUDP_EXPORT std::size_t get_max_udp_datagram_size() const;
+
+    /**
+     * @brief Sets the size of the ring. Must be called before bind().
+     */
+    ECALUDP_EXPORT bool set_send_buffer_size(int size);
+
+  /////////////////////////////////////////////////////////////////
+  // API "Passthrough"
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT bool is_valid() const;
+    ECALUDP_EXPORT bool bind(const asio::ip::udp::endpoint& local_endpoint); // The address selects the interface. Address and port are used as source of all datagrams.
+    ECALUDP_EXPORT bool is_bound() const;
+    ECALUDP_EXPORT asio::ip::udp::endpoint local_endpoint() const;
+    ECALUDP_EXPORT void close();
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Writes the message to the ring and flushes the ring.
+     *
+     * @return The number of bytes of all datagrams (including the ecaludp headers)
+     */
+    ECALUDP_EXPORT std::size_t send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint&          destination
+                                    , asio::error_code&                       ec);
+
+    inline std::size_t send_to(const asio::const_buffer&      buffer
+                            , const asio::ip::udp::endpoint& destination
+                            , asio::error_code&              ec)
+    {
+      return send_to(std::vector<asio::const_buffer>{buffer}, destination, ec);
+    }
+
+    /**
+     * @brief Writes the message to the ring without flushing it.
+     *
+     * The frames are sent when the ring is full or flush() is called. This
+     * reduces the number of syscalls for small messages.
+     *
+     * @return The number of bytes of all datagrams (including the ecaludp headers)
+     */
+    ECALUDP_EXPORT std::size_t enqueue_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                       , const asio::ip::udp::endpoint&          destination
+                                       , asio::error_code&                       ec);
+
+    inline std::size_t enqueue_to(const asio::const_buffer&      buffer
+                               , const asio::ip::udp::endpoint& destination
+                               , asio::error_code&              ec)
+    {
+      return enqueue_to(std::vector<asio::const_buffer>{buffer}, destination, ec);
+    }
+
+    /**
+     * @brief Sends all frames that have been written to the ring
+     */
+    ECALUDP_EXPORT void flush(asio::error_code& ec);
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    std::unique_ptr<ecaludp::PacketMmapTransmitter> transmitter_;               ///< The ring implementation
+
+    std::array<char, 4>                       magic_header_bytes_;              ///< The magic bytes that each fragment starts with
+    std::size_t                               max_udp_datagram_size_;           ///< The maximum UDP payload size of each fragment
+  };
+}
@@ -0,0 +1,148 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include <asio.hpp>
+
+// IWYU pragma: begin_exports
+#include <ecaludp/ecaludp_export.h>
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+// IWYU pragma: end_exports
+
+namespace ecaludp
+{
+  class PacketMmapReceiver;
+  class ReceiveEngine;
+  struct CapturedDatagram;
+
+  /**
+   * @brief A receiver that captures UDP traffic from a memory mapped AF_PACKET ring (Linux only)
+   *
+   * This is the Linux counterpart of the SocketNpcap. Instead of receiving
+   * from a UDP socket, the datagrams are captured from a TPACKET_V3 ring
+   * that is shared with the kernel. A BPF filter only lets pass the traffic
+   * to the bound port (and address or joined multicast groups). Fragments
+   * are handed to the reassembly directly from the ring, i.e. without
+   * copying them. Non-fragmented messages are copied, as the user may keep
+   * them for an arbitrary time and the kernel cannot reuse ring memory that
+   * is still referenced.
+   *
+   * Multiple processes can capture the same traffic at the same time, e.g.
+   * multiple processes receiving the same multicast group on the same port.
+   *
+   * Limitations:
+   *   - Only IPv4 is supported.
+   *   - IP fragments are dropped. The maximum UDP datagram size of the sender
+   *     must therefore fit into the MTU (which is the default for ecaludp).
+   *   - Capturing requires CAP_NET_RAW.
+   *   - Incomplete messages in the reassembly reference the ring. If the
+   *     ring runs full because of that, the incomplete messages are dropped
+   *     (they could not be completed anyways, as the kernel drops all
+   *     packets while the ring is full).
+   */
+  class SocketPacketMmap
+  {
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT SocketPacketMmap(std::array<char, 4> magic_header_bytes);
+
+    // Destructor
+    ECALUDP_EXPORT ~SocketPacketMmap();
+
+    // Disable copy constructor and assignment operator
+    SocketPacketMmap(const SocketPacketMmap&)             = delete;
+    SocketPacketMmap& operator=(const SocketPacketMmap&)  = delete;
+
+    // Disable move constructor and assignment operator
+    SocketPacketMmap(SocketPacketMmap&&)            = delete;
+    SocketPacketMmap& operator=(SocketPacketMmap&&) = delete;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
+    ECALUDP_EXPORT std::chrono::steady_clock::duration get_max_reassembly_age() const;
+
+    /**
+     * See ecaludp::Socket::set_reassembly_limits()
+     */
+    ECALUDP_EXPORT void set_reassembly_limits(const ecaludp::ReassemblyLimits& limits);
+    ECALUDP_EXPORT ecaludp::ReassemblyLimits get_reassembly_limits() const;
+
+    /**
+     * @brief Returns how many incomplete messages have been dropped because of the reassembly limits
+     */
+    ECALUDP_EXPORT ecaludp::ReassemblyEvictionCounters get_reassembly_eviction_counters() const;
+
+    /**
+     * See ecaludp::Socket::set_partial_message_callback()
+     */
+    ECALUDP_EXPORT void set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback);
+
+  /////////////////////////////////////////////////////////////////
+  // API "Passthrough"
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT bool is_valid() const;
+    ECALUDP_EXPORT bool bind(const asio::ip::udp::endpoint& sender_endpoint);
+    ECALUDP_EXPORT bool is_bound() const;
+    ECALUDP_EXPORT asio::ip::udp::endpoint local_endpoint();
+    ECALUDP_EXPORT bool set_receive_buffer_size(int size); // Size of the ring. Must be set before binding.
+    ECALUDP_EXPORT bool join_multicast_group(const asio::ip::address_v4& group_address);
+    ECALUDP_EXPORT bool leave_multicast_group(const asio::ip::address_v4& group_address);
+    ECALUDP_EXPORT void set_multicast_loopback_enabled(bool enabled);
+    ECALUDP_EXPORT bool is_multicast_loopback_enabled() const;
+    ECALUDP_EXPORT void close();
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT std::shared_ptr<ecaludp::OwningBuffer> receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error);
+
+    ECALUDP_EXPORT void async_receive_from(asio::ip::udp::endpoint& sender_endpoint
+                                  , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler);
+
+  private:
+    void receive_next_datagram_from(asio::ip::udp::endpoint& sender_endpoint
+                                  , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler);
+
+    std::shared_ptr<ecaludp::OwningBuffer> handle_datagram(const ecaludp::CapturedDatagram& datagram
+                                                        , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                        , ecaludp::Error&                                 error);
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    std::unique_ptr<ecaludp::PacketMmapReceiver> receiver_;                     ///< The capture implementation
+
+    std::unique_ptr<ecaludp::ReceiveEngine>   receive_engine_;                  ///< Buffer pool and reassembly. Non-fragmented messages are copied out of the ring.
+  };
+}
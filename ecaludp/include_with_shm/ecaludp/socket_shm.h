@@ -0,0 +1,328 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+// IWYU pragma: begin_exports
+#include <ecaludp/ecaludp_export.h>
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/reassembly_limits.h>
+#include <ecaludp/socket.h>
+// IWYU pragma: end_exports
+
+namespace ecaludp
+{
+  /**
+   * @brief An ecaludp socket that sends to receivers on the same host via shared memory (Linux only)
+   *
+   * The socket offers the same API as the ecaludp::Socket and sends and
+   * receives regular ecaludp datagrams. In addition, a receiving socket offers
+   * a shared memory channel to other SocketShm instances on the same host:
+   *
+   * - When a SocketShm starts receiving, it listens on a Unix domain socket
+   *   whose (abstract) name is derived from the magic bytes and its local
+   *   endpoint.
+   *
+   * - When a SocketShm sends to a unicast address of this host, it connects
+   *   to that listener and hands over a memfd with a ring buffer and an
+   *   eventfd. All further messages to that destination are copied to the
+   *   ring as a whole, i.e. without fragmentation, and the receiver is woken
+   *   up via the eventfd. If there is no listener, the message is sent via
+   *   UDP and the connection is retried after one second at the earliest.
+   *
+   * - The receiver hands out OwningBuffers that point directly into the
+   *   shared memory. The space is given back to the sender, when the buffer
+   *   is released, so keeping buffers for a long time blocks the ring.
+   *
+   * Just like UDP, the shared memory channel is lossy: If the ring of a
+   * destination is full, the message is dropped instead of waiting for the
+   * receiver. Messages that don't fit into the ring at all are sent via UDP.
+   * Multicast destinations always use UDP. There is no ordering between
+   * messages that took different paths.
+   *
+   * Only one SocketShm can offer a channel for the same local endpoint. All
+   * other receivers sharing that port (e.g. via reuse_address) only receive
+   * via UDP.
+   *
+   * Trust model: The listener is reachable by all processes on this host
+   * (in the same network namespace). The receiver only accepts channels
+   * from processes of the same user or root, but it does not verify the
+   * sender endpoint announced by them. A process of the same user can
+   * therefore impersonate any sender, which a local UDP sender can do just
+   * as well. The contents of the ring are never trusted: A corrupted ring
+   * is detected and closes the channel, it cannot make the receiver read
+   * outside of the shared memory. The payload of a received message still
+   * resides in the shared memory though, so a misbehaving sender can modify
+   * it while it is being used.
+   */
+  class SocketShm
+  {
+  /////////////////////////////////////////////////////////////////
+  // Private types
+  /////////////////////////////////////////////////////////////////
+  private:
+    struct SendChannel;
+    struct ReceiveChannel;
+
+    using ChannelAcceptor = asio::basic_socket_acceptor<asio::generic::seq_packet_protocol>;
+
+    using ReceiveHandler = std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>;
+
+    struct ReceiveRequest
+    {
+      asio::ip::udp::endpoint* sender_endpoint_;
+      ReceiveHandler           completion_handler_;
+    };
+
+    struct ReceivedMessage
+    {
+      std::shared_ptr<ecaludp::OwningBuffer> message_;
+      asio::ip::udp::endpoint                sender_endpoint_;
+    };
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT SocketShm(asio::io_context& io_context, std::array<char, 4> magic_header_bytes);
+
+    // Destructor
+    ECALUDP_EXPORT ~SocketShm();
+
+    // Disable copy constructor and assignment operator
+    SocketShm(const SocketShm&)             = delete;
+    SocketShm& operator=(const SocketShm&)  = delete;
+
+    // Disable move constructor and assignment operator
+    SocketShm(SocketShm&&)            = delete;
+    SocketShm& operator=(SocketShm&&) = delete;
+
+  /////////////////////////////////////////////////////////////////
+  // API Passthrough
+  /////////////////////////////////////////////////////////////////
+  public:
+    void bind(const asio::ip::udp::endpoint& endpoint)                                           { socket_.bind(endpoint); }
+    asio::error_code bind(const asio::ip::udp::endpoint& endpoint, asio::error_code& ec)         { socket_.bind(endpoint, ec); return ec; }
+
+    /**
+     * @brief Cancels all operations, closes all shared memory channels and closes the socket
+     *
+     * The completion handlers of all pending receive operations are called
+     * with asio::error::operation_aborted.
+     */
+    ECALUDP_EXPORT void close();
+
+    asio::any_io_executor get_executor()                                                         { return socket_.get_executor(); }
+
+    template<typename GettableSocketOption>
+    void get_option(GettableSocketOption& option)                                                { socket_.get_option(option); }
+
+    template<typename GettableSocketOption>
+    asio::error_code get_option(GettableSocketOption& option, asio::error_code& ec)              { return socket_.get_option(option, ec); }
+
+    bool is_open() const                                                                         { return socket_.is_open(); }
+
+    asio::ip::udp::endpoint local_endpoint()                     const                           { return socket_.local_endpoint(); }
+    asio::ip::udp::endpoint local_endpoint(asio::error_code& ec) const                           { return socket_.local_endpoint(ec); }
+
+    asio::ip::udp::socket::native_handle_type native_handle()                                    { return socket_.native_handle(); }
+
+    void open(const asio::ip::udp& protocol)                                                     { socket_.open(protocol); }
+    asio::error_code open(const asio::ip::udp& protocol, asio::error_code& ec)                   { socket_.open(protocol, ec); return ec;}
+
+    template<typename SettableSocketOption>
+    void set_option(const SettableSocketOption& option)                                          { socket_.set_option(option); }
+
+    template<typename SettableSocketOption>
+    asio::error_code set_option(const SettableSocketOption& option, asio::error_code& ec)        { socket_.set_option(option, ec); return ec;}
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    void set_max_udp_datagram_size(std::size_t max_udp_datagram_size)                            { socket_.set_max_udp_datagram_size(max_udp_datagram_size); }
+    std::size_t get_max_udp_datagram_size() const                                                { return socket_.get_max_udp_datagram_size(); }
+
+    void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)          { socket_.set_max_reassembly_age(max_reassembly_age); }
+    std::chrono::steady_clock::duration get_max_reassembly_age() const                           { return socket_.get_max_reassembly_age(); }
+
+    void set_reassembly_limits(const ecaludp::ReassemblyLimits& limits)                          { socket_.set_reassembly_limits(limits); }
+    ecaludp::ReassemblyLimits get_reassembly_limits() const                                      { return socket_.get_reassembly_limits(); }
+    ecaludp::ReassemblyEvictionCounters get_reassembly_eviction_counters() const                 { return socket_.get_reassembly_eviction_counters(); }
+    void set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback) { socket_.set_partial_message_callback(partial_message_callback); }
+
+    /**
+     * @brief Sets the size of the ring buffer that is created for each destination
+     *
+     * Only affects channels that are opened afterwards. The ring must be
+     * large enough for the biggest messages, otherwise they are sent via UDP.
+     * The memory is only used when it is written to, but it is not given back
+     * to the system while the channel is open. Default: 64 MiB.
+     */
+    ECALUDP_EXPORT void set_shm_buffer_size(std::size_t shm_buffer_size);
+    ECALUDP_EXPORT std::size_t get_shm_buffer_size() const;
+
+    /**
+     * @brief Returns whether messages to the given destination currently go through shared memory
+     */
+    ECALUDP_EXPORT bool is_shm_channel_open(const asio::ip::udp::endpoint& destination) const;
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Sends the message via shared memory or UDP
+     *
+     * @return The number of bytes sent. For the shared memory channel, that
+     *         is the message size, or 0 if the ring was full and the message
+     *         has been dropped.
+     */
+    ECALUDP_EXPORT std::size_t send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                      , const asio::ip::udp::endpoint& destination
+                                      , asio::socket_base::message_flags flags
+                                      , asio::error_code& ec);
+
+    inline std::size_t send_to(const asio::const_buffer& buffer
+                              , const asio::ip::udp::endpoint& destination
+                              , asio::socket_base::message_flags flags
+                              , asio::error_code& ec)
+    {
+      return send_to(std::vector<asio::const_buffer>{buffer}, destination, flags, ec);
+    }
+
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint& destination
+                                    , const std::function<void(asio::error_code)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const asio::ip::udp::endpoint& destination
+                            , const std::function<void(asio::error_code)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destination, completion_handler);
+    }
+
+    /**
+     * @brief Asynchronously sends the message and reports what has been sent
+     *
+     * The completion handler additionally receives the number of bytes
+     * sent including the ecaludp headers and the number of datagrams.
+     * Messages that went through shared memory are not fragmented, so they
+     * are reported with their size (0 if dropped) and 0 datagrams.
+     */
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint& destination
+                                    , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const asio::ip::udp::endpoint& destination
+                            , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destination, completion_handler);
+    }
+
+  private:
+    /**
+     * @brief Tries to write the message to the shared memory channel of the destination
+     *
+     * @return false, if the message has to be sent via UDP
+     */
+    bool send_via_shm_locked(const std::vector<asio::const_buffer>& buffer_sequence
+                            , const asio::ip::udp::endpoint& destination
+                            , std::size_t& bytes_sent);
+
+    SendChannel* get_send_channel_locked(const asio::ip::udp::endpoint& destination);
+
+    std::unique_ptr<SendChannel> open_send_channel_locked(const asio::ip::udp::endpoint& destination);
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT void async_receive_from(asio::ip::udp::endpoint& sender_endpoint
+                                         , const ReceiveHandler& completion_handler);
+
+  private:
+    void start_udp_receiving_locked();
+
+    void on_udp_receive(const std::shared_ptr<ecaludp::OwningBuffer>& message
+                       , const asio::ip::udp::endpoint& sender_endpoint
+                       , const asio::error_code& ec);
+
+    void start_listening_locked();
+
+    void accept_next_channel_locked();
+
+    void on_channel_accepted(const std::shared_ptr<ReceiveChannel>& channel, const asio::error_code& ec);
+
+    void wait_for_channel_control_locked(const std::shared_ptr<ReceiveChannel>& channel);
+
+    void on_channel_control(const std::shared_ptr<ReceiveChannel>& channel, const asio::error_code& ec);
+
+    void wait_for_channel_event_locked(const std::shared_ptr<ReceiveChannel>& channel);
+
+    void on_channel_event(const std::shared_ptr<ReceiveChannel>& channel, const asio::error_code& ec);
+
+    void read_from_channel_locked(const std::shared_ptr<ReceiveChannel>& channel);
+
+    void remove_receive_channel_locked(const std::shared_ptr<ReceiveChannel>& channel);
+
+    void resume_receiving_locked();
+
+    void collect_receive_results_locked(std::vector<std::function<void()>>& handlers);
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    asio::io_context&                         io_context_;
+    ecaludp::Socket                           socket_;
+
+    std::array<char, 4>                       magic_header_bytes_;
+    std::size_t                               shm_buffer_size_;
+
+    mutable std::mutex                        mutex_;
+
+    // Sending
+    std::map<asio::ip::udp::endpoint, std::unique_ptr<SendChannel>>           send_channels_;
+    std::map<asio::ip::udp::endpoint, std::chrono::steady_clock::time_point>  unreachable_destinations_;   ///< Destinations without a listener and when to retry
+
+    // Receiving
+    bool                                      receiving_started_;
+    bool                                      udp_receive_active_;
+    asio::error_code                          receive_error_;
+    std::deque<ReceivedMessage>               received_messages_;
+    std::deque<ReceiveRequest>                receive_requests_;
+
+    std::unique_ptr<ChannelAcceptor>          channel_acceptor_;            ///< Offers the shared memory channels to senders on this host
+    std::vector<std::shared_ptr<ReceiveChannel>> receive_channels_;
+
+    std::shared_ptr<int>                      lifetime_token_;              ///< Used by the handlers to detect that the socket has been destroyed
+  };
+}
@@ -17,9 +17,11 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <chrono>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -28,19 +30,17 @@
 // IWYU pragma: begin_exports
 #include <ecaludp/ecaludp_export.h>
 #include <ecaludp/error.h>
+#include <ecaludp/incomplete_message.h>
 #include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
 #include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
 // IWYU pragma: end_exports
 
 namespace ecaludp
 {
-  namespace v5
-  {
-    class Reassembly;
-  }
-
-  class recycle_shared_pool;
   class AsyncUdpcapSocket;
+  class ReceiveEngine;
 
   class SocketNpcap
   {
@@ -68,6 +68,22 @@ namespace ecaludp
     ECALUDP_EXPORT void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
     ECALUDP_EXPORT std::chrono::steady_clock::duration get_max_reassembly_age() const;
 
+    /**
+     * See ecaludp::Socket::set_reassembly_limits()
+     */
+    ECALUDP_EXPORT void set_reassembly_limits(const ecaludp::ReassemblyLimits& limits);
+    ECALUDP_EXPORT ecaludp::ReassemblyLimits get_reassembly_limits() const;
+
+    /**
+     * @brief Returns how many incomplete messages have been dropped because of the reassembly limits
+     */
+    ECALUDP_EXPORT ecaludp::ReassemblyEvictionCounters get_reassembly_eviction_counters() const;
+
+    /**
+     * See ecaludp::Socket::set_partial_message_callback()
+     */
+    ECALUDP_EXPORT void set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback);
+
   /////////////////////////////////////////////////////////////////
   // API "Passthrough" (and a bit conversion to asio types)
   /////////////////////////////////////////////////////////////////
@@ -92,13 +108,31 @@ namespace ecaludp
     ECALUDP_EXPORT void async_receive_from(asio::ip::udp::endpoint& sender_endpoint
                                   , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler);
 
+    /**
+     * @brief Returns all fragmented messages that have not been completed, yet
+     * 
+     * See ecaludp::Socket::get_reassembly_snapshot(). Can be called from any thread.
+     */
+    ECALUDP_EXPORT std::vector<ecaludp::IncompleteMessage> get_reassembly_snapshot() const;
+
   private:
     void receive_next_datagram_from(asio::ip::udp::endpoint& sender_endpoint
                                   , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler);
 
-    std::shared_ptr<ecaludp::OwningBuffer> handle_datagram(const std::shared_ptr<ecaludp::RawMemory>&     buffer
-                                                        , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
-                                                        , ecaludp::Error&                                 error);
+  /////////////////////////////////////////////////////////////////
+  // Recording
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Starts appending all received datagrams to a pcap file
+     * 
+     * See ecaludp::Socket::start_recording(). Must not be called while a
+     * receive operation is in progress, just like stop_recording().
+     */
+    ECALUDP_EXPORT bool start_recording(const std::string& file_path, ecaludp::Error& error);
+    ECALUDP_EXPORT void stop_recording();
+    ECALUDP_EXPORT bool is_recording() const;
+    ECALUDP_EXPORT uint64_t get_recording_dropped_datagrams() const;
 
   /////////////////////////////////////////////////////////////////
   // Member Variables
@@ -106,10 +140,6 @@ namespace ecaludp
   private:
     std::unique_ptr<ecaludp::AsyncUdpcapSocket> socket_;                        ///< The "socket" implementation
 
-    std::unique_ptr<recycle_shared_pool>      datagram_buffer_pool_;            ///< A reusable buffer pool for single datagrams (i.e. tyically 1500 byte fragments)
-    std::unique_ptr<ecaludp::v5::Reassembly>  reassembly_v5_;                   ///< The reassembly for the eCAL v5 protocol
-
-    std::array<char, 4>                       magic_header_bytes_;              ///< The magic bytes that are expected to start each fragment. If the received datagram doesn't have those, it will be dropped immediatelly
-    std::chrono::steady_clock::duration       max_reassembly_age_;              ///< Fragments that are stored in the reassembly for longer than that period will be dropped.
+    std::unique_ptr<ecaludp::ReceiveEngine>   receive_engine_;                  ///< Buffer pool, reassembly and recording
   };
 }
\ No newline at end of file
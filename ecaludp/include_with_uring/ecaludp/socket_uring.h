@@ -0,0 +1,292 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+// IWYU pragma: begin_exports
+#include <ecaludp/ecaludp_export.h>
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+// IWYU pragma: end_exports
+
+struct io_uring_cqe;
+struct msghdr;
+
+namespace ecaludp
+{
+  class IoUring;
+  class ReceiveEngine;
+
+  /**
+   * @brief An ecaludp socket that sends and receives via io_uring (Linux only)
+   *
+   * The socket offers the same asynchronous API as the ecaludp::Socket, but
+   * instead of issuing one syscall per datagram, it talks to the kernel via
+   * an io_uring:
+   *
+   * - Receiving uses a single multishot recvmsg operation. The kernel picks
+   *   the buffers for the datagrams from a ring of provided buffers that are
+   *   taken from the datagram buffer pool. Thus, receiving continues in the
+   *   kernel without any syscall, as long as there are free buffers.
+   *   Completed messages are kept until async_receive_from() is called. If
+   *   too many completed messages are pending, the socket stops handing new
+   *   buffers to the kernel, which stops receiving until the user catches up.
+   *
+   * - Sending fragments the message with the same datagram builder as the
+   *   ecaludp::Socket and submits a sendmsg operation for each datagram. All
+   *   datagrams of one async_send_to() call are submitted with one syscall,
+   *   as long as they fit into the submission queue (1024 entries).
+   *   Completion handlers are called in the order of the async_send_to()
+   *   calls.
+   *
+   * The kernel reports completions via an eventfd that is waited for on the
+   * io_context, so the completion handlers are executed by the io_context,
+   * just like with the ecaludp::Socket. The io_context only has work while
+   * operations are in flight.
+   *
+   * Requires Linux 6.0 or newer. If io_uring is not available, all
+   * operations fail with the error that the ring setup returned.
+   */
+  class SocketUring
+  {
+  /////////////////////////////////////////////////////////////////
+  // Private types
+  /////////////////////////////////////////////////////////////////
+  private:
+    struct SendJob;
+
+    using ReceiveHandler = std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>;
+
+    struct ReceiveRequest
+    {
+      asio::ip::udp::endpoint* sender_endpoint_;
+      ReceiveHandler           completion_handler_;
+    };
+
+    struct ReceivedMessage
+    {
+      std::shared_ptr<ecaludp::OwningBuffer> message_;
+      asio::ip::udp::endpoint                sender_endpoint_;
+    };
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT SocketUring(asio::io_context& io_context, std::array<char, 4> magic_header_bytes);
+
+    // Destructor
+    ECALUDP_EXPORT ~SocketUring();
+
+    // Disable copy constructor and assignment operator
+    SocketUring(const SocketUring&)             = delete;
+    SocketUring& operator=(const SocketUring&)  = delete;
+
+    // Disable move constructor and assignment operator
+    SocketUring(SocketUring&&)            = delete;
+    SocketUring& operator=(SocketUring&&) = delete;
+
+    /**
+     * @brief Returns whether the io_uring could be set up
+     */
+    ECALUDP_EXPORT bool is_valid() const;
+
+  /////////////////////////////////////////////////////////////////
+  // API Passthrough
+  /////////////////////////////////////////////////////////////////
+  public:
+    void bind(const asio::ip::udp::endpoint& endpoint)                                           { socket_.bind(endpoint); }
+    asio::error_code bind(const asio::ip::udp::endpoint& endpoint, asio::error_code& ec)         { socket_.bind(endpoint, ec); return ec; }
+
+    /**
+     * @brief Cancels all operations and closes the socket
+     *
+     * The completion handlers of all pending operations are called with
+     * asio::error::operation_aborted.
+     */
+    ECALUDP_EXPORT void close();
+
+    asio::any_io_executor get_executor()                                                         { return socket_.get_executor(); }
+
+    template<typename GettableSocketOption>
+    void get_option(GettableSocketOption& option)                                                { socket_.get_option(option); }
+
+    template<typename GettableSocketOption>
+    asio::error_code get_option(GettableSocketOption& option, asio::error_code& ec)              { return socket_.get_option(option, ec); }
+
+    bool is_open() const                                                                         { return socket_.is_open(); }
+
+    asio::ip::udp::endpoint local_endpoint()                     const                           { return socket_.local_endpoint(); }
+    asio::ip::udp::endpoint local_endpoint(asio::error_code& ec) const                           { return socket_.local_endpoint(ec); }
+
+    asio::ip::udp::socket::native_handle_type native_handle()                                    { return socket_.native_handle(); }
+
+    void open(const asio::ip::udp& protocol)                                                     { socket_.open(protocol); }
+    asio::error_code open(const asio::ip::udp& protocol, asio::error_code& ec)                   { socket_.open(protocol, ec); return ec;}
+
+    template<typename SettableSocketOption>
+    void set_option(const SettableSocketOption& option)                                          { socket_.set_option(option); }
+
+    template<typename SettableSocketOption>
+    asio::error_code set_option(const SettableSocketOption& option, asio::error_code& ec)        { socket_.set_option(option, ec); return ec;}
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT void set_max_udp_datagram_size(std::size_t max_udp_datagram_size);
+    ECALUDP_EXPORT std::size_t get_max_udp_datagram_size() const;
+
+    ECALUDP_EXPORT void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
+    ECALUDP_EXPORT std::chrono::steady_clock::duration get_max_reassembly_age() const;
+
+    /**
+     * See ecaludp::Socket::set_reassembly_limits()
+     */
+    ECALUDP_EXPORT void set_reassembly_limits(const ecaludp::ReassemblyLimits& limits);
+    ECALUDP_EXPORT ecaludp::ReassemblyLimits get_reassembly_limits() const;
+
+    /**
+     * @brief Returns how many incomplete messages have been dropped because of the reassembly limits
+     */
+    ECALUDP_EXPORT ecaludp::ReassemblyEvictionCounters get_reassembly_eviction_counters() const;
+
+    /**
+     * See ecaludp::Socket::set_partial_message_callback(). The callback is
+     * posted to the io_context.
+     */
+    ECALUDP_EXPORT void set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback);
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint& destination
+                                    , const std::function<void(asio::error_code)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const asio::ip::udp::endpoint& destination
+                            , const std::function<void(asio::error_code)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destination, completion_handler);
+    }
+
+    /**
+     * @brief Asynchronously sends the message and reports what has been sent
+     *
+     * The completion handler additionally receives the number of bytes
+     * sent including the ecaludp headers and the number of datagrams.
+     */
+    ECALUDP_EXPORT void async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint& destination
+                                    , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler);
+
+    inline void async_send_to(const asio::const_buffer& buffer
+                            , const asio::ip::udp::endpoint& destination
+                            , const std::function<void(asio::error_code, std::size_t bytes_sent, std::size_t datagrams_sent)>& completion_handler)
+    {
+      async_send_to(std::vector<asio::const_buffer>{buffer}, destination, completion_handler);
+    }
+
+  private:
+    void issue_send_operations_locked();
+
+    void on_send_completion_locked(SendJob* job, int result);
+
+    void collect_finished_send_jobs_locked(std::vector<std::function<void()>>& handlers);
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  public:
+    ECALUDP_EXPORT void async_receive_from(asio::ip::udp::endpoint& sender_endpoint
+                                         , const ReceiveHandler& completion_handler);
+
+  private:
+    void start_receiving_locked();
+
+    void provide_receive_buffer_locked(uint16_t buffer_id);
+
+    void on_receive_completion_locked(const io_uring_cqe& cqe);
+
+    void collect_receive_results_locked(std::vector<std::function<void()>>& handlers);
+
+  /////////////////////////////////////////////////////////////////
+  // Completion handling
+  /////////////////////////////////////////////////////////////////
+  private:
+    void submit_locked();
+
+    void wait_for_completions_locked();
+
+    void on_completions(const asio::error_code& ec);
+
+    void reap_completions_locked(std::vector<std::function<void()>>& handlers);
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    asio::io_context&                         io_context_;
+    asio::ip::udp::socket                     socket_;
+
+    std::unique_ptr<ecaludp::ReceiveEngine>   receive_engine_;
+
+    std::array<char, 4>                       magic_header_bytes_;
+    std::size_t                               max_udp_datagram_size_;
+
+    mutable std::mutex                        mutex_;
+
+    // Receiving
+    std::vector<std::shared_ptr<ecaludp::RawMemory>> receive_buffers_;      ///< The buffers currently provided to the kernel, indexed by buffer ID. nullptr for buffers that have been used.
+    std::vector<uint16_t>                     unprovided_buffer_ids_;       ///< Buffer IDs that have not been re-provided, because too many messages are pending
+    bool                                      receiving_started_;
+    bool                                      receive_armed_;               ///< Whether the multishot recvmsg is active
+    asio::error_code                          receive_error_;
+    std::deque<ReceivedMessage>               received_messages_;
+    std::deque<ReceiveRequest>                receive_requests_;
+
+    // Sending
+    std::deque<std::unique_ptr<SendJob>>      send_jobs_;                   ///< All jobs that have not been completed, yet
+    std::size_t                               first_unissued_job_index_;
+
+    // Completion handling
+    std::size_t                               operations_in_flight_;
+    bool                                      completion_wait_active_;
+    std::shared_ptr<int>                      lifetime_token_;              ///< Used by the eventfd handler to detect that the socket has been destroyed
+
+    asio::error_code                          init_error_;
+    asio::posix::stream_descriptor            completion_event_;            ///< eventfd that is signalled by the kernel when CQEs are posted
+    std::unique_ptr<msghdr>                   receive_msghdr_;              ///< The msghdr template of the multishot recvmsg. Must stay valid while receiving.
+    std::unique_ptr<IoUring>                  ring_;                        ///< Declared last, so it is destroyed before all buffers that the kernel may still use
+  };
+}
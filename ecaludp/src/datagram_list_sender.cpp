@@ -0,0 +1,483 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "datagram_list_sender.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "protocol/datagram_description.h"
+#include "token_bucket.h"
+#include "usdt_probes.h"
+
+#ifdef __linux__
+  #include <cerrno>
+  #include <cstdint>
+  #include <cstring>
+  #include <netinet/in.h>
+  #include <netinet/udp.h>
+  #include <sys/socket.h>
+  #include <sys/uio.h>
+
+  // Older libc headers may not know about UDP GSO, yet
+  #ifndef SOL_UDP
+    #define SOL_UDP 17
+  #endif
+  #ifndef UDP_SEGMENT
+    #define UDP_SEGMENT 103
+  #endif
+#endif // __linux__
+
+namespace ecaludp
+{
+  namespace
+  {
+    // Blocks until the rate limiter allows sending the given amount of bytes
+    void wait_for_tokens(TokenBucket* rate_limiter, std::size_t bytes)
+    {
+      if (rate_limiter == nullptr)
+        return;
+
+      auto wait_time = rate_limiter->try_consume(bytes);
+      while (wait_time > std::chrono::steady_clock::duration(0))
+      {
+        std::this_thread::sleep_for(wait_time);
+        wait_time = rate_limiter->try_consume(bytes);
+      }
+    }
+
+#ifdef __linux__
+    // The kernel refuses to handle more messages than this with one sendmmsg
+    // call. The same limit applies to the iovecs of a single message.
+    constexpr std::size_t max_messages_per_sendmmsg = UIO_MAXIOV;
+    constexpr std::size_t max_iovecs_per_message    = UIO_MAXIOV;
+
+    // The kernel refuses to segment a message into more datagrams than this
+    constexpr std::size_t max_gso_segments          = 64;
+
+    // The maximum UDP payload of an IPv4 datagram. All segments of one GSO
+    // message must fit into a single UDP datagram before segmentation.
+    constexpr std::size_t max_gso_message_size      = 65507;
+
+    // A control message buffer for the UDP_SEGMENT option, properly aligned for cmsghdr
+    union GsoControlBuffer
+    {
+      char     buffer[CMSG_SPACE(sizeof(uint16_t))];
+      cmsghdr  align;
+    };
+
+#ifdef ECALUDP_USDT_ENABLED
+    // Fires the fragment_sent probe for each datagram of a sent message. The
+    // kernel splits a GSO message into datagrams of the segment size.
+    void probe_fragments_sent(const mmsghdr& message)
+    {
+      std::size_t segment_size = message.msg_len;
+
+      const cmsghdr* cmsg = CMSG_FIRSTHDR(&message.msg_hdr);
+      if ((cmsg != nullptr) && (cmsg->cmsg_level == SOL_UDP) && (cmsg->cmsg_type == UDP_SEGMENT))
+      {
+        uint16_t gso_size = 0;
+        std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+        if (gso_size > 0)
+          segment_size = gso_size;
+      }
+
+      std::size_t remaining_bytes = message.msg_len;
+      do
+      {
+        const std::size_t datagram_size = std::min(remaining_bytes, segment_size);
+        ECALUDP_PROBE2(fragment_sent, message.msg_hdr.msg_name, datagram_size);
+        remaining_bytes -= datagram_size;
+      } while (remaining_bytes > 0);
+    }
+#endif // ECALUDP_USDT_ENABLED
+
+    /**
+     * @brief Sends all messages with as few sendmmsg() calls as possible
+     *
+     * @param messages      The first of message_count messages
+     * @param message_sizes The size of each message, used for the rate limiter
+     *
+     * @return The number of bytes sent
+     */
+    std::size_t send_messages(asio::ip::udp::socket&           socket
+                            , mmsghdr*                         messages
+                            , const std::size_t*               message_sizes
+                            , std::size_t                      message_count
+                            , asio::socket_base::message_flags flags
+                            , TokenBucket*                     rate_limiter
+                            , asio::error_code&                ec)
+    {
+      std::size_t bytes_sent    = 0;
+      std::size_t messages_sent = 0;
+      std::size_t messages_paid = 0; // Messages that the rate limiter has been charged for
+
+      const bool is_rate_limited = ((rate_limiter != nullptr) && rate_limiter->is_enabled());
+
+      // Returns the tokens of all messages that have been paid for, but that
+      // the kernel has not accepted. Must be called before returning early.
+      auto refund_unsent_messages = [&]()
+                                    {
+                                      for (std::size_t i = messages_sent; i < messages_paid; i++)
+                                        rate_limiter->refund(message_sizes[i]);
+                                    };
+
+      while (messages_sent < message_count)
+      {
+        auto batch_size = static_cast<unsigned int>(std::min(message_count - messages_sent, max_messages_per_sendmmsg));
+
+        if (is_rate_limited)
+        {
+          // Wait until at least the next message may be sent. Then add all
+          // following messages to the batch that the rate limiter allows to
+          // send right now. Messages that have already been paid for by a
+          // previous (partial) sendmmsg call are not charged again.
+          if (messages_paid == messages_sent)
+          {
+            wait_for_tokens(rate_limiter, message_sizes[messages_sent]);
+            messages_paid++;
+          }
+
+          while ((messages_paid < messages_sent + batch_size)
+                && (rate_limiter->try_consume(message_sizes[messages_paid]) == std::chrono::steady_clock::duration(0)))
+          {
+            messages_paid++;
+          }
+          batch_size = static_cast<unsigned int>(std::min<std::size_t>(batch_size, messages_paid - messages_sent));
+        }
+
+        const int result = ::sendmmsg(socket.native_handle(), &messages[messages_sent], batch_size, static_cast<int>(flags));
+
+        if (result > 0)
+        {
+          for (std::size_t i = messages_sent; i < messages_sent + static_cast<std::size_t>(result); i++)
+          {
+            bytes_sent += messages[i].msg_len;
+
+#ifdef ECALUDP_USDT_ENABLED
+            probe_fragments_sent(messages[i]);
+#endif // ECALUDP_USDT_ENABLED
+          }
+          messages_sent += static_cast<std::size_t>(result);
+        }
+        else if ((result < 0) && (errno == EINTR))
+        {
+          continue;
+        }
+        else if ((result < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+          // The socket is non-blocking and the send buffer is full. If the
+          // user explicitly requested non-blocking mode, we report that.
+          // Otherwise the socket is only non-blocking internally (asio does
+          // that for async operations), so we wait for it to become writable.
+          if (socket.non_blocking())
+          {
+            ec = asio::error::would_block;
+            refund_unsent_messages();
+            return bytes_sent;
+          }
+
+          socket.wait(asio::socket_base::wait_write, ec);
+          if (ec)
+          {
+            refund_unsent_messages();
+            return bytes_sent;
+          }
+        }
+        else
+        {
+          ec = asio::error_code(errno, asio::error::get_system_category());
+          refund_unsent_messages();
+          return bytes_sent;
+        }
+      }
+
+      return bytes_sent;
+    }
+
+    // Errors that indicate that the kernel or the network device refused to
+    // segment a message, while regular datagrams would still be accepted
+    bool is_gso_rejection(const asio::error_code& ec)
+    {
+      return (ec.category() == asio::error::get_system_category())
+            && ((ec.value() == EINVAL) || (ec.value() == EIO) || (ec.value() == ENOPROTOOPT) || (ec.value() == EOPNOTSUPP));
+    }
+#endif // __linux__
+  }
+
+#ifdef __linux__
+  std::size_t send_datagram_list_to(asio::ip::udp::socket&                      socket
+                                  , const DatagramList&                         datagram_list
+                                  , const std::vector<asio::ip::udp::endpoint>& destinations
+                                  , asio::socket_base::message_flags            flags
+                                  , TokenBucket*                                rate_limiter
+                                  , asio::error_code&                           ec)
+  {
+    ec = asio::error_code();
+
+    if (datagram_list.empty() || destinations.empty())
+      return 0;
+
+    // Create the iovecs for each datagram only once. All destinations share
+    // the same iovecs, as the payload is identical.
+    std::vector<std::size_t> iovec_start_index;
+    iovec_start_index.reserve(datagram_list.size());
+
+    std::vector<iovec> iovecs;
+    for (const auto& datagram : datagram_list)
+    {
+      iovec_start_index.push_back(iovecs.size());
+      for (const auto& buffer : datagram.asio_buffer_list_)
+      {
+        iovecs.push_back(iovec{const_cast<void*>(buffer.data()), buffer.size()});
+      }
+    }
+
+    // Create one message for each (destination x datagram) pair
+    const std::size_t message_count = destinations.size() * datagram_list.size();
+
+    std::vector<mmsghdr>     messages(message_count);
+    std::vector<std::size_t> message_sizes(message_count);
+    for (std::size_t destination_index = 0; destination_index < destinations.size(); destination_index++)
+    {
+      for (std::size_t datagram_index = 0; datagram_index < datagram_list.size(); datagram_index++)
+      {
+        const std::size_t message_index = destination_index * datagram_list.size() + datagram_index;
+        msghdr& msg = messages[message_index].msg_hdr;
+
+        msg.msg_name    = const_cast<void*>(static_cast<const void*>(destinations[destination_index].data()));
+        msg.msg_namelen = static_cast<socklen_t>(destinations[destination_index].size());
+        msg.msg_iov     = &iovecs[iovec_start_index[datagram_index]];
+        msg.msg_iovlen  = datagram_list[datagram_index].asio_buffer_list_.size();
+
+        message_sizes[message_index] = datagram_list[datagram_index].size();
+      }
+    }
+
+    return send_messages(socket, messages.data(), message_sizes.data(), messages.size(), flags, rate_limiter, ec);
+  }
+
+  bool is_udp_gso_supported(asio::ip::udp::socket& socket)
+  {
+    if (!socket.is_open())
+      return false;
+
+    // The UDP_SEGMENT socket option has been added together with UDP GSO
+    int       gso_size     = 0;
+    socklen_t gso_size_len = sizeof(gso_size);
+    return (::getsockopt(socket.native_handle(), SOL_UDP, UDP_SEGMENT, &gso_size, &gso_size_len) == 0);
+  }
+
+  std::size_t send_datagram_list_gso_to(asio::ip::udp::socket&                      socket
+                                      , const DatagramList&                         datagram_list
+                                      , const std::vector<asio::ip::udp::endpoint>& destinations
+                                      , asio::socket_base::message_flags            flags
+                                      , TokenBucket*                                rate_limiter
+                                      , asio::error_code&                           ec)
+  {
+    ec = asio::error_code();
+
+    // GSO only pays off for fragmented messages, i.e. a fragment info
+    // datagram followed by at least 2 fragments.
+    if ((datagram_list.size() < 3) || destinations.empty())
+      return send_datagram_list_to(socket, datagram_list, destinations, flags, rate_limiter, ec);
+
+    // All fragments have the same size, except for the last one, which may
+    // be smaller. That is exactly what UDP GSO expects.
+    const std::size_t segment_size = datagram_list[1].size();
+    if ((segment_size == 0) || (segment_size > max_gso_message_size) || (segment_size > UINT16_MAX))
+    {
+      ec = asio::error::operation_not_supported;
+      return 0;
+    }
+
+    const std::size_t max_segments_per_message = std::max<std::size_t>(1, std::min(max_gso_segments, max_gso_message_size / segment_size));
+
+    // Create the iovecs for each datagram only once. As the iovecs of
+    // consecutive datagrams are consecutive in the vector, a range of
+    // fragments can directly be referenced by one message. The kernel then
+    // cuts the message into datagrams of segment_size bytes, each starting
+    // with its own header.
+    std::vector<std::size_t> iovec_start_index;
+    iovec_start_index.reserve(datagram_list.size() + 1);
+
+    std::vector<iovec> iovecs;
+    for (const auto& datagram : datagram_list)
+    {
+      iovec_start_index.push_back(iovecs.size());
+      for (const auto& buffer : datagram.asio_buffer_list_)
+      {
+        iovecs.push_back(iovec{const_cast<void*>(buffer.data()), buffer.size()});
+      }
+    }
+    iovec_start_index.push_back(iovecs.size());
+
+    // Split the fragments into ranges [first, last) that are sent as one GSO message
+    std::vector<std::pair<std::size_t, std::size_t>> fragment_ranges;
+    {
+      std::size_t first = 1;
+      while (first < datagram_list.size())
+      {
+        std::size_t last = first + 1;
+        while ((last < datagram_list.size())
+              && ((last - first) < max_segments_per_message)
+              && ((iovec_start_index[last + 1] - iovec_start_index[first]) <= max_iovecs_per_message))
+        {
+          last++;
+        }
+        fragment_ranges.emplace_back(first, last);
+        first = last;
+      }
+    }
+
+    // For each destination: one GSO message for each range of fragments and
+    // the fragment info datagram as regular message. The fragment info is
+    // sent after the first range, so the kernel has accepted at least one
+    // GSO message before anything else goes out. The receiver handles
+    // fragments that arrive before their fragment info.
+    const std::size_t messages_per_destination = 1 + fragment_ranges.size();
+    const std::size_t message_count            = destinations.size() * messages_per_destination;
+
+    std::vector<mmsghdr>          messages(message_count);
+    std::vector<std::size_t>      message_sizes(message_count);
+    std::vector<GsoControlBuffer> control_buffers(fragment_ranges.size());
+
+    for (std::size_t range_index = 0; range_index < fragment_ranges.size(); range_index++)
+    {
+      // The control message is identical for all destinations, as it only
+      // contains the segment size
+      std::memset(&control_buffers[range_index], 0, sizeof(GsoControlBuffer));
+
+      msghdr control_msg{};
+      control_msg.msg_control    = control_buffers[range_index].buffer;
+      control_msg.msg_controllen = sizeof(control_buffers[range_index].buffer);
+
+      cmsghdr* cmsg   = CMSG_FIRSTHDR(&control_msg);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type  = UDP_SEGMENT;
+      cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+
+      const auto gso_size = static_cast<uint16_t>(segment_size);
+      std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    }
+
+    for (std::size_t destination_index = 0; destination_index < destinations.size(); destination_index++)
+    {
+      for (std::size_t i = 0; i < messages_per_destination; i++)
+      {
+        const std::size_t message_index = destination_index * messages_per_destination + i;
+        msghdr& msg = messages[message_index].msg_hdr;
+
+        msg.msg_name    = const_cast<void*>(static_cast<const void*>(destinations[destination_index].data()));
+        msg.msg_namelen = static_cast<socklen_t>(destinations[destination_index].size());
+
+        // Order: first range, fragment info, remaining ranges
+        const std::size_t range_index    = (i == 0 ? 0 : i - 1);
+        const bool        is_info        = (i == 1);
+        const std::size_t first_datagram = (is_info ? 0 : fragment_ranges[range_index].first);
+        const std::size_t last_datagram  = (is_info ? 1 : fragment_ranges[range_index].second);
+
+        msg.msg_iov     = &iovecs[iovec_start_index[first_datagram]];
+        msg.msg_iovlen  = iovec_start_index[last_datagram] - iovec_start_index[first_datagram];
+
+        // Only attach the segment size, if the kernel actually has to split
+        // the message
+        if (last_datagram - first_datagram > 1)
+        {
+          msg.msg_control    = control_buffers[range_index].buffer;
+          msg.msg_controllen = sizeof(control_buffers[range_index].buffer);
+        }
+
+        for (std::size_t datagram_index = first_datagram; datagram_index < last_datagram; datagram_index++)
+        {
+          message_sizes[message_index] += datagram_list[datagram_index].size();
+        }
+      }
+    }
+
+    // Send the first GSO message on its own. If the kernel or the network
+    // device rejects it, nothing has been sent, yet, and the caller may fall
+    // back to regular sending. This e.g. happens when the segment size
+    // exceeds the path MTU or when the device cannot checksum the segments.
+    std::size_t bytes_sent = send_messages(socket, messages.data(), message_sizes.data(), 1, flags, rate_limiter, ec);
+    if (ec)
+    {
+      if ((bytes_sent == 0) && is_gso_rejection(ec))
+        ec = asio::error::operation_not_supported;
+      return bytes_sent;
+    }
+
+    bytes_sent += send_messages(socket, messages.data() + 1, message_sizes.data() + 1, messages.size() - 1, flags, rate_limiter, ec);
+    return bytes_sent;
+  }
+
+#else // __linux__
+
+  std::size_t send_datagram_list_to(asio::ip::udp::socket&                      socket
+                                  , const DatagramList&                         datagram_list
+                                  , const std::vector<asio::ip::udp::endpoint>& destinations
+                                  , asio::socket_base::message_flags            flags
+                                  , TokenBucket*                                rate_limiter
+                                  , asio::error_code&                           ec)
+  {
+    ec = asio::error_code();
+
+    std::size_t bytes_sent = 0;
+    for (const auto& destination : destinations)
+    {
+      for (const auto& datagram : datagram_list)
+      {
+        wait_for_tokens(rate_limiter, datagram.size());
+
+        const std::size_t datagram_bytes_sent = socket.send_to(datagram.asio_buffer_list_, destination, flags, ec);
+        bytes_sent += datagram_bytes_sent;
+        if (ec)
+        {
+          // The datagram has not been sent, so it must not count against the rate limit
+          if (rate_limiter != nullptr)
+            rate_limiter->refund(datagram.size());
+          return bytes_sent;
+        }
+
+        ECALUDP_PROBE2(fragment_sent, destination.data(), datagram_bytes_sent);
+      }
+    }
+    return bytes_sent;
+  }
+
+  bool is_udp_gso_supported(asio::ip::udp::socket& /*socket*/)
+  {
+    return false;
+  }
+
+  std::size_t send_datagram_list_gso_to(asio::ip::udp::socket&                      /*socket*/
+                                      , const DatagramList&                         /*datagram_list*/
+                                      , const std::vector<asio::ip::udp::endpoint>& /*destinations*/
+                                      , asio::socket_base::message_flags            /*flags*/
+                                      , TokenBucket*                                /*rate_limiter*/
+                                      , asio::error_code&                           ec)
+  {
+    ec = asio::error::operation_not_supported;
+    return 0;
+  }
+
+#endif // __linux__
+}
@@ -0,0 +1,96 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "protocol/datagram_description.h"
+
+namespace ecaludp
+{
+  class TokenBucket;
+
+  /**
+   * @brief Synchronously sends every datagram of the list to every destination
+   *
+   * The datagram list is only created once by the caller and then sent to all
+   * destinations. On Linux, all (destination x datagram) pairs are handed to
+   * the kernel with as few sendmmsg() calls as possible. On other platforms,
+   * each datagram is sent with a separate send_to() call.
+   *
+   * If the socket is in non-blocking mode internally (asio does that as soon
+   * as an async operation has been started), the function waits for the
+   * socket to become writable, if it would block. If the user explicitly
+   * set the socket to non-blocking mode, asio::error::would_block is
+   * returned instead.
+   *
+   * If a rate limiter is given, the function blocks until enough tokens are
+   * available for the next datagrams. On Linux, all datagrams that fit into
+   * the currently available tokens are still sent with one sendmmsg() call.
+   *
+   * @param socket          The socket to send with
+   * @param datagram_list   The datagrams to send
+   * @param destinations    The destinations to send each datagram to
+   * @param flags           Flags passed to the underlying send call
+   * @param rate_limiter    Token bucket for pacing the datagrams. May be nullptr.
+   * @param ec              Set to the first error that occurred
+   *
+   * @return The number of bytes sent in total (including headers and all destinations)
+   */
+  std::size_t send_datagram_list_to(asio::ip::udp::socket&                      socket
+                                  , const DatagramList&                         datagram_list
+                                  , const std::vector<asio::ip::udp::endpoint>& destinations
+                                  , asio::socket_base::message_flags            flags
+                                  , TokenBucket*                                rate_limiter
+                                  , asio::error_code&                           ec);
+
+  /**
+   * @brief Checks whether the kernel supports UDP GSO (UDP_SEGMENT) for this socket
+   *
+   * Always false on non-Linux platforms or if the socket is not open.
+   */
+  bool is_udp_gso_supported(asio::ip::udp::socket& socket);
+
+  /**
+   * @brief Synchronously sends the datagram list using UDP GSO
+   *
+   * All fragments of a fragmented message have the same size, except for the
+   * last one. Thus, a range of up to 64 consecutive fragments (headers
+   * included) is handed to the kernel as one message with the UDP_SEGMENT
+   * control message set to the fragment size. The kernel (or the network
+   * device) then cuts that message into the original datagrams. The fragment
+   * info datagram is sent as a regular message after the first range of
+   * fragments. Messages that are not fragmented are sent by
+   * send_datagram_list_to().
+   *
+   * The first GSO message is sent on its own. If the kernel rejects it (e.g.
+   * because of a fragment size that exceeds the path MTU or disabled UDP
+   * checksums), nothing has been sent, ec is set to
+   * asio::error::operation_not_supported and the caller should fall back to
+   * send_datagram_list_to().
+   *
+   * @return The number of bytes sent in total (including headers and all destinations)
+   */
+  std::size_t send_datagram_list_gso_to(asio::ip::udp::socket&                      socket
+                                      , const DatagramList&                         datagram_list
+                                      , const std::vector<asio::ip::udp::endpoint>& destinations
+                                      , asio::socket_base::message_flags            flags
+                                      , TokenBucket*                                rate_limiter
+                                      , asio::error_code&                           ec);
+}
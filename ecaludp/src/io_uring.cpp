@@ -0,0 +1,291 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "io_uring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  namespace
+  {
+    int io_uring_setup(unsigned int entries, io_uring_params* params)
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int ring_fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int io_uring_register(int ring_fd, unsigned int opcode, const void* arg, unsigned int nr_args)
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+    }
+
+    void* offset_pointer(void* base, uint32_t offset)
+    {
+      return static_cast<char*>(base) + offset;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  IoUring::IoUring()
+    : ring_fd_             (-1)
+    , sq_ring_ptr_         (nullptr)
+    , sq_ring_size_        (0)
+    , cq_ring_ptr_         (nullptr)
+    , cq_ring_size_        (0)
+    , sqes_                (nullptr)
+    , sqes_size_           (0)
+    , sq_entries_          (0)
+    , sq_head_             (nullptr)
+    , sq_tail_             (nullptr)
+    , sq_ring_mask_        (nullptr)
+    , sq_flags_            (nullptr)
+    , sqe_tail_            (0)
+    , cq_entries_          (0)
+    , cq_head_             (nullptr)
+    , cq_tail_             (nullptr)
+    , cq_ring_mask_        (nullptr)
+    , cqes_                (nullptr)
+    , buffer_ring_         (nullptr)
+    , buffer_ring_size_    (0)
+    , buffer_ring_entries_ (0)
+    , buffer_ring_group_id_(0)
+    , buffer_ring_tail_    (0)
+  {}
+
+  IoUring::~IoUring()
+  {
+    // Closing the ring cancels all operations that are still in flight. The
+    // buffer ring may only be unmapped afterwards.
+    if (ring_fd_ >= 0)
+      ::close(ring_fd_);
+
+    if (buffer_ring_ != nullptr)
+      ::munmap(buffer_ring_, buffer_ring_size_);
+    if (sqes_ != nullptr)
+      ::munmap(sqes_, sqes_size_);
+    if ((cq_ring_ptr_ != nullptr) && (cq_ring_ptr_ != sq_ring_ptr_))
+      ::munmap(cq_ring_ptr_, cq_ring_size_);
+    if (sq_ring_ptr_ != nullptr)
+      ::munmap(sq_ring_ptr_, sq_ring_size_);
+  }
+
+  void IoUring::init(unsigned int entries, asio::error_code& ec)
+  {
+    io_uring_params params{};
+    params.flags      = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    const int ring_fd = io_uring_setup(entries, &params);
+    if (ring_fd < 0)
+    {
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      return;
+    }
+    ring_fd_ = ring_fd;
+
+    sq_ring_size_ = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+    cq_ring_size_ = params.cq_off.cqes  + (params.cq_entries * sizeof(io_uring_cqe));
+
+    const bool single_mmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+    if (single_mmap)
+    {
+      sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+      cq_ring_size_ = sq_ring_size_;
+    }
+
+    void* sq_ring_ptr = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ptr == MAP_FAILED)
+    {
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      return;
+    }
+    sq_ring_ptr_ = sq_ring_ptr;
+
+    if (single_mmap)
+    {
+      cq_ring_ptr_ = sq_ring_ptr_;
+    }
+    else
+    {
+      void* cq_ring_ptr = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+      if (cq_ring_ptr == MAP_FAILED)
+      {
+        ec = asio::error_code(errno, asio::error::get_system_category());
+        return;
+      }
+      cq_ring_ptr_ = cq_ring_ptr;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      return;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_entries_   = params.sq_entries;
+    sq_head_      = static_cast<unsigned int*>(offset_pointer(sq_ring_ptr_, params.sq_off.head));
+    sq_tail_      = static_cast<unsigned int*>(offset_pointer(sq_ring_ptr_, params.sq_off.tail));
+    sq_ring_mask_ = static_cast<unsigned int*>(offset_pointer(sq_ring_ptr_, params.sq_off.ring_mask));
+    sq_flags_     = static_cast<unsigned int*>(offset_pointer(sq_ring_ptr_, params.sq_off.flags));
+    sqe_tail_     = *sq_tail_;
+
+    cq_entries_   = params.cq_entries;
+    cq_head_      = static_cast<unsigned int*>(offset_pointer(cq_ring_ptr_, params.cq_off.head));
+    cq_tail_      = static_cast<unsigned int*>(offset_pointer(cq_ring_ptr_, params.cq_off.tail));
+    cq_ring_mask_ = static_cast<unsigned int*>(offset_pointer(cq_ring_ptr_, params.cq_off.ring_mask));
+    cqes_         = static_cast<io_uring_cqe*>(offset_pointer(cq_ring_ptr_, params.cq_off.cqes));
+
+    // We always use the SQEs in order, so the indirection array can be
+    // initialized once with the identity
+    auto* sq_array = static_cast<unsigned int*>(offset_pointer(sq_ring_ptr_, params.sq_off.array));
+    for (unsigned int i = 0; i < sq_entries_; ++i)
+      sq_array[i] = i;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Submission
+  /////////////////////////////////////////////////////////////////
+  io_uring_sqe* IoUring::get_sqe()
+  {
+    const unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_)
+      return nullptr;
+
+    io_uring_sqe* sqe = &sqes_[sqe_tail_ & *sq_ring_mask_];
+    ++sqe_tail_;
+
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    return sqe;
+  }
+
+  unsigned int IoUring::submit(unsigned int min_complete, asio::error_code& ec)
+  {
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+    // SQEs that the kernel did not consume in a previous call (e.g. because
+    // the completion queue was overflowing) are submitted again.
+    const unsigned int to_submit = sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if ((to_submit == 0) && (min_complete == 0))
+      return 0;
+
+    const unsigned int flags = (min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+
+    int result = 0;
+    do
+    {
+      result = io_uring_enter(ring_fd_, to_submit, min_complete, flags);
+    } while ((result < 0) && (errno == EINTR));
+
+    if (result < 0)
+    {
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      return 0;
+    }
+
+    return static_cast<unsigned int>(result);
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Completion
+  /////////////////////////////////////////////////////////////////
+  void IoUring::register_eventfd(int eventfd, asio::error_code& ec)
+  {
+    if (io_uring_register(ring_fd_, IORING_REGISTER_EVENTFD, &eventfd, 1) < 0)
+      ec = asio::error_code(errno, asio::error::get_system_category());
+  }
+
+  bool IoUring::has_overflowed_cqes() const
+  {
+    return (__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0;
+  }
+
+  bool IoUring::flush_overflowed_cqes()
+  {
+    // Entering the kernel with GETEVENTS moves overflowed CQEs to the ring
+    return io_uring_enter(ring_fd_, 0, 0, IORING_ENTER_GETEVENTS) >= 0;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Provided buffers
+  /////////////////////////////////////////////////////////////////
+  void IoUring::register_buffer_ring(uint16_t group_id, unsigned int entries, asio::error_code& ec)
+  {
+    const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t size = ((entries * sizeof(io_uring_buf)) + page_size - 1) / page_size * page_size;
+
+    void* buffer_ring = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer_ring == MAP_FAILED)
+    {
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      return;
+    }
+
+    io_uring_buf_reg registration{};
+    registration.ring_addr    = reinterpret_cast<uint64_t>(buffer_ring);
+    registration.ring_entries = entries;
+    registration.bgid         = group_id;
+
+    if (io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+    {
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      ::munmap(buffer_ring, size);
+      return;
+    }
+
+    buffer_ring_          = static_cast<io_uring_buf_ring*>(buffer_ring);
+    buffer_ring_size_     = size;
+    buffer_ring_entries_  = entries;
+    buffer_ring_group_id_ = group_id;
+    buffer_ring_tail_     = 0;
+  }
+
+  void IoUring::add_buffer(void* address, unsigned int length, uint16_t buffer_id)
+  {
+    // The bufs member of io_uring_buf_ring is declared as flexible array after
+    // an empty struct, which has a size of 1 in C++. Thus, we cannot use it.
+    auto*         buffers = reinterpret_cast<io_uring_buf*>(buffer_ring_);
+    io_uring_buf& buffer  = buffers[buffer_ring_tail_ & (buffer_ring_entries_ - 1)];
+    buffer.addr = reinterpret_cast<uint64_t>(address);
+    buffer.len  = length;
+    buffer.bid  = buffer_id;
+    ++buffer_ring_tail_;
+  }
+
+  void IoUring::commit_buffers()
+  {
+    __atomic_store_n(&buffer_ring_->tail, buffer_ring_tail_, __ATOMIC_RELEASE);
+  }
+}
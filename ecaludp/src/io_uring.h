@@ -0,0 +1,191 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  /**
+   * @brief A minimal wrapper around a Linux io_uring instance
+   *
+   * The ring is set up with the raw io_uring syscalls, so there is no
+   * dependency to liburing. Only the features needed by the SocketUring are
+   * implemented: Getting and submitting SQEs, reaping CQEs, notifying an
+   * eventfd about new CQEs and one ring of provided buffers.
+   *
+   * The class is not thread-safe.
+   */
+  class IoUring
+  {
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    IoUring();
+
+    // Disable copy and move
+    IoUring(const IoUring&)            = delete;
+    IoUring& operator=(const IoUring&) = delete;
+    IoUring(IoUring&&)                 = delete;
+    IoUring& operator=(IoUring&&)      = delete;
+
+    ~IoUring();
+
+    /**
+     * @brief Creates the ring with the given amount of SQEs
+     *
+     * The completion queue is 4 times as large as the submission queue.
+     */
+    void init(unsigned int entries, asio::error_code& ec);
+
+    bool is_initialized() const { return ring_fd_ >= 0; }
+
+    unsigned int sq_entries() const { return sq_entries_; }
+    unsigned int cq_entries() const { return cq_entries_; }
+
+  /////////////////////////////////////////////////////////////////
+  // Submission
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Returns the next free SQE, initialized to zero
+     *
+     * @return nullptr, if the submission queue is full
+     */
+    io_uring_sqe* get_sqe();
+
+    /**
+     * @brief Submits all SQEs that have not been consumed by the kernel, yet
+     *
+     * @param min_complete  Wait until at least this amount of CQEs is available
+     *
+     * @return The number of submitted SQEs
+     */
+    unsigned int submit(unsigned int min_complete, asio::error_code& ec);
+
+  /////////////////////////////////////////////////////////////////
+  // Completion
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Calls the handler for each available CQE and marks it as seen
+     *
+     * CQEs that the kernel had to keep in its overflow list are flushed to
+     * the completion queue and handled as well.
+     *
+     * @return The number of handled CQEs
+     */
+    template <typename Handler>
+    unsigned int for_each_cqe(Handler&& handler)
+    {
+      unsigned int count = 0;
+
+      while (true)
+      {
+        unsigned int       head = *cq_head_;
+        const unsigned int tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+        if (head == tail)
+        {
+          if (!has_overflowed_cqes() || !flush_overflowed_cqes())
+            break;
+          continue;
+        }
+
+        while (head != tail)
+        {
+          const io_uring_cqe cqe = cqes_[head & *cq_ring_mask_];
+          ++head;
+          __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+          handler(cqe);
+          ++count;
+        }
+      }
+
+      return count;
+    }
+
+    /**
+     * @brief Lets the kernel signal the eventfd whenever a CQE is posted
+     */
+    void register_eventfd(int eventfd, asio::error_code& ec);
+
+  private:
+    bool has_overflowed_cqes() const;
+    bool flush_overflowed_cqes();
+
+  /////////////////////////////////////////////////////////////////
+  // Provided buffers
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Registers a ring of provided buffers for the given buffer group
+     *
+     * Operations with IOSQE_BUFFER_SELECT pick a buffer from that ring. The
+     * ID of the picked buffer is returned in the flags of the CQE.
+     *
+     * @param entries Number of entries. Must be a power of 2.
+     */
+    void register_buffer_ring(uint16_t group_id, unsigned int entries, asio::error_code& ec);
+
+    /**
+     * @brief Adds a buffer to the buffer ring. The buffer is handed to the
+     *        kernel with the next call to commit_buffers().
+     */
+    void add_buffer(void* address, unsigned int length, uint16_t buffer_id);
+
+    void commit_buffers();
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    int                 ring_fd_;
+
+    void*               sq_ring_ptr_;
+    std::size_t         sq_ring_size_;
+    void*               cq_ring_ptr_;
+    std::size_t         cq_ring_size_;
+    io_uring_sqe*       sqes_;
+    std::size_t         sqes_size_;
+
+    unsigned int        sq_entries_;
+    unsigned int*       sq_head_;
+    unsigned int*       sq_tail_;
+    unsigned int*       sq_ring_mask_;
+    unsigned int*       sq_flags_;
+    unsigned int        sqe_tail_;              ///< Tail of the SQEs handed out by get_sqe(). Published to the kernel on submit().
+
+    unsigned int        cq_entries_;
+    unsigned int*       cq_head_;
+    unsigned int*       cq_tail_;
+    unsigned int*       cq_ring_mask_;
+    io_uring_cqe*       cqes_;
+
+    io_uring_buf_ring*  buffer_ring_;
+    std::size_t         buffer_ring_size_;
+    unsigned int        buffer_ring_entries_;
+    uint16_t            buffer_ring_group_id_;
+    uint16_t            buffer_ring_tail_;      ///< Tail including buffers that have not been committed, yet
+  };
+}
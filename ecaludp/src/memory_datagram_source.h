@@ -0,0 +1,92 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/raw_memory.h>
+
+#include "receive_engine.h"
+
+namespace ecaludp
+{
+  /**
+   * @brief A datagram source for the ReceiveEngine that hands out datagrams from memory
+   *
+   * The datagrams are copied once when they are added and handed out without
+   * copying afterwards, so the reassembly can be measured without any
+   * network or file I/O. Handing out the same datagrams multiple times is
+   * done with rewind().
+   *
+   * Usage:
+   *   MemoryDatagramSource source;
+   *   source.add_datagram(data, size, sender);
+   *   auto message = engine.receive_from(source, sender_endpoint, error);
+   */
+  class MemoryDatagramSource
+  {
+  public:
+    void add_datagram(const void* data, std::size_t size, const asio::ip::udp::endpoint& sender_endpoint)
+    {
+      auto buffer = std::make_shared<ecaludp::RawMemory>(size);
+      if (size > 0)
+        memcpy(buffer->data(), data, size);
+
+      datagrams_.push_back(StoredDatagram{std::move(buffer), std::make_shared<asio::ip::udp::endpoint>(sender_endpoint)});
+    }
+
+    /**
+     * @brief Hands out the next datagram or END_OF_FILE after the last one
+     */
+    bool operator()(ecaludp::ReceivedDatagram& datagram, ecaludp::Error& error)
+    {
+      if (next_datagram_ >= datagrams_.size())
+      {
+        error = ecaludp::Error::END_OF_FILE;
+        return false;
+      }
+
+      const StoredDatagram& stored_datagram = datagrams_[next_datagram_++];
+
+      datagram.data_            = stored_datagram.buffer_->data();
+      datagram.size_            = stored_datagram.buffer_->size();
+      datagram.owner_           = stored_datagram.buffer_;
+      datagram.sender_endpoint_ = stored_datagram.sender_endpoint_;
+      return true;
+    }
+
+    void rewind()                   { next_datagram_ = 0; }
+    std::size_t size() const        { return datagrams_.size(); }
+    void clear()                    { datagrams_.clear(); next_datagram_ = 0; }
+
+  private:
+    struct StoredDatagram
+    {
+      std::shared_ptr<ecaludp::RawMemory>      buffer_;
+      std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint_;
+    };
+
+    std::vector<StoredDatagram> datagrams_;
+    std::size_t                 next_datagram_ {0};
+  };
+}
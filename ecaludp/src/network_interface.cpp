@@ -0,0 +1,182 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "network_interface.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  namespace
+  {
+    bool read_interface_details(NetworkInterface& network_interface)
+    {
+      const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+      if (fd < 0)
+        return false;
+
+      ifreq request{};
+      std::strncpy(request.ifr_name, network_interface.name_.c_str(), IFNAMSIZ - 1);
+
+      bool success = (::ioctl(fd, SIOCGIFHWADDR, &request) == 0);
+      if (success)
+        std::memcpy(network_interface.mac_address_.data(), request.ifr_hwaddr.sa_data, network_interface.mac_address_.size());
+
+      success = success && (::ioctl(fd, SIOCGIFMTU, &request) == 0);
+      if (success)
+        network_interface.mtu_ = static_cast<std::size_t>(request.ifr_mtu);
+
+      ::close(fd);
+      return success;
+    }
+  }
+
+  bool find_network_interface(const asio::ip::address_v4& address, NetworkInterface& network_interface)
+  {
+    ifaddrs* interface_addresses = nullptr;
+    if (::getifaddrs(&interface_addresses) != 0)
+      return false;
+
+    std::string interface_name;
+    std::string loopback_interface_name;
+    bool        is_loopback = false;
+
+    for (const ifaddrs* it = interface_addresses; it != nullptr; it = it->ifa_next)
+    {
+      if ((it->ifa_addr == nullptr) || (it->ifa_addr->sa_family != AF_INET))
+        continue;
+
+      const auto* inet_address = reinterpret_cast<const sockaddr_in*>(it->ifa_addr);
+      if (ntohl(inet_address->sin_addr.s_addr) == address.to_uint())
+      {
+        interface_name = it->ifa_name;
+        is_loopback    = ((it->ifa_flags & IFF_LOOPBACK) != 0);
+        break;
+      }
+
+      if ((it->ifa_flags & IFF_LOOPBACK) != 0)
+        loopback_interface_name = it->ifa_name;
+    }
+    ::freeifaddrs(interface_addresses);
+
+    // The whole 127.0.0.0/8 network belongs to the loopback interface
+    if (interface_name.empty() && address.is_loopback())
+    {
+      interface_name = loopback_interface_name;
+      is_loopback    = true;
+    }
+
+    if (interface_name.empty())
+      return false;
+
+    const unsigned int interface_index = ::if_nametoindex(interface_name.c_str());
+    if (interface_index == 0)
+      return false;
+
+    network_interface.index_       = static_cast<int>(interface_index);
+    network_interface.name_        = interface_name;
+    network_interface.is_loopback_ = is_loopback;
+
+    return read_interface_details(network_interface);
+  }
+
+  bool find_neighbor_mac_address(const asio::ip::address_v4& address, const std::string& interface_name, MacAddress& mac_address)
+  {
+    // Format: IP address, HW type, Flags, HW address, Mask, Device
+    std::ifstream arp_table("/proc/net/arp");
+    if (!arp_table.is_open())
+      return false;
+
+    std::string line;
+    std::getline(arp_table, line); // Skip the header
+
+    const std::string address_string = address.to_string();
+
+    while (std::getline(arp_table, line))
+    {
+      std::istringstream line_stream(line);
+      std::string ip;
+      std::string hw_type;
+      std::string flags;
+      std::string hw_address;
+      std::string mask;
+      std::string device;
+
+      if (!(line_stream >> ip >> hw_type >> flags >> hw_address >> mask >> device))
+        continue;
+
+      constexpr unsigned long arp_flag_complete = 0x02;
+      if ((ip != address_string) || (device != interface_name) || ((std::stoul(flags, nullptr, 16) & arp_flag_complete) == 0))
+        continue;
+
+      std::array<unsigned int, 6> bytes{};
+      if (std::sscanf(hw_address.c_str(), "%x:%x:%x:%x:%x:%x", &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]) != 6)
+        return false;
+
+      for (std::size_t i = 0; i < bytes.size(); ++i)
+        mac_address[i] = static_cast<uint8_t>(bytes[i]);
+
+      return true;
+    }
+
+    return false;
+  }
+
+  bool resolve_destination_mac_address(const asio::ip::address_v4& address, const NetworkInterface& network_interface, MacAddress& mac_address)
+  {
+    if (network_interface.is_loopback_)
+    {
+      // The loopback interface ignores the MAC address
+      mac_address = network_interface.mac_address_;
+      return true;
+    }
+
+    if (address.is_multicast())
+    {
+      // 01:00:5e + the lower 23 bit of the group address (RFC 1112)
+      const uint32_t group = address.to_uint();
+      mac_address = MacAddress{{ 0x01, 0x00, 0x5E
+                               , static_cast<uint8_t>((group >> 16) & 0x7F)
+                               , static_cast<uint8_t>((group >> 8)  & 0xFF)
+                               , static_cast<uint8_t>(group         & 0xFF) }};
+      return true;
+    }
+
+    if (address == asio::ip::address_v4::broadcast())
+    {
+      mac_address = MacAddress{{ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }};
+      return true;
+    }
+
+    return find_neighbor_mac_address(address, network_interface.name_, mac_address);
+  }
+}
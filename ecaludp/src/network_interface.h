@@ -0,0 +1,66 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  using MacAddress = std::array<uint8_t, 6>;
+
+  /**
+   * @brief Information about a (Linux) network interface that is needed to
+   *        capture or inject packets with AF_PACKET sockets
+   */
+  struct NetworkInterface
+  {
+    int         index_        {-1};
+    std::string name_;
+    bool        is_loopback_  {false};
+    MacAddress  mac_address_  {};
+    std::size_t mtu_          {0};
+  };
+
+  /**
+   * @brief Finds the interface that owns the given IPv4 address.
+   *
+   * The whole 127.0.0.0/8 network is considered to belong to the loopback
+   * interface.
+   *
+   * @return false, if no interface owns the address
+   */
+  bool find_network_interface(const asio::ip::address_v4& address, NetworkInterface& network_interface);
+
+  /**
+   * @brief Looks up the MAC address of a neighbor from the kernel's ARP table
+   *
+   * Only complete entries are considered. No ARP request is sent, if there
+   * is no entry, yet.
+   */
+  bool find_neighbor_mac_address(const asio::ip::address_v4& address, const std::string& interface_name, MacAddress& mac_address);
+
+  /**
+   * @brief Returns the MAC address that the given destination address is sent
+   *        to from the given interface (loopback, multicast, broadcast or a
+   *        neighbor from the ARP table).
+   */
+  bool resolve_destination_mac_address(const asio::ip::address_v4& address, const NetworkInterface& network_interface, MacAddress& mac_address);
+}
@@ -0,0 +1,788 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "packet_mmap_receiver.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_arp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+
+#include "network_interface.h"
+#include "udp_packet.h"
+
+namespace ecaludp
+{
+  namespace
+  {
+    constexpr std::size_t default_ring_size = 32 * 1024 * 1024;
+    constexpr std::size_t ring_block_size   = 1024 * 1024;              // Must be a multiple of the page size and large enough for the largest packet
+    constexpr std::size_t ring_frame_size   = 2048;
+    constexpr std::size_t min_ring_blocks   = 4;
+    constexpr unsigned    block_timeout_ms  = 1;                        // Maximum time the kernel keeps a partially filled block before handing it to us
+    constexpr uint32_t    max_capture_size  = 0x40000;
+    constexpr int         stall_timeout_ms  = 10;                       // Time to wait before checking for a stall, while blocks of the ring are still referenced
+
+    /**
+     * @brief Helper to build classic BPF programs with symbolic jump targets
+     */
+    class FilterBuilder
+    {
+    public:
+      enum Label : int
+      {
+        NEXT       = -1,
+        PORT_CHECK = 0,
+        DROP       = 1,
+      };
+
+      void statement(uint16_t code, uint32_t k)
+      {
+        instructions_.push_back({code, NEXT, NEXT, k});
+      }
+
+      void jump(uint16_t code, uint32_t k, int jump_true, int jump_false)
+      {
+        instructions_.push_back({code, jump_true, jump_false, k});
+      }
+
+      void label(Label label)
+      {
+        label_positions_[label] = instructions_.size();
+      }
+
+      bool build(std::vector<sock_filter>& program) const
+      {
+        program.clear();
+        program.reserve(instructions_.size());
+        for (std::size_t i = 0; i < instructions_.size(); ++i)
+        {
+          uint8_t jt = 0;
+          uint8_t jf = 0;
+          if (!resolve(i, instructions_[i].jump_true_, jt) || !resolve(i, instructions_[i].jump_false_, jf))
+            return false;
+          program.push_back(sock_filter{instructions_[i].code_, jt, jf, instructions_[i].k_});
+        }
+        return true;
+      }
+
+    private:
+      bool resolve(std::size_t index, int label, uint8_t& offset) const
+      {
+        if (label == NEXT)
+        {
+          offset = 0;
+          return true;
+        }
+
+        // Classic BPF can only jump forward by up to 255 instructions
+        const std::size_t target = label_positions_[label];
+        if ((target <= index) || (target - index - 1 > 255))
+          return false;
+
+        offset = static_cast<uint8_t>(target - index - 1);
+        return true;
+      }
+
+      struct Instruction
+      {
+        uint16_t code_;
+        int      jump_true_;
+        int      jump_false_;
+        uint32_t k_;
+      };
+
+      std::vector<Instruction> instructions_;
+      std::size_t              label_positions_[2] {0, 0};
+    };
+
+    /**
+     * @brief Creates a filter for IPv4 UDP packets (starting at the IP header)
+     *        to the given endpoint or the given multicast groups.
+     *
+     * Fragmented packets are dropped, as they cannot be parsed anyways.
+     */
+    bool create_filter(const asio::ip::udp::endpoint&           local_endpoint
+                      , const std::vector<asio::ip::address_v4>& multicast_groups
+                      , std::vector<sock_filter>&                 program)
+    {
+      FilterBuilder builder;
+
+      // IP protocol must be UDP
+      builder.statement(BPF_LD  | BPF_B   | BPF_ABS, 9);
+      builder.jump     (BPF_JMP | BPF_JEQ | BPF_K,   17, FilterBuilder::NEXT, FilterBuilder::DROP);
+
+      // Drop all fragments
+      builder.statement(BPF_LD  | BPF_H   | BPF_ABS, 6);
+      builder.jump     (BPF_JMP | BPF_JSET| BPF_K,   0x3FFF, FilterBuilder::DROP, FilterBuilder::NEXT);
+
+      // Destination address
+      const asio::ip::address_v4 local_address = local_endpoint.address().to_v4();
+      builder.statement(BPF_LD  | BPF_W   | BPF_ABS, 16);
+      for (const auto& group : multicast_groups)
+      {
+        builder.jump(BPF_JMP | BPF_JEQ | BPF_K, group.to_uint(), FilterBuilder::PORT_CHECK, FilterBuilder::NEXT);
+      }
+
+      if (local_address.is_unspecified())
+      {
+        // Accept all unicast and broadcast traffic, but only multicast traffic
+        // of the groups that we have joined
+        builder.statement(BPF_ALU | BPF_AND | BPF_K,   0xF0000000);
+        builder.jump     (BPF_JMP | BPF_JEQ | BPF_K,   0xE0000000, FilterBuilder::DROP, FilterBuilder::PORT_CHECK);
+      }
+      else
+      {
+        builder.jump     (BPF_JMP | BPF_JEQ | BPF_K,   local_address.to_uint(), FilterBuilder::PORT_CHECK, FilterBuilder::DROP);
+      }
+
+      // Destination port
+      builder.label(FilterBuilder::PORT_CHECK);
+      builder.statement(BPF_LDX | BPF_B   | BPF_MSH, 0);
+      builder.statement(BPF_LD  | BPF_H   | BPF_IND, 2);
+      builder.jump     (BPF_JMP | BPF_JEQ | BPF_K,   local_endpoint.port(), FilterBuilder::NEXT, FilterBuilder::DROP);
+      builder.statement(BPF_RET | BPF_K,             max_capture_size);
+
+      builder.label(FilterBuilder::DROP);
+      builder.statement(BPF_RET | BPF_K,             0);
+
+      return builder.build(program);
+    }
+
+    bool attach_filter(int fd, std::vector<sock_filter>& program)
+    {
+      sock_fprog filter_program{};
+      filter_program.len    = static_cast<unsigned short>(program.size());
+      filter_program.filter = program.data();
+
+      return (::setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter_program, sizeof(filter_program)) == 0);
+    }
+
+    bool attach_drop_all_filter(int fd)
+    {
+      std::vector<sock_filter> program{ sock_filter{BPF_RET | BPF_K, 0, 0, 0} };
+      return attach_filter(fd, program);
+    }
+
+    /**
+     * @brief Finds the interface that owns the given address.
+     *
+     * @return the interface index, 0 for the any address, or -1 if no interface was found
+     */
+    int find_interface_index(const asio::ip::address_v4& address)
+    {
+      if (address.is_unspecified() || address.is_multicast())
+        return 0;
+
+      NetworkInterface network_interface;
+      if (!find_network_interface(address, network_interface))
+        return -1;
+
+      return network_interface.index_;
+    }
+  }
+
+  /////////////////////////////////////////////////////
+  // Packet ring
+  /////////////////////////////////////////////////////
+
+  struct PacketMmapReceiver::PacketRing
+  {
+    PacketRing()
+      : fd_         (::socket(AF_PACKET, SOCK_DGRAM, 0)) // Protocol 0: Nothing is captured until we bind the socket
+      , map_        (nullptr)
+      , map_size_   (0)
+      , block_size_ (0)
+      , block_count_(0)
+      , blocks_in_use_(0)
+    {}
+
+    ~PacketRing()
+    {
+      if (map_ != nullptr)
+        ::munmap(map_, map_size_);
+      if (fd_ >= 0)
+        ::close(fd_);
+    }
+
+    // Disable copy and move
+    PacketRing(const PacketRing&)            = delete;
+    PacketRing(PacketRing&&)                 = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+    PacketRing& operator=(PacketRing&&)      = delete;
+
+    tpacket_block_desc* block(std::size_t index) const
+    {
+      return reinterpret_cast<tpacket_block_desc*>(static_cast<uint8_t*>(map_) + (index * block_size_));
+    }
+
+    bool is_block_ready(std::size_t index) const
+    {
+      // A block that is still held by the user keeps its old TP_STATUS_USER
+      // status, so we have to check that first.
+      if (block_held_[index].load(std::memory_order_acquire))
+        return false;
+      return ((__atomic_load_n(&block(index)->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) != 0);
+    }
+
+    // Returns whether the kernel has dropped packets or frozen the ring since
+    // the last call. The kernel resets the statistics when reading them.
+    bool kernel_dropped_packets() const
+    {
+      tpacket_stats_v3 stats{};
+      socklen_t        stats_size = sizeof(stats);
+      if (::getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &stats, &stats_size) != 0)
+        return false;
+      return (stats.tp_drops > 0) || (stats.tp_freeze_q_cnt > 0);
+    }
+
+    int                       fd_;
+    void*                     map_;
+    std::size_t               map_size_;
+    std::size_t               block_size_;
+    std::size_t               block_count_;
+    std::atomic<std::size_t>  blocks_in_use_;                   ///< Blocks that we have taken from the ring and not returned, yet
+    std::unique_ptr<std::atomic<bool>[]> block_held_;           ///< Per block: whether it has been taken from the ring and not returned, yet
+  };
+
+  /////////////////////////////////////////////////////
+  // Constructor/Destructor
+  /////////////////////////////////////////////////////
+
+  PacketMmapReceiver::PacketMmapReceiver()
+    : ring_                       (std::make_shared<PacketRing>())
+    , wakeup_event_fd_            (::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , membership_socket_fd_       (-1)
+    , ring_size_                  (default_ring_size)
+    , is_bound_                   (false)
+    , is_closed_                  (false)
+    , multicast_loopback_enabled_ (true)
+    , current_block_index_        (0)
+    , remaining_packets_in_block_ (0)
+    , next_packet_                (nullptr)
+  {}
+
+  PacketMmapReceiver::~PacketMmapReceiver()
+  {
+    // Close the socket and un-block the wait thread
+    close();
+
+    // Join the wait thread
+    if (wait_thread_)
+    {
+      wait_thread_->join();
+    }
+
+    if (wakeup_event_fd_ >= 0)
+      ::close(wakeup_event_fd_);
+  }
+
+  /////////////////////////////////////////////////////
+  // Socket-like API
+  /////////////////////////////////////////////////////
+
+  bool PacketMmapReceiver::is_valid() const
+  {
+    return (ring_->fd_ >= 0) && (wakeup_event_fd_ >= 0);
+  }
+
+  bool PacketMmapReceiver::bind(const asio::ip::udp::endpoint& local_endpoint)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!is_valid() || is_bound_ || is_closed_ || !local_endpoint.address().is_v4())
+      return false;
+
+    const int interface_index = find_interface_index(local_endpoint.address().to_v4());
+    if (interface_index < 0)
+      return false;
+
+    local_endpoint_ = local_endpoint;
+
+    // Attach the filter before binding, so we never capture unrelated packets
+    std::vector<sock_filter> program;
+    if (!create_filter(local_endpoint_, multicast_groups_, program) || !attach_filter(ring_->fd_, program))
+      return false;
+
+    // Create the ring
+    int version = TPACKET_V3;
+    if (::setsockopt(ring_->fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+      return false;
+
+    tpacket_req3 request{};
+    request.tp_block_size       = static_cast<unsigned int>(ring_block_size);
+    request.tp_block_nr         = static_cast<unsigned int>(std::max(min_ring_blocks, ring_size_ / ring_block_size));
+    request.tp_frame_size       = static_cast<unsigned int>(ring_frame_size);
+    request.tp_frame_nr         = static_cast<unsigned int>((ring_block_size / ring_frame_size) * request.tp_block_nr);
+    request.tp_retire_blk_tov   = block_timeout_ms;
+
+    if (::setsockopt(ring_->fd_, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0)
+      return false;
+
+    const std::size_t map_size = static_cast<std::size_t>(request.tp_block_size) * request.tp_block_nr;
+    void* map = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, ring_->fd_, 0);
+    if (map == MAP_FAILED)
+    {
+      // MAP_LOCKED may fail due to RLIMIT_MEMLOCK
+      map = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_->fd_, 0);
+      if (map == MAP_FAILED)
+        return false;
+    }
+
+    ring_->map_         = map;
+    ring_->map_size_    = map_size;
+    ring_->block_size_  = request.tp_block_size;
+    ring_->block_count_ = request.tp_block_nr;
+    ring_->block_held_  = std::make_unique<std::atomic<bool>[]>(ring_->block_count_);
+    for (std::size_t i = 0; i < ring_->block_count_; ++i)
+      ring_->block_held_[i].store(false);
+
+    // Start capturing
+    sockaddr_ll link_address{};
+    link_address.sll_family   = AF_PACKET;
+    link_address.sll_protocol = htons(ETH_P_IP);
+    link_address.sll_ifindex  = interface_index;
+
+    if (::bind(ring_->fd_, reinterpret_cast<const sockaddr*>(&link_address), sizeof(link_address)) != 0)
+      return false;
+
+    is_bound_ = true;
+
+    if (wait_thread_ && wait_thread_->joinable())
+    {
+      wait_thread_->join();
+    }
+
+    wait_thread_ = std::make_unique<std::thread>(&PacketMmapReceiver::wait_for_data, this);
+
+    return true;
+  }
+
+  bool PacketMmapReceiver::is_bound() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return is_bound_;
+  }
+
+  asio::ip::udp::endpoint PacketMmapReceiver::local_endpoint() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return local_endpoint_;
+  }
+
+  bool PacketMmapReceiver::set_receive_buffer_size(int size)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (is_bound_ || (size <= 0))
+      return false;
+
+    ring_size_ = static_cast<std::size_t>(size);
+    return true;
+  }
+
+  bool PacketMmapReceiver::join_multicast_group(const asio::ip::address_v4& group_address)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!is_bound_ || is_closed_ || !group_address.is_multicast())
+      return false;
+
+    if (std::find(multicast_groups_.begin(), multicast_groups_.end(), group_address) != multicast_groups_.end())
+      return true;
+
+    // Join the group with a regular UDP socket, so the network interface
+    // actually delivers the traffic to us
+    if (membership_socket_fd_ < 0)
+    {
+      membership_socket_fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+      if (membership_socket_fd_ < 0)
+        return false;
+    }
+
+    ip_mreq membership_request{};
+    membership_request.imr_multiaddr.s_addr = htonl(group_address.to_uint());
+    membership_request.imr_interface.s_addr = htonl(local_endpoint_.address().to_v4().is_multicast() ? INADDR_ANY : local_endpoint_.address().to_v4().to_uint());
+
+    if (::setsockopt(membership_socket_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership_request, sizeof(membership_request)) != 0)
+      return false;
+
+    multicast_groups_.push_back(group_address);
+
+    if (!update_filter_locked())
+    {
+      multicast_groups_.pop_back();
+      ::setsockopt(membership_socket_fd_, IPPROTO_IP, IP_DROP_MEMBERSHIP, &membership_request, sizeof(membership_request));
+      return false;
+    }
+
+    return true;
+  }
+
+  bool PacketMmapReceiver::leave_multicast_group(const asio::ip::address_v4& group_address)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    auto group_it = std::find(multicast_groups_.begin(), multicast_groups_.end(), group_address);
+    if (is_closed_ || (group_it == multicast_groups_.end()))
+      return false;
+
+    multicast_groups_.erase(group_it);
+    update_filter_locked();
+
+    ip_mreq membership_request{};
+    membership_request.imr_multiaddr.s_addr = htonl(group_address.to_uint());
+    membership_request.imr_interface.s_addr = htonl(local_endpoint_.address().to_v4().is_multicast() ? INADDR_ANY : local_endpoint_.address().to_v4().to_uint());
+
+    return (::setsockopt(membership_socket_fd_, IPPROTO_IP, IP_DROP_MEMBERSHIP, &membership_request, sizeof(membership_request)) == 0);
+  }
+
+  void PacketMmapReceiver::set_multicast_loopback_enabled(bool enabled)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    multicast_loopback_enabled_ = enabled;
+  }
+
+  bool PacketMmapReceiver::is_multicast_loopback_enabled() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return multicast_loopback_enabled_;
+  }
+
+  void PacketMmapReceiver::close()
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (is_closed_)
+      return;
+
+    is_closed_ = true;
+
+    // Stop capturing. The socket itself and the ring stay alive until all
+    // blocks have been returned.
+    if (ring_->fd_ >= 0)
+      attach_drop_all_filter(ring_->fd_);
+
+    // Closing the membership socket leaves all multicast groups
+    if (membership_socket_fd_ >= 0)
+    {
+      ::close(membership_socket_fd_);
+      membership_socket_fd_ = -1;
+    }
+    multicast_groups_.clear();
+
+    // Wake up blocking receive calls. The eventfd stays readable forever.
+    if (wakeup_event_fd_ >= 0)
+    {
+      const uint64_t value = 1;
+      const ssize_t  written = ::write(wakeup_event_fd_, &value, sizeof(value));
+      static_cast<void>(written);
+    }
+
+    wait_thread_trigger_cv_.notify_one();
+  }
+
+  bool PacketMmapReceiver::is_closed() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return is_closed_;
+  }
+
+  bool PacketMmapReceiver::update_filter_locked()
+  {
+    std::vector<sock_filter> program;
+    return create_filter(local_endpoint_, multicast_groups_, program) && attach_filter(ring_->fd_, program);
+  }
+
+  /////////////////////////////////////////////////////
+  // Receive methods
+  /////////////////////////////////////////////////////
+
+  void PacketMmapReceiver::receive_datagram(CapturedDatagram& datagram, ecaludp::Error& error)
+  {
+    const std::lock_guard<std::mutex> receive_lock(receive_mutex_);
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      if (is_closed_)
+      {
+        error = ecaludp::Error(ecaludp::Error::SOCKET_CLOSED);
+        return;
+      }
+      if (!is_bound_)
+      {
+        error = ecaludp::Error(ecaludp::Error::NOT_BOUND);
+        return;
+      }
+    }
+
+    while (!next_datagram_from_ring(datagram))
+    {
+      bool stalled = false;
+      if (!wait_for_next_block(stalled))
+      {
+        error = ecaludp::Error(ecaludp::Error::SOCKET_CLOSED);
+        return;
+      }
+
+      if (stalled)
+      {
+        // Return an empty datagram, so the caller gets the chance to release
+        // the block that we are waiting for
+        datagram = CapturedDatagram();
+        break;
+      }
+    }
+
+    error = ecaludp::Error(ecaludp::Error::OK);
+  }
+
+  void PacketMmapReceiver::async_receive_datagram(const ReceiveHandler& handler)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    async_receive_handlers_.push_back(handler);
+    wait_thread_trigger_cv_.notify_one();
+  }
+
+  bool PacketMmapReceiver::next_datagram_from_ring(CapturedDatagram& datagram)
+  {
+    bool multicast_loopback_enabled = true;
+    uint16_t local_port             = 0;
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      multicast_loopback_enabled = multicast_loopback_enabled_;
+      local_port                 = local_endpoint_.port();
+    }
+
+    while (true)
+    {
+      if (remaining_packets_in_block_ == 0)
+      {
+        // Return the current block to the kernel (as soon as nobody references it anymore)
+        if (current_block_)
+        {
+          current_block_.reset();
+          current_block_index_ = (current_block_index_ + 1) % ring_->block_count_;
+        }
+
+        if (!ring_->is_block_ready(current_block_index_))
+          return false;
+
+        tpacket_block_desc* block = ring_->block(current_block_index_);
+
+        // Keep the ring alive as long as the block is in use
+        const std::shared_ptr<PacketRing> ring        = ring_;
+        const std::size_t                 block_index = current_block_index_;
+        ring->block_held_[block_index].store(true, std::memory_order_relaxed);
+        ring->blocks_in_use_++;
+        current_block_ = std::shared_ptr<void const>(block, [ring, block_index](const void* block_ptr)
+                                                            {
+                                                              auto* block_desc = static_cast<tpacket_block_desc*>(const_cast<void*>(block_ptr));
+                                                              __atomic_store_n(&block_desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+                                                              ring->block_held_[block_index].store(false, std::memory_order_release);
+                                                              ring->blocks_in_use_--;
+                                                            });
+
+        remaining_packets_in_block_ = block->hdr.bh1.num_pkts;
+        next_packet_                = reinterpret_cast<const uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+        continue;
+      }
+
+      const auto* packet_header = reinterpret_cast<const tpacket3_hdr*>(next_packet_);
+      const auto* link_address  = reinterpret_cast<const sockaddr_ll*>(next_packet_ + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+      const uint8_t* packet     = next_packet_ + packet_header->tp_net;
+      const std::size_t packet_size = packet_header->tp_snaplen - (packet_header->tp_net - packet_header->tp_mac);
+
+      next_packet_ += packet_header->tp_next_offset;
+      remaining_packets_in_block_--;
+
+      // Outgoing packets are only of interest for looped back multicast
+      // traffic. On the loopback interface, each packet is captured twice
+      // (outgoing and incoming), so we always use the incoming one there.
+      if (link_address->sll_pkttype == PACKET_OTHERHOST)
+        continue;
+
+      UdpPacketView udp_packet;
+      if (!parse_ipv4_udp_packet(packet, packet_size, udp_packet))
+        continue;
+
+      if (udp_packet.destination_.port() != local_port)
+        continue;
+
+      if (link_address->sll_pkttype == PACKET_OUTGOING)
+      {
+        if ((link_address->sll_hatype == ARPHRD_LOOPBACK)
+            || !multicast_loopback_enabled
+            || !udp_packet.destination_.address().is_multicast())
+        {
+          continue;
+        }
+      }
+
+      datagram.sender_endpoint_ = udp_packet.source_;
+
+      if (ring_->blocks_in_use_.load() <= (ring_->block_count_ / 2))
+      {
+        datagram.data_  = udp_packet.payload_;
+        datagram.size_  = udp_packet.payload_size_;
+        datagram.owner_ = current_block_;
+      }
+      else
+      {
+        // Too many blocks are held by the user (e.g. incomplete messages in
+        // the reassembly). Copy the datagram, so the kernel doesn't run out
+        // of free blocks.
+        auto copy = std::make_shared<std::vector<uint8_t>>(udp_packet.payload_, udp_packet.payload_ + udp_packet.payload_size_);
+        datagram.data_  = copy->data();
+        datagram.size_  = copy->size();
+        datagram.owner_ = std::move(copy);
+      }
+
+      return true;
+    }
+  }
+
+  bool PacketMmapReceiver::wait_for_next_block(bool& stalled)
+  {
+    const auto wait_start = std::chrono::steady_clock::now();
+
+    // The kernel cannot write to a block that is still held by the user (it
+    // drops packets instead), and it will not wake us up in that case. While
+    // blocks are held, we therefore check for a stall after a short time.
+    // A sender that merely pauses is no stall, so the held blocks are only
+    // reported, if the kernel is really blocked by them.
+    bool stall_check_pending = (ring_->blocks_in_use_.load(std::memory_order_acquire) > 0);
+
+    while (true)
+    {
+      {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (is_closed_)
+          return false;
+      }
+
+      // The current block may still be referenced by us, although all
+      // packets have been read. Release it, so we can check the next one.
+      if (current_block_ && (remaining_packets_in_block_ == 0))
+      {
+        current_block_.reset();
+        current_block_index_ = (current_block_index_ + 1) % ring_->block_count_;
+      }
+
+      if (ring_->is_block_ready(current_block_index_))
+        return true;
+
+      int poll_timeout_ms = -1;
+      if (stall_check_pending)
+      {
+        const auto waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - wait_start).count();
+        if (waited_ms >= stall_timeout_ms)
+        {
+          // The ring is stalled, if the block the kernel is filling or the
+          // one it fills next is held, if (almost) all blocks are held, or if
+          // the kernel has dropped packets since the last check. In the
+          // latter case, the held fragments are most likely incomplete
+          // forever.
+          const std::size_t next_block_index = (current_block_index_ + 1) % ring_->block_count_;
+          stall_check_pending = false;
+          if (ring_->block_held_[current_block_index_].load(std::memory_order_acquire)
+              || ring_->block_held_[next_block_index].load(std::memory_order_acquire)
+              || (ring_->blocks_in_use_.load(std::memory_order_acquire) + 1 >= ring_->block_count_)
+              || ring_->kernel_dropped_packets())
+          {
+            stalled = true;
+            return true;
+          }
+        }
+        else
+        {
+          poll_timeout_ms = static_cast<int>(stall_timeout_ms - waited_ms);
+        }
+      }
+
+      std::array<pollfd, 2> poll_fds{};
+      poll_fds[0].fd     = ring_->fd_;
+      poll_fds[0].events = POLLIN | POLLERR;
+      poll_fds[1].fd     = wakeup_event_fd_;
+      poll_fds[1].events = POLLIN;
+
+      const int poll_result = ::poll(poll_fds.data(), poll_fds.size(), poll_timeout_ms);
+      if ((poll_result < 0) && (errno != EINTR))
+        return false;
+
+      // The kernel also reports the socket as readable, if the block before
+      // the one it is currently filling hasn't been returned by us. Don't
+      // spin in that case, but give the kernel the chance to retire the
+      // block it is filling.
+      if ((poll_result > 0) && ((poll_fds[1].revents & POLLIN) == 0) && !ring_->is_block_ready(current_block_index_))
+        std::this_thread::sleep_for(std::chrono::milliseconds(block_timeout_ms));
+    }
+  }
+
+  void PacketMmapReceiver::wait_for_data()
+  {
+    while (true)
+    {
+      ReceiveHandler next_handler;
+
+      // Wait until there is somebody requesting some data. This is done by waiting for the handler queue to be non-empty.
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        wait_thread_trigger_cv_.wait(lock, [this] { return is_closed_ || !async_receive_handlers_.empty(); });
+
+        if (async_receive_handlers_.empty() && is_closed_)
+        {
+          return;
+        }
+
+        next_handler = std::move(async_receive_handlers_.front());
+        async_receive_handlers_.pop_front();
+      }
+
+      CapturedDatagram datagram;
+      ecaludp::Error   error = ecaludp::Error::GENERIC_ERROR;
+      receive_datagram(datagram, error);
+
+      next_handler(error, datagram);
+    }
+  }
+}
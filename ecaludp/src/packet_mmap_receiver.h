@@ -0,0 +1,175 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+
+namespace ecaludp
+{
+  /**
+   * @brief A UDP payload that has been captured from a packet ring
+   *
+   * The data points into a block of the ring (or into a copy of the datagram,
+   * if the ring is running out of free blocks). The owner keeps that memory
+   * alive.
+   */
+  struct CapturedDatagram
+  {
+    const void*                 data_  {nullptr};
+    std::size_t                 size_  {0};
+    std::shared_ptr<void const> owner_;
+    asio::ip::udp::endpoint     sender_endpoint_;
+  };
+
+  /**
+   * @brief Captures UDP datagrams from a memory mapped TPACKET_V3 ring (Linux only)
+   *
+   * This is the Linux counterpart of the AsyncUdpcapSocket. An AF_PACKET
+   * socket captures all IPv4 packets of one interface (or all interfaces, if
+   * bound to the any address), a BPF filter drops everything that is not
+   * addressed to the bound port (and address / joined multicast groups).
+   * The kernel writes the packets into blocks of a ring buffer that is shared
+   * with the user space, so receiving doesn't need any syscall or copy, as
+   * long as there are packets in the ring.
+   *
+   * A block is handed back to the kernel as soon as all datagrams in it have
+   * been released. As long as a block is not handed back, the kernel cannot
+   * write to it. To keep the ring from running full (e.g. because many
+   * incomplete messages are kept by the reassembly), datagrams are copied as
+   * soon as more than half of the blocks are in use. Still, a block that is
+   * referenced for a long time stalls the ring, once the kernel has wrapped
+   * around to it.
+   *
+   * Capturing requires CAP_NET_RAW. Multiple processes can capture the same
+   * traffic at the same time.
+   */
+  class PacketMmapReceiver
+  {
+  /////////////////////////////////////////////////////
+  // Private types
+  /////////////////////////////////////////////////////
+  private:
+    struct PacketRing;
+
+    using ReceiveHandler = std::function<void(const ecaludp::Error&, const CapturedDatagram&)>;
+
+  /////////////////////////////////////////////////////
+  // Constructor/Destructor
+  /////////////////////////////////////////////////////
+  public:
+    PacketMmapReceiver();
+    ~PacketMmapReceiver();
+
+    // Disable copy and move
+    PacketMmapReceiver(const PacketMmapReceiver&)            = delete;
+    PacketMmapReceiver(PacketMmapReceiver&&)                 = delete;
+    PacketMmapReceiver& operator=(const PacketMmapReceiver&) = delete;
+    PacketMmapReceiver& operator=(PacketMmapReceiver&&)      = delete;
+
+  /////////////////////////////////////////////////////
+  // Socket-like API
+  /////////////////////////////////////////////////////
+  public:
+    bool is_valid() const;
+    bool bind(const asio::ip::udp::endpoint& local_endpoint); // This also starts the wait thread for async receive
+    bool is_bound() const;
+    asio::ip::udp::endpoint local_endpoint() const;
+
+    /**
+     * @brief Sets the size of the packet ring. Must be called before bind().
+     */
+    bool set_receive_buffer_size(int size);
+
+    bool join_multicast_group(const asio::ip::address_v4& group_address);
+    bool leave_multicast_group(const asio::ip::address_v4& group_address);
+    void set_multicast_loopback_enabled(bool enabled);
+    bool is_multicast_loopback_enabled() const;
+    void close();
+    bool is_closed() const;
+
+  /////////////////////////////////////////////////////
+  // Receive methods
+  /////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Blocks until the next datagram has been captured or the receiver is closed
+     *
+     * If the ring is stalled by blocks that are still referenced (e.g. by an
+     * incomplete message in the reassembly), an empty datagram
+     * (data_ == nullptr) is returned. The ring is considered stalled, if no
+     * new datagram arrives within a short time and the kernel is (about to
+     * be) blocked: The block it is filling or the one it fills next is
+     * referenced, (almost) all blocks are referenced, or it has dropped
+     * packets. The caller should use that chance to release old datagrams.
+     */
+    void receive_datagram(CapturedDatagram& datagram, ecaludp::Error& error);
+
+    /**
+     * @brief Receives the next datagram asynchronously
+     *
+     * The handler is called from the wait thread.
+     */
+    void async_receive_datagram(const ReceiveHandler& handler);
+
+  private:
+    bool next_datagram_from_ring(CapturedDatagram& datagram);
+
+    bool wait_for_next_block(bool& stalled);
+
+    bool update_filter_locked();
+
+    void wait_for_data();
+
+  /////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////
+  private:
+    mutable std::mutex                      mutex_;
+    std::shared_ptr<PacketRing>             ring_;                      ///< The ring and the AF_PACKET socket. Shared with the blocks that are in use.
+    int                                     wakeup_event_fd_;           ///< Wakes up a blocking receive_datagram() on close
+    int                                     membership_socket_fd_;      ///< A UDP socket that holds the multicast group memberships
+    std::size_t                             ring_size_;
+    bool                                    is_bound_;
+    bool                                    is_closed_;
+    asio::ip::udp::endpoint                 local_endpoint_;
+    std::vector<asio::ip::address_v4>       multicast_groups_;
+    bool                                    multicast_loopback_enabled_;
+
+    // State of the reader. Only accessed by the thread that receives.
+    std::mutex                              receive_mutex_;
+    std::size_t                             current_block_index_;
+    std::shared_ptr<void const>             current_block_;             ///< Keeps the current block from being returned to the kernel
+    std::size_t                             remaining_packets_in_block_;
+    const uint8_t*                          next_packet_;
+
+    // Async receiving
+    std::unique_ptr<std::thread>            wait_thread_;
+    std::condition_variable                 wait_thread_trigger_cv_;
+    std::deque<ReceiveHandler>              async_receive_handlers_;
+  };
+}
@@ -0,0 +1,371 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "packet_mmap_transmitter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "network_interface.h"
+#include "protocol/datagram_description.h"
+#include "udp_packet.h"
+
+namespace ecaludp
+{
+  namespace
+  {
+    constexpr std::size_t default_ring_size   = 8 * 1024 * 1024;
+    constexpr std::size_t min_ring_block_size = 1024 * 1024;            // Must be a multiple of the page size
+    constexpr std::size_t min_ring_frames     = 16;
+    constexpr std::size_t frame_data_offset   = TPACKET2_HDRLEN - sizeof(sockaddr_ll);
+    constexpr int         poll_timeout_ms     = 100;                    // Used to check whether the transmitter has been closed while waiting
+    constexpr uint8_t     unicast_ttl         = 64;
+    constexpr uint8_t     multicast_ttl       = 1;
+
+    tpacket2_hdr* frame_header(void* ring, std::size_t block_size, std::size_t frames_per_block, std::size_t frame_size, std::size_t frame_index)
+    {
+      const std::size_t block_index     = frame_index / frames_per_block;
+      const std::size_t index_in_block  = frame_index % frames_per_block;
+      return reinterpret_cast<tpacket2_hdr*>(static_cast<uint8_t*>(ring) + (block_index * block_size) + (index_in_block * frame_size));
+    }
+
+    bool is_frame_available(const tpacket2_hdr* header)
+    {
+      // Frames that the kernel has rejected (TP_STATUS_WRONG_FORMAT) can be reused, as we use PACKET_LOSS
+      const uint32_t status = __atomic_load_n(&header->tp_status, __ATOMIC_ACQUIRE);
+      return (status == TP_STATUS_AVAILABLE) || (status == TP_STATUS_WRONG_FORMAT);
+    }
+  }
+
+  /////////////////////////////////////////////////////
+  // Constructor/Destructor
+  /////////////////////////////////////////////////////
+
+  PacketMmapTransmitter::PacketMmapTransmitter()
+    : fd_                     (::socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0)) // Protocol 0: We never receive anything
+    , ring_                   (nullptr)
+    , ring_map_size_          (0)
+    , ring_size_              (default_ring_size)
+    , frame_size_             (0)
+    , frame_count_            (0)
+    , frames_per_block_       (0)
+    , block_size_             (0)
+    , next_frame_index_       (0)
+    , pending_frames_         (0)
+    , is_bound_               (false)
+    , is_closed_              (false)
+    , max_udp_datagram_size_  (0)
+    , next_ip_id_             (0)
+    , cached_destination_mac_ {}
+    , has_cached_destination_ (false)
+  {}
+
+  PacketMmapTransmitter::~PacketMmapTransmitter()
+  {
+    {
+      // Hand all pending frames to the kernel. The kernel keeps references
+      // to the ring memory of frames that are still being sent, so we can
+      // unmap the ring right afterwards.
+      const std::lock_guard<std::mutex> lock(mutex_);
+      asio::error_code ec;
+      flush_locked(ec);
+    }
+
+    if (ring_ != nullptr)
+      ::munmap(ring_, ring_map_size_);
+    if (fd_ >= 0)
+      ::close(fd_);
+  }
+
+  /////////////////////////////////////////////////////
+  // Socket-like API
+  /////////////////////////////////////////////////////
+
+  bool PacketMmapTransmitter::is_valid() const
+  {
+    return (fd_ >= 0);
+  }
+
+  bool PacketMmapTransmitter::bind(const asio::ip::udp::endpoint& local_endpoint, std::size_t max_udp_datagram_size)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!is_valid() || is_bound_ || is_closed_ || !local_endpoint.address().is_v4())
+      return false;
+
+    NetworkInterface network_interface;
+    if (!find_network_interface(local_endpoint.address().to_v4(), network_interface))
+      return false;
+
+    // We never fragment on IP level
+    if (ipv4_header_size + udp_header_size + max_udp_datagram_size > network_interface.mtu_)
+      return false;
+
+    int version = TPACKET_V2;
+    if (::setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+      return false;
+
+    // Skip malformed frames instead of stopping the transmission
+    int discard_malformed = 1;
+    if (::setsockopt(fd_, SOL_PACKET, PACKET_LOSS, &discard_malformed, sizeof(discard_malformed)) != 0)
+      return false;
+
+    const std::size_t frame_size       = TPACKET_ALIGN(frame_data_offset + ethernet_header_size + ipv4_header_size + udp_header_size + max_udp_datagram_size);
+    const std::size_t block_size       = std::max(min_ring_block_size, ((frame_size + min_ring_block_size - 1) / min_ring_block_size) * min_ring_block_size);
+    const std::size_t frames_per_block = block_size / frame_size;
+    const std::size_t block_count      = std::max(ring_size_ / block_size, (min_ring_frames + frames_per_block - 1) / frames_per_block);
+
+    tpacket_req request{};
+    request.tp_block_size = static_cast<unsigned int>(block_size);
+    request.tp_block_nr   = static_cast<unsigned int>(block_count);
+    request.tp_frame_size = static_cast<unsigned int>(frame_size);
+    request.tp_frame_nr   = static_cast<unsigned int>(frames_per_block * block_count);
+
+    if (::setsockopt(fd_, SOL_PACKET, PACKET_TX_RING, &request, sizeof(request)) != 0)
+      return false;
+
+    const std::size_t map_size = block_size * block_count;
+    void* map = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED)
+      return false;
+
+    ring_             = map;
+    ring_map_size_    = map_size;
+    block_size_       = block_size;
+    frame_size_       = frame_size;
+    frames_per_block_ = frames_per_block;
+    frame_count_      = frames_per_block * block_count;
+
+    // Binding the socket to the interface makes send() use it for all frames
+    sockaddr_ll link_address{};
+    link_address.sll_family   = AF_PACKET;
+    link_address.sll_protocol = htons(ETH_P_IP);
+    link_address.sll_ifindex  = network_interface.index_;
+
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&link_address), sizeof(link_address)) != 0)
+      return false;
+
+    network_interface_      = network_interface;
+    local_endpoint_         = local_endpoint;
+    max_udp_datagram_size_  = max_udp_datagram_size;
+    next_ip_id_             = static_cast<uint16_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    is_bound_               = true;
+
+    return true;
+  }
+
+  bool PacketMmapTransmitter::is_bound() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return is_bound_;
+  }
+
+  asio::ip::udp::endpoint PacketMmapTransmitter::local_endpoint() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return local_endpoint_;
+  }
+
+  bool PacketMmapTransmitter::set_send_buffer_size(int size)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (is_bound_ || (size <= 0))
+      return false;
+
+    ring_size_ = static_cast<std::size_t>(size);
+    return true;
+  }
+
+  void PacketMmapTransmitter::close()
+  {
+    is_closed_ = true;
+  }
+
+  /////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////
+
+  std::size_t PacketMmapTransmitter::write_datagrams(const DatagramList& datagram_list, const asio::ip::udp::endpoint& destination, asio::error_code& ec)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (is_closed_)
+    {
+      ec = asio::error::bad_descriptor;
+      return 0;
+    }
+    if (!is_bound_)
+    {
+      ec = asio::error::not_connected;
+      return 0;
+    }
+    if (!destination.address().is_v4())
+    {
+      ec = asio::error::address_family_not_supported;
+      return 0;
+    }
+
+    MacAddress destination_mac{};
+    if (!resolve_destination_locked(destination.address().to_v4(), destination_mac))
+    {
+      ec = asio::error::host_unreachable;
+      return 0;
+    }
+
+    const uint8_t ttl = (destination.address().is_multicast() ? multicast_ttl : unicast_ttl);
+
+    std::size_t bytes_written = 0;
+
+    for (const auto& datagram : datagram_list)
+    {
+      const std::size_t payload_size = datagram.size();
+      if (payload_size > max_udp_datagram_size_)
+      {
+        ec = asio::error::message_size;
+        return bytes_written;
+      }
+
+      uint8_t* frame_data = wait_for_free_frame_locked(ec);
+      if (frame_data == nullptr)
+        return bytes_written;
+
+      const std::size_t header_size = write_ethernet_ipv4_udp_headers(frame_data
+                                                                    , network_interface_.mac_address_
+                                                                    , destination_mac
+                                                                    , local_endpoint_
+                                                                    , destination
+                                                                    , next_ip_id_++
+                                                                    , ttl
+                                                                    , payload_size);
+
+      uint8_t* payload = frame_data + header_size;
+      for (const auto& buffer : datagram.asio_buffer_list_)
+      {
+        std::memcpy(payload, buffer.data(), buffer.size());
+        payload += buffer.size();
+      }
+
+      // Hand the frame to the kernel
+      auto* header = frame_header(ring_, block_size_, frames_per_block_, frame_size_, next_frame_index_);
+      header->tp_len = static_cast<uint32_t>(header_size + payload_size);
+      __atomic_store_n(&header->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+
+      next_frame_index_ = (next_frame_index_ + 1) % frame_count_;
+      pending_frames_++;
+      bytes_written += payload_size;
+    }
+
+    ec = asio::error_code();
+    return bytes_written;
+  }
+
+  void PacketMmapTransmitter::flush(asio::error_code& ec)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    flush_locked(ec);
+  }
+
+  uint8_t* PacketMmapTransmitter::wait_for_free_frame_locked(asio::error_code& ec)
+  {
+    auto* header = frame_header(ring_, block_size_, frames_per_block_, frame_size_, next_frame_index_);
+
+    while (!is_frame_available(header))
+    {
+      if (is_closed_)
+      {
+        ec = asio::error::bad_descriptor;
+        return nullptr;
+      }
+
+      // The ring is full. Send everything we have and wait for the kernel.
+      flush_locked(ec);
+      if (ec)
+        return nullptr;
+
+      if (is_frame_available(header))
+        break;
+
+      pollfd poll_fd{};
+      poll_fd.fd     = fd_;
+      poll_fd.events = POLLOUT;
+
+      if ((::poll(&poll_fd, 1, poll_timeout_ms) < 0) && (errno != EINTR))
+      {
+        ec = asio::error_code(errno, asio::error::get_system_category());
+        return nullptr;
+      }
+    }
+
+    return reinterpret_cast<uint8_t*>(header) + frame_data_offset;
+  }
+
+  void PacketMmapTransmitter::flush_locked(asio::error_code& ec)
+  {
+    ec = asio::error_code();
+
+    if (pending_frames_ == 0)
+      return;
+
+    // A send() without data sends all frames with TP_STATUS_SEND_REQUEST
+    while (::send(fd_, nullptr, 0, MSG_DONTWAIT) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      // The queue of the device is full. The frames stay in the ring and are
+      // sent with the next flush.
+      if ((errno == EAGAIN) || (errno == ENOBUFS))
+        return;
+
+      ec = asio::error_code(errno, asio::error::get_system_category());
+      return;
+    }
+
+    pending_frames_ = 0;
+  }
+
+  bool PacketMmapTransmitter::resolve_destination_locked(const asio::ip::address_v4& destination, MacAddress& mac_address)
+  {
+    if (has_cached_destination_ && (cached_destination_ == destination))
+    {
+      mac_address = cached_destination_mac_;
+      return true;
+    }
+
+    if (!resolve_destination_mac_address(destination, network_interface_, mac_address))
+      return false;
+
+    cached_destination_     = destination;
+    cached_destination_mac_ = mac_address;
+    has_cached_destination_ = true;
+    return true;
+  }
+}
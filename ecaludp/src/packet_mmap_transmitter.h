@@ -0,0 +1,136 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "network_interface.h"
+#include "protocol/datagram_description.h"
+
+namespace ecaludp
+{
+  /**
+   * @brief Sends UDP datagrams by writing complete Ethernet frames to a memory
+   *        mapped PACKET_TX_RING (Linux only)
+   *
+   * The frames are written to the ring without any syscall. The kernel is
+   * only told to send them (with one send() call for all pending frames)
+   * when the ring is full or when flush() is called. This bypasses the UDP
+   * and IP layer of the kernel completely, so the frames are also not
+   * subject to the routing table: they are always sent on the interface
+   * that owns the bound address.
+   *
+   * Sending requires CAP_NET_RAW.
+   */
+  class PacketMmapTransmitter
+  {
+  /////////////////////////////////////////////////////
+  // Constructor/Destructor
+  /////////////////////////////////////////////////////
+  public:
+    PacketMmapTransmitter();
+    ~PacketMmapTransmitter();
+
+    // Disable copy and move
+    PacketMmapTransmitter(const PacketMmapTransmitter&)            = delete;
+    PacketMmapTransmitter(PacketMmapTransmitter&&)                 = delete;
+    PacketMmapTransmitter& operator=(const PacketMmapTransmitter&) = delete;
+    PacketMmapTransmitter& operator=(PacketMmapTransmitter&&)      = delete;
+
+  /////////////////////////////////////////////////////
+  // Socket-like API
+  /////////////////////////////////////////////////////
+  public:
+    bool is_valid() const;
+
+    /**
+     * @brief Creates the ring for the interface that owns the given address.
+     *
+     * The address and port are used as source of all datagrams.
+     * max_udp_datagram_size is used to size the frames of the ring. It must
+     * fit into the MTU of the interface, as the frames are never fragmented.
+     */
+    bool bind(const asio::ip::udp::endpoint& local_endpoint, std::size_t max_udp_datagram_size);
+    bool is_bound() const;
+    asio::ip::udp::endpoint local_endpoint() const;
+
+    /**
+     * @brief Sets the size of the ring. Must be called before bind().
+     */
+    bool set_send_buffer_size(int size);
+
+    void close();
+
+  /////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Writes all datagrams to the ring. If the ring is full, the
+     *        pending frames are flushed and the function blocks until there
+     *        is space in the ring again.
+     *
+     * @return The number of UDP payload bytes written to the ring
+     */
+    std::size_t write_datagrams(const DatagramList& datagram_list, const asio::ip::udp::endpoint& destination, asio::error_code& ec);
+
+    /**
+     * @brief Tells the kernel to send all frames that have been written to the ring
+     */
+    void flush(asio::error_code& ec);
+
+  private:
+    uint8_t* wait_for_free_frame_locked(asio::error_code& ec);
+
+    void flush_locked(asio::error_code& ec);
+
+    bool resolve_destination_locked(const asio::ip::address_v4& destination, MacAddress& mac_address);
+
+  /////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////
+  private:
+    mutable std::mutex          mutex_;
+    int                         fd_;
+    void*                       ring_;
+    std::size_t                 ring_map_size_;
+    std::size_t                 ring_size_;
+    std::size_t                 frame_size_;
+    std::size_t                 frame_count_;
+    std::size_t                 frames_per_block_;
+    std::size_t                 block_size_;
+    std::size_t                 next_frame_index_;
+    std::size_t                 pending_frames_;                ///< Frames that have been written, but not flushed
+
+    bool                        is_bound_;
+    std::atomic<bool>           is_closed_;                     ///< Atomic, as close() must not wait for a blocking write_datagrams()
+    asio::ip::udp::endpoint     local_endpoint_;
+    NetworkInterface            network_interface_;
+    std::size_t                 max_udp_datagram_size_;
+    uint16_t                    next_ip_id_;
+
+    // The last resolved destination. Resolving unicast destinations means
+    // reading the ARP table, so we don't want to do that for each message.
+    asio::ip::address_v4        cached_destination_;
+    MacAddress                  cached_destination_mac_;
+    bool                        has_cached_destination_;
+  };
+}
@@ -0,0 +1,62 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecaludp
+{
+  // Link types of the captured packets (see https://www.tcpdump.org/linktypes.html)
+  constexpr uint32_t link_type_null       = 0;      ///< BSD loopback: 4 byte address family in host byte order
+  constexpr uint32_t link_type_ethernet   = 1;
+  constexpr uint32_t link_type_raw        = 101;    ///< Raw IP packets
+  constexpr uint32_t link_type_loop       = 108;    ///< OpenBSD loopback: 4 byte address family in network byte order
+  constexpr uint32_t link_type_linux_sll  = 113;    ///< Linux "cooked" capture
+  constexpr uint32_t link_type_ipv4       = 228;
+  constexpr uint32_t link_type_linux_sll2 = 276;    ///< Linux "cooked" capture v2
+
+  // Classic pcap format. The file is written in the byte order of the
+  // machine, which the reader detects from the magic number.
+  constexpr uint32_t    pcap_magic_microseconds = 0xA1B2C3D4;
+  constexpr uint32_t    pcap_magic_nanoseconds  = 0xA1B23C4D;
+  constexpr uint16_t    pcap_version_major      = 2;
+  constexpr uint16_t    pcap_version_minor      = 4;
+  constexpr std::size_t pcap_file_header_size   = 24;
+  constexpr std::size_t pcap_record_header_size = 16;
+
+  struct PcapFileHeader
+  {
+    uint32_t magic_number;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t  this_zone;                 ///< Always 0
+    uint32_t sigfigs;                   ///< Always 0
+    uint32_t snap_length;
+    uint32_t link_type;
+  };
+
+  struct PcapRecordHeader
+  {
+    uint32_t timestamp_seconds;
+    uint32_t timestamp_fraction;        ///< Micro- or nanoseconds, depending on the magic number
+    uint32_t captured_size;
+    uint32_t original_size;
+  };
+
+  static_assert(sizeof(PcapFileHeader)   == pcap_file_header_size,   "Unexpected padding in PcapFileHeader");
+  static_assert(sizeof(PcapRecordHeader) == pcap_record_header_size, "Unexpected padding in PcapRecordHeader");
+}
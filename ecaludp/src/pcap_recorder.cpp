@@ -0,0 +1,245 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "pcap_recorder.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "pcap_format.h"
+#include "udp_packet.h"
+
+#include <ecaludp/error.h>
+
+namespace ecaludp
+{
+  namespace
+  {
+    // The synthesized IPv4 total length and UDP length fields are 16 bit wide
+    constexpr std::size_t max_datagram_size = 65535 - ipv4_header_size - udp_header_size;
+
+    // Size of a record in the ring: pcap record header, IPv4 and UDP header, payload
+    constexpr std::size_t record_overhead = pcap_record_header_size + ipv4_header_size + udp_header_size;
+
+    // The writer wakes up at least that often. When the ring is half full,
+    // the producer wakes it up early.
+    constexpr auto writer_interval = std::chrono::milliseconds(10);
+
+    uint64_t next_power_of_two(uint64_t value)
+    {
+      uint64_t power = 1;
+      while (power < value)
+        power <<= 1;
+      return power;
+    }
+  }
+
+  PcapRecorder::PcapRecorder(std::size_t ring_size)
+    : ring_                (next_power_of_two(std::max<uint64_t>(ring_size, 2 * (record_overhead + max_datagram_size))))
+    , ring_mask_           (ring_.size() - 1)
+    , write_position_      (0)
+    , cached_read_position_(0)
+    , cache_line_padding_  {}
+    , read_position_       (0)
+    , dropped_datagrams_   (0)
+    , file_                (nullptr)
+    , ip_id_               (0)
+    , writer_stop_         (false)
+  {}
+
+  PcapRecorder::~PcapRecorder()
+  {
+    close();
+  }
+
+  bool PcapRecorder::open(const std::string& file_path, ecaludp::Error& error)
+  {
+    close();
+
+    file_ = std::fopen(file_path.c_str(), "wb");
+    if (file_ == nullptr)
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Unable to create " + file_path + ": " + std::strerror(errno));
+      return false;
+    }
+
+    // The ring already collects the data into large chunks, so the stdio
+    // buffer would only add another copy.
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    PcapFileHeader header{};
+    header.magic_number  = pcap_magic_nanoseconds;
+    header.version_major = pcap_version_major;
+    header.version_minor = pcap_version_minor;
+    header.snap_length   = static_cast<uint32_t>(ipv4_header_size + udp_header_size + max_datagram_size);
+    header.link_type     = link_type_raw;
+
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Unable to write to " + file_path + ": " + std::strerror(errno));
+      std::fclose(file_);
+      file_ = nullptr;
+      return false;
+    }
+
+    write_position_.store(0);
+    cached_read_position_ = 0;
+    read_position_.store(0);
+    dropped_datagrams_.store(0);
+
+    writer_stop_   = false;
+    writer_thread_ = std::make_unique<std::thread>(&PcapRecorder::writer_loop, this);
+
+    error = ecaludp::Error::OK;
+    return true;
+  }
+
+  void PcapRecorder::close()
+  {
+    if (writer_thread_)
+    {
+      {
+        const std::lock_guard<std::mutex> lock(writer_mutex_);
+        writer_stop_ = true;
+      }
+      writer_cv_.notify_all();
+      writer_thread_->join();
+      writer_thread_.reset();
+    }
+
+    if (file_ != nullptr)
+    {
+      std::fclose(file_);
+      file_ = nullptr;
+    }
+  }
+
+  bool PcapRecorder::is_open() const
+  {
+    return file_ != nullptr;
+  }
+
+  void PcapRecorder::record(const void* data, std::size_t size, const asio::ip::udp::endpoint& source, const asio::ip::udp::endpoint& destination)
+  {
+    if ((size > max_datagram_size) || !source.address().is_v4() || !destination.address().is_v4())
+      return;
+
+    const uint64_t record_size    = record_overhead + size;
+    const uint64_t write_position = write_position_.load(std::memory_order_relaxed);
+
+    if (ring_.size() - (write_position - cached_read_position_) < record_size)
+    {
+      cached_read_position_ = read_position_.load(std::memory_order_acquire);
+      if (ring_.size() - (write_position - cached_read_position_) < record_size)
+      {
+        dropped_datagrams_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+
+    const auto timestamp = std::chrono::system_clock::now().time_since_epoch();
+    const auto seconds   = std::chrono::duration_cast<std::chrono::seconds>(timestamp);
+
+    std::array<uint8_t, record_overhead> headers{};
+
+    PcapRecordHeader record_header{};
+    record_header.timestamp_seconds  = static_cast<uint32_t>(seconds.count());
+    record_header.timestamp_fraction = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp - seconds).count());
+    record_header.captured_size      = static_cast<uint32_t>(record_size - pcap_record_header_size);
+    record_header.original_size      = record_header.captured_size;
+    std::memcpy(headers.data(), &record_header, sizeof(record_header));
+
+    write_ipv4_udp_headers(headers.data() + pcap_record_header_size, source, destination, ip_id_++, 64, size);
+
+    write_to_ring(write_position,                  headers.data(), headers.size());
+    write_to_ring(write_position + headers.size(), data,           size);
+
+    write_position_.store(write_position + record_size, std::memory_order_release);
+
+    // Wake up the writer early, when the ring becomes half full
+    const uint64_t half_ring = ring_.size() / 2;
+    if ((write_position - cached_read_position_ < half_ring) && (write_position + record_size - cached_read_position_ >= half_ring))
+      writer_cv_.notify_one();
+  }
+
+  uint64_t PcapRecorder::get_dropped_datagrams() const
+  {
+    return dropped_datagrams_.load(std::memory_order_relaxed);
+  }
+
+  void PcapRecorder::write_to_ring(uint64_t position, const void* data, std::size_t size)
+  {
+    // The data may wrap around the end of the ring
+    const std::size_t index      = static_cast<std::size_t>(position & ring_mask_);
+    const std::size_t first_part = std::min(size, ring_.size() - index);
+
+    std::memcpy(&ring_[index], data, first_part);
+    if (first_part < size)
+      std::memcpy(ring_.data(), static_cast<const uint8_t*>(data) + first_part, size - first_part);
+  }
+
+  void PcapRecorder::writer_loop()
+  {
+    for (;;)
+    {
+      bool stop = false;
+      {
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        writer_cv_.wait_for(lock, writer_interval, [this]() { return writer_stop_; });
+        stop = writer_stop_;
+      }
+
+      flush_ring();
+
+      if (stop)
+        return;
+    }
+  }
+
+  void PcapRecorder::flush_ring()
+  {
+    const uint64_t read_position  = read_position_.load(std::memory_order_relaxed);
+    const uint64_t write_position = write_position_.load(std::memory_order_acquire);
+
+    if (read_position == write_position)
+      return;
+
+    // Write the range in at most two pieces, as it may wrap around the end of
+    // the ring. Write errors (e.g. a full disk) can't be reported to anybody,
+    // so the data is discarded in that case.
+    const std::size_t size       = static_cast<std::size_t>(write_position - read_position);
+    const std::size_t index      = static_cast<std::size_t>(read_position & ring_mask_);
+    const std::size_t first_part = std::min(size, ring_.size() - index);
+
+    std::fwrite(&ring_[index], 1, first_part, file_);
+    if (first_part < size)
+      std::fwrite(ring_.data(), 1, size - first_part, file_);
+
+    read_position_.store(write_position, std::memory_order_release);
+  }
+}
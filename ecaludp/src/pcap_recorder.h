@@ -0,0 +1,114 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+
+namespace ecaludp
+{
+  /// Large enough to bridge a stalled disk for a moment at high data rates
+  constexpr std::size_t default_recording_ring_size = 64 * 1024 * 1024;
+
+  /**
+   * @brief Appends received datagrams to a pcap file without blocking the receiver
+   *
+   * record() copies the datagram (prefixed with a pcap record header and
+   * synthesized IPv4 / UDP headers) into a lock-free single-producer /
+   * single-consumer ring. A background thread writes the ring to the file in
+   * large chunks. If the writer can't keep up and the ring is full, the
+   * datagram is not recorded and counted as dropped, so the receiver never
+   * waits for the disk.
+   *
+   * record() must only be called from one thread at a time. Only IPv4
+   * traffic with datagrams of at most 65507 bytes can be recorded.
+   */
+  class PcapRecorder
+  {
+  public:
+    PcapRecorder(std::size_t ring_size);
+
+    // Disable copy and move
+    PcapRecorder(const PcapRecorder&)            = delete;
+    PcapRecorder& operator=(const PcapRecorder&) = delete;
+    PcapRecorder(PcapRecorder&&)                 = delete;
+    PcapRecorder& operator=(PcapRecorder&&)      = delete;
+
+    ~PcapRecorder();
+
+    /**
+     * @brief Creates the file, writes the pcap header and starts the writer thread
+     */
+    bool open(const std::string& file_path, ecaludp::Error& error);
+
+    /**
+     * @brief Writes all pending datagrams, stops the writer thread and closes the file
+     */
+    void close();
+
+    bool is_open() const;
+
+    void record(const void* data, std::size_t size, const asio::ip::udp::endpoint& source, const asio::ip::udp::endpoint& destination);
+
+    /**
+     * @brief Returns the number of datagrams that have not been recorded, because the ring was full
+     */
+    uint64_t get_dropped_datagrams() const;
+
+  private:
+    void write_to_ring(uint64_t position, const void* data, std::size_t size);
+
+    void writer_loop();
+
+    /**
+     * @brief Writes everything between the read and the write position to the file
+     */
+    void flush_ring();
+
+  private:
+    std::vector<uint8_t>      ring_;
+    const uint64_t            ring_mask_;                  ///< The ring size is a power of two
+
+    // The positions increase monotonically, the index into the ring is the
+    // position & ring_mask_. The producer only looks at the read position
+    // again, when the ring seems to be full.
+    std::atomic<uint64_t>     write_position_;             ///< Only written by the producer
+    uint64_t                  cached_read_position_;       ///< Producer's copy of the read position
+    char                      cache_line_padding_[64];     ///< Keeps the producer and consumer data on separate cache lines
+    std::atomic<uint64_t>     read_position_;              ///< Only written by the writer thread
+    std::atomic<uint64_t>     dropped_datagrams_;
+
+    std::FILE*                file_;
+    uint16_t                  ip_id_;
+
+    std::mutex                writer_mutex_;
+    std::condition_variable   writer_cv_;
+    bool                      writer_stop_;
+    std::unique_ptr<std::thread> writer_thread_;
+  };
+}
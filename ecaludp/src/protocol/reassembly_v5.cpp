@@ -16,9 +16,13 @@
 #include "reassembly_v5.h"
 
 #include "ecaludp/owning_buffer.h"
+#include "ecaludp/partial_message.h"
 #include "ecaludp/raw_memory.h"
+#include "ecaludp/reassembly_limits.h"
 #include "header_v5.h"
 #include "portable_endian.h"
+#include "receive_profiler.h"
+#include "usdt_probes.h"
 
 #include <algorithm>
 #include <chrono>
@@ -26,8 +30,12 @@
 #include <cstdint>
 #include <cstring>
 #include <ecaludp/error.h>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <asio.hpp> // IWYU pragma: keep
 
@@ -35,6 +43,16 @@ namespace ecaludp
 {
   namespace v5
   {
+    namespace
+    {
+      // Upper bound of the fragment count of a single message. The list of
+      // fragments holds one pointer per fragment and is allocated as soon as the
+      // fragment count is known, so it must be bounded even without configured
+      // ReassemblyLimits. With the default datagram size of 1448 bytes this
+      // still permits messages of roughly 1.4 GiB.
+      constexpr uint32_t max_fragment_count = 1024 * 1024;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     // Constructor, Destructor
     //////////////////////////////////////////////////////////////////////////////
@@ -46,29 +64,34 @@ namespace ecaludp
 
     std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error)
     {
-      if (buffer->size() < sizeof(ecaludp::v5::Header))
+      return handle_datagram(buffer->data(), buffer->size(), buffer, sender_endpoint, error);
+    }
+
+    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram(const void* data, size_t size, const std::shared_ptr<void const>& owning_container, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error)
+    {
+      if (size < sizeof(ecaludp::v5::Header))
       {
-        error = ecaludp::Error(ecaludp::Error::ErrorCode::MALFORMED_DATAGRAM, "Datagram too small, cannot contain V5 header. Size is " + std::to_string(buffer->size()) + " bytes.");
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::MALFORMED_DATAGRAM, "Datagram too small, cannot contain V5 header. Size is " + std::to_string(size) + " bytes.");
         return nullptr;
       }
 
-      const auto* header = reinterpret_cast<ecaludp::v5::Header*>(buffer->data());
+      const auto* header = reinterpret_cast<const ecaludp::v5::Header*>(data);
 
       // Each message type must be handled differently
       if (static_cast<ecaludp::v5::datagram_type_uint32t>(le32toh(static_cast<uint32_t>(header->type)))
                  == ecaludp::v5::datagram_type_uint32t::datagram_type_fragmented_message_info)
       {
-        return handle_datagram_fragmented_message_info(buffer, sender_endpoint, error);
+        return handle_datagram_fragmented_message_info(data, sender_endpoint, error);
       }
       else if (static_cast<ecaludp::v5::datagram_type_uint32t>(le32toh(static_cast<uint32_t>(header->type)))
                  == ecaludp::v5::datagram_type_uint32t::datagram_type_fragment)
       {
-        return handle_datagram_fragment(buffer, sender_endpoint, error);
+        return handle_datagram_fragment(data, size, owning_container, sender_endpoint, error);
       }
       else if (static_cast<ecaludp::v5::datagram_type_uint32t>(le32toh(static_cast<uint32_t>(header->type)))
                  == ecaludp::v5::datagram_type_uint32t::datagram_type_non_fragmented_message)
       {
-        return handle_datagram_non_fragmented_message(buffer, error);
+        return handle_datagram_non_fragmented_message(data, size, owning_container, error);
       }
       else 
       {
@@ -77,66 +100,175 @@ namespace ecaludp
       }
     }
 
-    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram_fragmented_message_info(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error)
+    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram_fragmented_message_info(const void* data, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error)
     {
-      auto* header = reinterpret_cast<ecaludp::v5::Header*>(buffer->data());
+      const auto* header = reinterpret_cast<const ecaludp::v5::Header*>(data);
 
       const int32_t package_id = le32toh(header->id);
       const fragmented_package_key package_key{*sender_endpoint, package_id};
 
+      if (check_discarded(package_key))
+      {
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::REASSEMBLY_LIMIT_EXCEEDED, "Package " + std::to_string(package_id) + " has been dropped by the reassembly limits");
+        return nullptr;
+      }
+
       // Check if we already have a package with this id. If not, create one
-      auto existing_package_it = fragmented_packages_.find(package_key);
-      if (existing_package_it == fragmented_packages_.end())
+      fragmented_package_map_t::iterator existing_package_it;
+      bool                               package_created = false;
       {
-        existing_package_it = fragmented_packages_.emplace(package_key, fragmented_package{}).first;
+        ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::REASSEMBLY_LOOKUP);
+        existing_package_it = fragmented_packages_.find(package_key);
+        if (existing_package_it == fragmented_packages_.end())
+        {
+          existing_package_it = fragmented_packages_.emplace(package_key, fragmented_package{}).first;
+          package_created     = true;
+        }
+      }
 
+      if (package_created)
+      {
+        existing_package_it->second.first.first_datagram_number_ = datagram_counter_;
+        ECALUDP_PROBE2(package_created, sender_endpoint->data(), package_id);
       }
-      else if (existing_package_it->second.first.fragment_info_received_)
+      existing_package_it->second.first.last_datagram_number_ = datagram_counter_++;
+
+      if (!package_created && existing_package_it->second.first.fragment_info_received_)
       {
         error = ecaludp::Error(ecaludp::Error::ErrorCode::DUPLICATE_DATAGRAM
                                         , "Received fragment info for package " + std::to_string(package_id) + " twice");
         return nullptr;
       }
 
+      // Drop packages that are too large, before allocating anything for them
+      if ((limits_.max_message_size > 0) && (le32toh(header->len) > limits_.max_message_size))
+      {
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::REASSEMBLY_LIMIT_EXCEEDED
+                                        , "Package " + std::to_string(package_id) + " has " + std::to_string(le32toh(header->len))
+                                          + " bytes, but the max message size is " + std::to_string(limits_.max_message_size) + " bytes");
+        eviction_counters_.rejected_messages++;
+        ECALUDP_PROBE3(package_rejected, sender_endpoint->data(), package_id, le32toh(header->len));
+        discard_package(existing_package_it);
+        return nullptr;
+      }
+
+      // Each fragment carries at least one byte, so there cannot be more
+      // fragments than bytes. Independent of that, the fragment count must not
+      // exceed the internal maximum, as the fragment list is allocated for it.
+      // The package is not marked as discarded, as it has not been dropped by
+      // the reassembly limits.
+      if ((le32toh(header->num) > le32toh(header->len))
+          || (le32toh(header->num) > max_fragment_count))
+      {
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::MALFORMED_DATAGRAM
+                                        , "Fragment info of package " + std::to_string(package_id) + " announces " + std::to_string(le32toh(header->num))
+                                          + " fragments for " + std::to_string(le32toh(header->len)) + " bytes");
+        erase_package(existing_package_it);
+        return nullptr;
+      }
+
+      fragmented_package_info&                             package_info = existing_package_it->second.first;
+      std::vector<std::shared_ptr<ecaludp::OwningBuffer>>& fragments    = existing_package_it->second.second;
+
       // Store that we received the fragment info
-      existing_package_it->second.first.fragment_info_received_ = true;
+      package_info.fragment_info_received_ = true;
 
       // Set the fragmentation info
-      existing_package_it->second.first.total_fragments_  = le32toh(header->num);
-      existing_package_it->second.first.total_size_bytes_ = le32toh(header->len);
+      package_info.total_fragments_  = le32toh(header->num);
+      package_info.total_size_bytes_ = le32toh(header->len);
+
+      // Fragments with a higher number than announced may have been received
+      // before the fragment info. They cannot be part of the message, so they
+      // must not be counted anymore.
+      if (fragments.size() > package_info.total_fragments_)
+      {
+        for (std::size_t i = package_info.total_fragments_; i < fragments.size(); i++)
+        {
+          if (fragments[i] == nullptr)
+            continue;
+
+          package_info.received_fragments_--;
+          package_info.buffered_bytes_ -= fragments[i]->size();
+          buffered_bytes_              -= fragments[i]->size();
+        }
+
+        package_info.highest_fragment_ = 0;
+        for (std::size_t i = 0; i < package_info.total_fragments_; i++)
+        {
+          if (fragments[i] != nullptr)
+            package_info.highest_fragment_ = static_cast<uint32_t>(i);
+        }
+        package_info.has_gap_ = (package_info.received_fragments_ > 0) && (package_info.received_fragments_ != package_info.highest_fragment_ + 1);
+      }
 
       // Resize the list of fragments, so we never have to resize again
-      existing_package_it->second.second.resize(existing_package_it->second.first.total_fragments_);
+      fragments.resize(package_info.total_fragments_);
 
       // Set the last access time
-      existing_package_it->second.first.last_access_ = std::chrono::steady_clock::now();
+      existing_package_it->second.first.last_access_ = now();
 
       // Maybe the message is already complete. So let's check and reassemble the
       // package if necessary
       return handle_fragmented_package_if_complete(existing_package_it, error);
     }
 
-    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram_fragment(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error)
+    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram_fragment(const void* data, size_t size, const std::shared_ptr<void const>& owning_container, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error)
     {
-       auto* header = reinterpret_cast<ecaludp::v5::Header*>(buffer->data());
+      const auto* header = reinterpret_cast<const ecaludp::v5::Header*>(data);
 
       const int32_t package_id = le32toh(header->id);
       const fragmented_package_key package_key{*sender_endpoint, package_id};
 
-      // Check if we already have a package with this id. If not, create one
-      auto existing_package_it = fragmented_packages_.find(package_key);
-      if (existing_package_it == fragmented_packages_.end())
+      if (check_discarded(package_key))
       {
-        existing_package_it = fragmented_packages_.emplace(package_key, fragmented_package{}).first;
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::REASSEMBLY_LIMIT_EXCEEDED, "Package " + std::to_string(package_id) + " has been dropped by the reassembly limits");
+        return nullptr;
       }
 
       const uint32_t package_num = le32toh(header->num);
-    
+
+      // Reject bogus fragment numbers before creating a package for them, as
+      // the list of fragments would have to be resized up to that number.
+      if (package_num >= max_fragment_count)
+      {
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::MALFORMED_DATAGRAM
+                                , "Fragment number " + std::to_string(package_num) + " of package " + std::to_string(package_id)
+                                  + " exceeds the maximum fragment count of " + std::to_string(max_fragment_count));
+        return nullptr;
+      }
+
+      // Check if we already have a package with this id. If not, create one
+      fragmented_package_map_t::iterator existing_package_it;
+      {
+        ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::REASSEMBLY_LOOKUP);
+        existing_package_it = fragmented_packages_.find(package_key);
+        if (existing_package_it == fragmented_packages_.end())
+        {
+          existing_package_it = fragmented_packages_.emplace(package_key, fragmented_package{}).first;
+          existing_package_it->second.first.first_datagram_number_ = datagram_counter_;
+          ECALUDP_PROBE2(package_created, sender_endpoint->data(), package_id);
+        }
+      }
+      existing_package_it->second.first.last_datagram_number_ = datagram_counter_++;
+
       // Resize the list of fragments, if necessary. We only do that, if we didn't
       // receive the fragment info yet, so we don't know how many fragments there
       // will be, yet
       if (!existing_package_it->second.first.fragment_info_received_)
       {
+        // Each fragment carries at least one byte, so the message would be
+        // too large for the configured limit.
+        if ((limits_.max_message_size > 0) && (package_num >= limits_.max_message_size))
+        {
+          error = ecaludp::Error(ecaludp::Error::ErrorCode::REASSEMBLY_LIMIT_EXCEEDED
+                                  , "Fragment number " + std::to_string(package_num) + " of package " + std::to_string(package_id)
+                                    + " exceeds the max message size of " + std::to_string(limits_.max_message_size) + " bytes");
+          eviction_counters_.rejected_messages++;
+          ECALUDP_PROBE3(package_rejected, sender_endpoint->data(), package_id, existing_package_it->second.first.buffered_bytes_);
+          discard_package(existing_package_it);
+          return nullptr;
+        }
+
         existing_package_it->second.second.resize(std::max(existing_package_it->second.second.size(), static_cast<size_t>(package_num + 1)));
       }
 
@@ -158,7 +290,7 @@ namespace ecaludp
     
       // Check if the size information from the fragment is valid
       const uint32_t fragment_size = le32toh(header->len);
-      const unsigned int bytes_available = (static_cast<unsigned int>(buffer->size()) - sizeof(ecaludp::v5::Header));
+      const unsigned int bytes_available = (static_cast<unsigned int>(size) - sizeof(ecaludp::v5::Header));
       if (fragment_size > bytes_available)
       {
         error = ecaludp::Error(ecaludp::Error::ErrorCode::MALFORMED_DATAGRAM
@@ -168,28 +300,63 @@ namespace ecaludp
       }
 
       // prepare a buffer view to the payload data and store the fragment in the list
-      const void* payload_data_ptr = static_cast<const uint8_t*>(buffer->data()) + sizeof(ecaludp::v5::Header);
-      auto fragment_buffer_view = std::make_shared<ecaludp::OwningBuffer>(payload_data_ptr, static_cast<size_t>(fragment_size), buffer);
+      const void* payload_data_ptr = static_cast<const uint8_t*>(data) + sizeof(ecaludp::v5::Header);
+      auto fragment_buffer_view = std::make_shared<ecaludp::OwningBuffer>(payload_data_ptr, static_cast<size_t>(fragment_size), owning_container);
       existing_package_it->second.second[package_num] = fragment_buffer_view;
 
       // Increase the number of received fragments
       existing_package_it->second.first.received_fragments_++;
+      existing_package_it->second.first.buffered_bytes_ += fragment_size;
+      buffered_bytes_                                   += fragment_size;
+
+      ECALUDP_PROBE4(fragment_added, sender_endpoint->data(), package_id, package_num, existing_package_it->second.first.received_fragments_);
 
       // Set the last access time
-      existing_package_it->second.first.last_access_ = std::chrono::steady_clock::now();
+      existing_package_it->second.first.last_access_ = now();
+
+      // Fragments are sent in order, so a missing fragment before the highest
+      // one has most likely been lost
+      {
+        fragmented_package_info& package_info = existing_package_it->second.first;
+        package_info.highest_fragment_ = std::max(package_info.highest_fragment_, package_num);
+
+        const bool has_gap = (package_info.received_fragments_ != package_info.highest_fragment_ + 1);
+        if (has_gap && !package_info.has_gap_)
+          package_info.gap_since_ = package_info.last_access_;
+        package_info.has_gap_ = has_gap;
+      }
+
+      // Without the fragment info, the size of the message is only known once it is too large
+      if (!existing_package_it->second.first.fragment_info_received_
+          && (limits_.max_message_size > 0)
+          && (existing_package_it->second.first.buffered_bytes_ > limits_.max_message_size))
+      {
+        error = ecaludp::Error(ecaludp::Error::ErrorCode::REASSEMBLY_LIMIT_EXCEEDED
+                                , "Package " + std::to_string(package_id) + " exceeds the max message size of " + std::to_string(limits_.max_message_size) + " bytes");
+        eviction_counters_.rejected_messages++;
+        ECALUDP_PROBE3(package_rejected, sender_endpoint->data(), package_id, existing_package_it->second.first.buffered_bytes_);
+        discard_package(existing_package_it);
+        return nullptr;
+      }
 
       // Maybe the message is already complete. So let's check and reassemble the
       // package if necessary
-      return handle_fragmented_package_if_complete(existing_package_it, error);
+      auto finished_package = handle_fragmented_package_if_complete(existing_package_it, error);
+
+      // If the package is still incomplete, it now holds more memory than before
+      if ((finished_package == nullptr) && !error)
+        enforce_buffer_limits(*sender_endpoint);
+
+      return finished_package;
     }
 
-    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram_non_fragmented_message(const std::shared_ptr<ecaludp::RawMemory>& buffer, ecaludp::Error& error)
+    std::shared_ptr<ecaludp::OwningBuffer> Reassembly::handle_datagram_non_fragmented_message(const void* data, size_t size, const std::shared_ptr<void const>& owning_container, ecaludp::Error& error)
     {
-      const auto* header = reinterpret_cast<ecaludp::v5::Header*>(buffer->data());
+      const auto* header = reinterpret_cast<const ecaludp::v5::Header*>(data);
 
       // Check if the size information from the header is valid
       const uint32_t payload_size = le32toh(header->len);
-      const unsigned int bytes_available = (static_cast<unsigned int>(buffer->size()) - sizeof(ecaludp::v5::Header));
+      const unsigned int bytes_available = (static_cast<unsigned int>(size) - sizeof(ecaludp::v5::Header));
 
       if (payload_size > bytes_available)
       {
@@ -200,8 +367,8 @@ namespace ecaludp
       }
 
       // Calculate the pointer to the payload data and create an OwningBuffer for that memory area
-      const void* payload_data_ptr = static_cast<const uint8_t*>(buffer->data()) + sizeof(ecaludp::v5::Header);
-      auto payload_buffer = std::make_shared<ecaludp::OwningBuffer>(payload_data_ptr, static_cast<size_t>(payload_size), buffer);
+      const void* payload_data_ptr = static_cast<const uint8_t*>(data) + sizeof(ecaludp::v5::Header);
+      auto payload_buffer = std::make_shared<ecaludp::OwningBuffer>(payload_data_ptr, static_cast<size_t>(payload_size), owning_container);
 
       error = ecaludp::Error::ErrorCode::OK;
       return payload_buffer;
@@ -233,7 +400,7 @@ namespace ecaludp
                             + " bytes, but received " + std::to_string(cummulated_package_sizes) + "bytes.");
 
           // Remove the package from the map. We don't need it anymore, as it is corrupted
-          fragmented_packages_.erase(it);
+          erase_package(it);
 
           return nullptr;
         }
@@ -242,8 +409,14 @@ namespace ecaludp
       // We have a complete package, so we can reassemble it
       auto reassebled_buffer = reassemble_package(it);
 
+      ECALUDP_PROBE4(package_completed, it->first.first.data(), it->first.second, it->second.first.total_size_bytes_, it->second.first.total_fragments_);
+
+      // Older packages of this sender will not be completed anymore
+      if (limits_.abandon_superseded_messages)
+        abandon_superseded_packages(it);
+
       // Remove the package from the map. We don't need it anymore, as it is complete
-      fragmented_packages_.erase(it);
+      erase_package(it);
 
       // Return the package to the user
       error = ecaludp::Error::ErrorCode::OK;
@@ -253,37 +426,389 @@ namespace ecaludp
     std::shared_ptr<ecaludp::OwningBuffer> Reassembly::reassemble_package(const fragmented_package_map_t::const_iterator& it)
     {
       // Create a mutable buffer that is big enough to hold the entire package
-      auto reassembled_buffer = largepackage_buffer_pool_.allocate();
+      std::shared_ptr<ecaludp::RawMemory> reassembled_buffer;
+      {
+        ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::POOL_ALLOCATE);
+        reassembled_buffer = largepackage_buffer_pool_.allocate();
+        reassembled_buffer->resize(it->second.first.total_size_bytes_);
+      }
 
-      reassembled_buffer->resize(it->second.first.total_size_bytes_);
+      {
+        ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::REASSEMBLY_COPY);
 
-      void* current_pos = reassembled_buffer->data();
+        void* current_pos = reassembled_buffer->data();
 
-      for (const auto& fragment : it->second.second)
-      {
-        // Copy the fragment into the reassembled buffer
-        memcpy(current_pos, fragment->data(), fragment->size());
-        current_pos = static_cast<uint8_t*>(current_pos) + fragment->size();
+        for (const auto& fragment : it->second.second)
+        {
+          // Copy the fragment into the reassembled buffer
+          memcpy(current_pos, fragment->data(), fragment->size());
+          current_pos = static_cast<uint8_t*>(current_pos) + fragment->size();
+        }
       }
 
       // In this case we don't have the header as residue in the raw memory, so we return the entire buffer.
       return std::make_shared<ecaludp::OwningBuffer>(reassembled_buffer->data(), reassembled_buffer->size(), reassembled_buffer);
     }
 
+    Reassembly::fragmented_package_map_t::iterator Reassembly::erase_package(fragmented_package_map_t::const_iterator it)
+    {
+      // Erasing drops the fragments, which gives their datagram buffers back to the pool
+      ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::POOL_RELEASE);
+      buffered_bytes_ -= it->second.first.buffered_bytes_;
+      return fragmented_packages_.erase(it);
+    }
+
+    bool Reassembly::check_discarded(const fragmented_package_key& package_key)
+    {
+      if (discarded_packages_.empty())
+        return false;
+
+      auto discarded_package_it = discarded_packages_.find(package_key);
+      if (discarded_package_it == discarded_packages_.end())
+        return false;
+
+      // Keep dropping the fragments as long as the sender is sending them
+      discarded_package_it->second = now();
+      return true;
+    }
+
+    Reassembly::fragmented_package_map_t::iterator Reassembly::discard_package(fragmented_package_map_t::const_iterator it)
+    {
+      discarded_packages_[it->first] = now();
+      return erase_package(it);
+    }
+
+    void Reassembly::evict_package(fragmented_package_map_t::const_iterator it)
+    {
+      ECALUDP_PROBE3(package_evicted, it->first.first.data(), it->first.second, it->second.first.buffered_bytes_);
+      collect_partial_message(it, ecaludp::PartialMessageReason::EVICTED);
+
+      eviction_counters_.evicted_messages++;
+      eviction_counters_.evicted_bytes += it->second.first.buffered_bytes_;
+      discard_package(it);
+    }
+
+    Reassembly::fragmented_package_map_t::iterator Reassembly::abandon_package(fragmented_package_map_t::const_iterator it)
+    {
+      ECALUDP_PROBE4(package_abandoned, it->first.first.data(), it->first.second, it->second.first.received_fragments_, it->second.first.total_fragments_);
+      collect_partial_message(it, ecaludp::PartialMessageReason::ABANDONED);
+
+      eviction_counters_.abandoned_messages++;
+      eviction_counters_.abandoned_bytes += it->second.first.buffered_bytes_;
+      return discard_package(it);
+    }
+
+    void Reassembly::abandon_superseded_packages(const fragmented_package_map_t::const_iterator& completed_package_it)
+    {
+      const asio::ip::udp::endpoint& sender_endpoint   = completed_package_it->first.first;
+      const uint64_t                  completed_started = completed_package_it->second.first.first_datagram_number_;
+
+      // Packages that have not received anything since the completed package
+      // has been started are older messages of that sender. Packages with
+      // interleaved fragments are kept. The packages are sorted by sender, so
+      // all packages of this sender are next to each other.
+      auto it = fragmented_packages_.lower_bound({sender_endpoint, std::numeric_limits<int32_t>::min()});
+      while ((it != fragmented_packages_.end()) && (it->first.first == sender_endpoint))
+      {
+        if ((it != completed_package_it) && (it->second.first.last_datagram_number_ < completed_started))
+          it = abandon_package(it);
+        else
+          ++it;
+      }
+    }
+
+    void Reassembly::enforce_buffer_limits(const asio::ip::udp::endpoint& sender_endpoint)
+    {
+      if (limits_.max_buffered_bytes_per_sender > 0)
+      {
+        for (;;)
+        {
+          // The packages are sorted by sender, so all packages of this sender are next to each other
+          std::size_t                              sender_buffered_bytes = 0;
+          fragmented_package_map_t::const_iterator victim_it             = fragmented_packages_.cend();
+
+          for (fragmented_package_map_t::const_iterator it = fragmented_packages_.lower_bound({sender_endpoint, std::numeric_limits<int32_t>::min()});
+               (it != fragmented_packages_.cend()) && (it->first.first == sender_endpoint);
+               ++it)
+          {
+            sender_buffered_bytes += it->second.first.buffered_bytes_;
+            if (is_better_eviction_candidate(it, victim_it))
+              victim_it = it;
+          }
+
+          if (sender_buffered_bytes <= limits_.max_buffered_bytes_per_sender)
+            break;
+
+          evict_package(victim_it);
+        }
+      }
+
+      if (limits_.max_buffered_bytes > 0)
+      {
+        while (buffered_bytes_ > limits_.max_buffered_bytes)
+        {
+          fragmented_package_map_t::const_iterator victim_it = fragmented_packages_.cend();
+
+          for (fragmented_package_map_t::const_iterator it = fragmented_packages_.cbegin(); it != fragmented_packages_.cend(); ++it)
+          {
+            if (is_better_eviction_candidate(it, victim_it))
+              victim_it = it;
+          }
+
+          evict_package(victim_it);
+        }
+      }
+    }
+
+    bool Reassembly::is_better_eviction_candidate(const fragmented_package_map_t::const_iterator& candidate, const fragmented_package_map_t::const_iterator& current_victim) const
+    {
+      // Evicting a package without fragments would not free anything. As the
+      // limit is exceeded, there always is a package with fragments.
+      if (candidate->second.first.buffered_bytes_ == 0)
+        return false;
+
+      if (current_victim == fragmented_packages_.cend())
+        return true;
+
+      if (limits_.eviction_policy == ecaludp::ReassemblyEvictionPolicy::LARGEST_FIRST)
+        return candidate->second.first.buffered_bytes_ > current_victim->second.first.buffered_bytes_;
+      else
+        return candidate->second.first.last_access_ < current_victim->second.first.last_access_;
+    }
+
     void Reassembly::remove_old_packages(std::chrono::steady_clock::time_point max_age)
     {
-      // Remove all packages that are older than max_age
+      const bool                                  check_fragment_gaps = (limits_.max_fragment_gap_age > std::chrono::steady_clock::duration::zero());
+      const std::chrono::steady_clock::time_point max_gap_start       = (check_fragment_gaps ? now() - limits_.max_fragment_gap_age : std::chrono::steady_clock::time_point());
+
+      // Remove all packages that are older than max_age and those that have
+      // been missing a fragment for too long
       for (auto it = fragmented_packages_.begin(); it != fragmented_packages_.end();)
       {
         if (it->second.first.last_access_ < max_age)
         {
-          fragmented_packages_.erase(it++);
+          ECALUDP_PROBE4(package_expired, it->first.first.data(), it->first.second, it->second.first.received_fragments_, it->second.first.total_fragments_);
+          collect_partial_message(it, ecaludp::PartialMessageReason::EXPIRED);
+          it = erase_package(it);
+        }
+        else if (check_fragment_gaps && it->second.first.has_gap_ && (it->second.first.gap_since_ < max_gap_start))
+        {
+          it = abandon_package(it);
         }
         else
         {
           ++it;
         }
       }
+
+      // Forget the discarded packages, the sender won't send fragments for them anymore
+      for (auto it = discarded_packages_.begin(); it != discarded_packages_.end();)
+      {
+        if (it->second < max_age)
+          it = discarded_packages_.erase(it);
+        else
+          ++it;
+      }
+    }
+
+    void Reassembly::remove_all_packages()
+    {
+      // Dropping the fragments gives their datagram buffers back to the pool
+      fragmented_packages_.clear();
+      discarded_packages_.clear();
+      buffered_bytes_ = 0;
+    }
+
+    void Reassembly::set_limits(const ecaludp::ReassemblyLimits& limits)
+    {
+      limits_ = limits;
+    }
+
+    const ecaludp::ReassemblyLimits& Reassembly::get_limits() const
+    {
+      return limits_;
+    }
+
+    const ecaludp::ReassemblyEvictionCounters& Reassembly::get_eviction_counters() const
+    {
+      return eviction_counters_;
+    }
+
+    std::size_t Reassembly::get_incomplete_message_count() const
+    {
+      return fragmented_packages_.size();
+    }
+
+    std::size_t Reassembly::get_buffered_bytes() const
+    {
+      return buffered_bytes_;
+    }
+
+    void Reassembly::set_partial_delivery_enabled(bool enabled)
+    {
+      partial_delivery_enabled_ = enabled;
+    }
+
+    bool Reassembly::has_partial_messages() const
+    {
+      return !partial_messages_.empty();
+    }
+
+    std::vector<ecaludp::PartialMessage> Reassembly::take_partial_messages()
+    {
+      std::vector<ecaludp::PartialMessage> partial_messages;
+      std::swap(partial_messages, partial_messages_);
+      return partial_messages;
+    }
+
+    void Reassembly::collect_partial_message(const fragmented_package_map_t::const_iterator& it, ecaludp::PartialMessageReason reason)
+    {
+      const fragmented_package_info&                              package_info = it->second.first;
+      const std::vector<std::shared_ptr<ecaludp::OwningBuffer>>&  fragments    = it->second.second;
+
+      // Without the fragment info, neither the size of the message nor the
+      // position of the fragments is known
+      if (!partial_delivery_enabled_
+          || !package_info.fragment_info_received_
+          || (fragments.size() < 2))
+      {
+        return;
+      }
+
+      // Only count the fragments that are actually there, instead of relying
+      // on the bookkeeping of the package
+      const auto available_fragments = std::count_if(fragments.begin(), fragments.end()
+                                                    , [](const std::shared_ptr<ecaludp::OwningBuffer>& fragment) { return fragment != nullptr; });
+      if (available_fragments == 0)
+        return;
+
+      // All fragments but the last one have the same size. If only the last
+      // one has been received, the size follows from the message size.
+      std::size_t fragment_size = 0;
+      for (std::size_t i = 0; i + 1 < fragments.size(); ++i)
+      {
+        if (fragments[i] != nullptr)
+        {
+          fragment_size = fragments[i]->size();
+          break;
+        }
+      }
+      if (fragment_size == 0)
+      {
+        if (fragments.back() == nullptr)
+          return;
+
+        const std::size_t last_fragment_size = fragments.back()->size();
+        if (last_fragment_size > package_info.total_size_bytes_)
+          return;
+        fragment_size = (package_info.total_size_bytes_ - last_fragment_size) / (fragments.size() - 1);
+      }
+
+      // Check that the fragments fit together, before copying anything. The
+      // last fragment must not be larger than the others, so the message size
+      // is bounded by the fragments that have actually been received and a
+      // bogus message size cannot make us allocate an arbitrary buffer.
+      const std::size_t last_fragment_offset = fragment_size * (fragments.size() - 1);
+      if ((fragment_size == 0)
+          || (last_fragment_offset >= package_info.total_size_bytes_)
+          || (package_info.total_size_bytes_ - last_fragment_offset > fragment_size))
+      {
+        return;
+      }
+
+      if ((limits_.max_message_size > 0) && (package_info.total_size_bytes_ > limits_.max_message_size))
+        return;
+
+      for (std::size_t i = 0; i < fragments.size(); ++i)
+      {
+        if (fragments[i] == nullptr)
+          continue;
+
+        const std::size_t expected_size = (i + 1 < fragments.size() ? fragment_size : package_info.total_size_bytes_ - last_fragment_offset);
+        if (fragments[i]->size() != expected_size)
+          return;
+      }
+
+      std::shared_ptr<ecaludp::RawMemory> partial_buffer;
+      {
+        ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::POOL_ALLOCATE);
+        partial_buffer = largepackage_buffer_pool_.allocate();
+        partial_buffer->resize(package_info.total_size_bytes_);
+      }
+
+      ecaludp::PartialMessage partial_message;
+      partial_message.sender_endpoint = it->first.first;
+      partial_message.message_id      = it->first.second;
+      partial_message.reason          = reason;
+      partial_message.fragment_size   = fragment_size;
+      partial_message.received_fragments.resize(fragments.size(), false);
+
+      {
+        ECALUDP_PROFILE_SCOPE(profiler_, ReceiveStage::REASSEMBLY_COPY);
+
+        // The buffers of the pool are reused, so the gaps must be cleared explicitly
+        for (std::size_t i = 0; i < fragments.size(); ++i)
+        {
+          uint8_t*          fragment_pos  = partial_buffer->data() + (i * fragment_size);
+          const std::size_t fragment_room = (i + 1 < fragments.size() ? fragment_size : package_info.total_size_bytes_ - last_fragment_offset);
+
+          if (fragments[i] != nullptr)
+          {
+            memcpy(fragment_pos, fragments[i]->data(), fragment_room);
+            partial_message.received_fragments[i] = true;
+          }
+          else
+          {
+            memset(fragment_pos, 0, fragment_room);
+          }
+        }
+      }
+
+      partial_message.payload = std::make_shared<ecaludp::OwningBuffer>(partial_buffer->data(), partial_buffer->size(), partial_buffer);
+      partial_messages_.push_back(std::move(partial_message));
+    }
+
+#ifdef ECALUDP_PROFILING_ENABLED
+    void Reassembly::set_profiler(ecaludp::ReceiveProfiler* profiler)
+    {
+      profiler_ = profiler;
+    }
+#endif // ECALUDP_PROFILING_ENABLED
+
+    std::vector<ecaludp::IncompleteMessage> Reassembly::get_incomplete_messages() const
+    {
+      const auto current_time = now();
+
+      std::vector<ecaludp::IncompleteMessage> incomplete_messages;
+      incomplete_messages.reserve(fragmented_packages_.size());
+
+      for (const auto& package : fragmented_packages_)
+      {
+        const fragmented_package_info& info = package.second.first;
+
+        ecaludp::IncompleteMessage message;
+        message.sender_endpoint    = package.first.first;
+        message.message_id         = package.first.second;
+        message.received_fragments = info.received_fragments_;
+        message.total_fragments    = (info.fragment_info_received_ ? info.total_fragments_  : 0);
+        message.total_size_bytes   = (info.fragment_info_received_ ? info.total_size_bytes_ : 0);
+        message.buffered_bytes     = info.buffered_bytes_;
+        message.age                = current_time - info.last_access_;
+
+        incomplete_messages.push_back(message);
+      }
+
+      return incomplete_messages;
+    }
+
+    void Reassembly::set_clock(const std::function<std::chrono::steady_clock::time_point()>& clock)
+    {
+      clock_ = clock;
+    }
+
+    std::chrono::steady_clock::time_point Reassembly::now() const
+    {
+      return (clock_ ? clock_() : std::chrono::steady_clock::now());
     }
 
   }
@@ -16,7 +16,9 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -28,11 +30,16 @@
 #include <recycle/shared_pool.hpp>
 
 #include <ecaludp/error.h>
+#include <ecaludp/incomplete_message.h>
 #include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
 #include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
 
 namespace ecaludp
 {
+  class ReceiveProfiler;
+
   namespace v5
   {
     class Reassembly
@@ -48,7 +55,14 @@ namespace ecaludp
           uint32_t                              total_fragments_        {0};
           uint32_t                              total_size_bytes_       {0};
           unsigned int                          received_fragments_     {0};
+          std::size_t                           buffered_bytes_         {0};
           std::chrono::steady_clock::time_point last_access_            {std::chrono::steady_clock::duration(0)};
+
+          uint64_t                              first_datagram_number_  {0};      ///< Position of the first and last datagram of this package in the stream of all received datagrams
+          uint64_t                              last_datagram_number_   {0};
+          uint32_t                              highest_fragment_       {0};
+          bool                                  has_gap_                {false};  ///< A fragment before the highest fragment is missing
+          std::chrono::steady_clock::time_point gap_since_              {std::chrono::steady_clock::duration(0)};
         };
         using fragmented_package       = std::pair<fragmented_package_info, std::vector<std::shared_ptr<ecaludp::OwningBuffer>>>;
         using fragmented_package_map_t = std::map<fragmented_package_key, fragmented_package>;
@@ -65,22 +79,133 @@ namespace ecaludp
     public:
       std::shared_ptr<ecaludp::OwningBuffer> handle_datagram                        (const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error);
 
+      /**
+       * @brief Handles a datagram that is located somewhere inside a memory owned by owning_container
+       *
+       * Used for handling multiple datagrams that share one buffer (e.g.
+       * datagrams received with UDP GRO). The fragments and messages returned
+       * by the reassembly are views into that memory and keep the
+       * owning_container alive.
+       */
+      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram                        (const void* data, size_t size, const std::shared_ptr<void const>& owning_container, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error);
+
     private:
-      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_fragmented_message_info(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error);
-      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_fragment               (const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error);
-      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_non_fragmented_message (const std::shared_ptr<ecaludp::RawMemory>& buffer, ecaludp::Error& error);
+      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_fragmented_message_info(const void* data, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error);
+      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_fragment               (const void* data, size_t size, const std::shared_ptr<void const>& owning_container, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint, ecaludp::Error& error);
+      std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_non_fragmented_message (const void* data, size_t size, const std::shared_ptr<void const>& owning_container, ecaludp::Error& error);
 
       std::shared_ptr<ecaludp::OwningBuffer> handle_fragmented_package_if_complete(const fragmented_package_map_t::const_iterator& it, ecaludp::Error& error);
       std::shared_ptr<ecaludp::OwningBuffer> reassemble_package  (const fragmented_package_map_t::const_iterator& it);
 
+      fragmented_package_map_t::iterator     erase_package(fragmented_package_map_t::const_iterator it);
+
+      bool                                   check_discarded(const fragmented_package_key& package_key);
+      fragmented_package_map_t::iterator     discard_package(fragmented_package_map_t::const_iterator it);
+      void                                   evict_package  (fragmented_package_map_t::const_iterator it);
+      fragmented_package_map_t::iterator     abandon_package(fragmented_package_map_t::const_iterator it);
+      void                                   abandon_superseded_packages(const fragmented_package_map_t::const_iterator& completed_package_it);
+
+      void                                   collect_partial_message(const fragmented_package_map_t::const_iterator& it, ecaludp::PartialMessageReason reason);
+      void                                   enforce_buffer_limits(const asio::ip::udp::endpoint& sender_endpoint);
+      bool                                   is_better_eviction_candidate(const fragmented_package_map_t::const_iterator& candidate, const fragmented_package_map_t::const_iterator& current_victim) const;
+
     public:
       void remove_old_packages(std::chrono::steady_clock::time_point max_age);
 
+      /**
+       * @brief Drops all incomplete messages without delivering them as partial messages
+       */
+      void remove_all_packages();
+
+      /**
+       * @brief Limits the memory that incomplete messages may hold
+       *
+       * When a byte limit is exceeded, incomplete messages are evicted
+       * according to the eviction policy until the limit is met again.
+       * Messages exceeding the max message size are dropped as soon as their
+       * size is known. The remaining fragments of evicted and rejected
+       * messages are dropped, too, until the max age has passed. New limits
+       * are enforced when the next fragment is received.
+       *
+       * Abandoned messages (see ReassemblyLimits) are treated the same way.
+       * The fragment gaps are checked together with the max age.
+       */
+      void set_limits(const ecaludp::ReassemblyLimits& limits);
+      const ecaludp::ReassemblyLimits& get_limits() const;
+
+      const ecaludp::ReassemblyEvictionCounters& get_eviction_counters() const;
+
+      /**
+       * @brief Keeps the expired, evicted and abandoned messages as partial messages
+       *
+       * Only messages whose fragment info has been received can be delivered,
+       * as the size of the others is unknown. The partial messages are
+       * collected until they are fetched with take_partial_messages().
+       * Disabled by default.
+       */
+      void set_partial_delivery_enabled(bool enabled);
+      bool has_partial_messages() const;
+      std::vector<ecaludp::PartialMessage> take_partial_messages();
+
+      /**
+       * @brief Sets the clock that is used to timestamp the fragments
+       *
+       * By default, the steady clock is used. Replaying recorded traffic uses
+       * the recorded time instead, so old packages are removed the same way
+       * regardless of the replay speed.
+       */
+      void set_clock(const std::function<std::chrono::steady_clock::time_point()>& clock);
+
+      /**
+       * @brief Returns the number of messages that have not been completed, yet
+       */
+      std::size_t get_incomplete_message_count() const;
+
+      /**
+       * @brief Returns the payload bytes of all fragments of the incomplete messages
+       *
+       * The fragments keep the memory of their datagrams alive, so the memory
+       * that is actually held may be larger, e.g. when each datagram has been
+       * received into a buffer of the maximum datagram size.
+       */
+      std::size_t get_buffered_bytes() const;
+
+      /**
+       * @brief Returns the state of all messages that have not been completed, yet
+       */
+      std::vector<ecaludp::IncompleteMessage> get_incomplete_messages() const;
+
+#ifdef ECALUDP_PROFILING_ENABLED
+      /**
+       * @brief Sets the profiler that measures the map lookups, the copying
+       *        and the buffer handling. nullptr disables profiling.
+       */
+      void set_profiler(ecaludp::ReceiveProfiler* profiler);
+#endif // ECALUDP_PROFILING_ENABLED
+
+    private:
+      std::chrono::steady_clock::time_point now() const;
+
     //////////////////////////////////////////////////////////////////////////////
     // Member variables
     //////////////////////////////////////////////////////////////////////////////
     private:
       fragmented_package_map_t fragmented_packages_;
+      std::size_t              buffered_bytes_ {0};                    ///< Sum of the buffered_bytes_ of all fragmented packages
+      uint64_t                 datagram_counter_ {0};                  ///< Number of fragmented datagrams received so far
+
+      ecaludp::ReassemblyLimits                                       limits_;
+      ecaludp::ReassemblyEvictionCounters                             eviction_counters_;
+      std::map<fragmented_package_key, std::chrono::steady_clock::time_point> discarded_packages_;   ///< Evicted and rejected packages with the time of their last fragment. Further fragments are dropped.
+
+      bool                                                            partial_delivery_enabled_ {false};
+      std::vector<ecaludp::PartialMessage>                            partial_messages_;
+
+      std::function<std::chrono::steady_clock::time_point()> clock_;   ///< Empty for the steady clock
+
+#ifdef ECALUDP_PROFILING_ENABLED
+      ecaludp::ReceiveProfiler* profiler_ {nullptr};
+#endif // ECALUDP_PROFILING_ENABLED
 
       // Buffer pool
       struct buffer_pool_lock_policy_
@@ -0,0 +1,318 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "receive_engine.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+
+#include "pcap_recorder.h"
+#include "receive_profiler.h"
+#include "usdt_probes.h"
+#include "protocol/header_common.h"
+#include "protocol/header_v5.h"
+#include "protocol/portable_endian.h"
+#include "protocol/reassembly_v5.h"
+
+#include <recycle/shared_pool.hpp>
+
+namespace ecaludp
+{
+  struct buffer_pool_lock_policy_
+  {
+    using mutex_type = std::mutex;
+    using lock_type  = std::lock_guard<mutex_type>;
+  };
+
+  class recycle_shared_pool : public recycle::shared_pool<ecaludp::RawMemory, buffer_pool_lock_policy_>{};
+
+  ReceiveEngine::ReceiveEngine(std::array<char, 4> magic_header_bytes)
+    : buffer_pool_                 (std::make_unique<ecaludp::recycle_shared_pool>())
+    , reassembly_v5_               (std::make_unique<ecaludp::v5::Reassembly>())
+    , magic_header_bytes_          (magic_header_bytes)
+    , max_reassembly_age_          (std::chrono::seconds(5))
+    , copy_non_fragmented_messages_(false)
+#ifdef ECALUDP_PROFILING_ENABLED
+    , profiler_                    (std::make_shared<ecaludp::ReceiveProfiler>())
+#endif // ECALUDP_PROFILING_ENABLED
+  {
+#ifdef ECALUDP_PROFILING_ENABLED
+    reassembly_v5_->set_profiler(profiler_.get());
+#endif // ECALUDP_PROFILING_ENABLED
+  }
+
+  ReceiveEngine::~ReceiveEngine() = default;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  void ReceiveEngine::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
+  {
+    max_reassembly_age_ = max_reassembly_age;
+  }
+
+  std::chrono::steady_clock::duration ReceiveEngine::get_max_reassembly_age() const
+  {
+    return max_reassembly_age_;
+  }
+
+  void ReceiveEngine::set_clock(const Clock& clock)
+  {
+    clock_ = clock;
+    reassembly_v5_->set_clock(clock);
+  }
+
+  void ReceiveEngine::set_copy_non_fragmented_messages(bool enabled)
+  {
+    copy_non_fragmented_messages_ = enabled;
+  }
+
+  void ReceiveEngine::set_reassembly_limits(const ecaludp::ReassemblyLimits& limits)
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    reassembly_v5_->set_limits(limits);
+  }
+
+  ecaludp::ReassemblyLimits ReceiveEngine::get_reassembly_limits() const
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    return reassembly_v5_->get_limits();
+  }
+
+  void ReceiveEngine::set_partial_message_callback(const PartialMessageCallback& callback)
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    partial_message_callback_ = callback;
+    reassembly_v5_->set_partial_delivery_enabled(static_cast<bool>(callback));
+  }
+
+  std::chrono::steady_clock::time_point ReceiveEngine::now() const
+  {
+    return (clock_ ? clock_() : std::chrono::steady_clock::now());
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  std::shared_ptr<ecaludp::RawMemory> ReceiveEngine::allocate_buffer()
+  {
+    ECALUDP_PROFILE_SCOPE(profiler_.get(), ReceiveStage::POOL_ALLOCATE);
+    return buffer_pool_->allocate();
+  }
+
+  std::shared_ptr<ecaludp::OwningBuffer> ReceiveEngine::handle_datagram(const void* data
+                                                                       , std::size_t size
+                                                                       , const std::shared_ptr<void const>& owner
+                                                                       , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                                       , ecaludp::Error& error)
+  {
+    ECALUDP_PROBE2(datagram_received, sender_endpoint->data(), size);
+
+    if (recorder_)
+      record(data, size, *sender_endpoint);
+
+    std::shared_ptr<ecaludp::OwningBuffer> finished_package;
+    std::vector<ecaludp::PartialMessage>   partial_messages;
+    PartialMessageCallback                 partial_message_callback;
+
+    {
+      const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+      finished_package = handle_datagram_locked(data, size, owner, sender_endpoint, error);
+
+      if (reassembly_v5_->has_partial_messages())
+      {
+        partial_messages         = reassembly_v5_->take_partial_messages();
+        partial_message_callback = partial_message_callback_;
+      }
+    }
+
+    // The user may do anything in the callback, so the reassembly must not be locked
+    if (partial_message_callback)
+    {
+      for (const auto& partial_message : partial_messages)
+        partial_message_callback(partial_message);
+    }
+
+    return finished_package;
+  }
+
+  std::shared_ptr<ecaludp::OwningBuffer> ReceiveEngine::handle_datagram_locked(const void* data
+                                                                              , std::size_t size
+                                                                              , const std::shared_ptr<void const>& owner
+                                                                              , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                                              , ecaludp::Error& error)
+  {
+    // Clean the reassembly from fragments that are too old
+    reassembly_v5_->remove_old_packages(now() - max_reassembly_age_);
+
+    // Start to parse the header
+    const auto* header = static_cast<const ecaludp::HeaderCommon*>(data);
+
+    {
+      ECALUDP_PROFILE_SCOPE(profiler_.get(), ReceiveStage::HEADER_CHECK);
+
+      if (size < sizeof(ecaludp::HeaderCommon)) // Magic number + version
+      {
+        error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Datagram too small to contain common header (" + std::to_string(size) + " bytes)");
+        ECALUDP_PROBE3(datagram_dropped, sender_endpoint->data(), size, static_cast<int>(error.GetErrorCode()));
+        return nullptr;
+      }
+
+      // Check the magic number
+      if (strncmp(header->magic, magic_header_bytes_.data(), 4) != 0)
+      {
+        error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Wrong magic bytes");
+        ECALUDP_PROBE3(datagram_dropped, sender_endpoint->data(), size, static_cast<int>(error.GetErrorCode()));
+        return nullptr;
+      }
+    }
+
+    std::shared_ptr<ecaludp::OwningBuffer> finished_package;
+
+    // Check the version and invoke the correct handler
+    if (header->version == 5)
+    {
+      const bool copy_message = copy_non_fragmented_messages_
+                                && (size >= sizeof(ecaludp::v5::Header))
+                                && (le32toh(static_cast<uint32_t>(static_cast<const ecaludp::v5::Header*>(data)->type)) == static_cast<uint32_t>(ecaludp::v5::datagram_type_uint32t::datagram_type_non_fragmented_message));
+
+      if (copy_message)
+      {
+        std::shared_ptr<ecaludp::RawMemory> buffer;
+        {
+          ECALUDP_PROFILE_SCOPE(profiler_.get(), ReceiveStage::POOL_ALLOCATE);
+          buffer = buffer_pool_->allocate();
+          buffer->resize(size);
+        }
+        memcpy(buffer->data(), data, size);
+        finished_package = reassembly_v5_->handle_datagram(buffer, sender_endpoint, error);
+      }
+      else
+      {
+        finished_package = reassembly_v5_->handle_datagram(data, size, owner, sender_endpoint, error);
+      }
+    }
+    else
+    {
+      error = ecaludp::Error(Error::UNSUPPORTED_PROTOCOL_VERSION, std::to_string(header->version));
+    }
+
+    if (error)
+    {
+      ECALUDP_PROBE3(datagram_dropped, sender_endpoint->data(), size, static_cast<int>(error.GetErrorCode()));
+      return nullptr;
+    }
+
+    return finished_package;
+  }
+
+  void ReceiveEngine::drop_incomplete_messages()
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    reassembly_v5_->remove_all_packages();
+  }
+
+  std::size_t ReceiveEngine::get_incomplete_message_count() const
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    return reassembly_v5_->get_incomplete_message_count();
+  }
+
+  std::size_t ReceiveEngine::get_reassembly_buffered_bytes() const
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    return reassembly_v5_->get_buffered_bytes();
+  }
+
+  std::vector<ecaludp::IncompleteMessage> ReceiveEngine::get_reassembly_snapshot() const
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    return reassembly_v5_->get_incomplete_messages();
+  }
+
+  ecaludp::ReassemblyEvictionCounters ReceiveEngine::get_reassembly_eviction_counters() const
+  {
+    const std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    return reassembly_v5_->get_eviction_counters();
+  }
+
+#ifdef ECALUDP_PROFILING_ENABLED
+  /////////////////////////////////////////////////////////////////
+  // Profiling
+  /////////////////////////////////////////////////////////////////
+  const std::shared_ptr<ecaludp::ReceiveProfiler>& ReceiveEngine::get_profiler() const
+  {
+    return profiler_;
+  }
+#endif // ECALUDP_PROFILING_ENABLED
+
+  /////////////////////////////////////////////////////////////////
+  // Recording
+  /////////////////////////////////////////////////////////////////
+  bool ReceiveEngine::start_recording(const std::string& file_path, const std::function<asio::ip::udp::endpoint()>& get_local_endpoint, ecaludp::Error& error)
+  {
+    stop_recording();
+
+    auto recorder = std::make_unique<ecaludp::PcapRecorder>(ecaludp::default_recording_ring_size);
+    if (!recorder->open(file_path, error))
+      return false;
+
+    recorder_              = std::move(recorder);
+    get_local_endpoint_    = get_local_endpoint;
+    recording_destination_ = asio::ip::udp::endpoint();
+    return true;
+  }
+
+  void ReceiveEngine::stop_recording()
+  {
+    // Closing the recorder writes all pending datagrams
+    recorder_.reset();
+  }
+
+  bool ReceiveEngine::is_recording() const
+  {
+    return static_cast<bool>(recorder_);
+  }
+
+  uint64_t ReceiveEngine::get_recording_dropped_datagrams() const
+  {
+    return (recorder_ ? recorder_->get_dropped_datagrams() : 0);
+  }
+
+  void ReceiveEngine::record(const void* data, std::size_t size, const asio::ip::udp::endpoint& sender_endpoint)
+  {
+    if ((recording_destination_.port() == 0) && get_local_endpoint_)
+      recording_destination_ = get_local_endpoint_();
+
+    recorder_->record(data, size, sender_endpoint, recording_destination_);
+  }
+}
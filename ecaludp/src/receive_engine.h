@@ -0,0 +1,276 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/incomplete_message.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+
+namespace ecaludp
+{
+  namespace v5
+  {
+    class Reassembly;
+  }
+
+  class PcapRecorder;
+  class ReceiveProfiler;
+  class recycle_shared_pool;
+
+  /**
+   * @brief A datagram that has been received by a datagram source
+   *
+   * The data points somewhere into the memory owned by the owner, e.g. into
+   * a buffer from ReceiveEngine::allocate_buffer() or into a capture ring.
+   */
+  struct ReceivedDatagram
+  {
+    const void*                              data_  {nullptr};
+    std::size_t                              size_  {0};
+    std::shared_ptr<void const>              owner_;
+    std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint_;
+  };
+
+  /**
+   * @brief The receive pipeline shared by all sockets: buffer pool, datagram
+   *        validation, reassembly and recording
+   *
+   * The sockets only differ in how they get the datagrams (asio, udpcap,
+   * io_uring, AF_PACKET, capture files, memory). They hand each datagram to
+   * handle_datagram() and deliver the messages that it returns. Sources that
+   * can be polled synchronously can use receive_from() instead of writing
+   * the receive loop themselves.
+   *
+   * The engine is not thread safe. All datagrams must be handed in by one
+   * thread at a time, which is what the sockets do anyway. Only the
+   * reassembly state (incomplete messages) may be inspected from any thread.
+   */
+  class ReceiveEngine
+  {
+  public:
+    using Clock                  = std::function<std::chrono::steady_clock::time_point()>;
+    using PartialMessageCallback = std::function<void(const ecaludp::PartialMessage&)>;
+
+  public:
+    ReceiveEngine(std::array<char, 4> magic_header_bytes);
+    ~ReceiveEngine();
+
+    // Disable copy and move
+    ReceiveEngine(const ReceiveEngine&)            = delete;
+    ReceiveEngine& operator=(const ReceiveEngine&) = delete;
+    ReceiveEngine(ReceiveEngine&&)                 = delete;
+    ReceiveEngine& operator=(ReceiveEngine&&)      = delete;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
+    std::chrono::steady_clock::duration get_max_reassembly_age() const;
+
+    /**
+     * @brief Sets the clock that decides about the age of fragments
+     *
+     * By default, the steady clock is used. Replaying recorded traffic uses
+     * the recorded time instead.
+     */
+    void set_clock(const Clock& clock);
+
+    /**
+     * @brief Copies non-fragmented messages to a buffer from the pool
+     *
+     * Otherwise the messages handed to the user keep the memory of the
+     * datagram alive, which is not desirable for sources that receive into a
+     * ring shared with the kernel. Fragmented messages are always copied
+     * when they are reassembled. Disabled by default.
+     */
+    void set_copy_non_fragmented_messages(bool enabled);
+
+    /**
+     * @brief Limits the memory of the incomplete messages, see v5::Reassembly::set_limits()
+     */
+    void set_reassembly_limits(const ecaludp::ReassemblyLimits& limits);
+    ecaludp::ReassemblyLimits get_reassembly_limits() const;
+
+    /**
+     * @brief Delivers the expired, evicted and abandoned messages to the callback
+     *
+     * The callback is called by handle_datagram(), after the reassembly has
+     * been unlocked and before the completed message is returned. An empty
+     * callback disables the partial delivery, which is the default.
+     */
+    void set_partial_message_callback(const PartialMessageCallback& callback);
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Returns an empty buffer from the pool, e.g. to receive a datagram into it
+     */
+    std::shared_ptr<ecaludp::RawMemory> allocate_buffer();
+
+    /**
+     * @brief Checks the datagram and hands it to the reassembly
+     *
+     * The datagram is recorded before it is checked, if a recording is
+     * active. Incomplete messages that are older than the max reassembly age
+     * are dropped.
+     *
+     * @return The message that has been completed by this datagram or nullptr
+     */
+    std::shared_ptr<ecaludp::OwningBuffer> handle_datagram(const void* data
+                                                          , std::size_t size
+                                                          , const std::shared_ptr<void const>& owner
+                                                          , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                          , ecaludp::Error& error);
+
+    std::shared_ptr<ecaludp::OwningBuffer> handle_datagram(const std::shared_ptr<ecaludp::RawMemory>& buffer
+                                                          , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                          , ecaludp::Error& error)
+    {
+      return handle_datagram(buffer->data(), buffer->size(), buffer, sender_endpoint, error);
+    }
+
+    /**
+     * @brief Pulls datagrams from the source until a message is complete
+     *
+     * The source is called as bool(ReceivedDatagram&, ecaludp::Error&) and
+     * returns false, if no more datagrams can be received. Malformed
+     * datagrams are skipped.
+     *
+     * @return The message or nullptr, if the source failed (error is set by the source)
+     */
+    template <typename DatagramSource>
+    std::shared_ptr<ecaludp::OwningBuffer> receive_from(DatagramSource&& source, asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error)
+    {
+      for (;;)
+      {
+        ReceivedDatagram datagram;
+        if (!source(datagram, error))
+          return nullptr;
+
+        ecaludp::Error datagram_error = ecaludp::Error::OK;
+        auto message = handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, datagram_error);
+
+        if (message != nullptr)
+        {
+          sender_endpoint = *datagram.sender_endpoint_;
+          error = ecaludp::Error::OK;
+          return message;
+        }
+      }
+    }
+
+    /**
+     * @brief Drops all incomplete messages
+     */
+    void drop_incomplete_messages();
+
+    std::size_t get_incomplete_message_count() const;
+
+    /**
+     * @brief Returns the payload bytes of the fragments of all incomplete messages
+     */
+    std::size_t get_reassembly_buffered_bytes() const;
+
+    /**
+     * @brief Returns the state of all incomplete messages
+     *
+     * Can be called from any thread. Receiving is blocked while the state is
+     * copied, which takes a few microseconds for typical numbers of
+     * incomplete messages.
+     */
+    std::vector<ecaludp::IncompleteMessage> get_reassembly_snapshot() const;
+
+    ecaludp::ReassemblyEvictionCounters get_reassembly_eviction_counters() const;
+
+#ifdef ECALUDP_PROFILING_ENABLED
+  /////////////////////////////////////////////////////////////////
+  // Profiling
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Returns the profiler that the engine and its reassembly report to
+     *
+     * The sockets use it for the stages they handle themselves, i.e. the
+     * receive calls and the user callbacks.
+     */
+    const std::shared_ptr<ecaludp::ReceiveProfiler>& get_profiler() const;
+#endif // ECALUDP_PROFILING_ENABLED
+
+  /////////////////////////////////////////////////////////////////
+  // Recording
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @param get_local_endpoint  Returns the destination of the datagrams. It
+     *                            is called when the first datagram is recorded.
+     */
+    bool start_recording(const std::string& file_path, const std::function<asio::ip::udp::endpoint()>& get_local_endpoint, ecaludp::Error& error);
+    void stop_recording();
+    bool is_recording() const;
+    uint64_t get_recording_dropped_datagrams() const;
+
+  private:
+    std::shared_ptr<ecaludp::OwningBuffer> handle_datagram_locked(const void* data
+                                                                 , std::size_t size
+                                                                 , const std::shared_ptr<void const>& owner
+                                                                 , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                                 , ecaludp::Error& error);
+
+    void record(const void* data, std::size_t size, const asio::ip::udp::endpoint& sender_endpoint);
+
+    std::chrono::steady_clock::time_point now() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    std::unique_ptr<recycle_shared_pool>      buffer_pool_;
+    std::unique_ptr<ecaludp::v5::Reassembly>  reassembly_v5_;
+    mutable std::mutex                        reassembly_mutex_;                ///< Protects the reassembly from snapshots taken by other threads
+
+    std::array<char, 4>                       magic_header_bytes_;              ///< Datagrams that don't start with those bytes are dropped
+    std::chrono::steady_clock::duration       max_reassembly_age_;              ///< Incomplete messages that are older than that are dropped
+    Clock                                     clock_;                           ///< Empty for the steady clock
+    bool                                      copy_non_fragmented_messages_;
+    PartialMessageCallback                    partial_message_callback_;        ///< Protected by the reassembly_mutex_
+
+#ifdef ECALUDP_PROFILING_ENABLED
+    std::shared_ptr<ecaludp::ReceiveProfiler> profiler_;
+#endif // ECALUDP_PROFILING_ENABLED
+
+    std::unique_ptr<ecaludp::PcapRecorder>    recorder_;                        ///< Only set while recording
+    std::function<asio::ip::udp::endpoint()>  get_local_endpoint_;
+    asio::ip::udp::endpoint                   recording_destination_;           ///< Determined when the first datagram is recorded
+  };
+}
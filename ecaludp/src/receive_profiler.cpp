@@ -0,0 +1,119 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "receive_profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <ecaludp/receive_profile.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+  #define ECALUDP_PROFILE_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <x86intrin.h>
+  #define ECALUDP_PROFILE_RDTSC
+#endif
+
+namespace ecaludp
+{
+  namespace
+  {
+    std::size_t bucket_index(uint64_t ticks)
+    {
+      std::size_t index = 0;
+      while ((ticks >>= 1) != 0)
+        ++index;
+      return index;
+    }
+
+    // Only the receiving thread writes, so a load and a store are enough
+    void increment(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+      counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+  }
+
+  ReceiveProfiler::ReceiveProfiler()
+    : start_ticks_(ticks())
+    , start_time_ (std::chrono::steady_clock::now())
+  {}
+
+  uint64_t ReceiveProfiler::ticks()
+  {
+#ifdef ECALUDP_PROFILE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  void ReceiveProfiler::record(ReceiveStage stage, uint64_t ticks)
+  {
+    AtomicHistogram& histogram = stages_[static_cast<std::size_t>(stage)];
+
+    increment(histogram.count_, 1);
+    increment(histogram.total_ticks_, ticks);
+    increment(histogram.buckets_[bucket_index(ticks)], 1);
+
+    if (ticks > histogram.max_ticks_.load(std::memory_order_relaxed))
+      histogram.max_ticks_.store(ticks, std::memory_order_relaxed);
+  }
+
+  ReceiveProfile ReceiveProfiler::get_profile() const
+  {
+    ReceiveProfile profile;
+
+    for (std::size_t stage = 0; stage < receive_stage_count; ++stage)
+    {
+      const AtomicHistogram& source      = stages_[stage];
+      StageHistogram&        destination = profile.stages[stage];
+
+      destination.count       = source.count_.load(std::memory_order_relaxed);
+      destination.total_ticks = source.total_ticks_.load(std::memory_order_relaxed);
+      destination.max_ticks   = source.max_ticks_.load(std::memory_order_relaxed);
+      for (std::size_t i = 0; i < destination.buckets.size(); ++i)
+        destination.buckets[i] = source.buckets_[i].load(std::memory_order_relaxed);
+    }
+
+#ifdef ECALUDP_PROFILE_RDTSC
+    // The TSC frequency is derived from the time since the profiler has been
+    // created, so it gets more precise the longer the socket lives.
+    const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start_time_).count();
+    profile.ticks_are_cpu_cycles = true;
+    profile.ticks_per_second     = (elapsed > 0.0 ? static_cast<double>(ticks() - start_ticks_) / elapsed : 0.0);
+#else
+    profile.ticks_are_cpu_cycles = false;
+    profile.ticks_per_second     = 1e9;
+#endif
+
+    return profile;
+  }
+
+  void ReceiveProfiler::reset()
+  {
+    for (auto& histogram : stages_)
+    {
+      histogram.count_      .store(0, std::memory_order_relaxed);
+      histogram.total_ticks_.store(0, std::memory_order_relaxed);
+      histogram.max_ticks_  .store(0, std::memory_order_relaxed);
+      for (auto& bucket : histogram.buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
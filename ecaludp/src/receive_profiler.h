@@ -0,0 +1,127 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+/**
+ * Probes for measuring the receive path, see ecaludp/receive_profile.h.
+ *
+ * ECALUDP_PROFILE_SCOPE(profiler, stage) measures the rest of the enclosing
+ * scope and adds it to the histogram of the stage. Without
+ * ECALUDP_PROFILING_ENABLED, the macro expands to nothing and its arguments
+ * are not evaluated, so the probes don't cost anything at all.
+ */
+
+#ifdef ECALUDP_PROFILING_ENABLED
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <ecaludp/receive_profile.h>
+
+namespace ecaludp
+{
+  /**
+   * @brief Collects the per-stage histograms of one receive engine
+   *
+   * The histograms are written by the receiving thread only and can be read
+   * from any thread. The counters are plain relaxed atomics without
+   * read-modify-write, so the single writer doesn't pay for locked
+   * instructions. Resetting while receiving may lose a few samples.
+   */
+  class ReceiveProfiler
+  {
+  public:
+    ReceiveProfiler();
+
+    static uint64_t ticks();
+
+    void record(ReceiveStage stage, uint64_t ticks);
+
+    ReceiveProfile get_profile() const;
+    void reset();
+
+  private:
+    struct AtomicHistogram
+    {
+      std::atomic<uint64_t>                  count_       {0};
+      std::atomic<uint64_t>                  total_ticks_ {0};
+      std::atomic<uint64_t>                  max_ticks_   {0};
+      std::array<std::atomic<uint64_t>, 64>  buckets_     {};
+    };
+
+    std::array<AtomicHistogram, receive_stage_count>  stages_;
+
+    // Reference points for converting ticks to seconds
+    uint64_t                                          start_ticks_;
+    std::chrono::steady_clock::time_point             start_time_;
+  };
+
+  class ProfileScope
+  {
+  public:
+    ProfileScope(ReceiveProfiler* profiler, ReceiveStage stage)
+      : profiler_   (profiler)
+      , stage_      (stage)
+      , start_ticks_(profiler != nullptr ? ReceiveProfiler::ticks() : 0)
+    {}
+
+    /**
+     * @brief Keeps the profiler alive while measuring
+     *
+     * For scopes that may outlive the socket, e.g. user callbacks that
+     * destroy the socket.
+     */
+    ProfileScope(const std::shared_ptr<ReceiveProfiler>& profiler, ReceiveStage stage)
+      : profiler_keep_alive_(profiler)
+      , profiler_           (profiler.get())
+      , stage_              (stage)
+      , start_ticks_        (profiler != nullptr ? ReceiveProfiler::ticks() : 0)
+    {}
+
+    ~ProfileScope()
+    {
+      if (profiler_ != nullptr)
+        profiler_->record(stage_, ReceiveProfiler::ticks() - start_ticks_);
+    }
+
+    // Disable copy and move
+    ProfileScope(const ProfileScope&)            = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+    ProfileScope(ProfileScope&&)                 = delete;
+    ProfileScope& operator=(ProfileScope&&)      = delete;
+
+  private:
+    std::shared_ptr<ReceiveProfiler> profiler_keep_alive_;
+    ReceiveProfiler*                 profiler_;
+    ReceiveStage                     stage_;
+    uint64_t                         start_ticks_;
+  };
+}
+
+#define ECALUDP_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ECALUDP_PROFILE_CONCAT(a, b)      ECALUDP_PROFILE_CONCAT_IMPL(a, b)
+
+#define ECALUDP_PROFILE_SCOPE(profiler, stage) const ecaludp::ProfileScope ECALUDP_PROFILE_CONCAT(ecaludp_profile_scope_, __LINE__)((profiler), (stage))
+
+#else // ECALUDP_PROFILING_ENABLED
+
+#define ECALUDP_PROFILE_SCOPE(profiler, stage) static_cast<void>(0)
+
+#endif // ECALUDP_PROFILING_ENABLED
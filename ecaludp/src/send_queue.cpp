@@ -0,0 +1,531 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "send_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "protocol/datagram_description.h"
+#include "token_bucket.h"
+#include "usdt_probes.h"
+#include "zerocopy.h"
+
+namespace ecaludp
+{
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  SendQueue::SendQueue(asio::ip::udp::socket& socket, TokenBucket& rate_limiter)
+    : socket_                 (socket)
+    , rate_limiter_           (rate_limiter)
+    , pacing_timer_           (socket.get_executor())
+    , pacing_timer_active_    (false)
+    , first_unsent_job_index_ (0)
+    , datagrams_in_flight_    (0)
+    , queued_bytes_           (0)
+    , calling_completion_handlers_(false)
+    , max_queue_size_         (0)
+    , max_datagrams_in_flight_(64)
+    , high_water_mark_bytes_  (0)
+    , high_water_mark_exceeded_(false)
+    , zerocopy_threshold_     (0)
+    , zerocopy_wait_active_   (false)
+    , zerocopy_id_base_       (0)
+    , zerocopy_ids_sent_      (0)
+    , zerocopy_ids_completed_ (0)
+    , zerocopy_ids_of_removed_jobs_(0)
+    , lifetime_token_         (std::make_shared<int>(0))
+  {}
+
+  SendQueue::~SendQueue()
+  {
+    // The socket outlives the queue, so pending sends and waits complete
+    // afterwards. Their handlers check the lifetime token.
+    lifetime_token_.reset();
+
+    std::deque<std::shared_ptr<SendJob>> finished_jobs;
+    std::deque<std::shared_ptr<SendJob>> aborted_jobs;
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      std::swap(finished_jobs, finished_jobs_);
+      std::swap(aborted_jobs,  queue_);
+    }
+
+    // Finished jobs keep their result, all others are aborted
+    for (const auto& job : finished_jobs)
+      asio::post(socket_.get_executor(), [job]() { job->completion_handler_(job->error_, job->bytes_sent_, job->datagrams_sent_); });
+
+    for (const auto& job : aborted_jobs)
+      asio::post(socket_.get_executor(), [job]() { job->completion_handler_(asio::error::operation_aborted, job->bytes_sent_, job->datagrams_sent_); });
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  void SendQueue::push(const std::shared_ptr<DatagramList>&        datagram_list
+                      , const std::vector<asio::ip::udp::endpoint>& destinations
+                      , const CompletionHandler&                   completion_handler)
+  {
+    auto job = std::make_shared<SendJob>();
+    job->datagram_list_      = datagram_list;
+    job->destinations_       = destinations;
+    job->completion_handler_ = completion_handler;
+    job->unsent_bytes_       = datagram_list_size(*datagram_list) * destinations.size();
+
+    bool                      high_water_mark_changed = false;
+    std::function<void(bool)> high_water_mark_callback;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      if ((max_queue_size_ > 0) && (queue_.size() >= max_queue_size_))
+      {
+        // The queue is full. Reject the message without sending anything.
+        asio::post(socket_.get_executor(), [completion_handler]() { completion_handler(asio::error::no_buffer_space, 0, 0); });
+        return;
+      }
+
+      if (job->total_datagram_count() == 0)
+      {
+        // Nothing to send (e.g. no destinations)
+        asio::post(socket_.get_executor(), [completion_handler]() { completion_handler(asio::error_code(), 0, 0); });
+        return;
+      }
+
+      // Large messages are sent without copying the payload, if possible
+      if ((zerocopy_threshold_ > 0) && (datagram_list_size(*datagram_list) >= zerocopy_threshold_))
+        job->zerocopy_ = prepare_zerocopy_locked();
+
+      queue_.push_back(job);
+      queued_bytes_ += job->unsent_bytes_;
+
+      high_water_mark_changed  = update_high_water_mark_state_locked();
+      high_water_mark_callback = high_water_mark_callback_;
+
+      send_next_datagrams_locked();
+    }
+
+    if (high_water_mark_changed && high_water_mark_callback)
+      high_water_mark_callback(true);
+  }
+
+  void SendQueue::send_next_datagrams_locked()
+  {
+    while ((datagrams_in_flight_ < max_datagrams_in_flight_)
+          && (first_unsent_job_index_ < queue_.size())
+          && !pacing_timer_active_)
+    {
+      const std::shared_ptr<SendJob> job = queue_[first_unsent_job_index_];
+
+      if (job->error_ || (job->next_datagram_ >= job->total_datagram_count()))
+      {
+        // All datagrams of this job have been issued (or the job has failed),
+        // so we continue with the next one
+        first_unsent_job_index_++;
+        continue;
+      }
+
+      const std::size_t datagram_index    = job->next_datagram_ % job->datagram_list_->size();
+      const std::size_t destination_index = job->next_datagram_ / job->datagram_list_->size();
+      const std::size_t datagram_size     = (*job->datagram_list_)[datagram_index].size();
+
+      // Check whether the rate limiter allows sending this datagram. If not,
+      // we wait for the pacing timer and continue sending afterwards.
+      const auto wait_time = rate_limiter_.try_consume(datagram_size);
+      if (wait_time > std::chrono::steady_clock::duration(0))
+      {
+        pacing_timer_active_ = true;
+        pacing_timer_.expires_after(wait_time);
+
+        const std::weak_ptr<int> lifetime_token = lifetime_token_;
+        pacing_timer_.async_wait([this, lifetime_token](const asio::error_code& ec)
+                                  {
+                                    // The timer is only cancelled when the queue is destroyed
+                                    if ((ec == asio::error::operation_aborted) || lifetime_token.expired())
+                                      return;
+
+                                    on_pacing_timer_expired();
+                                  });
+        break;
+      }
+
+      job->next_datagram_++;
+      job->datagrams_in_flight_++;
+      datagrams_in_flight_++;
+
+      send_datagram_locked(job, datagram_index, destination_index, job->zerocopy_);
+    }
+  }
+
+  void SendQueue::send_datagram_locked(const std::shared_ptr<SendJob>& job, std::size_t datagram_index, std::size_t destination_index, bool zerocopy)
+  {
+    // asio executes the operation immediately, if the socket is writable.
+    // The completion handler is never executed from within this call, so
+    // it is safe to hold the mutex here. The operation may complete after
+    // the queue has been destroyed, so it must not be accessed then.
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    socket_.async_send_to((*job->datagram_list_)[datagram_index].asio_buffer_list_
+                        , job->destinations_[destination_index]
+                        , (zerocopy ? zerocopy_send_flag() : 0)
+                        , [this, lifetime_token, job, datagram_index, destination_index, zerocopy](asio::error_code ec, std::size_t bytes_transferred)
+                          {
+                            if (lifetime_token.expired())
+                              return;
+
+                            on_datagram_sent(job, datagram_index, destination_index, zerocopy, ec, bytes_transferred);
+                          });
+  }
+
+  void SendQueue::on_datagram_sent(const std::shared_ptr<SendJob>& job, std::size_t datagram_index, std::size_t destination_index, bool zerocopy, const asio::error_code& ec, std::size_t bytes_transferred)
+  {
+    bool                                  high_water_mark_changed = false;
+    std::function<void(bool)>             high_water_mark_callback;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      if (zerocopy && (ec == asio::error::no_buffer_space) && !job->error_)
+      {
+        // The kernel ran out of memory for tracking zerocopy sends (limited
+        // by optmem_max). Send this datagram with a regular copy instead.
+        send_datagram_locked(job, datagram_index, destination_index, false);
+        return;
+      }
+
+      const std::size_t datagram_size = (*job->datagram_list_)[datagram_index].size();
+
+      job->datagrams_in_flight_--;
+      datagrams_in_flight_--;
+
+      if (!ec)
+      {
+        job->bytes_sent_ += bytes_transferred;
+        job->datagrams_sent_++;
+
+        ECALUDP_PROBE2(fragment_sent, job->destinations_[destination_index].data(), bytes_transferred);
+      }
+
+      // Each successful zerocopy send gets an ID from the kernel, which is
+      // reported on the error queue, once the kernel is done with the memory
+      if (zerocopy && !ec)
+      {
+        job->zerocopy_sends_++;
+        zerocopy_ids_sent_++;
+        wait_for_zerocopy_completions_locked();
+      }
+
+      job->unsent_bytes_ -= datagram_size;
+      queued_bytes_      -= datagram_size;
+
+      // Remember the first error. The remaining datagrams of this job will not
+      // be sent anymore.
+      if (ec && !job->error_)
+        job->error_ = ec;
+
+      // Once all issued datagrams of a failed job have returned, the bytes of
+      // the datagrams that will never be sent are removed from the queue.
+      if (job->error_ && (job->datagrams_in_flight_ == 0))
+      {
+        queued_bytes_      -= job->unsent_bytes_;
+        job->unsent_bytes_  = 0;
+      }
+
+      collect_finished_jobs_locked();
+
+      high_water_mark_changed  = update_high_water_mark_state_locked();
+      high_water_mark_callback = high_water_mark_callback_;
+
+      send_next_datagrams_locked();
+    }
+
+    // The user may destroy the socket from the completion handler
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    call_completion_handlers();
+
+    if (!lifetime_token.expired() && high_water_mark_changed && high_water_mark_callback)
+      high_water_mark_callback(false);
+  }
+
+  void SendQueue::on_pacing_timer_expired()
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    pacing_timer_active_ = false;
+    send_next_datagrams_locked();
+  }
+
+  void SendQueue::collect_finished_jobs_locked()
+  {
+    // Only finished jobs at the front of the queue are completed, so the
+    // completion handlers are called in the same order as the messages were
+    // pushed. Zerocopy jobs are only finished, when the kernel has released
+    // their memory.
+    while (!queue_.empty() && queue_.front()->is_finished() && is_zerocopy_completed_locked(*queue_.front()))
+    {
+      zerocopy_ids_of_removed_jobs_ += queue_.front()->zerocopy_sends_;
+
+      finished_jobs_.push_back(queue_.front());
+      queue_.pop_front();
+
+      if (first_unsent_job_index_ > 0)
+        first_unsent_job_index_--;
+    }
+  }
+
+  void SendQueue::call_completion_handlers()
+  {
+    // The handlers are called outside of the lock, as the user may directly
+    // push the next message from the completion handler. If multiple threads
+    // run the io_context, only one of them calls the handlers, so they are
+    // called in order and one after another.
+    const std::weak_ptr<int>     lifetime_token = lifetime_token_;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (calling_completion_handlers_)
+      return;
+
+    calling_completion_handlers_ = true;
+
+    while (!finished_jobs_.empty())
+    {
+      const std::shared_ptr<SendJob> finished_job = finished_jobs_.front();
+      finished_jobs_.pop_front();
+
+      lock.unlock();
+      finished_job->completion_handler_(finished_job->error_, finished_job->bytes_sent_, finished_job->datagrams_sent_);
+
+      // The queue has been destroyed from within the completion handler
+      if (lifetime_token.expired())
+        return;
+
+      lock.lock();
+    }
+
+    calling_completion_handlers_ = false;
+  }
+
+  bool SendQueue::update_high_water_mark_state_locked()
+  {
+    if (high_water_mark_bytes_ == 0)
+      return false;
+
+    const bool high_water_mark_exceeded = (queued_bytes_ >= high_water_mark_bytes_);
+    if (high_water_mark_exceeded != high_water_mark_exceeded_)
+    {
+      high_water_mark_exceeded_ = high_water_mark_exceeded;
+      return true;
+    }
+    return false;
+  }
+
+  bool SendQueue::prepare_zerocopy_locked()
+  {
+    bool newly_enabled = false;
+    if (!enable_zerocopy(socket_, newly_enabled))
+      return false;
+
+    if (newly_enabled)
+    {
+      // The kernel starts counting the zerocopy sends of this socket at 0.
+      // If this is not the first time (i.e. the socket has been re-opened),
+      // the sends on the old socket will never be reported, so we consider
+      // them completed.
+      zerocopy_ids_completed_ = zerocopy_ids_sent_;
+      zerocopy_id_base_       = zerocopy_ids_sent_;
+      zerocopy_pending_ranges_.clear();
+    }
+
+    return true;
+  }
+
+  void SendQueue::wait_for_zerocopy_completions_locked()
+  {
+    if (zerocopy_wait_active_)
+      return;
+
+    zerocopy_wait_active_ = true;
+
+    // The error queue handler may outlive the send queue, as it is bound to
+    // the socket. So we must not access the send queue anymore, once it has
+    // been destroyed.
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    socket_.async_wait(asio::socket_base::wait_error
+                      , [this, lifetime_token](const asio::error_code& ec)
+                        {
+                          if (lifetime_token.expired())
+                            return;
+
+                          on_zerocopy_completions(ec);
+                        });
+  }
+
+  void SendQueue::on_zerocopy_completions(const asio::error_code& ec)
+  {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      zerocopy_wait_active_ = false;
+
+      if (ec)
+      {
+        // The socket has been closed or the operation has been cancelled. We
+        // will not be notified about any completion anymore, so we consider
+        // all sends completed.
+        zerocopy_ids_completed_ = zerocopy_ids_sent_;
+        zerocopy_pending_ranges_.clear();
+      }
+      else
+      {
+        read_zerocopy_completions_locked();
+
+        if (zerocopy_ids_completed_ < zerocopy_ids_sent_)
+        {
+          wait_for_zerocopy_completions_locked();
+
+          // Notifications that have arrived between reading the error queue
+          // and starting the wait operation will not complete the wait
+          // operation, so we have to read them now.
+          read_zerocopy_completions_locked();
+        }
+      }
+
+      collect_finished_jobs_locked();
+    }
+
+    call_completion_handlers();
+  }
+
+  void SendQueue::read_zerocopy_completions_locked()
+  {
+    std::vector<std::pair<uint32_t, uint32_t>> completed_ranges;
+    asio::error_code                           ec;
+    read_zerocopy_completions(socket_, completed_ranges, ec);
+
+    for (const auto& range : completed_ranges)
+    {
+      // Convert the 32 bit IDs of the kernel to our cumulative IDs. The
+      // reported IDs are always at or after the first ID that has not been
+      // completed, yet.
+      const auto     first_not_completed = static_cast<uint32_t>(zerocopy_ids_completed_ - zerocopy_id_base_);
+      const uint64_t first               = zerocopy_ids_completed_ + static_cast<uint32_t>(range.first - first_not_completed);
+      const uint64_t last                = first + static_cast<uint32_t>(range.second - range.first);
+
+      auto& pending_last = zerocopy_pending_ranges_[first];
+      pending_last = std::max(pending_last, last);
+    }
+
+    // Merge all ranges that are contiguous to the completed IDs
+    auto it = zerocopy_pending_ranges_.begin();
+    while ((it != zerocopy_pending_ranges_.end()) && (it->first <= zerocopy_ids_completed_))
+    {
+      zerocopy_ids_completed_ = std::max(zerocopy_ids_completed_, it->second + 1);
+      it = zerocopy_pending_ranges_.erase(it);
+    }
+
+    if (ec && (ec != asio::error::would_block))
+    {
+      // The error queue cannot be read. We will not be notified about any
+      // completion anymore, so we consider all sends completed.
+      zerocopy_ids_completed_ = zerocopy_ids_sent_;
+      zerocopy_pending_ranges_.clear();
+    }
+  }
+
+  bool SendQueue::is_zerocopy_completed_locked(const SendJob& job) const
+  {
+    // All jobs before this one have already been removed, so this job used
+    // the IDs directly after the ones of the removed jobs
+    return (zerocopy_ids_of_removed_jobs_ + job.zerocopy_sends_) <= zerocopy_ids_completed_;
+  }
+
+  std::size_t SendQueue::datagram_list_size(const DatagramList& datagram_list)
+  {
+    std::size_t size = 0;
+    for (const auto& datagram : datagram_list)
+    {
+      size += datagram.size();
+    }
+    return size;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Settings & Statistics
+  /////////////////////////////////////////////////////////////////
+  void SendQueue::set_max_queue_size(std::size_t max_queued_messages)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    max_queue_size_ = max_queued_messages;
+  }
+
+  std::size_t SendQueue::get_max_queue_size() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return max_queue_size_;
+  }
+
+  void SendQueue::set_max_datagrams_in_flight(std::size_t max_datagrams_in_flight)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    max_datagrams_in_flight_ = (max_datagrams_in_flight > 0 ? max_datagrams_in_flight : 1);
+  }
+
+  std::size_t SendQueue::get_max_datagrams_in_flight() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return max_datagrams_in_flight_;
+  }
+
+  void SendQueue::set_high_water_mark(std::size_t high_water_mark_bytes, const std::function<void(bool)>& high_water_mark_callback)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    high_water_mark_bytes_    = high_water_mark_bytes;
+    high_water_mark_callback_ = high_water_mark_callback;
+    high_water_mark_exceeded_ = ((high_water_mark_bytes_ > 0) && (queued_bytes_ >= high_water_mark_bytes_));
+  }
+
+  void SendQueue::set_zerocopy_threshold(std::size_t zerocopy_threshold_bytes)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    zerocopy_threshold_ = zerocopy_threshold_bytes;
+  }
+
+  std::size_t SendQueue::get_zerocopy_threshold() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return zerocopy_threshold_;
+  }
+
+  std::size_t SendQueue::get_queued_bytes() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return queued_bytes_;
+  }
+
+  std::size_t SendQueue::get_queued_messages() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+}
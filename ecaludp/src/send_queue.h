@@ -0,0 +1,199 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "protocol/datagram_description.h"
+
+namespace ecaludp
+{
+  class TokenBucket;
+
+  /**
+   * @brief The send queue for asynchronous sending of datagram lists
+   *
+   * Messages are sent in the order they have been pushed to the queue. The
+   * datagrams of the queued messages are issued as async_send_to operations in
+   * bursts of up to max_datagrams_in_flight datagrams. The operations are
+   * executed immediately by asio, if the socket is writable. Only if the
+   * socket would block, asio waits for the socket to become writable again.
+   * As asio executes the operations of one socket in order, the order of the
+   * datagrams on the wire is preserved.
+   *
+   * The completion handlers are always called in the order the messages have
+   * been pushed to the queue, one after another, even if multiple threads run
+   * the io_context. When the queue is destroyed, the handlers of all
+   * remaining messages are posted to the io_context with
+   * operation_aborted. Operations that complete afterwards don't touch the
+   * queue anymore.
+   *
+   * If the rate limiter is enabled, a datagram is only issued when the rate
+   * limiter has enough tokens. Otherwise, a timer on the io_context is used
+   * to continue sending as soon as enough tokens are available.
+   *
+   * Messages that are at least zerocopy_threshold bytes large are sent with
+   * MSG_ZEROCOPY on Linux. The kernel then does not copy the payload, but
+   * uses the user memory directly. The completion handler of such a message
+   * is only called when the kernel has reported (via the error queue of the
+   * socket) that it doesn't need the memory anymore.
+   */
+  class SendQueue
+  {
+  /////////////////////////////////////////////////////////////////
+  // Public types
+  /////////////////////////////////////////////////////////////////
+  public:
+    /// Called with the error, the bytes sent including headers and the number of datagrams sent
+    using CompletionHandler = std::function<void(asio::error_code, std::size_t, std::size_t)>;
+
+  /////////////////////////////////////////////////////////////////
+  // Private types
+  /////////////////////////////////////////////////////////////////
+  private:
+    struct SendJob
+    {
+      std::shared_ptr<DatagramList>               datagram_list_;
+      std::vector<asio::ip::udp::endpoint>        destinations_;
+      CompletionHandler                           completion_handler_;
+
+      std::size_t                                 next_datagram_     {0};  ///< Index of the next datagram to send, counted over all (destination x datagram) pairs
+      std::size_t                                 datagrams_in_flight_{0};
+      std::size_t                                 unsent_bytes_      {0};  ///< Bytes that are still accounted for in the queue
+      asio::error_code                            error_;
+      std::size_t                                 bytes_sent_        {0};
+      std::size_t                                 datagrams_sent_    {0};
+
+      bool                                        zerocopy_          {false};
+      std::size_t                                 zerocopy_sends_    {0};  ///< Number of successful zerocopy sends. Each one is assigned an ID by the kernel.
+
+      std::size_t total_datagram_count() const { return datagram_list_->size() * destinations_.size(); }
+      bool        is_finished()          const { return ((next_datagram_ >= total_datagram_count()) || error_) && (datagrams_in_flight_ == 0); }
+    };
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    SendQueue(asio::ip::udp::socket& socket, TokenBucket& rate_limiter);
+
+    // Disable copy and move
+    SendQueue(const SendQueue&)            = delete;
+    SendQueue& operator=(const SendQueue&) = delete;
+    SendQueue(SendQueue&&)                 = delete;
+    SendQueue& operator=(SendQueue&&)      = delete;
+
+    ~SendQueue();
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  public:
+    void push(const std::shared_ptr<DatagramList>&        datagram_list
+            , const std::vector<asio::ip::udp::endpoint>& destinations
+            , const CompletionHandler&                   completion_handler);
+
+  private:
+    void send_next_datagrams_locked();
+
+    void send_datagram_locked(const std::shared_ptr<SendJob>& job, std::size_t datagram_index, std::size_t destination_index, bool zerocopy);
+
+    void on_pacing_timer_expired();
+
+    void on_datagram_sent(const std::shared_ptr<SendJob>& job, std::size_t datagram_index, std::size_t destination_index, bool zerocopy, const asio::error_code& ec, std::size_t bytes_transferred);
+
+    bool prepare_zerocopy_locked();
+
+    void wait_for_zerocopy_completions_locked();
+
+    void on_zerocopy_completions(const asio::error_code& ec);
+
+    void read_zerocopy_completions_locked();
+
+    bool is_zerocopy_completed_locked(const SendJob& job) const;
+
+    void collect_finished_jobs_locked();
+
+    void call_completion_handlers();
+
+    bool update_high_water_mark_state_locked();
+
+    static std::size_t datagram_list_size(const DatagramList& datagram_list);
+
+  /////////////////////////////////////////////////////////////////
+  // Settings & Statistics
+  /////////////////////////////////////////////////////////////////
+  public:
+    void set_max_queue_size(std::size_t max_queued_messages);
+    std::size_t get_max_queue_size() const;
+
+    void set_max_datagrams_in_flight(std::size_t max_datagrams_in_flight);
+    std::size_t get_max_datagrams_in_flight() const;
+
+    void set_high_water_mark(std::size_t high_water_mark_bytes, const std::function<void(bool)>& high_water_mark_callback);
+
+    void set_zerocopy_threshold(std::size_t zerocopy_threshold_bytes);
+    std::size_t get_zerocopy_threshold() const;
+
+    std::size_t get_queued_bytes() const;
+    std::size_t get_queued_messages() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    asio::ip::udp::socket&                  socket_;
+    TokenBucket&                            rate_limiter_;
+    asio::steady_timer                      pacing_timer_;
+    bool                                    pacing_timer_active_;
+
+    mutable std::mutex                      mutex_;
+    std::deque<std::shared_ptr<SendJob>>    queue_;                       ///< All jobs that have not been completed, yet. The front job is the oldest one.
+    std::size_t                             first_unsent_job_index_;      ///< Index of the first job in queue_ that still has datagrams that have not been issued, yet
+    std::size_t                             datagrams_in_flight_;
+    std::size_t                             queued_bytes_;
+    std::deque<std::shared_ptr<SendJob>>    finished_jobs_;               ///< Jobs whose completion handlers have not been called, yet
+    bool                                    calling_completion_handlers_; ///< Whether a thread is currently calling the completion handlers of the finished_jobs_
+
+    std::size_t                             max_queue_size_;              ///< Maximum number of queued messages. 0 means unlimited.
+    std::size_t                             max_datagrams_in_flight_;
+
+    std::size_t                             high_water_mark_bytes_;       ///< 0 means disabled
+    std::function<void(bool)>               high_water_mark_callback_;
+    bool                                    high_water_mark_exceeded_;
+
+    // Zerocopy sending. All IDs are counted cumulatively, i.e. they don't
+    // wrap around like the 32 bit IDs of the kernel.
+    std::size_t                             zerocopy_threshold_;          ///< 0 means disabled
+    bool                                    zerocopy_wait_active_;        ///< Whether we are waiting for the error queue
+    uint64_t                                zerocopy_id_base_;            ///< The cumulative ID that the kernel counts as 0
+    uint64_t                                zerocopy_ids_sent_;           ///< Number of successful zerocopy sends
+    uint64_t                                zerocopy_ids_completed_;      ///< All IDs below this one have been reported as completed by the kernel
+    uint64_t                                zerocopy_ids_of_removed_jobs_;///< Number of zerocopy IDs used by jobs that have already been removed from the queue
+    std::map<uint64_t, uint64_t>            zerocopy_pending_ranges_;     ///< Completed ranges [first, last] that are not contiguous to zerocopy_ids_completed_, yet
+
+    std::shared_ptr<int>                    lifetime_token_;              ///< Used by the handlers of the socket and the timer to detect that the queue has been destroyed
+  };
+}
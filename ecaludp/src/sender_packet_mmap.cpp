@@ -0,0 +1,102 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <ecaludp/sender_packet_mmap.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "packet_mmap_transmitter.h"
+
+#include "protocol/datagram_builder_v5.h"
+#include "protocol/datagram_description.h"
+
+namespace ecaludp
+{
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  SenderPacketMmap::SenderPacketMmap(std::array<char, 4> magic_header_bytes)
+    : transmitter_          (std::make_unique<ecaludp::PacketMmapTransmitter>())
+    , magic_header_bytes_   (magic_header_bytes)
+    , max_udp_datagram_size_(1448)
+  {}
+
+  // Destructor
+  SenderPacketMmap::~SenderPacketMmap() = default;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  bool SenderPacketMmap::set_max_udp_datagram_size(std::size_t max_udp_datagram_size)
+  {
+    if (transmitter_->is_bound())
+      return false;
+
+    max_udp_datagram_size_ = max_udp_datagram_size;
+    return true;
+  }
+
+  std::size_t SenderPacketMmap::get_max_udp_datagram_size() const
+  {
+    return max_udp_datagram_size_;
+  }
+
+  bool SenderPacketMmap::set_send_buffer_size(int size)
+  {
+    return transmitter_->set_send_buffer_size(size);
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // API "Passthrough"
+  /////////////////////////////////////////////////////////////////
+  bool SenderPacketMmap::is_valid() const                                     { return transmitter_->is_valid(); }
+  bool SenderPacketMmap::bind(const asio::ip::udp::endpoint& local_endpoint)  { return transmitter_->bind(local_endpoint, max_udp_datagram_size_); }
+  bool SenderPacketMmap::is_bound() const                                     { return transmitter_->is_bound(); }
+  asio::ip::udp::endpoint SenderPacketMmap::local_endpoint() const            { return transmitter_->local_endpoint(); }
+  void SenderPacketMmap::close()                                              { transmitter_->close(); }
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  std::size_t SenderPacketMmap::send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                      , const asio::ip::udp::endpoint&          destination
+                                      , asio::error_code&                       ec)
+  {
+    const std::size_t bytes_written = enqueue_to(buffer_sequence, destination, ec);
+    if (ec)
+      return bytes_written;
+
+    flush(ec);
+    return bytes_written;
+  }
+
+  std::size_t SenderPacketMmap::enqueue_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                         , const asio::ip::udp::endpoint&          destination
+                                         , asio::error_code&                       ec)
+  {
+    // Create fragments from the buffer_sequence
+    const ecaludp::DatagramList datagram_list = ecaludp::v5::create_datagram_list(buffer_sequence, max_udp_datagram_size_, magic_header_bytes_);
+
+    return transmitter_->write_datagrams(datagram_list, destination, ec);
+  }
+
+  void SenderPacketMmap::flush(asio::error_code& ec)
+  {
+    transmitter_->flush(ec);
+  }
+}
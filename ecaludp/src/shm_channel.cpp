@@ -0,0 +1,569 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "shm_channel.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+
+namespace ecaludp
+{
+  /**
+   * @brief The header at the beginning of the shared memory
+   *
+   * The indices are monotonically increasing byte counters. The position in
+   * the data area is the index modulo the data size.
+   */
+  struct ShmRingHeader
+  {
+    alignas(64) uint64_t write_index;       ///< Written by the writer. End of the last complete record.
+    alignas(64) uint64_t read_index;        ///< Written by the reader. Everything before has been given back to the writer.
+    alignas(64) uint64_t data_size;         ///< Size of the data area that follows the header page
+    uint32_t             reader_closed;
+  };
+
+  namespace
+  {
+    struct ShmRecordHeader
+    {
+      uint64_t record_size;                 ///< Including this header and the padding
+      uint64_t payload_size;
+      char     magic_header_bytes[4];
+      uint32_t flags;
+    };
+
+    struct ShmChannelHello
+    {
+      char     magic_header_bytes[4];
+      uint16_t sender_port;
+      uint8_t  sender_is_v6;
+      uint8_t  reserved;
+      uint8_t  sender_address[16];
+    };
+
+    constexpr uint64_t record_alignment = 64;
+    constexpr uint32_t record_flag_skip = 0x1;         // The record only fills the space up to the end of the ring
+
+    uint64_t align_up(uint64_t value, uint64_t alignment)
+    {
+      return ((value + alignment - 1) / alignment) * alignment;
+    }
+
+    std::size_t page_size()
+    {
+      return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    asio::error_code last_error()
+    {
+      return asio::error_code(errno, asio::error::get_system_category());
+    }
+  }
+
+  asio::generic::seq_packet_protocol::endpoint shm_channel_endpoint(const std::array<char, 4>& magic_header_bytes, const asio::ip::udp::endpoint& endpoint)
+  {
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (const char c : magic_header_bytes)
+      ss << std::setw(2) << static_cast<unsigned int>(static_cast<uint8_t>(c));
+
+    // Abstract socket names start with a null character
+    const std::string name = std::string(1, '\0') + "ecaludp-shm-" + ss.str() + "-" + endpoint.address().to_string() + "-" + std::to_string(endpoint.port());
+    return asio::generic::seq_packet_protocol::endpoint(asio::local::stream_protocol::endpoint(name));
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // ShmRingWriter
+  /////////////////////////////////////////////////////////////////
+  ShmRingWriter::ShmRingWriter()
+    : memory_fd_   (-1)
+    , event_fd_    (-1)
+    , mapping_     (nullptr)
+    , mapping_size_(0)
+    , header_      (nullptr)
+    , data_        (nullptr)
+    , data_size_   (0)
+  {}
+
+  ShmRingWriter::~ShmRingWriter()
+  {
+    if (mapping_ != nullptr)
+      ::munmap(mapping_, mapping_size_);
+    if (event_fd_ >= 0)
+      ::close(event_fd_);
+    if (memory_fd_ >= 0)
+      ::close(memory_fd_);
+  }
+
+  void ShmRingWriter::create(std::size_t ring_size, asio::error_code& ec)
+  {
+    const std::size_t header_size = page_size();
+    const std::size_t data_size   = static_cast<std::size_t>(align_up(std::max<std::size_t>(ring_size, header_size), header_size));
+
+    memory_fd_ = ::memfd_create("ecaludp_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memory_fd_ < 0)
+    {
+      ec = last_error();
+      return;
+    }
+
+    if (::ftruncate(memory_fd_, static_cast<off_t>(header_size + data_size)) != 0)
+    {
+      ec = last_error();
+      return;
+    }
+
+    // The reader maps the memory with the size it sees. Sealing the size
+    // guarantees that nobody can shrink it afterwards, which would make the
+    // reader crash with a SIGBUS.
+    if (::fcntl(memory_fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+    {
+      ec = last_error();
+      return;
+    }
+
+    void* mapping = ::mmap(nullptr, header_size + data_size, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd_, 0);
+    if (mapping == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast, performance-no-int-to-ptr) MAP_FAILED is a macro with a C-style cast
+    {
+      ec = last_error();
+      return;
+    }
+
+    mapping_      = mapping;
+    mapping_size_ = header_size + data_size;
+    header_       = static_cast<ShmRingHeader*>(mapping_);
+    data_         = static_cast<uint8_t*>(mapping_) + header_size;
+    data_size_    = data_size;
+
+    // The memory of a new memfd is zero-initialized
+    header_->data_size = data_size_;
+
+    event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0)
+    {
+      ec = last_error();
+      return;
+    }
+
+    ec = asio::error_code();
+  }
+
+  std::size_t ShmRingWriter::max_message_size() const
+  {
+    return static_cast<std::size_t>(data_size_ - sizeof(ShmRecordHeader));
+  }
+
+  bool ShmRingWriter::is_reader_closed() const
+  {
+    return (header_ == nullptr) || (__atomic_load_n(&header_->reader_closed, __ATOMIC_ACQUIRE) != 0);
+  }
+
+  bool ShmRingWriter::write(const std::vector<asio::const_buffer>& buffer_sequence, std::size_t message_size, const std::array<char, 4>& magic_header_bytes)
+  {
+    const uint64_t record_size = align_up(sizeof(ShmRecordHeader) + message_size, record_alignment);
+    if (record_size > data_size_)
+      return false;
+
+    const uint64_t write_index = __atomic_load_n(&header_->write_index, __ATOMIC_RELAXED);
+    const uint64_t read_index  = __atomic_load_n(&header_->read_index,  __ATOMIC_ACQUIRE);
+
+    // Records are never split, so the space up to the end of the ring may
+    // have to be skipped
+    const uint64_t space_to_end = data_size_ - (write_index % data_size_);
+    const uint64_t skip_size    = (space_to_end < record_size ? space_to_end : 0);
+
+    if (data_size_ - (write_index - read_index) < skip_size + record_size)
+      return false;
+
+    uint64_t record_index = write_index;
+
+    if (skip_size > 0)
+    {
+      auto* skip_record = reinterpret_cast<ShmRecordHeader*>(data_ + (record_index % data_size_));
+      skip_record->record_size  = skip_size;
+      skip_record->payload_size = 0;
+      std::memcpy(skip_record->magic_header_bytes, magic_header_bytes.data(), magic_header_bytes.size());
+      skip_record->flags        = record_flag_skip;
+
+      record_index += skip_size;
+    }
+
+    auto* record = reinterpret_cast<ShmRecordHeader*>(data_ + (record_index % data_size_));
+    record->record_size  = record_size;
+    record->payload_size = message_size;
+    std::memcpy(record->magic_header_bytes, magic_header_bytes.data(), magic_header_bytes.size());
+    record->flags        = 0;
+
+    uint8_t* payload = reinterpret_cast<uint8_t*>(record + 1);
+    for (const auto& buffer : buffer_sequence)
+    {
+      std::memcpy(payload, buffer.data(), buffer.size());
+      payload += buffer.size();
+    }
+
+    __atomic_store_n(&header_->write_index, record_index + record_size, __ATOMIC_RELEASE);
+
+    // Wake up the reader. This can only fail, if the counter overflows, in
+    // which case the reader will be woken up anyways.
+    const uint64_t event_count = 1;
+    const auto bytes_written = ::write(event_fd_, &event_count, sizeof(event_count));
+    static_cast<void>(bytes_written);
+
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // ShmRingReader
+  /////////////////////////////////////////////////////////////////
+  ShmRingReader::ShmRingReader()
+    : mapping_     (nullptr)
+    , mapping_size_(0)
+    , header_      (nullptr)
+    , data_        (nullptr)
+    , data_size_   (0)
+    , next_record_ (0)
+    , is_corrupted_(false)
+  {}
+
+  ShmRingReader::~ShmRingReader()
+  {
+    if (mapping_ != nullptr)
+      ::munmap(mapping_, mapping_size_);
+  }
+
+  void ShmRingReader::map(int memory_fd, asio::error_code& ec)
+  {
+    const std::size_t header_size = page_size();
+
+    // Only accept memory that cannot change its size while we have it mapped
+    constexpr int required_seals = F_SEAL_SHRINK | F_SEAL_GROW;
+    const int     seals          = ::fcntl(memory_fd, F_GET_SEALS);
+    if ((seals < 0) || ((seals & required_seals) != required_seals))
+    {
+      ec = asio::error::invalid_argument;
+      ::close(memory_fd);
+      return;
+    }
+
+    struct stat memory_stat {};
+    if (::fstat(memory_fd, &memory_stat) != 0)
+    {
+      ec = last_error();
+      ::close(memory_fd);
+      return;
+    }
+
+    const auto mapping_size = static_cast<std::size_t>(memory_stat.st_size);
+    if (mapping_size <= header_size)
+    {
+      ec = asio::error::invalid_argument;
+      ::close(memory_fd);
+      return;
+    }
+
+    void* mapping = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+
+    // The mapping keeps the memory alive
+    ::close(memory_fd);
+
+    if (mapping == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast, performance-no-int-to-ptr) MAP_FAILED is a macro with a C-style cast
+    {
+      ec = last_error();
+      return;
+    }
+
+    mapping_      = mapping;
+    mapping_size_ = mapping_size;
+    header_       = static_cast<ShmRingHeader*>(mapping_);
+    data_         = static_cast<const uint8_t*>(mapping_) + header_size;
+    data_size_    = __atomic_load_n(&header_->data_size, __ATOMIC_ACQUIRE);
+
+    if ((data_size_ != mapping_size - header_size) || ((data_size_ % record_alignment) != 0))
+    {
+      ec = asio::error::invalid_argument;
+      return;
+    }
+
+    next_record_ = __atomic_load_n(&header_->read_index, __ATOMIC_ACQUIRE);
+    ec = asio::error_code();
+  }
+
+  std::shared_ptr<ecaludp::OwningBuffer> ShmRingReader::read_next(const std::array<char, 4>& magic_header_bytes, ecaludp::Error& error)
+  {
+    if (is_corrupted_ || (header_ == nullptr))
+    {
+      error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Shared memory ring is corrupted");
+      return nullptr;
+    }
+
+    while (true)
+    {
+      const uint64_t write_index = __atomic_load_n(&header_->write_index, __ATOMIC_ACQUIRE);
+      if (next_record_ == write_index)
+      {
+        error = ecaludp::Error(ecaludp::Error::OK);
+        return nullptr;
+      }
+
+      const uint64_t position = next_record_ % data_size_;
+      const auto*    record   = reinterpret_cast<const ShmRecordHeader*>(data_ + position);
+
+      // Never trust the other process. It may change the record at any time,
+      // so each field is loaded only once (atomically, so the compiler
+      // cannot re-read it either).
+      const uint64_t record_size  = __atomic_load_n(&record->record_size,  __ATOMIC_RELAXED);
+      const uint64_t payload_size = __atomic_load_n(&record->payload_size, __ATOMIC_RELAXED);
+      if ((record_size < sizeof(ShmRecordHeader))
+          || ((record_size % record_alignment) != 0)
+          || (record_size > data_size_ - position)
+          || (record_size > write_index - next_record_)
+          || (payload_size > record_size - sizeof(ShmRecordHeader)))
+      {
+        is_corrupted_ = true;
+        error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Shared memory ring is corrupted");
+        return nullptr;
+      }
+
+      const uint64_t record_begin = next_record_;
+      const bool     is_skip      = ((record->flags & record_flag_skip) != 0);
+      next_record_ += record_size;
+
+      {
+        const std::lock_guard<std::mutex> lock(release_mutex_);
+        unreleased_records_.push_back(Record{record_begin, next_record_, false});
+      }
+
+      if (is_skip)
+      {
+        release(record_begin);
+        continue;
+      }
+
+      if (std::memcmp(record->magic_header_bytes, magic_header_bytes.data(), magic_header_bytes.size()) != 0)
+      {
+        // Messages of other protocols are dropped, just like datagrams
+        release(record_begin);
+        continue;
+      }
+
+      // The buffer keeps the reader (and thus the mapping) alive and gives
+      // the space back to the writer, when it is destroyed
+      const std::shared_ptr<ShmRingReader> reader = shared_from_this();
+      const std::shared_ptr<void const> owner(record, [reader, record_begin](const void*) { reader->release(record_begin); });
+
+      error = ecaludp::Error(ecaludp::Error::OK);
+      return std::make_shared<ecaludp::OwningBuffer>(record + 1, static_cast<std::size_t>(payload_size), owner);
+    }
+  }
+
+  void ShmRingReader::close()
+  {
+    if (header_ != nullptr)
+      __atomic_store_n(&header_->reader_closed, 1, __ATOMIC_RELEASE);
+  }
+
+  void ShmRingReader::release(uint64_t record_begin)
+  {
+    const std::lock_guard<std::mutex> lock(release_mutex_);
+
+    auto record_it = std::lower_bound(unreleased_records_.begin(), unreleased_records_.end(), record_begin
+                                    , [](const Record& record, uint64_t begin) { return record.begin_ < begin; });
+    if ((record_it == unreleased_records_.end()) || (record_it->begin_ != record_begin))
+      return;
+
+    record_it->released_ = true;
+
+    // The writer can only re-use the space up to the first record that is
+    // still in use
+    if (!unreleased_records_.front().released_)
+      return;
+
+    uint64_t read_index = 0;
+    while (!unreleased_records_.empty() && unreleased_records_.front().released_)
+    {
+      read_index = unreleased_records_.front().end_;
+      unreleased_records_.pop_front();
+    }
+
+    __atomic_store_n(&header_->read_index, read_index, __ATOMIC_RELEASE);
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Handshake
+  /////////////////////////////////////////////////////////////////
+  void send_shm_channel_hello(int socket_fd
+                            , const ShmRingWriter& ring
+                            , const asio::ip::udp::endpoint& sender_endpoint
+                            , const std::array<char, 4>& magic_header_bytes
+                            , asio::error_code& ec)
+  {
+    ShmChannelHello hello {};
+    std::memcpy(hello.magic_header_bytes, magic_header_bytes.data(), magic_header_bytes.size());
+    hello.sender_port = sender_endpoint.port();
+    if (sender_endpoint.address().is_v6())
+    {
+      const auto address_bytes = sender_endpoint.address().to_v6().to_bytes();
+      std::memcpy(hello.sender_address, address_bytes.data(), address_bytes.size());
+      hello.sender_is_v6 = 1;
+    }
+    else
+    {
+      const auto address_bytes = sender_endpoint.address().to_v4().to_bytes();
+      std::memcpy(hello.sender_address, address_bytes.data(), address_bytes.size());
+    }
+
+    std::array<int, 2> fds {ring.memory_fd(), ring.event_fd()};
+
+    iovec iov {};
+    iov.iov_base = &hello;
+    iov.iov_len  = sizeof(hello);
+
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(fds))> control {};
+
+    msghdr message {};
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.data();
+    message.msg_controllen = control.size();
+
+    cmsghdr* cmsg   = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(fds));
+
+    if (::sendmsg(socket_fd, &message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(hello)))
+      ec = last_error();
+    else
+      ec = asio::error_code();
+  }
+
+  void receive_shm_channel_hello(int socket_fd
+                               , const std::array<char, 4>& magic_header_bytes
+                               , int& memory_fd
+                               , int& event_fd
+                               , asio::ip::udp::endpoint& sender_endpoint
+                               , asio::error_code& ec)
+  {
+    memory_fd = -1;
+    event_fd  = -1;
+
+    ShmChannelHello hello {};
+
+    iovec iov {};
+    iov.iov_base = &hello;
+    iov.iov_len  = sizeof(hello);
+
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(2 * sizeof(int))> control {};
+
+    msghdr message {};
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.data();
+    message.msg_controllen = control.size();
+
+    const ssize_t bytes_received = ::recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    if (bytes_received < 0)
+    {
+      ec = last_error();
+      return;
+    }
+
+    // Take the ownership of all fds, before checking anything else
+    std::vector<int> received_fds;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+    {
+      if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS))
+      {
+        const std::size_t fd_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (std::size_t i = 0; i < fd_count; ++i)
+        {
+          int fd = -1;
+          std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+          received_fds.push_back(fd);
+        }
+      }
+    }
+
+    if (bytes_received == 0)
+      ec = asio::error::eof;
+    else if ((bytes_received != static_cast<ssize_t>(sizeof(hello)))
+             || ((message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0)
+             || (received_fds.size() != 2)
+             || (std::memcmp(hello.magic_header_bytes, magic_header_bytes.data(), magic_header_bytes.size()) != 0))
+      ec = asio::error::invalid_argument;
+    else
+      ec = asio::error_code();
+
+    // The listener can be reached by every process on this host, but the
+    // sender endpoint in the hello is not verified. So we only accept
+    // channels from processes of the same user (or root).
+    if (!ec)
+    {
+      ucred     peer_credentials {};
+      socklen_t peer_credentials_size = sizeof(peer_credentials);
+      if (::getsockopt(socket_fd, SOL_SOCKET, SO_PEERCRED, &peer_credentials, &peer_credentials_size) != 0)
+        ec = last_error();
+      else if ((peer_credentials.uid != ::geteuid()) && (peer_credentials.uid != 0))
+        ec = asio::error::access_denied;
+    }
+
+    if (ec)
+    {
+      for (const int fd : received_fds)
+        ::close(fd);
+      return;
+    }
+
+    memory_fd = received_fds[0];
+    event_fd  = received_fds[1];
+
+    if (hello.sender_is_v6 != 0)
+    {
+      asio::ip::address_v6::bytes_type address_bytes {};
+      std::memcpy(address_bytes.data(), hello.sender_address, address_bytes.size());
+      sender_endpoint = asio::ip::udp::endpoint(asio::ip::address_v6(address_bytes), hello.sender_port);
+    }
+    else
+    {
+      asio::ip::address_v4::bytes_type address_bytes {};
+      std::memcpy(address_bytes.data(), hello.sender_address, address_bytes.size());
+      sender_endpoint = asio::ip::udp::endpoint(asio::ip::address_v4(address_bytes), hello.sender_port);
+    }
+  }
+}
@@ -0,0 +1,197 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+
+namespace ecaludp
+{
+  struct ShmRingHeader;
+
+  /**
+   * @brief Returns the address of the channel listener of a SocketShm bound to the given endpoint
+   *
+   * The address is in the abstract namespace of Unix domain sockets, so it
+   * doesn't have to be cleaned up and is only visible in the same network
+   * namespace.
+   */
+  asio::generic::seq_packet_protocol::endpoint shm_channel_endpoint(const std::array<char, 4>& magic_header_bytes, const asio::ip::udp::endpoint& endpoint);
+
+  /**
+   * @brief The sending side of a shared memory ring
+   *
+   * The ring lives in a memfd that is handed to the receiver together with an
+   * eventfd, which is signalled for every message. Each message is written as
+   * one record (header + payload), so there is no fragmentation. A record is
+   * never split at the end of the ring; the remaining space is skipped
+   * instead.
+   *
+   * The writer never waits for the reader. If there is not enough free space
+   * in the ring, the message is dropped, just like a full UDP receive buffer
+   * would drop it.
+   *
+   * The class is not thread-safe.
+   */
+  class ShmRingWriter
+  {
+  public:
+    ShmRingWriter();
+
+    // Disable copy and move
+    ShmRingWriter(const ShmRingWriter&)            = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+    ShmRingWriter(ShmRingWriter&&)                 = delete;
+    ShmRingWriter& operator=(ShmRingWriter&&)      = delete;
+
+    ~ShmRingWriter();
+
+    /**
+     * @brief Creates the shared memory and the eventfd
+     *
+     * @param ring_size The size of the data area. It is rounded up to the page size.
+     */
+    void create(std::size_t ring_size, asio::error_code& ec);
+
+    int memory_fd() const { return memory_fd_; }
+    int event_fd()  const { return event_fd_; }
+
+    /**
+     * @brief Returns the size of the largest message that fits into the ring
+     */
+    std::size_t max_message_size() const;
+
+    /**
+     * @brief Returns whether the reader has closed the channel
+     */
+    bool is_reader_closed() const;
+
+    /**
+     * @brief Copies the message to the ring and signals the reader
+     *
+     * @return false, if there was not enough free space and the message has been dropped
+     */
+    bool write(const std::vector<asio::const_buffer>& buffer_sequence, std::size_t message_size, const std::array<char, 4>& magic_header_bytes);
+
+  private:
+    int            memory_fd_;
+    int            event_fd_;
+    void*          mapping_;
+    std::size_t    mapping_size_;
+    ShmRingHeader* header_;
+    uint8_t*       data_;
+    uint64_t       data_size_;
+  };
+
+  /**
+   * @brief The receiving side of a shared memory ring
+   *
+   * Messages are handed out as OwningBuffers that point into the shared
+   * memory. The space of a message is given back to the writer once the
+   * buffer and all buffers before it have been released.
+   *
+   * The reader must be managed by a std::shared_ptr, as the buffers keep it
+   * alive. Reading is not thread-safe, releasing the buffers is.
+   */
+  class ShmRingReader : public std::enable_shared_from_this<ShmRingReader>
+  {
+  private:
+    struct Record
+    {
+      uint64_t begin_;
+      uint64_t end_;
+      bool     released_;
+    };
+
+  public:
+    ShmRingReader();
+
+    // Disable copy and move
+    ShmRingReader(const ShmRingReader&)            = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+    ShmRingReader(ShmRingReader&&)                 = delete;
+    ShmRingReader& operator=(ShmRingReader&&)      = delete;
+
+    ~ShmRingReader();
+
+    /**
+     * @brief Maps the shared memory of a writer. Takes the ownership of the fd.
+     */
+    void map(int memory_fd, asio::error_code& ec);
+
+    /**
+     * @brief Returns the next message or nullptr, if the ring is empty
+     *
+     * Messages with other magic bytes are skipped. If the ring is corrupted,
+     * nullptr is returned and the error is set. Reading is not possible
+     * anymore afterwards.
+     */
+    std::shared_ptr<ecaludp::OwningBuffer> read_next(const std::array<char, 4>& magic_header_bytes, ecaludp::Error& error);
+
+    /**
+     * @brief Tells the writer that no more messages will be read
+     */
+    void close();
+
+  private:
+    void release(uint64_t record_begin);
+
+  private:
+    void*              mapping_;
+    std::size_t        mapping_size_;
+    ShmRingHeader*     header_;
+    const uint8_t*     data_;
+    uint64_t           data_size_;
+
+    uint64_t           next_record_;         ///< Index of the next record to read
+    bool               is_corrupted_;
+
+    std::mutex         release_mutex_;
+    std::deque<Record> unreleased_records_;  ///< All records that have been read, but not given back to the writer, yet
+  };
+
+  /**
+   * @brief Sends the memfd and eventfd of the ring and the sender endpoint to the receiver
+   */
+  void send_shm_channel_hello(int socket_fd
+                            , const ShmRingWriter& ring
+                            , const asio::ip::udp::endpoint& sender_endpoint
+                            , const std::array<char, 4>& magic_header_bytes
+                            , asio::error_code& ec);
+
+  /**
+   * @brief Receives the hello of a writer. The caller owns the returned fds.
+   *
+   * Hellos from processes of other users (except root) are rejected with
+   * asio::error::access_denied.
+   */
+  void receive_shm_channel_hello(int socket_fd
+                               , const std::array<char, 4>& magic_header_bytes
+                               , int& memory_fd
+                               , int& event_fd
+                               , asio::ip::udp::endpoint& sender_endpoint
+                               , asio::error_code& ec);
+}
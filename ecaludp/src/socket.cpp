@@ -13,76 +13,50 @@
  * 
  * SPDX-License-Identifier: Apache-2.0
  ********************************************************************************/
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstddef>
-#include <cstring>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <mutex>
-#include <recycle/shared_pool.hpp>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <asio.hpp> // IWYU pragma: keep
 
+#include "datagram_list_sender.h"
 #include "ecaludp/error.h"
 #include "ecaludp/raw_memory.h"
 #include "protocol/datagram_builder_v5.h"
 #include "protocol/datagram_description.h"
-#include "protocol/header_common.h"
-#include "protocol/reassembly_v5.h"
+#include "receive_engine.h"
+#include "receive_profiler.h"
+#include "send_queue.h"
+#include "token_bucket.h"
+#include "udp_gro.h"
 
 #include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/reassembly_limits.h>
 #include <ecaludp/socket.h>
 
 namespace ecaludp
 {
-  namespace
-  {
-    void async_send_datagram_list_to(asio::ip::udp::socket& socket
-                                      , const DatagramList& datagram_list
-                                      , DatagramList::const_iterator start_it
-                                      , const asio::ip::udp::endpoint& destination
-                                      , const std::function<void(asio::error_code)>& completion_handler)
-    {
-      if (start_it == datagram_list.end())
-      {
-        completion_handler(asio::error_code());
-        return;
-      }
-
-      socket.async_send_to(start_it->asio_buffer_list_
-                            , destination
-                            , [&socket, &datagram_list, start_it, destination, completion_handler](asio::error_code ec, std::size_t /*bytes_transferred*/)
-                              {
-                                if (ec)
-                                {
-                                  completion_handler(ec);
-                                  return;
-                                }
-
-                                async_send_datagram_list_to(socket, datagram_list, start_it + 1, destination, completion_handler);
-                              });
-    }
-  }
-
-  struct buffer_pool_lock_policy_
-  {
-    using mutex_type = std::mutex;
-    using lock_type  = std::lock_guard<mutex_type>;
-  };
-
-  class recycle_shared_pool : public recycle::shared_pool<ecaludp::RawMemory, buffer_pool_lock_policy_>{};
-
   Socket::Socket(asio::io_context& io_context, std::array<char, 4> magic_header_bytes)
     : socket_               (io_context)
-    , datagram_buffer_pool_ (std::make_unique<ecaludp::recycle_shared_pool>())
-    , reassembly_v5_        (std::make_unique<ecaludp::v5::Reassembly>())
+    , receive_engine_       (std::make_unique<ecaludp::ReceiveEngine>(magic_header_bytes))
+    , send_rate_limiter_    (std::make_unique<ecaludp::TokenBucket>())
+    , send_queue_           (std::make_unique<ecaludp::SendQueue>(socket_, *send_rate_limiter_))
     , magic_header_bytes_   (magic_header_bytes)
     , max_udp_datagram_size_(1448)
-    , max_reassembly_age_   (std::chrono::seconds(5))
+    , udp_gso_enabled_      (false)
+    , udp_gso_support_      (OffloadSupport::UNKNOWN)
+    , udp_gro_enabled_      (false)
+    , udp_gro_support_      (OffloadSupport::UNKNOWN)
+    , udp_gro_buffer_offset_(0)
+    , udp_gro_segment_size_ (0)
   {}
 
   Socket::~Socket() = default;
@@ -95,6 +69,14 @@ namespace ecaludp
                             , const asio::ip::udp::endpoint& destination
                             , asio::socket_base::message_flags flags
                             , asio::error_code& ec)
+  {
+    return send_to(buffer_sequence, std::vector<asio::ip::udp::endpoint>{destination}, flags, ec);
+  }
+
+  std::size_t Socket::send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                            , const std::vector<asio::ip::udp::endpoint>& destinations
+                            , asio::socket_base::message_flags flags
+                            , asio::error_code& ec)
   {
     constexpr int protocol_version = 5;  //TODO: make this configurable
 
@@ -109,19 +91,57 @@ namespace ecaludp
       throw std::runtime_error("Protocol version not supported");
     }
 
-    std::size_t sent(0);
-    for (const auto& datagram : datagram_list)
+    if (udp_gso_enabled_)
     {
-      sent += socket_.send_to(datagram.asio_buffer_list_, destination, flags, ec);
-      if (ec) 
-        break;
+      if ((udp_gso_support_ == OffloadSupport::UNKNOWN) && socket_.is_open())
+        udp_gso_support_ = (is_udp_gso_supported(socket_) ? OffloadSupport::SUPPORTED : OffloadSupport::UNSUPPORTED);
+
+      if (udp_gso_support_ == OffloadSupport::SUPPORTED)
+      {
+        const std::size_t bytes_sent = send_datagram_list_gso_to(socket_, datagram_list, destinations, flags, send_rate_limiter_.get(), ec);
+
+        // Only fall back to the regular send path, if the kernel rejected the
+        // message. It will reject all further messages the same way, so GSO
+        // is not tried again on this socket.
+        if (ec != asio::error::operation_not_supported)
+          return bytes_sent;
+
+        udp_gso_support_ = OffloadSupport::UNSUPPORTED;
+      }
     }
-    return sent;
+
+    return send_datagram_list_to(socket_, datagram_list, destinations, flags, send_rate_limiter_.get(), ec);
   }
 
   void Socket::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
                                 , const asio::ip::udp::endpoint& destination
                                 , const std::function<void(asio::error_code)>& completion_handler)
+  {
+    async_send_to(buffer_sequence, std::vector<asio::ip::udp::endpoint>{destination}, completion_handler);
+  }
+
+  void Socket::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                , const std::vector<asio::ip::udp::endpoint>& destinations
+                                , const std::function<void(asio::error_code)>& completion_handler)
+  {
+    async_send_to(buffer_sequence
+                , destinations
+                , [completion_handler](asio::error_code ec, std::size_t /*bytes_sent*/, std::size_t /*datagrams_sent*/)
+                  {
+                    completion_handler(ec);
+                  });
+  }
+
+  void Socket::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                , const asio::ip::udp::endpoint& destination
+                                , const std::function<void(asio::error_code, std::size_t, std::size_t)>& completion_handler)
+  {
+    async_send_to(buffer_sequence, std::vector<asio::ip::udp::endpoint>{destination}, completion_handler);
+  }
+
+  void Socket::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                , const std::vector<asio::ip::udp::endpoint>& destinations
+                                , const std::function<void(asio::error_code, std::size_t, std::size_t)>& completion_handler)
   {
     constexpr int protocol_version  = 5;  //TODO: make this configurable
 
@@ -136,14 +156,7 @@ namespace ecaludp
       throw std::runtime_error("Protocol version not supported");
     }
 
-    async_send_datagram_list_to(socket_
-                              , *datagram_list
-                              , datagram_list->begin()
-                              , destination
-                              , [completion_handler, datagram_list](asio::error_code ec)
-                                {
-                                  completion_handler(ec);
-                                });
+    send_queue_->push(datagram_list, destinations, completion_handler);
   }
 
   void Socket::set_max_udp_datagram_size(std::size_t max_udp_datagram_size)
@@ -156,14 +169,94 @@ namespace ecaludp
     return max_udp_datagram_size_;
   }
 
+  void Socket::set_max_send_queue_size(std::size_t max_queued_messages)
+  {
+    send_queue_->set_max_queue_size(max_queued_messages);
+  }
+
+  std::size_t Socket::get_max_send_queue_size() const
+  {
+    return send_queue_->get_max_queue_size();
+  }
+
+  void Socket::set_max_datagrams_in_flight(std::size_t max_datagrams_in_flight)
+  {
+    send_queue_->set_max_datagrams_in_flight(max_datagrams_in_flight);
+  }
+
+  std::size_t Socket::get_max_datagrams_in_flight() const
+  {
+    return send_queue_->get_max_datagrams_in_flight();
+  }
+
+  void Socket::set_send_queue_high_water_mark(std::size_t high_water_mark_bytes, const std::function<void(bool)>& high_water_mark_callback)
+  {
+    send_queue_->set_high_water_mark(high_water_mark_bytes, high_water_mark_callback);
+  }
+
+  std::size_t Socket::get_send_queue_bytes() const
+  {
+    return send_queue_->get_queued_bytes();
+  }
+
+  std::size_t Socket::get_send_queue_messages() const
+  {
+    return send_queue_->get_queued_messages();
+  }
+
+  void Socket::set_send_rate_limit(std::size_t rate_bytes_per_second, std::size_t burst_bytes)
+  {
+    send_rate_limiter_->configure(rate_bytes_per_second, burst_bytes);
+  }
+
+  std::size_t Socket::get_send_rate_limit() const
+  {
+    return send_rate_limiter_->get_rate();
+  }
+
+  std::size_t Socket::get_send_burst_size() const
+  {
+    return send_rate_limiter_->get_burst();
+  }
+
+  void Socket::set_zerocopy_threshold(std::size_t zerocopy_threshold_bytes)
+  {
+    send_queue_->set_zerocopy_threshold(zerocopy_threshold_bytes);
+  }
+
+  std::size_t Socket::get_zerocopy_threshold() const
+  {
+    return send_queue_->get_zerocopy_threshold();
+  }
+
+  void Socket::set_udp_gso_enabled(bool enabled)
+  {
+    udp_gso_enabled_ = enabled;
+  }
+
+  bool Socket::is_udp_gso_enabled() const
+  {
+    return udp_gso_enabled_;
+  }
+
   void Socket::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
   {
-    max_reassembly_age_ = max_reassembly_age;
+    receive_engine_->set_max_reassembly_age(max_reassembly_age);
   }
 
   std::chrono::steady_clock::duration Socket::get_max_reassembly_age() const
   {
-    return max_reassembly_age_;
+    return receive_engine_->get_max_reassembly_age();
+  }
+
+  void Socket::set_reassembly_limits(const ecaludp::ReassemblyLimits& limits)
+  {
+    receive_engine_->set_reassembly_limits(limits);
+  }
+
+  ecaludp::ReassemblyLimits Socket::get_reassembly_limits() const
+  {
+    return receive_engine_->get_reassembly_limits();
   }
 
   /////////////////////////////////////////////////////////////////
@@ -173,20 +266,46 @@ namespace ecaludp
                                                             , asio::socket_base::message_flags flags
                                                             , asio::error_code& ec)
   {
-    while (true)
+    // Handle datagrams that are left from a previously received GRO buffer
     {
-      auto datagram_buffer = datagram_buffer_pool_->allocate();
-      datagram_buffer->resize(65535); // Max UDP datagram size
+      auto completed_package = handle_pending_udp_gro_segments(sender_endpoint);
+      if (completed_package != nullptr)
+        return completed_package;
+    }
+
+    const bool use_udp_gro = is_udp_gro_active();
 
-      auto buffer = datagram_buffer_pool_->allocate();
+    while (true)
+    {
+      auto buffer = receive_engine_->allocate_buffer();
       buffer->resize(65535); // max datagram size
 
       auto sender_endpoint_of_this_datagram = std::make_shared<asio::ip::udp::endpoint>();
 
-      const std::size_t bytes_received = socket_.receive_from(asio::buffer(buffer->data(), buffer->size())
-                                                            , *sender_endpoint_of_this_datagram
-                                                            , flags
-                                                            , ec);
+      std::size_t bytes_received = 0;
+      std::size_t segment_size   = 0;
+
+      {
+        ECALUDP_PROFILE_SCOPE(receive_engine_->get_profiler().get(), ReceiveStage::RECEIVE_SYSCALL);
+
+        if (use_udp_gro)
+        {
+          bytes_received = receive_with_udp_gro(socket_
+                                              , asio::buffer(buffer->data(), buffer->size())
+                                              , *sender_endpoint_of_this_datagram
+                                              , segment_size
+                                              , flags
+                                              , true
+                                              , ec);
+        }
+        else
+        {
+          bytes_received = socket_.receive_from(asio::buffer(buffer->data(), buffer->size())
+                                              , *sender_endpoint_of_this_datagram
+                                              , flags
+                                              , ec);
+        }
+      }
 
       if (ec)
       {
@@ -212,9 +331,25 @@ namespace ecaludp
       // resize the buffer to the actually received size
       buffer->resize(bytes_received);
 
+      if (use_udp_gro)
+      {
+        // The buffer may contain multiple datagrams. Handle them one by one
+        // and keep the rest for the next call.
+        udp_gro_buffer_          = buffer;
+        udp_gro_buffer_offset_   = 0;
+        udp_gro_segment_size_    = segment_size;
+        udp_gro_sender_endpoint_ = sender_endpoint_of_this_datagram;
+
+        auto completed_package = handle_pending_udp_gro_segments(sender_endpoint);
+        if (completed_package != nullptr)
+          return completed_package;
+
+        continue;
+      }
+
       // Handle the datagram
       ecaludp::Error error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
-      auto completed_package = this->handle_datagram(buffer, sender_endpoint_of_this_datagram, error);
+      auto completed_package = receive_engine_->handle_datagram(buffer->data(), buffer->size(), buffer, sender_endpoint_of_this_datagram, error);
 
       if (completed_package != nullptr)
       {
@@ -229,18 +364,61 @@ namespace ecaludp
   void Socket::async_receive_from(asio::ip::udp::endpoint& sender_endpoint
                                       , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler)
   {
-    receive_next_datagram_from(sender_endpoint, completion_handler);
+    // Handle datagrams that are left from a previously received GRO buffer.
+    // The completion handler must not be called from within this function, so
+    // we post it to the io_context.
+    {
+      auto completed_package = handle_pending_udp_gro_segments(sender_endpoint);
+      if (completed_package != nullptr)
+      {
+        asio::post(socket_.get_executor(), [completed_package, completion_handler]() { completion_handler(completed_package, asio::error_code()); });
+        return;
+      }
+    }
+
+    if (is_udp_gro_active())
+      receive_next_datagram_with_udp_gro_from(sender_endpoint, completion_handler);
+    else
+      receive_next_datagram_from(sender_endpoint, completion_handler);
   }
 
+  void Socket::set_udp_gro_enabled(bool enabled)
+  {
+    // Turn GRO off again, if we have turned it on before. Otherwise the
+    // kernel would still deliver coalesced datagrams.
+    if (!enabled && (udp_gro_support_ == OffloadSupport::SUPPORTED))
+      set_udp_gro(socket_, false);
+
+    // The socket option is set when the next receive operation starts
+    udp_gro_enabled_ = enabled;
+    udp_gro_support_ = OffloadSupport::UNKNOWN;
+  }
 
-  void Socket::receive_next_datagram_from(asio::ip::udp::endpoint& sender_endpoint
-                                              , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler)
+  bool Socket::is_udp_gro_enabled() const
   {
-    auto datagram_buffer = datagram_buffer_pool_->allocate();
-    datagram_buffer->resize(65535); // Max UDP datagram size
+    return udp_gro_enabled_;
+  }
 
-    auto buffer = datagram_buffer_pool_->allocate();
+  std::vector<ecaludp::IncompleteMessage> Socket::get_reassembly_snapshot() const
+  {
+    return receive_engine_->get_reassembly_snapshot();
+  }
 
+  ecaludp::ReassemblyEvictionCounters Socket::get_reassembly_eviction_counters() const
+  {
+    return receive_engine_->get_reassembly_eviction_counters();
+  }
+
+  void Socket::set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback)
+  {
+    receive_engine_->set_partial_message_callback(partial_message_callback);
+  }
+
+
+  void Socket::receive_next_datagram_from(asio::ip::udp::endpoint& sender_endpoint
+                                              , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler)
+  {
+    auto buffer = receive_engine_->allocate_buffer();
     buffer->resize(65535); // max datagram size
 
     auto sender_endpoint_of_this_datagram = std::make_shared<asio::ip::udp::endpoint>();
@@ -260,11 +438,13 @@ namespace ecaludp
 
                                   // Handle the datagram
                                   ecaludp::Error error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
-                                  auto completed_package = this->handle_datagram(buffer, sender_endpoint_of_this_datagram, error);
+                                  auto completed_package = receive_engine_->handle_datagram(buffer->data(), buffer->size(), buffer, sender_endpoint_of_this_datagram, error);
 
                                   if (completed_package != nullptr)
                                   {
                                     sender_endpoint = *sender_endpoint_of_this_datagram;
+
+                                    ECALUDP_PROFILE_SCOPE(receive_engine_->get_profiler(), ReceiveStage::USER_CALLBACK);
                                     completion_handler(completed_package, ec);
                                   }
                                   else
@@ -276,52 +456,162 @@ namespace ecaludp
 
   }
 
-  std::shared_ptr<ecaludp::OwningBuffer> Socket::handle_datagram(const std::shared_ptr<ecaludp::RawMemory>& buffer
-                                                                  , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
-                                                                  , ecaludp::Error& error)
+  void Socket::receive_next_datagram_with_udp_gro_from(asio::ip::udp::endpoint& sender_endpoint
+                                                      , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)>& completion_handler)
   {
-    // Clean the reassembly from fragments that are too old
-    reassembly_v5_->remove_old_packages(std::chrono::steady_clock::now() - max_reassembly_age_);
+    // asio cannot tell us the GRO segment size, so we wait for the socket to
+    // become readable and then receive the data ourselves.
+    socket_.async_wait(asio::socket_base::wait_read
+                      , [this, completion_handler, &sender_endpoint](const asio::error_code& ec)
+                        {
+                          if (ec)
+                          {
+                            completion_handler(nullptr, ec);
+                            return;
+                          }
+
+                          auto buffer = receive_engine_->allocate_buffer();
+                          buffer->resize(65535); // max datagram size
+
+                          auto sender_endpoint_of_this_datagram = std::make_shared<asio::ip::udp::endpoint>();
+
+                          asio::error_code receive_ec;
+                          std::size_t      segment_size   = 0;
+                          std::size_t      bytes_received = 0;
+                          {
+                            ECALUDP_PROFILE_SCOPE(receive_engine_->get_profiler().get(), ReceiveStage::RECEIVE_SYSCALL);
+                            bytes_received = receive_with_udp_gro(socket_
+                                                                , asio::buffer(buffer->data(), buffer->size())
+                                                                , *sender_endpoint_of_this_datagram
+                                                                , segment_size
+                                                                , 0
+                                                                , false
+                                                                , receive_ec);
+                          }
+
+                          if (receive_ec == asio::error::would_block)
+                          {
+                            // Somebody else was faster. Wait for the next datagram.
+                            receive_next_datagram_with_udp_gro_from(sender_endpoint, completion_handler);
+                            return;
+                          }
+                          else if (receive_ec)
+                          {
+                            completion_handler(nullptr, receive_ec);
+                            return;
+                          }
+
+                          // resize the buffer to the actually received size
+                          buffer->resize(bytes_received);
+
+                          udp_gro_buffer_          = buffer;
+                          udp_gro_buffer_offset_   = 0;
+                          udp_gro_segment_size_    = segment_size;
+                          udp_gro_sender_endpoint_ = sender_endpoint_of_this_datagram;
+
+                          auto completed_package = handle_pending_udp_gro_segments(sender_endpoint);
+                          if (completed_package != nullptr)
+                          {
+                            ECALUDP_PROFILE_SCOPE(receive_engine_->get_profiler(), ReceiveStage::USER_CALLBACK);
+                            completion_handler(completed_package, receive_ec);
+                          }
+                          else
+                          {
+                            // Receive the next datagram
+                            receive_next_datagram_with_udp_gro_from(sender_endpoint, completion_handler);
+                          }
+                        });
+  }
 
-    // Start to parse the header
+  bool Socket::is_udp_gro_active()
+  {
+    if (!udp_gro_enabled_)
+      return false;
 
-    if (buffer->size() < sizeof(ecaludp::HeaderCommon)) // Magic number + version
-    {
-      error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Datagram too small to contain common header (" + std::to_string(buffer->size()) + " bytes)");
-      return nullptr;
-    }
+    if ((udp_gro_support_ == OffloadSupport::UNKNOWN) && socket_.is_open())
+      udp_gro_support_ = (set_udp_gro(socket_, true) ? OffloadSupport::SUPPORTED : OffloadSupport::UNSUPPORTED);
 
-    auto* header = reinterpret_cast<ecaludp::HeaderCommon*>(buffer->data());
+    return (udp_gro_support_ == OffloadSupport::SUPPORTED);
+  }
 
-    // Check the magic number
-    if (strncmp(header->magic, magic_header_bytes_.data(), 4) != 0)
-    {
-      error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Wrong magic bytes");
+  std::shared_ptr<ecaludp::OwningBuffer> Socket::handle_pending_udp_gro_segments(asio::ip::udp::endpoint& sender_endpoint)
+  {
+    if (udp_gro_buffer_ == nullptr)
       return nullptr;
-    }
 
-    std::shared_ptr<ecaludp::OwningBuffer> finished_package;
+    // All segments have the same size, except for the last one, which may be smaller
+    const std::size_t segment_size = (udp_gro_segment_size_ > 0 ? udp_gro_segment_size_ : udp_gro_buffer_->size());
 
-    // Check the version and invoke the correct handler
-    if (header->version == 5)
-    {
-      finished_package = reassembly_v5_->handle_datagram(buffer, sender_endpoint, error);
-    }
-    else if (header->version == 6)
-    {
-      error = ecaludp::Error(Error::UNSUPPORTED_PROTOCOL_VERSION, std::to_string(header->version));
-      //handle_datagram_v6(buffer);
-    }
-    else
+    std::shared_ptr<ecaludp::OwningBuffer> completed_package;
+
+    while ((completed_package == nullptr) && (udp_gro_buffer_offset_ < udp_gro_buffer_->size()))
     {
-      error = ecaludp::Error(Error::UNSUPPORTED_PROTOCOL_VERSION, std::to_string(header->version));
+      const auto*       segment_data = static_cast<const uint8_t*>(udp_gro_buffer_->data()) + udp_gro_buffer_offset_;
+      const std::size_t segment_len  = std::min(segment_size, udp_gro_buffer_->size() - udp_gro_buffer_offset_);
+
+      udp_gro_buffer_offset_ += segment_len;
+
+      // The segment is handled as a view into the GRO buffer, so nothing is copied here
+      ecaludp::Error error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
+      completed_package = receive_engine_->handle_datagram(segment_data, segment_len, udp_gro_buffer_, udp_gro_sender_endpoint_, error);
     }
 
-    if (error)
+    if (completed_package != nullptr)
+      sender_endpoint = *udp_gro_sender_endpoint_;
+
+    // Release the buffer as soon as all segments have been handled
+    if (udp_gro_buffer_offset_ >= udp_gro_buffer_->size())
     {
-      return nullptr;
+      udp_gro_buffer_.reset();
+      udp_gro_sender_endpoint_.reset();
+      udp_gro_buffer_offset_ = 0;
+      udp_gro_segment_size_  = 0;
     }
 
-    return finished_package;
+    return completed_package;
+  }
+
+#ifdef ECALUDP_PROFILING_ENABLED
+  /////////////////////////////////////////////////////////////////
+  // Profiling
+  /////////////////////////////////////////////////////////////////
+  ecaludp::ReceiveProfile Socket::get_receive_profile() const
+  {
+    return receive_engine_->get_profiler()->get_profile();
+  }
+
+  void Socket::reset_receive_profile()
+  {
+    receive_engine_->get_profiler()->reset();
+  }
+#endif // ECALUDP_PROFILING_ENABLED
+
+  /////////////////////////////////////////////////////////////////
+  // Recording
+  /////////////////////////////////////////////////////////////////
+  bool Socket::start_recording(const std::string& file_path, ecaludp::Error& error)
+  {
+    return receive_engine_->start_recording(file_path
+                                          , [this]()
+                                            {
+                                              asio::error_code ec;
+                                              return socket_.local_endpoint(ec);
+                                            }
+                                          , error);
+  }
+
+  void Socket::stop_recording()
+  {
+    receive_engine_->stop_recording();
+  }
+
+  bool Socket::is_recording() const
+  {
+    return receive_engine_->is_recording();
+  }
+
+  uint64_t Socket::get_recording_dropped_datagrams() const
+  {
+    return receive_engine_->get_recording_dropped_datagrams();
   }
 }
@@ -20,45 +20,31 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <vector>
 
 #include <ecaludp/error.h>
+#include <ecaludp/incomplete_message.h>
 #include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
 #include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
 
 #include <udpcap/host_address.h>
 
 #include "async_udpcap_socket.h"
-
-#include "protocol/header_common.h"
-#include "protocol/reassembly_v5.h"
-
-#include <recycle/shared_pool.hpp>
+#include "receive_engine.h"
 
 namespace ecaludp
 {
-  
-  struct buffer_pool_lock_policy_
-  {
-    using mutex_type = std::mutex;
-    using lock_type  = std::lock_guard<mutex_type>;
-  };
-
-  class recycle_shared_pool : public recycle::shared_pool<ecaludp::RawMemory, buffer_pool_lock_policy_>{};
-
   /////////////////////////////////////////////////////////////////
   // Constructor
   /////////////////////////////////////////////////////////////////
   SocketNpcap::SocketNpcap(std::array<char, 4> magic_header_bytes)
     : socket_              (std::make_unique<ecaludp::AsyncUdpcapSocket>())
-    , datagram_buffer_pool_(std::make_unique<recycle_shared_pool>())
-    , reassembly_v5_       (std::make_unique<ecaludp::v5::Reassembly>())
-    , magic_header_bytes_  (magic_header_bytes)
-    , max_reassembly_age_  (std::chrono::seconds(5))
+    , receive_engine_      (std::make_unique<ecaludp::ReceiveEngine>(magic_header_bytes))
   {}
 
   // Destructor
@@ -69,12 +55,32 @@ namespace ecaludp
   /////////////////////////////////////////////////////////////////
   void SocketNpcap::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
   {
-    max_reassembly_age_ = max_reassembly_age;
+    receive_engine_->set_max_reassembly_age(max_reassembly_age);
   }
 
   std::chrono::steady_clock::duration SocketNpcap::get_max_reassembly_age() const
   {
-    return max_reassembly_age_;
+    return receive_engine_->get_max_reassembly_age();
+  }
+
+  void SocketNpcap::set_reassembly_limits(const ecaludp::ReassemblyLimits& limits)
+  {
+    receive_engine_->set_reassembly_limits(limits);
+  }
+
+  ecaludp::ReassemblyLimits SocketNpcap::get_reassembly_limits() const
+  {
+    return receive_engine_->get_reassembly_limits();
+  }
+
+  ecaludp::ReassemblyEvictionCounters SocketNpcap::get_reassembly_eviction_counters() const
+  {
+    return receive_engine_->get_reassembly_eviction_counters();
+  }
+
+  void SocketNpcap::set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback)
+  {
+    receive_engine_->set_partial_message_callback(partial_message_callback);
   }
 
   /////////////////////////////////////////////////////////////////
@@ -97,49 +103,36 @@ namespace ecaludp
   
   std::shared_ptr<ecaludp::OwningBuffer> SocketNpcap::receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error)
   {
-    while (true)
-    {
-      auto datagram_buffer = datagram_buffer_pool_->allocate();
-      datagram_buffer->resize(65535); // Max UDP datagram size
-
-      auto buffer = datagram_buffer_pool_->allocate();
-      buffer->resize(65535); // max datagram size
-
-      auto sender_address = std::make_shared<Udpcap::HostAddress>();
-      auto sender_port    = std::make_shared<uint16_t>();
-
-      size_t bytes_received = socket_->receiveFrom(reinterpret_cast<char*>(buffer->data())
-                                                  , buffer->size()
-                                                  , *sender_address
-                                                  , *sender_port
-                                                  , error);
-
-      if (error)
-      {
-        return nullptr;
-      }
-
-      // resize the buffer to the actually received size
-      buffer->resize(bytes_received);
-
-      // Convert sender address and port to asio
-      auto sender_endpoint_of_this_datagram = std::make_shared<asio::ip::udp::endpoint>(asio::ip::make_address(sender_address->toString()), *sender_port);
-
-      // Handle the datagram. Discard the error, as we don't really want to
-      // react on faulty datagrams here. Those will just be dropped and we will
-      // continue to receive the next one.
-      ecaludp::Error handle_datagram_error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
-      auto completed_package = this->handle_datagram(buffer, sender_endpoint_of_this_datagram, handle_datagram_error);
-
-      if (completed_package != nullptr)
-      {
-        sender_endpoint = *sender_endpoint_of_this_datagram;
-        return completed_package;
-      }
-    }
+    return receive_engine_->receive_from([this](ecaludp::ReceivedDatagram& datagram, ecaludp::Error& receive_error) -> bool
+                                         {
+                                           auto buffer = receive_engine_->allocate_buffer();
+                                           buffer->resize(65535); // max datagram size
+
+                                           Udpcap::HostAddress sender_address;
+                                           uint16_t            sender_port = 0;
+
+                                           const size_t bytes_received = socket_->receiveFrom(reinterpret_cast<char*>(buffer->data())
+                                                                                            , buffer->size()
+                                                                                            , sender_address
+                                                                                            , sender_port
+                                                                                            , receive_error);
+
+                                           if (receive_error)
+                                             return false;
+
+                                           // resize the buffer to the actually received size
+                                           buffer->resize(bytes_received);
+
+                                           datagram.data_            = buffer->data();
+                                           datagram.size_            = buffer->size();
+                                           datagram.owner_           = buffer;
+                                           datagram.sender_endpoint_ = std::make_shared<asio::ip::udp::endpoint>(asio::ip::make_address(sender_address.toString()), sender_port);
+                                           return true;
+                                         }
+                                         , sender_endpoint
+                                         , error);
   }
   
-  
   void SocketNpcap::async_receive_from(asio::ip::udp::endpoint& sender_endpoint
                                       , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler)
   {
@@ -150,11 +143,7 @@ namespace ecaludp
                                               , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler)
 
   {
-    auto datagram_buffer = datagram_buffer_pool_->allocate();
-    datagram_buffer->resize(65535); // Max UDP datagram size
-
-    auto buffer = datagram_buffer_pool_->allocate();
-
+    auto buffer = receive_engine_->allocate_buffer();
     buffer->resize(65535); // max datagram size
 
     auto sender_address = std::make_shared<Udpcap::HostAddress>();
@@ -179,7 +168,7 @@ namespace ecaludp
 
                                 // Handle the datagram
                                 ecaludp::Error datagam_handle_error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
-                                auto completed_package = this->handle_datagram(buffer, sender_endpoint_of_this_datagram, datagam_handle_error);
+                                auto completed_package = receive_engine_->handle_datagram(buffer, sender_endpoint_of_this_datagram, datagam_handle_error);
 
                                 if (completed_package != nullptr)
                                 {
@@ -195,55 +184,31 @@ namespace ecaludp
 
   }
 
-  std::shared_ptr<ecaludp::OwningBuffer> SocketNpcap::handle_datagram(const std::shared_ptr<ecaludp::RawMemory>& buffer
-                                                                      , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
-                                                                      , ecaludp::Error& error)
+  std::vector<ecaludp::IncompleteMessage> SocketNpcap::get_reassembly_snapshot() const
+  {
+    return receive_engine_->get_reassembly_snapshot();
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Recording
+  /////////////////////////////////////////////////////////////////
+  bool SocketNpcap::start_recording(const std::string& file_path, ecaludp::Error& error)
   {
-    // TODO: This function is code duplication.
-
-    // Clean the reassembly from fragments that are too old
-    reassembly_v5_->remove_old_packages(std::chrono::steady_clock::now() - max_reassembly_age_);
-
-    // Start to parse the header
-
-    if (buffer->size() < sizeof(ecaludp::HeaderCommon)) // Magic number + version
-    {
-      error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Datagram too small to contain common header (" + std::to_string(buffer->size()) + " bytes)");
-      return nullptr;
-    }
-
-    auto* header = reinterpret_cast<ecaludp::HeaderCommon*>(buffer->data());
-
-    // Check the magic number
-    if (strncmp(header->magic, magic_header_bytes_.data(), 4) != 0)
-    {
-      error = ecaludp::Error(ecaludp::Error::MALFORMED_DATAGRAM, "Wrong magic bytes");
-      return nullptr;
-    }
-
-    std::shared_ptr<ecaludp::OwningBuffer> finished_package;
-
-    // Check the version and invoke the correct handler
-    if (header->version == 5)
-    {
-      finished_package = reassembly_v5_->handle_datagram(buffer, sender_endpoint, error);
-    }
-    else if (header->version == 6)
-    {
-      error = ecaludp::Error(Error::UNSUPPORTED_PROTOCOL_VERSION, std::to_string(header->version));
-      //handle_datagram_v6(buffer);
-    }
-    else
-    {
-      error = ecaludp::Error(Error::UNSUPPORTED_PROTOCOL_VERSION, std::to_string(header->version));
-    }
-
-    if (error)
-    {
-      return nullptr;
-    }
-
-    return finished_package;
+    return receive_engine_->start_recording(file_path, [this]() { return local_endpoint(); }, error);
   }
 
-}
\ No newline at end of file
+  void SocketNpcap::stop_recording()
+  {
+    receive_engine_->stop_recording();
+  }
+
+  bool SocketNpcap::is_recording() const
+  {
+    return receive_engine_->is_recording();
+  }
+
+  uint64_t SocketNpcap::get_recording_dropped_datagrams() const
+  {
+    return receive_engine_->get_recording_dropped_datagrams();
+  }
+}
@@ -0,0 +1,185 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <ecaludp/socket_packet_mmap.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+
+#include "packet_mmap_receiver.h"
+#include "receive_engine.h"
+
+namespace ecaludp
+{
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  SocketPacketMmap::SocketPacketMmap(std::array<char, 4> magic_header_bytes)
+    : receiver_            (std::make_unique<ecaludp::PacketMmapReceiver>())
+    , receive_engine_      (std::make_unique<ecaludp::ReceiveEngine>(magic_header_bytes))
+  {
+    // The messages handed to the user would otherwise point into the ring.
+    // As the user may keep them forever and thus block the ring, we copy them.
+    receive_engine_->set_copy_non_fragmented_messages(true);
+  }
+
+  // Destructor
+  SocketPacketMmap::~SocketPacketMmap() = default;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  void SocketPacketMmap::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
+  {
+    receive_engine_->set_max_reassembly_age(max_reassembly_age);
+  }
+
+  std::chrono::steady_clock::duration SocketPacketMmap::get_max_reassembly_age() const
+  {
+    return receive_engine_->get_max_reassembly_age();
+  }
+
+  void SocketPacketMmap::set_reassembly_limits(const ecaludp::ReassemblyLimits& limits)
+  {
+    receive_engine_->set_reassembly_limits(limits);
+  }
+
+  ecaludp::ReassemblyLimits SocketPacketMmap::get_reassembly_limits() const
+  {
+    return receive_engine_->get_reassembly_limits();
+  }
+
+  ecaludp::ReassemblyEvictionCounters SocketPacketMmap::get_reassembly_eviction_counters() const
+  {
+    return receive_engine_->get_reassembly_eviction_counters();
+  }
+
+  void SocketPacketMmap::set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback)
+  {
+    receive_engine_->set_partial_message_callback(partial_message_callback);
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // API "Passthrough"
+  /////////////////////////////////////////////////////////////////
+  bool SocketPacketMmap::is_valid() const                                                 { return receiver_->is_valid(); }
+  bool SocketPacketMmap::bind(const asio::ip::udp::endpoint& sender_endpoint)             { return receiver_->bind(sender_endpoint); }
+  bool SocketPacketMmap::is_bound() const                                                 { return receiver_->is_bound(); }
+  asio::ip::udp::endpoint SocketPacketMmap::local_endpoint()                              { return receiver_->local_endpoint(); }
+  bool SocketPacketMmap::set_receive_buffer_size(int size)                                { return receiver_->set_receive_buffer_size(size); }
+  bool SocketPacketMmap::join_multicast_group(const asio::ip::address_v4& group_address)  { return receiver_->join_multicast_group(group_address); }
+  bool SocketPacketMmap::leave_multicast_group(const asio::ip::address_v4& group_address) { return receiver_->leave_multicast_group(group_address); }
+  void SocketPacketMmap::set_multicast_loopback_enabled(bool enabled)                     { receiver_->set_multicast_loopback_enabled(enabled); }
+  bool SocketPacketMmap::is_multicast_loopback_enabled() const                            { return receiver_->is_multicast_loopback_enabled(); }
+  void SocketPacketMmap::close()                                                          { receiver_->close(); }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+
+  std::shared_ptr<ecaludp::OwningBuffer> SocketPacketMmap::receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error)
+  {
+    while (true)
+    {
+      ecaludp::CapturedDatagram datagram;
+      receiver_->receive_datagram(datagram, error);
+
+      if (error)
+      {
+        return nullptr;
+      }
+
+      auto sender_endpoint_of_this_datagram = std::make_shared<asio::ip::udp::endpoint>(datagram.sender_endpoint_);
+
+      // Handle the datagram. Discard the error, as we don't really want to
+      // react on faulty datagrams here. Those will just be dropped and we will
+      // continue to receive the next one.
+      ecaludp::Error handle_datagram_error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
+      auto completed_package = this->handle_datagram(datagram, sender_endpoint_of_this_datagram, handle_datagram_error);
+
+      if (completed_package != nullptr)
+      {
+        sender_endpoint = *sender_endpoint_of_this_datagram;
+        return completed_package;
+      }
+    }
+  }
+
+  void SocketPacketMmap::async_receive_from(asio::ip::udp::endpoint& sender_endpoint
+                                           , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler)
+  {
+    receive_next_datagram_from(sender_endpoint, completion_handler);
+  }
+
+  void SocketPacketMmap::receive_next_datagram_from(asio::ip::udp::endpoint& sender_endpoint
+                                                   , const std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, const ecaludp::Error&)>& completion_handler)
+  {
+    receiver_->async_receive_datagram([this, completion_handler, &sender_endpoint](const ecaludp::Error& error, const ecaludp::CapturedDatagram& datagram)
+                                      {
+                                        if (error)
+                                        {
+                                          completion_handler(nullptr, error);
+                                          return;
+                                        }
+
+                                        auto sender_endpoint_of_this_datagram = std::make_shared<asio::ip::udp::endpoint>(datagram.sender_endpoint_);
+
+                                        // Handle the datagram
+                                        ecaludp::Error datagam_handle_error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
+                                        auto completed_package = this->handle_datagram(datagram, sender_endpoint_of_this_datagram, datagam_handle_error);
+
+                                        if (completed_package != nullptr)
+                                        {
+                                          sender_endpoint = *sender_endpoint_of_this_datagram;
+                                          completion_handler(completed_package, datagam_handle_error);
+                                        }
+                                        else
+                                        {
+                                          // Receive the next datagram
+                                          receive_next_datagram_from(sender_endpoint, completion_handler);
+                                        }
+                                      });
+  }
+
+  std::shared_ptr<ecaludp::OwningBuffer> SocketPacketMmap::handle_datagram(const ecaludp::CapturedDatagram& datagram
+                                                                          , const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint
+                                                                          , ecaludp::Error& error)
+  {
+    // The receiver returns an empty datagram, if the ring is stalled, because
+    // the kernel has (almost) wrapped around to a block that is still
+    // referenced by an incomplete message, or has dropped packets. The
+    // incomplete messages will most likely never be completed, then. We drop
+    // them to release the ring.
+    if (datagram.data_ == nullptr)
+    {
+      receive_engine_->drop_incomplete_messages();
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Capture ring stalled");
+      return nullptr;
+    }
+
+    return receive_engine_->handle_datagram(datagram.data_, datagram.size_, datagram.owner_, sender_endpoint, error);
+  }
+}
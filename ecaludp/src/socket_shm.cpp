@@ -0,0 +1,790 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <ecaludp/socket_shm.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+
+#include "shm_channel.h"
+
+namespace ecaludp
+{
+  namespace
+  {
+    constexpr std::size_t default_shm_buffer_size         = 64 * 1024 * 1024;
+    constexpr std::size_t max_pending_received_messages   = 1024;
+    constexpr auto        channel_retry_interval          = std::chrono::seconds(1);
+
+    /**
+     * @brief Returns whether the address belongs to one of the interfaces of this host
+     */
+    bool is_local_address(const asio::ip::address& address)
+    {
+      if (address.is_loopback())
+        return true;
+
+      if (address.is_unspecified() || address.is_multicast())
+        return false;
+
+      ifaddrs* interface_addresses = nullptr;
+      if (::getifaddrs(&interface_addresses) != 0)
+        return false;
+
+      bool is_local = false;
+      for (const ifaddrs* interface_address = interface_addresses; (interface_address != nullptr) && !is_local; interface_address = interface_address->ifa_next)
+      {
+        if (interface_address->ifa_addr == nullptr)
+          continue;
+
+        if (address.is_v4() && (interface_address->ifa_addr->sa_family == AF_INET))
+        {
+          const auto* sockaddr = reinterpret_cast<const sockaddr_in*>(interface_address->ifa_addr);
+          is_local = (std::memcmp(&sockaddr->sin_addr, address.to_v4().to_bytes().data(), 4) == 0);
+        }
+        else if (address.is_v6() && (interface_address->ifa_addr->sa_family == AF_INET6))
+        {
+          const auto* sockaddr = reinterpret_cast<const sockaddr_in6*>(interface_address->ifa_addr);
+          is_local = (std::memcmp(&sockaddr->sin6_addr, address.to_v6().to_bytes().data(), 16) == 0);
+        }
+      }
+
+      ::freeifaddrs(interface_addresses);
+      return is_local;
+    }
+
+    /**
+     * @brief Returns whether the receiver has closed the control connection
+     *
+     * The receiver never sends anything, so the socket only becomes readable
+     * when it is closed.
+     */
+    bool is_connection_closed(int socket_fd)
+    {
+      pollfd poll_fd {};
+      poll_fd.fd     = socket_fd;
+      poll_fd.events = POLLIN;
+      return (::poll(&poll_fd, 1, 0) != 0);
+    }
+
+    asio::ip::address unspecified_address_of(const asio::ip::address& address)
+    {
+      if (address.is_v4())
+        return asio::ip::address_v4::any();
+      else
+        return asio::ip::address_v6::any();
+    }
+  }
+
+  struct SocketShm::SendChannel
+  {
+    explicit SendChannel(asio::io_context& io_context)
+      : control_socket_(io_context)
+    {}
+
+    asio::generic::seq_packet_protocol::socket control_socket_;     ///< The connection to the receiver. Closed by the receiver when it goes away.
+    ShmRingWriter                              ring_;
+  };
+
+  struct SocketShm::ReceiveChannel
+  {
+    explicit ReceiveChannel(asio::io_context& io_context)
+      : control_socket_(io_context)
+      , event_         (io_context)
+    {}
+
+    asio::generic::seq_packet_protocol::socket control_socket_;
+    asio::posix::stream_descriptor             event_;              ///< The eventfd that the sender signals for every message
+    std::shared_ptr<ShmRingReader>             ring_;               ///< nullptr until the sender has introduced itself
+    asio::ip::udp::endpoint                    sender_endpoint_;
+
+    bool event_wait_active_  {false};
+    bool is_throttled_       {false};                               ///< Reading has been stopped, because too many messages are pending
+    bool is_closed_by_sender_{false};
+  };
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  SocketShm::SocketShm(asio::io_context& io_context, std::array<char, 4> magic_header_bytes)
+    : io_context_        (io_context)
+    , socket_            (io_context, magic_header_bytes)
+    , magic_header_bytes_(magic_header_bytes)
+    , shm_buffer_size_   (default_shm_buffer_size)
+    , receiving_started_ (false)
+    , udp_receive_active_(false)
+    , lifetime_token_    (std::make_shared<int>(0))
+  {}
+
+  SocketShm::~SocketShm()
+  {
+    close();
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // API Passthrough
+  /////////////////////////////////////////////////////////////////
+  void SocketShm::close()
+  {
+    std::vector<std::function<void()>> handlers;
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (channel_acceptor_)
+    {
+      asio::error_code ec;
+      channel_acceptor_->close(ec); // NOLINT(bugprone-unused-return-value) Closing is best effort
+      channel_acceptor_.reset();
+    }
+
+    // Copy the list, as removing a channel modifies it
+    const auto receive_channels = receive_channels_;
+    for (const auto& channel : receive_channels)
+      remove_receive_channel_locked(channel);
+
+    send_channels_.clear();
+    unreachable_destinations_.clear();
+
+    receiving_started_ = false;
+    receive_error_.clear();
+    received_messages_.clear();
+    while (!receive_requests_.empty())
+    {
+      auto completion_handler = std::move(receive_requests_.front().completion_handler_);
+      receive_requests_.pop_front();
+      handlers.emplace_back([completion_handler]() { completion_handler(nullptr, asio::error::operation_aborted); });
+    }
+
+    asio::error_code ec;
+    socket_.close(ec); // NOLINT(bugprone-unused-return-value) Closing is best effort
+
+    for (auto& handler : handlers)
+      asio::post(io_context_, std::move(handler));
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  void SocketShm::set_shm_buffer_size(std::size_t shm_buffer_size)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    shm_buffer_size_ = shm_buffer_size;
+  }
+
+  std::size_t SocketShm::get_shm_buffer_size() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return shm_buffer_size_;
+  }
+
+  bool SocketShm::is_shm_channel_open(const asio::ip::udp::endpoint& destination) const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    auto channel_it = send_channels_.find(destination);
+    return (channel_it != send_channels_.end()) && !channel_it->second->ring_.is_reader_closed();
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  std::size_t SocketShm::send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                , const asio::ip::udp::endpoint& destination
+                                , asio::socket_base::message_flags flags
+                                , asio::error_code& ec)
+  {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      std::size_t bytes_sent = 0;
+      if (send_via_shm_locked(buffer_sequence, destination, bytes_sent))
+      {
+        ec = asio::error_code();
+        return bytes_sent;
+      }
+    }
+
+    return socket_.send_to(buffer_sequence, destination, flags, ec);
+  }
+
+  void SocketShm::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                              , const asio::ip::udp::endpoint& destination
+                              , const std::function<void(asio::error_code)>& completion_handler)
+  {
+    async_send_to(buffer_sequence
+                , destination
+                , [completion_handler](asio::error_code ec, std::size_t /*bytes_sent*/, std::size_t /*datagrams_sent*/)
+                  {
+                    completion_handler(ec);
+                  });
+  }
+
+  void SocketShm::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                              , const asio::ip::udp::endpoint& destination
+                              , const std::function<void(asio::error_code, std::size_t, std::size_t)>& completion_handler)
+  {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      // Writing to the ring never blocks, so the message is written right
+      // away and only the handler is deferred
+      std::size_t bytes_sent = 0;
+      if (send_via_shm_locked(buffer_sequence, destination, bytes_sent))
+      {
+        asio::post(io_context_, [completion_handler, bytes_sent]() { completion_handler(asio::error_code(), bytes_sent, 0); });
+        return;
+      }
+    }
+
+    socket_.async_send_to(buffer_sequence, destination, completion_handler);
+  }
+
+  bool SocketShm::send_via_shm_locked(const std::vector<asio::const_buffer>& buffer_sequence
+                                    , const asio::ip::udp::endpoint& destination
+                                    , std::size_t& bytes_sent)
+  {
+    // Let the UDP path report errors of closed sockets
+    if (!socket_.is_open() || destination.address().is_multicast())
+      return false;
+
+    SendChannel* channel = get_send_channel_locked(destination);
+    if (channel == nullptr)
+      return false;
+
+    const std::size_t message_size = asio::buffer_size(buffer_sequence);
+    if (message_size > channel->ring_.max_message_size())
+      return false;
+
+    if (channel->ring_.write(buffer_sequence, message_size, magic_header_bytes_))
+    {
+      bytes_sent = message_size;
+      return true;
+    }
+
+    // The ring is full. That is either a slow receiver, in which case the
+    // message is dropped, or a receiver that has died without closing the
+    // ring.
+    if (is_connection_closed(channel->control_socket_.native_handle()))
+    {
+      send_channels_.erase(destination);
+      return false;
+    }
+
+    bytes_sent = 0;
+    return true;
+  }
+
+  SocketShm::SendChannel* SocketShm::get_send_channel_locked(const asio::ip::udp::endpoint& destination)
+  {
+    auto channel_it = send_channels_.find(destination);
+    if (channel_it != send_channels_.end())
+    {
+      if (!channel_it->second->ring_.is_reader_closed())
+        return channel_it->second.get();
+
+      // The receiver is gone. Another one may have taken its place, though.
+      send_channels_.erase(channel_it);
+      unreachable_destinations_.erase(destination);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    auto unreachable_it = unreachable_destinations_.find(destination);
+    if ((unreachable_it != unreachable_destinations_.end()) && (now < unreachable_it->second))
+      return nullptr;
+
+    auto channel = open_send_channel_locked(destination);
+    if (channel == nullptr)
+    {
+      unreachable_destinations_[destination] = now + channel_retry_interval;
+      return nullptr;
+    }
+
+    unreachable_destinations_.erase(destination);
+
+    SendChannel* channel_ptr = channel.get();
+    send_channels_[destination] = std::move(channel);
+    return channel_ptr;
+  }
+
+  std::unique_ptr<SocketShm::SendChannel> SocketShm::open_send_channel_locked(const asio::ip::udp::endpoint& destination)
+  {
+    if (!is_local_address(destination.address()))
+      return nullptr;
+
+    // The receiver reports our local endpoint as sender of the messages, so
+    // the socket must be bound. Sending via UDP would bind it anyways.
+    asio::error_code ec;
+    asio::ip::udp::endpoint sender_endpoint = socket_.local_endpoint(ec);
+    if (!ec && (sender_endpoint.port() == 0))
+    {
+      socket_.bind(asio::ip::udp::endpoint(sender_endpoint.protocol(), 0), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (!ec)
+        sender_endpoint = socket_.local_endpoint(ec);
+    }
+    if (ec)
+      return nullptr;
+
+    if (sender_endpoint.address().is_unspecified())
+    {
+      if (sender_endpoint.address().is_v4())
+        sender_endpoint.address(asio::ip::address_v4::loopback());
+      else
+        sender_endpoint.address(asio::ip::address_v6::loopback());
+    }
+
+    // The receiver may either be bound to the destination address or to all
+    // addresses of this host
+    std::vector<asio::ip::udp::endpoint> listener_endpoints{destination};
+    if (!destination.address().is_unspecified())
+      listener_endpoints.emplace_back(unspecified_address_of(destination.address()), destination.port());
+
+    for (const auto& listener_endpoint : listener_endpoints)
+    {
+      auto channel = std::make_unique<SendChannel>(io_context_);
+
+      channel->control_socket_.open(asio::generic::seq_packet_protocol(AF_UNIX, 0), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (ec)
+        return nullptr;
+
+      // Never block when the backlog of the listener is full
+      channel->control_socket_.non_blocking(true, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (!ec)
+        channel->control_socket_.connect(shm_channel_endpoint(magic_header_bytes_, listener_endpoint), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (ec)
+        continue;
+
+      channel->ring_.create(shm_buffer_size_, ec);
+      if (ec)
+        return nullptr;
+
+      send_shm_channel_hello(channel->control_socket_.native_handle(), channel->ring_, sender_endpoint, magic_header_bytes_, ec);
+      if (ec)
+        continue;
+
+      return channel;
+    }
+
+    return nullptr;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  void SocketShm::async_receive_from(asio::ip::udp::endpoint& sender_endpoint
+                                   , const ReceiveHandler& completion_handler)
+  {
+    std::vector<std::function<void()>> handlers;
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!socket_.is_open())
+    {
+      asio::post(io_context_, [completion_handler]() { completion_handler(nullptr, asio::error::bad_descriptor); });
+      return;
+    }
+
+    receive_requests_.push_back(ReceiveRequest{&sender_endpoint, completion_handler});
+
+    if (!receiving_started_)
+    {
+      receiving_started_ = true;
+      start_listening_locked();
+    }
+
+    collect_receive_results_locked(handlers);
+    resume_receiving_locked();
+    collect_receive_results_locked(handlers);
+
+    // Never call the handler from within the initiating function
+    for (auto& handler : handlers)
+      asio::post(io_context_, std::move(handler));
+  }
+
+  void SocketShm::start_udp_receiving_locked()
+  {
+    if (!receiving_started_ || udp_receive_active_ || receive_error_ || !socket_.is_open())
+      return;
+
+    if (received_messages_.size() >= max_pending_received_messages)
+      return;
+
+    udp_receive_active_ = true;
+
+    // The endpoint must stay valid until the handler is called
+    auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    socket_.async_receive_from(*sender_endpoint
+                              , [this, lifetime_token, sender_endpoint](const std::shared_ptr<ecaludp::OwningBuffer>& message, asio::error_code ec)
+                                {
+                                  if (lifetime_token.expired())
+                                    return;
+
+                                  on_udp_receive(message, *sender_endpoint, ec);
+                                });
+  }
+
+  void SocketShm::on_udp_receive(const std::shared_ptr<ecaludp::OwningBuffer>& message
+                                , const asio::ip::udp::endpoint& sender_endpoint
+                                , const asio::error_code& ec)
+  {
+    std::vector<std::function<void()>> handlers;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      udp_receive_active_ = false;
+
+      if (ec == asio::error::operation_aborted)
+      {
+        // The socket may have been re-opened in the meantime
+        start_udp_receiving_locked();
+        return;
+      }
+
+      if (ec)
+        receive_error_ = ec;
+      else if (message != nullptr)
+        received_messages_.push_back(ReceivedMessage{message, sender_endpoint});
+
+      collect_receive_results_locked(handlers);
+      start_udp_receiving_locked();
+    }
+
+    for (const auto& handler : handlers)
+      handler();
+  }
+
+  void SocketShm::start_listening_locked()
+  {
+    // Without a port, nobody can send to us
+    asio::error_code ec;
+    const asio::ip::udp::endpoint local_endpoint = socket_.local_endpoint(ec);
+    if (ec || (local_endpoint.port() == 0))
+      return;
+
+    // If anything fails, we just don't offer a shared memory channel and
+    // only receive via UDP
+    auto acceptor = std::make_unique<ChannelAcceptor>(io_context_);
+
+    acceptor->open(asio::generic::seq_packet_protocol(AF_UNIX, 0), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    if (ec)
+      return;
+
+    // Fails, if another socket already offers a channel for this endpoint
+    acceptor->bind(shm_channel_endpoint(magic_header_bytes_, local_endpoint), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    if (ec)
+      return;
+
+    acceptor->listen(asio::socket_base::max_listen_connections, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    if (ec)
+      return;
+
+    channel_acceptor_ = std::move(acceptor);
+    accept_next_channel_locked();
+  }
+
+  void SocketShm::accept_next_channel_locked()
+  {
+    auto channel = std::make_shared<ReceiveChannel>(io_context_);
+
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    channel_acceptor_->async_accept(channel->control_socket_
+                                   , [this, lifetime_token, channel](const asio::error_code& ec)
+                                     {
+                                       if (lifetime_token.expired())
+                                         return;
+
+                                       on_channel_accepted(channel, ec);
+                                     });
+  }
+
+  void SocketShm::on_channel_accepted(const std::shared_ptr<ReceiveChannel>& channel, const asio::error_code& ec)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if ((ec == asio::error::operation_aborted) || !channel_acceptor_)
+      return;
+
+    if (!ec)
+    {
+      receive_channels_.push_back(channel);
+
+      // The sender introduces itself with a message that contains the fds
+      wait_for_channel_control_locked(channel);
+    }
+
+    accept_next_channel_locked();
+  }
+
+  void SocketShm::wait_for_channel_control_locked(const std::shared_ptr<ReceiveChannel>& channel)
+  {
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    channel->control_socket_.async_wait(asio::socket_base::wait_read
+                                       , [this, lifetime_token, channel](const asio::error_code& ec)
+                                         {
+                                           if (lifetime_token.expired())
+                                             return;
+
+                                           on_channel_control(channel, ec);
+                                         });
+  }
+
+  void SocketShm::on_channel_control(const std::shared_ptr<ReceiveChannel>& channel, const asio::error_code& ec)
+  {
+    std::vector<std::function<void()>> handlers;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      if ((ec == asio::error::operation_aborted) || !channel->control_socket_.is_open())
+        return;
+
+      if (ec)
+      {
+        remove_receive_channel_locked(channel);
+        return;
+      }
+
+      if (channel->ring_ == nullptr)
+      {
+        int memory_fd = -1;
+        int event_fd  = -1;
+
+        asio::error_code hello_ec;
+        receive_shm_channel_hello(channel->control_socket_.native_handle(), magic_header_bytes_, memory_fd, event_fd, channel->sender_endpoint_, hello_ec);
+
+        if ((hello_ec == asio::error::would_block) || (hello_ec == asio::error::try_again))
+        {
+          wait_for_channel_control_locked(channel);
+          return;
+        }
+        else if (hello_ec)
+        {
+          remove_receive_channel_locked(channel);
+          return;
+        }
+
+        auto ring = std::make_shared<ShmRingReader>();
+        ring->map(memory_fd, hello_ec);
+
+        if (!hello_ec)
+          channel->event_.assign(event_fd, hello_ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+
+        if (hello_ec)
+        {
+          if (!channel->event_.is_open())
+            ::close(event_fd);
+          remove_receive_channel_locked(channel);
+          return;
+        }
+
+        channel->ring_ = std::move(ring);
+
+        // From now on, the socket only becomes readable when the sender
+        // closes it
+        wait_for_channel_control_locked(channel);
+      }
+      else
+      {
+        channel->is_closed_by_sender_ = true;
+      }
+
+      // Messages that have been written before are still delivered
+      if (!channel->is_throttled_)
+        read_from_channel_locked(channel);
+
+      collect_receive_results_locked(handlers);
+    }
+
+    for (const auto& handler : handlers)
+      handler();
+  }
+
+  void SocketShm::wait_for_channel_event_locked(const std::shared_ptr<ReceiveChannel>& channel)
+  {
+    if (channel->event_wait_active_)
+      return;
+
+    channel->event_wait_active_ = true;
+
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    channel->event_.async_wait(asio::posix::stream_descriptor::wait_read
+                              , [this, lifetime_token, channel](const asio::error_code& ec)
+                                {
+                                  if (lifetime_token.expired())
+                                    return;
+
+                                  on_channel_event(channel, ec);
+                                });
+  }
+
+  void SocketShm::on_channel_event(const std::shared_ptr<ReceiveChannel>& channel, const asio::error_code& ec)
+  {
+    std::vector<std::function<void()>> handlers;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      channel->event_wait_active_ = false;
+
+      if ((ec == asio::error::operation_aborted) || !channel->event_.is_open())
+        return;
+
+      if (ec)
+      {
+        remove_receive_channel_locked(channel);
+        return;
+      }
+
+      // Reset the eventfd before reading, so no notification is lost
+      uint64_t event_count = 0;
+      const auto bytes_read = ::read(channel->event_.native_handle(), &event_count, sizeof(event_count));
+      static_cast<void>(bytes_read);
+
+      // A throttled channel is read again, when the user catches up
+      if (!channel->is_throttled_)
+        read_from_channel_locked(channel);
+
+      collect_receive_results_locked(handlers);
+    }
+
+    for (const auto& handler : handlers)
+      handler();
+  }
+
+  void SocketShm::read_from_channel_locked(const std::shared_ptr<ReceiveChannel>& channel)
+  {
+    while (true)
+    {
+      if (received_messages_.size() >= max_pending_received_messages)
+      {
+        channel->is_throttled_ = true;
+        return;
+      }
+
+      ecaludp::Error error = ecaludp::Error::ErrorCode::OK;
+      auto message = channel->ring_->read_next(magic_header_bytes_, error);
+
+      if (message != nullptr)
+      {
+        received_messages_.push_back(ReceivedMessage{std::move(message), channel->sender_endpoint_});
+      }
+      else if (error)
+      {
+        // The sender has corrupted the ring. There is no way to recover.
+        remove_receive_channel_locked(channel);
+        return;
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    if (channel->is_closed_by_sender_)
+      remove_receive_channel_locked(channel);
+    else
+      wait_for_channel_event_locked(channel);
+  }
+
+  void SocketShm::remove_receive_channel_locked(const std::shared_ptr<ReceiveChannel>& channel)
+  {
+    // Buffers that are still in use keep the memory mapped
+    if (channel->ring_ != nullptr)
+      channel->ring_->close();
+
+    asio::error_code ec;
+    channel->control_socket_.close(ec); // NOLINT(bugprone-unused-return-value) Closing is best effort
+    channel->event_.close(ec);          // NOLINT(bugprone-unused-return-value) Closing is best effort
+
+    receive_channels_.erase(std::remove(receive_channels_.begin(), receive_channels_.end(), channel), receive_channels_.end());
+  }
+
+  void SocketShm::resume_receiving_locked()
+  {
+    start_udp_receiving_locked();
+
+    // Copy the list, as reading may remove channels
+    const auto receive_channels = receive_channels_;
+    for (const auto& channel : receive_channels)
+    {
+      if (received_messages_.size() >= max_pending_received_messages)
+        break;
+
+      if (channel->is_throttled_)
+      {
+        channel->is_throttled_ = false;
+        read_from_channel_locked(channel);
+      }
+    }
+  }
+
+  void SocketShm::collect_receive_results_locked(std::vector<std::function<void()>>& handlers)
+  {
+    while (!receive_requests_.empty())
+    {
+      if (!received_messages_.empty())
+      {
+        ReceiveRequest  request = std::move(receive_requests_.front());
+        ReceivedMessage message = std::move(received_messages_.front());
+        receive_requests_.pop_front();
+        received_messages_.pop_front();
+
+        *request.sender_endpoint_ = message.sender_endpoint_;
+
+        auto completion_handler = std::move(request.completion_handler_);
+        auto completed_package  = std::move(message.message_);
+        handlers.emplace_back([completion_handler, completed_package]() { completion_handler(completed_package, asio::error_code()); });
+      }
+      else if (receive_error_)
+      {
+        // Errors are reported once, just like a socket would do. Receiving is
+        // restarted afterwards.
+        auto completion_handler = std::move(receive_requests_.front().completion_handler_);
+        receive_requests_.pop_front();
+
+        const asio::error_code ec = receive_error_;
+        receive_error_.clear();
+        handlers.emplace_back([completion_handler, ec]() { completion_handler(nullptr, ec); });
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+}
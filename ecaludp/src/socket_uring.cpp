@@ -0,0 +1,706 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <ecaludp/socket_uring.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/raw_memory.h>
+#include <ecaludp/reassembly_limits.h>
+
+#include "io_uring.h"
+#include "protocol/datagram_builder_v5.h"
+#include "protocol/datagram_description.h"
+#include "receive_engine.h"
+
+namespace ecaludp
+{
+  namespace
+  {
+    constexpr unsigned int ring_entries                 = 1024;
+    constexpr unsigned int receive_buffer_count         = 256;   // Must be a power of 2
+    constexpr uint16_t     receive_buffer_group_id      = 0;
+    constexpr std::size_t  max_pending_received_messages = 1024;
+
+    // The kernel puts a header and the sender address in front of the payload
+    constexpr std::size_t  receive_buffer_size = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in6) + 65535;
+
+    // user_data of the operations that are not send operations. Send
+    // operations use the (always aligned) pointer to their SendJob.
+    constexpr uint64_t     receive_operation_tag = 1;
+    constexpr uint64_t     cancel_operation_tag  = 2;
+
+    asio::error_code to_error_code(int result)
+    {
+      if (result == -ECANCELED)
+        return asio::error::operation_aborted;
+      else
+        return asio::error_code(-result, asio::error::get_system_category());
+    }
+  }
+
+  struct SocketUring::SendJob
+  {
+    DatagramList                          datagram_list_;
+    asio::ip::udp::endpoint               destination_;
+    std::vector<iovec>                    iovecs_;
+    std::vector<msghdr>                   messages_;             ///< One message per datagram. Must stay valid until the datagram has been sent.
+    std::function<void(asio::error_code, std::size_t, std::size_t)> completion_handler_;
+
+    std::size_t                           next_datagram_      {0};
+    std::size_t                           datagrams_in_flight_{0};
+    asio::error_code                      error_;
+    std::size_t                           bytes_sent_         {0};
+    std::size_t                           datagrams_sent_     {0};
+
+    bool is_finished() const { return ((next_datagram_ >= messages_.size()) || error_) && (datagrams_in_flight_ == 0); }
+  };
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  SocketUring::SocketUring(asio::io_context& io_context, std::array<char, 4> magic_header_bytes)
+    : io_context_               (io_context)
+    , socket_                   (io_context)
+    , receive_engine_           (std::make_unique<ecaludp::ReceiveEngine>(magic_header_bytes))
+    , magic_header_bytes_       (magic_header_bytes)
+    , max_udp_datagram_size_    (1448)
+    , receive_buffers_          (receive_buffer_count)
+    , receiving_started_        (false)
+    , receive_armed_            (false)
+    , first_unissued_job_index_ (0)
+    , operations_in_flight_     (0)
+    , completion_wait_active_   (false)
+    , lifetime_token_           (std::make_shared<int>(0))
+    , completion_event_         (io_context)
+    , receive_msghdr_           (std::make_unique<msghdr>())
+    , ring_                     (std::make_unique<IoUring>())
+  {
+    ring_->init(ring_entries, init_error_);
+
+    if (!init_error_)
+    {
+      const int event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (event_fd < 0)
+        init_error_ = asio::error_code(errno, asio::error::get_system_category());
+      else
+        completion_event_.assign(event_fd, init_error_);
+
+      if (init_error_ && (event_fd >= 0))
+        ::close(event_fd);
+    }
+
+    if (!init_error_)
+      ring_->register_eventfd(completion_event_.native_handle(), init_error_);
+
+    if (!init_error_)
+      ring_->register_buffer_ring(receive_buffer_group_id, receive_buffer_count, init_error_);
+
+    // All buffers are provided to the kernel when receiving starts
+    for (unsigned int i = 0; i < receive_buffer_count; ++i)
+      unprovided_buffer_ids_.push_back(static_cast<uint16_t>(i));
+
+    // The kernel only uses the sizes of this template. It reserves space for
+    // the sender address in each buffer and doesn't receive any control data.
+    *receive_msghdr_ = msghdr{};
+    receive_msghdr_->msg_namelen = sizeof(sockaddr_in6);
+  }
+
+  SocketUring::~SocketUring()
+  {
+    close();
+
+    std::vector<std::function<void()>> handlers;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      // The kernel may still write to our buffers until it has completed all
+      // (cancelled) operations, so we have to wait for that.
+      while (ring_->is_initialized() && (operations_in_flight_ > 0))
+      {
+        asio::error_code ec;
+        ring_->submit(1, ec);
+        if (ec)
+          break;
+
+        reap_completions_locked(handlers);
+      }
+    }
+
+    for (auto& handler : handlers)
+      asio::post(io_context_, std::move(handler));
+  }
+
+  bool SocketUring::is_valid() const
+  {
+    return !init_error_;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // API Passthrough
+  /////////////////////////////////////////////////////////////////
+  void SocketUring::close()
+  {
+    std::vector<std::function<void()>> handlers;
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!init_error_ && socket_.is_open() && (operations_in_flight_ > 0))
+    {
+      // Cancel all operations on the socket. Closing the socket is not
+      // enough, as the ring holds its own reference to it.
+      io_uring_sqe* sqe = ring_->get_sqe();
+      if (sqe == nullptr)
+      {
+        submit_locked();
+        sqe = ring_->get_sqe();
+      }
+
+      if (sqe != nullptr)
+      {
+        sqe->opcode       = IORING_OP_ASYNC_CANCEL;
+        sqe->fd           = socket_.native_handle();
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data    = cancel_operation_tag;
+        ++operations_in_flight_;
+      }
+    }
+
+    // Datagrams that have not been issued, yet, are not sent anymore
+    for (std::size_t i = first_unissued_job_index_; i < send_jobs_.size(); ++i)
+    {
+      if (!send_jobs_[i]->error_)
+        send_jobs_[i]->error_ = asio::error::operation_aborted;
+    }
+    collect_finished_send_jobs_locked(handlers);
+
+    receiving_started_ = false;
+    received_messages_.clear();
+    while (!receive_requests_.empty())
+    {
+      auto completion_handler = std::move(receive_requests_.front().completion_handler_);
+      receive_requests_.pop_front();
+      handlers.emplace_back([completion_handler]() { completion_handler(nullptr, asio::error::operation_aborted); });
+    }
+
+    if (!init_error_)
+      submit_locked();
+
+    asio::error_code ec;
+    socket_.close(ec); // NOLINT(bugprone-unused-return-value) Closing is best effort
+
+    // Post the handlers while still holding the lock. Otherwise, the
+    // completion handler could finish the last operation in the meantime
+    // and the io_context would run out of work before the handlers are
+    // posted.
+    for (auto& handler : handlers)
+      asio::post(io_context_, std::move(handler));
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  void SocketUring::set_max_udp_datagram_size(std::size_t max_udp_datagram_size)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    max_udp_datagram_size_ = max_udp_datagram_size;
+  }
+
+  std::size_t SocketUring::get_max_udp_datagram_size() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return max_udp_datagram_size_;
+  }
+
+  void SocketUring::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    receive_engine_->set_max_reassembly_age(max_reassembly_age);
+  }
+
+  std::chrono::steady_clock::duration SocketUring::get_max_reassembly_age() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return receive_engine_->get_max_reassembly_age();
+  }
+
+  void SocketUring::set_reassembly_limits(const ecaludp::ReassemblyLimits& limits)
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    receive_engine_->set_reassembly_limits(limits);
+  }
+
+  ecaludp::ReassemblyLimits SocketUring::get_reassembly_limits() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return receive_engine_->get_reassembly_limits();
+  }
+
+  ecaludp::ReassemblyEvictionCounters SocketUring::get_reassembly_eviction_counters() const
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return receive_engine_->get_reassembly_eviction_counters();
+  }
+
+  void SocketUring::set_partial_message_callback(const std::function<void(const ecaludp::PartialMessage&)>& partial_message_callback)
+  {
+    // The reassembly is fed with the mutex locked, so the user callback must not be called directly
+    std::function<void(const ecaludp::PartialMessage&)> posting_callback;
+    if (partial_message_callback)
+    {
+      posting_callback = [this, partial_message_callback](const ecaludp::PartialMessage& partial_message)
+                         {
+                           asio::post(io_context_, [partial_message_callback, partial_message]() { partial_message_callback(partial_message); });
+                         };
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    receive_engine_->set_partial_message_callback(posting_callback);
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  void SocketUring::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                , const asio::ip::udp::endpoint& destination
+                                , const std::function<void(asio::error_code)>& completion_handler)
+  {
+    async_send_to(buffer_sequence
+                , destination
+                , [completion_handler](asio::error_code ec, std::size_t /*bytes_sent*/, std::size_t /*datagrams_sent*/)
+                  {
+                    completion_handler(ec);
+                  });
+  }
+
+  void SocketUring::async_send_to(const std::vector<asio::const_buffer>& buffer_sequence
+                                , const asio::ip::udp::endpoint& destination
+                                , const std::function<void(asio::error_code, std::size_t, std::size_t)>& completion_handler)
+  {
+    if (init_error_)
+    {
+      const asio::error_code ec = init_error_;
+      asio::post(io_context_, [completion_handler, ec]() { completion_handler(ec, 0, 0); });
+      return;
+    }
+
+    auto job = std::make_unique<SendJob>();
+    job->destination_        = destination;
+    job->completion_handler_ = completion_handler;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      if (!socket_.is_open())
+      {
+        asio::post(io_context_, [completion_handler]() { completion_handler(asio::error::bad_descriptor, 0, 0); });
+        return;
+      }
+
+      job->datagram_list_ = ecaludp::v5::create_datagram_list(buffer_sequence, max_udp_datagram_size_, magic_header_bytes_);
+
+      std::size_t iovec_count = 0;
+      for (const auto& datagram : job->datagram_list_)
+        iovec_count += datagram.asio_buffer_list_.size();
+
+      // The vectors must not reallocate, as the messages point into them
+      job->iovecs_.reserve(iovec_count);
+      job->messages_.reserve(job->datagram_list_.size());
+
+      for (const auto& datagram : job->datagram_list_)
+      {
+        msghdr message{};
+        message.msg_name    = job->destination_.data();
+        message.msg_namelen = static_cast<socklen_t>(job->destination_.size());
+        message.msg_iov     = job->iovecs_.data() + job->iovecs_.size();
+        message.msg_iovlen  = datagram.asio_buffer_list_.size();
+
+        for (const auto& buffer : datagram.asio_buffer_list_)
+          job->iovecs_.push_back(iovec{const_cast<void*>(buffer.data()), buffer.size()});
+
+        job->messages_.push_back(message);
+      }
+
+      send_jobs_.push_back(std::move(job));
+
+      issue_send_operations_locked();
+      submit_locked();
+    }
+  }
+
+  void SocketUring::issue_send_operations_locked()
+  {
+    // Leave enough room in the completion queue for the receive operation
+    const std::size_t max_operations_in_flight = ring_->cq_entries() - receive_buffer_count - 16;
+
+    while (first_unissued_job_index_ < send_jobs_.size())
+    {
+      SendJob& job = *send_jobs_[first_unissued_job_index_];
+
+      while (!job.error_ && (job.next_datagram_ < job.messages_.size()))
+      {
+        if (operations_in_flight_ >= max_operations_in_flight)
+          return;
+
+        io_uring_sqe* sqe = ring_->get_sqe();
+        if (sqe == nullptr)
+        {
+          // The submission queue is full. Hand it to the kernel and continue.
+          submit_locked();
+          sqe = ring_->get_sqe();
+          if (sqe == nullptr)
+            return;
+        }
+
+        sqe->opcode    = IORING_OP_SENDMSG;
+        sqe->fd        = socket_.native_handle();
+        sqe->addr      = reinterpret_cast<uint64_t>(&job.messages_[job.next_datagram_]);
+        sqe->len       = 1;
+        sqe->user_data = reinterpret_cast<uint64_t>(&job);
+
+        ++job.next_datagram_;
+        ++job.datagrams_in_flight_;
+        ++operations_in_flight_;
+      }
+
+      ++first_unissued_job_index_;
+    }
+  }
+
+  void SocketUring::on_send_completion_locked(SendJob* job, int result)
+  {
+    --job->datagrams_in_flight_;
+
+    // Only the first error is reported. The remaining datagrams of that
+    // message are not sent anymore.
+    if (result >= 0)
+    {
+      job->bytes_sent_ += static_cast<std::size_t>(result);
+      ++job->datagrams_sent_;
+    }
+    else if (!job->error_)
+    {
+      job->error_ = to_error_code(result);
+    }
+  }
+
+  void SocketUring::collect_finished_send_jobs_locked(std::vector<std::function<void()>>& handlers)
+  {
+    // Handlers are called in order, so we only remove jobs from the front
+    while (!send_jobs_.empty() && send_jobs_.front()->is_finished())
+    {
+      std::unique_ptr<SendJob> job = std::move(send_jobs_.front());
+      send_jobs_.pop_front();
+
+      if (first_unissued_job_index_ > 0)
+        --first_unissued_job_index_;
+
+      auto                   completion_handler = std::move(job->completion_handler_);
+      const asio::error_code ec                 = job->error_;
+      const std::size_t      bytes_sent         = job->bytes_sent_;
+      const std::size_t      datagrams_sent     = job->datagrams_sent_;
+      handlers.emplace_back([completion_handler, ec, bytes_sent, datagrams_sent]() { completion_handler(ec, bytes_sent, datagrams_sent); });
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  void SocketUring::async_receive_from(asio::ip::udp::endpoint& sender_endpoint
+                                     , const ReceiveHandler& completion_handler)
+  {
+    if (init_error_)
+    {
+      const asio::error_code ec = init_error_;
+      asio::post(io_context_, [completion_handler, ec]() { completion_handler(nullptr, ec); });
+      return;
+    }
+
+    std::vector<std::function<void()>> handlers;
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!socket_.is_open())
+    {
+      asio::post(io_context_, [completion_handler]() { completion_handler(nullptr, asio::error::bad_descriptor); });
+      return;
+    }
+
+    receive_requests_.push_back(ReceiveRequest{&sender_endpoint, completion_handler});
+    receiving_started_ = true;
+
+    collect_receive_results_locked(handlers);
+    start_receiving_locked();
+    submit_locked();
+
+    // Never call the handler from within the initiating function
+    for (auto& handler : handlers)
+      asio::post(io_context_, std::move(handler));
+  }
+
+  void SocketUring::start_receiving_locked()
+  {
+    if (!receiving_started_ || receive_armed_ || receive_error_ || !socket_.is_open())
+      return;
+
+    if (received_messages_.size() >= max_pending_received_messages)
+      return;
+
+    // Hand all buffers to the kernel that have been held back
+    for (const uint16_t buffer_id : unprovided_buffer_ids_)
+      provide_receive_buffer_locked(buffer_id);
+    unprovided_buffer_ids_.clear();
+    ring_->commit_buffers();
+
+    io_uring_sqe* sqe = ring_->get_sqe();
+    if (sqe == nullptr)
+    {
+      submit_locked();
+      sqe = ring_->get_sqe();
+      if (sqe == nullptr)
+        return; // Retried when the next completions are handled
+    }
+
+    sqe->opcode    = IORING_OP_RECVMSG;
+    sqe->fd        = socket_.native_handle();
+    sqe->addr      = reinterpret_cast<uint64_t>(receive_msghdr_.get());
+    sqe->ioprio    = IORING_RECV_MULTISHOT;
+    sqe->flags     = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = receive_buffer_group_id;
+    sqe->user_data = receive_operation_tag;
+
+    receive_armed_ = true;
+    ++operations_in_flight_;
+  }
+
+  void SocketUring::provide_receive_buffer_locked(uint16_t buffer_id)
+  {
+    // Buffers that are still used by received messages have been replaced by
+    // a new one from the pool. They return to the pool when they are released.
+    auto buffer = receive_engine_->allocate_buffer();
+    buffer->resize(receive_buffer_size);
+
+    ring_->add_buffer(buffer->data(), static_cast<unsigned int>(buffer->size()), buffer_id);
+    receive_buffers_[buffer_id] = std::move(buffer);
+  }
+
+  void SocketUring::on_receive_completion_locked(const io_uring_cqe& cqe)
+  {
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+    {
+      // The multishot operation has terminated. This also happens when the
+      // kernel runs out of buffers. It is restarted after the completions
+      // have been handled.
+      receive_armed_ = false;
+      --operations_in_flight_;
+
+      if ((cqe.res < 0) && (cqe.res != -ENOBUFS) && (cqe.res != -ECANCELED))
+        receive_error_ = to_error_code(cqe.res);
+    }
+
+    if ((cqe.flags & IORING_CQE_F_BUFFER) == 0)
+      return;
+
+    const auto buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    const std::shared_ptr<ecaludp::RawMemory> buffer = std::move(receive_buffers_[buffer_id]);
+
+    // Only hand a new buffer to the kernel, if the user keeps up with the
+    // received messages
+    if (receiving_started_ && (received_messages_.size() < max_pending_received_messages))
+    {
+      provide_receive_buffer_locked(buffer_id);
+      ring_->commit_buffers();
+    }
+    else
+    {
+      unprovided_buffer_ids_.push_back(buffer_id);
+    }
+
+    if ((buffer == nullptr) || (cqe.res <= 0))
+      return;
+
+    // Layout of the buffer: io_uring_recvmsg_out | sender address | payload
+    const auto* data = reinterpret_cast<const char*>(buffer->data());
+    const auto  size = static_cast<std::size_t>(cqe.res);
+
+    if (size < sizeof(io_uring_recvmsg_out))
+      return;
+
+    io_uring_recvmsg_out recvmsg_out{};
+    memcpy(&recvmsg_out, data, sizeof(recvmsg_out));
+
+    const std::size_t payload_offset = sizeof(io_uring_recvmsg_out) + receive_msghdr_->msg_namelen + receive_msghdr_->msg_controllen;
+    if ((payload_offset > size) || ((recvmsg_out.flags & MSG_TRUNC) != 0))
+      return;
+
+    const std::size_t payload_size = std::min<std::size_t>(recvmsg_out.payloadlen, size - payload_offset);
+
+    auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+    const std::size_t address_size = std::min<std::size_t>(recvmsg_out.namelen, receive_msghdr_->msg_namelen);
+    memcpy(sender_endpoint->data(), data + sizeof(io_uring_recvmsg_out), address_size);
+    sender_endpoint->resize(address_size);
+
+    // Malformed datagrams are dropped silently
+    ecaludp::Error error = ecaludp::Error::ErrorCode::GENERIC_ERROR;
+    auto completed_package = receive_engine_->handle_datagram(data + payload_offset, payload_size, buffer, sender_endpoint, error);
+
+    if (completed_package != nullptr)
+      received_messages_.push_back(ReceivedMessage{completed_package, *sender_endpoint});
+  }
+
+  void SocketUring::collect_receive_results_locked(std::vector<std::function<void()>>& handlers)
+  {
+    while (!receive_requests_.empty())
+    {
+      if (!received_messages_.empty())
+      {
+        ReceiveRequest  request = std::move(receive_requests_.front());
+        ReceivedMessage message = std::move(received_messages_.front());
+        receive_requests_.pop_front();
+        received_messages_.pop_front();
+
+        *request.sender_endpoint_ = message.sender_endpoint_;
+
+        auto completion_handler = std::move(request.completion_handler_);
+        auto completed_package  = std::move(message.message_);
+        handlers.emplace_back([completion_handler, completed_package]() { completion_handler(completed_package, asio::error_code()); });
+      }
+      else if (receive_error_)
+      {
+        // Errors are reported once, just like a socket would do. Receiving is
+        // restarted afterwards.
+        auto completion_handler = std::move(receive_requests_.front().completion_handler_);
+        receive_requests_.pop_front();
+
+        const asio::error_code ec = receive_error_;
+        receive_error_.clear();
+        handlers.emplace_back([completion_handler, ec]() { completion_handler(nullptr, ec); });
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Completion handling
+  /////////////////////////////////////////////////////////////////
+  void SocketUring::submit_locked()
+  {
+    // If the kernel cannot take the SQEs right now (e.g. because the
+    // completion queue is overflowing), they stay in the submission queue
+    // and are submitted again after the next completions have been handled.
+    asio::error_code ec;
+    ring_->submit(0, ec);
+
+    wait_for_completions_locked();
+  }
+
+  void SocketUring::wait_for_completions_locked()
+  {
+    // Only wait while operations are in flight, so the io_context can run
+    // out of work
+    if (completion_wait_active_ || (operations_in_flight_ == 0))
+      return;
+
+    completion_wait_active_ = true;
+
+    const std::weak_ptr<int> lifetime_token = lifetime_token_;
+    completion_event_.async_wait(asio::posix::stream_descriptor::wait_read
+                                , [this, lifetime_token](const asio::error_code& ec)
+                                  {
+                                    if (lifetime_token.expired())
+                                      return;
+
+                                    on_completions(ec);
+                                  });
+  }
+
+  void SocketUring::on_completions(const asio::error_code& ec)
+  {
+    std::vector<std::function<void()>> handlers;
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      completion_wait_active_ = false;
+
+      if (ec == asio::error::operation_aborted)
+        return;
+
+      // Reset the eventfd before reaping, so no notification is lost
+      uint64_t event_count = 0;
+      const auto bytes_read = ::read(completion_event_.native_handle(), &event_count, sizeof(event_count));
+      static_cast<void>(bytes_read);
+
+      reap_completions_locked(handlers);
+
+      issue_send_operations_locked();
+      start_receiving_locked();
+      submit_locked();
+    }
+
+    for (const auto& handler : handlers)
+      handler();
+  }
+
+  void SocketUring::reap_completions_locked(std::vector<std::function<void()>>& handlers)
+  {
+    ring_->for_each_cqe([this](const io_uring_cqe& cqe)
+                        {
+                          if (cqe.user_data == receive_operation_tag)
+                          {
+                            on_receive_completion_locked(cqe);
+                          }
+                          else if (cqe.user_data == cancel_operation_tag)
+                          {
+                            --operations_in_flight_;
+                          }
+                          else
+                          {
+                            --operations_in_flight_;
+                            on_send_completion_locked(reinterpret_cast<SendJob*>(cqe.user_data), cqe.res);
+                          }
+                        });
+
+    collect_finished_send_jobs_locked(handlers);
+    collect_receive_results_locked(handlers);
+  }
+}
@@ -0,0 +1,132 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace ecaludp
+{
+  /**
+   * @brief A thread-safe token bucket used for pacing outgoing datagrams
+   *
+   * The bucket is filled with rate_bytes_per_second tokens per second and
+   * holds at most burst_bytes tokens. Sending a datagram consumes as many
+   * tokens as the datagram has bytes. Datagrams that are larger than the
+   * burst size are allowed to pass as soon as the bucket is full, so the
+   * bucket never blocks forever.
+   *
+   * A rate of 0 disables the bucket, i.e. all datagrams pass immediately.
+   */
+  class TokenBucket
+  {
+  public:
+    TokenBucket()
+      : rate_bytes_per_second_(0)
+      , burst_bytes_          (0)
+      , tokens_               (0.0)
+      , last_refill_          (std::chrono::steady_clock::now())
+    {}
+
+    void configure(std::size_t rate_bytes_per_second, std::size_t burst_bytes)
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      rate_bytes_per_second_ = rate_bytes_per_second;
+      burst_bytes_           = std::max<std::size_t>(burst_bytes, 1);
+      tokens_                = static_cast<double>(burst_bytes_);
+      last_refill_           = std::chrono::steady_clock::now();
+    }
+
+    bool is_enabled() const
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      return rate_bytes_per_second_ > 0;
+    }
+
+    std::size_t get_rate() const
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      return rate_bytes_per_second_;
+    }
+
+    std::size_t get_burst() const
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      return burst_bytes_;
+    }
+
+    /**
+     * @brief Tries to consume the given amount of bytes
+     *
+     * @return 0, if the bytes have been consumed. Otherwise the duration after
+     *         which enough tokens will be available. In that case, nothing is
+     *         consumed.
+     */
+    std::chrono::steady_clock::duration try_consume(std::size_t bytes)
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      if (rate_bytes_per_second_ == 0)
+        return std::chrono::steady_clock::duration(0);
+
+      refill_locked();
+
+      const double needed_tokens = static_cast<double>(std::min(bytes, burst_bytes_));
+      if (tokens_ >= needed_tokens)
+      {
+        tokens_ -= static_cast<double>(bytes);
+        return std::chrono::steady_clock::duration(0);
+      }
+
+      const double missing_seconds = (needed_tokens - tokens_) / static_cast<double>(rate_bytes_per_second_);
+      return std::max(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(missing_seconds))
+                    , std::chrono::steady_clock::duration(1));
+    }
+
+    /**
+     * @brief Returns tokens that have been consumed for bytes that could not be sent
+     */
+    void refund(std::size_t bytes)
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+
+      if (rate_bytes_per_second_ == 0)
+        return;
+
+      refill_locked();
+      tokens_ = std::min(static_cast<double>(burst_bytes_), tokens_ + static_cast<double>(bytes));
+    }
+
+  private:
+    void refill_locked()
+    {
+      const auto now     = std::chrono::steady_clock::now();
+      const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - last_refill_).count();
+      last_refill_       = now;
+
+      tokens_ = std::min(static_cast<double>(burst_bytes_), tokens_ + (elapsed * static_cast<double>(rate_bytes_per_second_)));
+    }
+
+  private:
+    mutable std::mutex                    mutex_;
+    std::size_t                           rate_bytes_per_second_;
+    std::size_t                           burst_bytes_;
+    double                                tokens_;             ///< May become negative, if a datagram larger than the burst size has been sent
+    std::chrono::steady_clock::time_point last_refill_;
+  };
+}
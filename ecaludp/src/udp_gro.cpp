@@ -0,0 +1,156 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "udp_gro.h"
+
+#include <cstddef>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#ifdef __linux__
+  #include <cerrno>
+  #include <cstring>
+  #include <netinet/in.h>
+  #include <netinet/udp.h>
+  #include <sys/socket.h>
+  #include <sys/uio.h>
+
+  // Older libc headers may not know about UDP GRO, yet
+  #ifndef SOL_UDP
+    #define SOL_UDP 17
+  #endif
+  #ifndef UDP_GRO
+    #define UDP_GRO 104
+  #endif
+#endif // __linux__
+
+namespace ecaludp
+{
+#ifdef __linux__
+  bool set_udp_gro(asio::ip::udp::socket& socket, bool enabled)
+  {
+    if (!socket.is_open())
+      return false;
+
+    const int value = (enabled ? 1 : 0);
+    return (::setsockopt(socket.native_handle(), SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0);
+  }
+
+  std::size_t receive_with_udp_gro(asio::ip::udp::socket&           socket
+                                 , const asio::mutable_buffer&      buffer
+                                 , asio::ip::udp::endpoint&         sender_endpoint
+                                 , std::size_t&                     segment_size
+                                 , asio::socket_base::message_flags flags
+                                 , bool                             wait_for_data
+                                 , asio::error_code&                ec)
+  {
+    ec           = asio::error_code();
+    segment_size = 0;
+
+    iovec iov{buffer.data(), buffer.size()};
+
+    // The kernel reports the segment size as int in a UDP_GRO control message
+    union
+    {
+      char     buffer[CMSG_SPACE(sizeof(int))];
+      cmsghdr  align;
+    } control{};
+
+    while (true)
+    {
+      msghdr msg{};
+      msg.msg_name       = sender_endpoint.data();
+      msg.msg_namelen    = static_cast<socklen_t>(sender_endpoint.capacity());
+      msg.msg_iov        = &iov;
+      msg.msg_iovlen     = 1;
+      msg.msg_control    = control.buffer;
+      msg.msg_controllen = sizeof(control.buffer);
+
+      const ssize_t result = ::recvmsg(socket.native_handle(), &msg, static_cast<int>(flags) | (wait_for_data ? 0 : MSG_DONTWAIT));
+
+      if (result >= 0)
+      {
+        sender_endpoint.resize(msg.msg_namelen);
+
+        segment_size = static_cast<std::size_t>(result);
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+          if ((cmsg->cmsg_level == SOL_UDP) && (cmsg->cmsg_type == UDP_GRO))
+          {
+            int gso_size = 0;
+            std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+            if (gso_size > 0)
+              segment_size = static_cast<std::size_t>(gso_size);
+          }
+        }
+
+        return static_cast<std::size_t>(result);
+      }
+      else if (errno == EINTR)
+      {
+        continue;
+      }
+      else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        // Only report would_block, if the user explicitly requested
+        // non-blocking mode. Otherwise the native socket has only been set to
+        // non-blocking mode by asio, so we wait for data to arrive.
+        if (!wait_for_data || socket.non_blocking())
+        {
+          ec = asio::error::would_block;
+          return 0;
+        }
+
+        socket.wait(asio::socket_base::wait_read, ec);
+        if (ec)
+          return 0;
+      }
+      else
+      {
+        ec = asio::error_code(errno, asio::error::get_system_category());
+        return 0;
+      }
+    }
+  }
+
+#else // __linux__
+
+  bool set_udp_gro(asio::ip::udp::socket& /*socket*/, bool /*enabled*/)
+  {
+    return false;
+  }
+
+  std::size_t receive_with_udp_gro(asio::ip::udp::socket&           socket
+                                 , const asio::mutable_buffer&      buffer
+                                 , asio::ip::udp::endpoint&         sender_endpoint
+                                 , std::size_t&                     segment_size
+                                 , asio::socket_base::message_flags flags
+                                 , bool                             wait_for_data
+                                 , asio::error_code&                ec)
+  {
+    if (!wait_for_data && (socket.available(ec) == 0))
+    {
+      if (!ec)
+        ec = asio::error::would_block;
+      return 0;
+    }
+
+    const std::size_t bytes_received = socket.receive_from(buffer, sender_endpoint, flags, ec);
+    segment_size = bytes_received;
+    return bytes_received;
+  }
+
+#endif // __linux__
+}
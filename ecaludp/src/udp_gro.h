@@ -0,0 +1,64 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  /**
+   * @brief Enables or disables UDP generic receive offload (GRO) on the socket
+   *
+   * With GRO, the kernel coalesces multiple consecutive datagrams of the same
+   * size from the same sender into one big buffer. A single receive call can
+   * then return many datagrams at once. The datagrams must be split again by
+   * using the segment size that receive_with_udp_gro() returns.
+   *
+   * @return true, if the kernel supports GRO and the option has been set.
+   *         Always false on non-Linux platforms.
+   */
+  bool set_udp_gro(asio::ip::udp::socket& socket, bool enabled);
+
+  /**
+   * @brief Receives one (possibly coalesced) buffer from a GRO enabled socket
+   *
+   * If wait_for_data is false or if the socket has been set to non-blocking
+   * mode by the user, the function returns asio::error::would_block if no
+   * data is available. Otherwise it blocks until data is available, even if
+   * asio has set the native socket to non-blocking mode internally.
+   *
+   * @param socket          The socket to receive from
+   * @param buffer          The buffer to receive into. Should be large enough for 64 KiB.
+   * @param sender_endpoint Set to the sender of the datagrams
+   * @param segment_size    Set to the size of each coalesced datagram. If the
+   *                        kernel did not coalesce anything, this is the
+   *                        received size.
+   * @param flags           Flags passed to recvmsg()
+   * @param wait_for_data   Whether to block until data is available
+   * @param ec              Set to the error, if any
+   *
+   * @return The number of bytes received in total
+   */
+  std::size_t receive_with_udp_gro(asio::ip::udp::socket&           socket
+                                 , const asio::mutable_buffer&      buffer
+                                 , asio::ip::udp::endpoint&         sender_endpoint
+                                 , std::size_t&                     segment_size
+                                 , asio::socket_base::message_flags flags
+                                 , bool                             wait_for_data
+                                 , asio::error_code&                ec);
+}
@@ -0,0 +1,180 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "udp_packet.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  namespace
+  {
+    constexpr std::size_t ipv4_min_header_size = ipv4_header_size;
+    constexpr uint8_t     ip_protocol_udp      = 17;
+    constexpr uint16_t    ethertype_ipv4       = 0x0800;
+    constexpr uint16_t    ethertype_vlan       = 0x8100;   // 802.1Q
+    constexpr uint16_t    ethertype_qinq       = 0x88A8;   // 802.1ad
+    constexpr std::size_t vlan_tag_size        = 4;
+
+    uint16_t read_uint16_be(const uint8_t* data)
+    {
+      return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8) | data[1]);
+    }
+
+    asio::ip::address_v4 read_address_v4(const uint8_t* data)
+    {
+      return asio::ip::address_v4(asio::ip::address_v4::bytes_type{{data[0], data[1], data[2], data[3]}});
+    }
+
+    void write_uint16_be(uint8_t* data, uint16_t value)
+    {
+      data[0] = static_cast<uint8_t>(value >> 8);
+      data[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+    void write_address_v4(uint8_t* data, const asio::ip::address_v4& address)
+    {
+      const auto bytes = address.to_bytes();
+      std::copy(bytes.begin(), bytes.end(), data);
+    }
+
+    uint16_t ipv4_header_checksum(const uint8_t* header, std::size_t size)
+    {
+      uint32_t sum = 0;
+      for (std::size_t i = 0; i + 1 < size; i += 2)
+        sum += read_uint16_be(header + i);
+
+      while ((sum >> 16) != 0)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+      return static_cast<uint16_t>(~sum);
+    }
+  }
+
+  bool parse_ipv4_udp_packet(const uint8_t* data, std::size_t size, UdpPacketView& packet)
+  {
+    if (size < ipv4_min_header_size)
+      return false;
+
+    // Version and header length
+    const uint8_t     version        = (data[0] >> 4);
+    const std::size_t ip_header_size = static_cast<std::size_t>(data[0] & 0x0F) * 4;
+    if ((version != 4) || (ip_header_size < ipv4_min_header_size) || (size < ip_header_size + udp_header_size))
+      return false;
+
+    // The total length may be smaller than the captured size (e.g. because of
+    // ethernet padding), but never larger
+    const std::size_t total_length = read_uint16_be(data + 2);
+    if ((total_length < ip_header_size + udp_header_size) || (total_length > size))
+      return false;
+
+    // Fragments: "More fragments" flag or a fragment offset
+    const uint16_t flags_and_fragment_offset = read_uint16_be(data + 6);
+    if ((flags_and_fragment_offset & 0x3FFF) != 0)
+      return false;
+
+    if (data[9] != ip_protocol_udp)
+      return false;
+
+    const uint8_t*    udp_header = data + ip_header_size;
+    const std::size_t udp_length = read_uint16_be(udp_header + 4);
+    if ((udp_length < udp_header_size) || (ip_header_size + udp_length > total_length))
+      return false;
+
+    packet.source_       = asio::ip::udp::endpoint(read_address_v4(data + 12), read_uint16_be(udp_header));
+    packet.destination_  = asio::ip::udp::endpoint(read_address_v4(data + 16), read_uint16_be(udp_header + 2));
+    packet.payload_      = udp_header + udp_header_size;
+    packet.payload_size_ = udp_length - udp_header_size;
+
+    return true;
+  }
+
+  bool parse_ethernet_udp_packet(const uint8_t* data, std::size_t size, UdpPacketView& packet)
+  {
+    if (size < ethernet_header_size)
+      return false;
+
+    std::size_t offset    = ethernet_header_size;
+    uint16_t    ethertype = read_uint16_be(data + 12);
+
+    // Skip VLAN tags
+    while ((ethertype == ethertype_vlan) || (ethertype == ethertype_qinq))
+    {
+      if (size < offset + vlan_tag_size)
+        return false;
+
+      ethertype = read_uint16_be(data + offset + 2);
+      offset   += vlan_tag_size;
+    }
+
+    if (ethertype != ethertype_ipv4)
+      return false;
+
+    return parse_ipv4_udp_packet(data + offset, size - offset, packet);
+  }
+
+  std::size_t write_ipv4_udp_headers(uint8_t*                       packet
+                                   , const asio::ip::udp::endpoint& source
+                                   , const asio::ip::udp::endpoint& destination
+                                   , uint16_t                       ip_id
+                                   , uint8_t                        ttl
+                                   , std::size_t                    payload_size)
+  {
+    // IPv4
+    uint8_t* ip_header = packet;
+    ip_header[0] = 0x45;                                                      // Version 4, 5 * 4 bytes header
+    ip_header[1] = 0;                                                         // DSCP / ECN
+    write_uint16_be(ip_header + 2, static_cast<uint16_t>(ipv4_header_size + udp_header_size + payload_size));
+    write_uint16_be(ip_header + 4, ip_id);
+    write_uint16_be(ip_header + 6, 0x4000);                                   // Don't fragment
+    ip_header[8] = ttl;
+    ip_header[9] = ip_protocol_udp;
+    write_uint16_be(ip_header + 10, 0);                                       // Checksum (computed below)
+    write_address_v4(ip_header + 12, source.address().to_v4());
+    write_address_v4(ip_header + 16, destination.address().to_v4());
+    write_uint16_be(ip_header + 10, ipv4_header_checksum(ip_header, ipv4_header_size));
+
+    // UDP
+    uint8_t* udp_header = ip_header + ipv4_header_size;
+    write_uint16_be(udp_header,     source.port());
+    write_uint16_be(udp_header + 2, destination.port());
+    write_uint16_be(udp_header + 4, static_cast<uint16_t>(udp_header_size + payload_size));
+    write_uint16_be(udp_header + 6, 0);                                       // No checksum
+
+    return ipv4_header_size + udp_header_size;
+  }
+
+  std::size_t write_ethernet_ipv4_udp_headers(uint8_t*                       frame
+                                            , const std::array<uint8_t, 6>&  source_mac
+                                            , const std::array<uint8_t, 6>&  destination_mac
+                                            , const asio::ip::udp::endpoint& source
+                                            , const asio::ip::udp::endpoint& destination
+                                            , uint16_t                       ip_id
+                                            , uint8_t                        ttl
+                                            , std::size_t                    payload_size)
+  {
+    // Ethernet
+    std::copy(destination_mac.begin(), destination_mac.end(), frame);
+    std::copy(source_mac.begin(),      source_mac.end(),      frame + 6);
+    write_uint16_be(frame + 12, ethertype_ipv4);
+
+    return ethernet_header_size + write_ipv4_udp_headers(frame + ethernet_header_size, source, destination, ip_id, ttl, payload_size);
+  }
+}
@@ -0,0 +1,97 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  constexpr std::size_t ethernet_header_size = 14;
+  constexpr std::size_t ipv4_header_size     = 20;    ///< Without options
+  constexpr std::size_t udp_header_size      = 8;
+
+  /**
+   * @brief A UDP datagram inside a captured packet
+   *
+   * The payload points into the memory of the packet.
+   */
+  struct UdpPacketView
+  {
+    asio::ip::udp::endpoint source_;
+    asio::ip::udp::endpoint destination_;
+    const uint8_t*          payload_      {nullptr};
+    std::size_t             payload_size_ {0};
+  };
+
+  /**
+   * @brief Parses an IPv4 packet (starting at the IP header) that carries a UDP datagram
+   *
+   * The checksums are not verified. IP fragments are not supported, as they
+   * would have to be reassembled first.
+   *
+   * @return false, if the packet is not a complete and unfragmented IPv4 UDP packet
+   */
+  bool parse_ipv4_udp_packet(const uint8_t* data, std::size_t size, UdpPacketView& packet);
+
+  /**
+   * @brief Parses an Ethernet frame that carries an IPv4 UDP packet
+   *
+   * VLAN tags (802.1Q and 802.1ad) are skipped.
+   *
+   * @return false, if the frame doesn't carry a complete and unfragmented IPv4 UDP packet
+   */
+  bool parse_ethernet_udp_packet(const uint8_t* data, std::size_t size, UdpPacketView& packet);
+
+  /**
+   * @brief Writes the IPv4 and UDP headers of a packet that carries a UDP
+   *        payload of the given size
+   *
+   * The packet must have room for ipv4_header_size + udp_header_size bytes.
+   * See write_ethernet_ipv4_udp_headers() for the header fields.
+   *
+   * @return the size of the headers, i.e. the offset of the payload in the packet
+   */
+  std::size_t write_ipv4_udp_headers(uint8_t*                       packet
+                                   , const asio::ip::udp::endpoint& source
+                                   , const asio::ip::udp::endpoint& destination
+                                   , uint16_t                       ip_id
+                                   , uint8_t                        ttl
+                                   , std::size_t                    payload_size);
+
+  /**
+   * @brief Writes the Ethernet, IPv4 and UDP headers of a frame that carries
+   *        a UDP payload of the given size
+   *
+   * The frame must have room for ethernet_header_size + ipv4_header_size +
+   * udp_header_size bytes. The IP header checksum is computed, the UDP
+   * checksum is left at 0 (i.e. not used), as it would require the payload.
+   * The "don't fragment" flag is set.
+   *
+   * @return the size of the headers, i.e. the offset of the payload in the frame
+   */
+  std::size_t write_ethernet_ipv4_udp_headers(uint8_t*                       frame
+                                            , const std::array<uint8_t, 6>&  source_mac
+                                            , const std::array<uint8_t, 6>&  destination_mac
+                                            , const asio::ip::udp::endpoint& source
+                                            , const asio::ip::udp::endpoint& destination
+                                            , uint16_t                       ip_id
+                                            , uint8_t                        ttl
+                                            , std::size_t                    payload_size);
+}
@@ -0,0 +1,54 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+/**
+ * USDT (user statically defined tracing) probes of the "ecaludp" provider.
+ *
+ * With ECALUDP_USDT_ENABLED, each probe compiles to a single nop and a note in
+ * the ELF file, which perf, bpftrace or SystemTap can attach to at runtime.
+ * Otherwise the macros expand to nothing and their arguments are not
+ * evaluated. Endpoints are passed as pointers to their sockaddr.
+ *
+ * | Probe               | Arguments                                                   |
+ * |---------------------|-------------------------------------------------------------|
+ * | datagram_received   | sender, datagram size                                       |
+ * | datagram_dropped    | sender, datagram size, reason (ecaludp::Error::ErrorCode)   |
+ * | package_created     | sender, message id                                          |
+ * | fragment_added      | sender, message id, fragment number, received fragments     |
+ * | package_completed   | sender, message id, message size, fragments                 |
+ * | package_expired     | sender, message id, received fragments, total fragments     |
+ * | package_evicted     | sender, message id, buffered bytes                          |
+ * | package_rejected    | sender, message id, message size (or bytes buffered so far) |
+ * | package_abandoned   | sender, message id, received fragments, total fragments     |
+ * | fragment_sent       | destination, datagram size (once per GSO segment, too)      |
+ */
+
+#ifdef ECALUDP_USDT_ENABLED
+
+#include <sys/sdt.h>
+
+#define ECALUDP_PROBE2(name, a1, a2)                 DTRACE_PROBE2(ecaludp, name, a1, a2)
+#define ECALUDP_PROBE3(name, a1, a2, a3)             DTRACE_PROBE3(ecaludp, name, a1, a2, a3)
+#define ECALUDP_PROBE4(name, a1, a2, a3, a4)         DTRACE_PROBE4(ecaludp, name, a1, a2, a3, a4)
+
+#else // ECALUDP_USDT_ENABLED
+
+#define ECALUDP_PROBE2(name, a1, a2)                 static_cast<void>(0)
+#define ECALUDP_PROBE3(name, a1, a2, a3)             static_cast<void>(0)
+#define ECALUDP_PROBE4(name, a1, a2, a3, a4)         static_cast<void>(0)
+
+#endif // ECALUDP_USDT_ENABLED
@@ -0,0 +1,150 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "zerocopy.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#ifdef __linux__
+  #include <cerrno>
+  #include <cstring>
+  #include <linux/errqueue.h>
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+
+  // Older libc headers may not know about zerocopy sending, yet
+  #ifndef SO_ZEROCOPY
+    #define SO_ZEROCOPY 60
+  #endif
+  #ifndef MSG_ZEROCOPY
+    #define MSG_ZEROCOPY 0x4000000
+  #endif
+  #ifndef SO_EE_ORIGIN_ZEROCOPY
+    #define SO_EE_ORIGIN_ZEROCOPY 5
+  #endif
+#endif // __linux__
+
+namespace ecaludp
+{
+#ifdef __linux__
+  bool enable_zerocopy(asio::ip::udp::socket& socket, bool& newly_enabled)
+  {
+    newly_enabled = false;
+
+    if (!socket.is_open())
+      return false;
+
+    int       enabled     = 0;
+    socklen_t enabled_len = sizeof(enabled);
+    if (::getsockopt(socket.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &enabled, &enabled_len) != 0)
+      return false;
+
+    if (enabled != 0)
+      return true;
+
+    const int enable = 1;
+    if (::setsockopt(socket.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) != 0)
+      return false;
+
+    newly_enabled = true;
+    return true;
+  }
+
+  asio::socket_base::message_flags zerocopy_send_flag()
+  {
+    return MSG_ZEROCOPY;
+  }
+
+  void read_zerocopy_completions(asio::ip::udp::socket&                      socket
+                               , std::vector<std::pair<uint32_t, uint32_t>>& completed_ranges
+                               , asio::error_code&                           ec)
+  {
+    ec = asio::error_code();
+
+    while (true)
+    {
+      // The notifications don't contain any data, only a control message
+      union
+      {
+        char     buffer[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+        cmsghdr  align;
+      } control{};
+
+      msghdr msg{};
+      msg.msg_control    = control.buffer;
+      msg.msg_controllen = sizeof(control.buffer);
+
+      const ssize_t result = ::recvmsg(socket.native_handle(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+
+      if (result < 0)
+      {
+        if (errno == EINTR)
+          continue;
+
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+          ec = asio::error::would_block;
+        else
+          ec = asio::error_code(errno, asio::error::get_system_category());
+        return;
+      }
+
+      for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+      {
+        if (!(((cmsg->cmsg_level == SOL_IP)   && (cmsg->cmsg_type == IP_RECVERR))
+           || ((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR))))
+        {
+          continue;
+        }
+
+        sock_extended_err serr{};
+        std::memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+
+        if ((serr.ee_origin == SO_EE_ORIGIN_ZEROCOPY) && (serr.ee_errno == 0))
+        {
+          // ee_info is the first and ee_data is the last completed ID. The
+          // ee_code tells whether the kernel had to copy the data anyways,
+          // which doesn't matter for us.
+          completed_ranges.emplace_back(serr.ee_info, serr.ee_data);
+        }
+      }
+    }
+  }
+
+#else // __linux__
+
+  bool enable_zerocopy(asio::ip::udp::socket& /*socket*/, bool& newly_enabled)
+  {
+    newly_enabled = false;
+    return false;
+  }
+
+  asio::socket_base::message_flags zerocopy_send_flag()
+  {
+    return 0;
+  }
+
+  void read_zerocopy_completions(asio::ip::udp::socket&                      /*socket*/
+                               , std::vector<std::pair<uint32_t, uint32_t>>& /*completed_ranges*/
+                               , asio::error_code&                           ec)
+  {
+    ec = asio::error::operation_not_supported;
+  }
+
+#endif // __linux__
+}
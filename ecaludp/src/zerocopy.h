@@ -0,0 +1,59 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+namespace ecaludp
+{
+  /**
+   * @brief Enables SO_ZEROCOPY on the socket, if it is not enabled, yet
+   *
+   * @param newly_enabled  Set to true, if the option has not been enabled
+   *                       before. In that case, the kernel starts counting
+   *                       the zerocopy sends from 0.
+   *
+   * @return true, if zerocopy sending is enabled on the socket. Always false
+   *         on non-Linux platforms.
+   */
+  bool enable_zerocopy(asio::ip::udp::socket& socket, bool& newly_enabled);
+
+  /**
+   * @brief The message flag that requests a zerocopy send (MSG_ZEROCOPY)
+   *
+   * Every successful send with this flag is assigned an ID by the kernel.
+   * The IDs start at 0 and are incremented by 1 for each send. When the
+   * kernel does not need the memory anymore, it reports the range of IDs
+   * on the error queue of the socket. 0 on non-Linux platforms.
+   */
+  asio::socket_base::message_flags zerocopy_send_flag();
+
+  /**
+   * @brief Reads all zerocopy completion notifications from the error queue of the socket
+   *
+   * The function never blocks. If the error queue is empty, ec is set to
+   * asio::error::would_block.
+   *
+   * @param completed_ranges  The ranges [first, last] of the completed send IDs are added to this vector
+   */
+  void read_zerocopy_completions(asio::ip::udp::socket&                      socket
+                               , std::vector<std::pair<uint32_t, uint32_t>>& completed_ranges
+                               , asio::error_code&                           ec);
+}
@@ -0,0 +1,146 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+  // Each power of two is divided into 1024 linear sub-buckets. The values
+  // below 2048 map to their own bucket.
+  constexpr unsigned int sub_bucket_bits       = 10;
+  constexpr uint64_t     sub_bucket_count      = uint64_t(1) << sub_bucket_bits;
+  constexpr uint64_t     linear_range          = sub_bucket_count * 2;
+
+  constexpr unsigned int max_value_bits        = 40;
+  constexpr uint64_t     max_trackable_value   = (uint64_t(1) << max_value_bits) - 1;
+
+  constexpr size_t       bucket_count          = linear_range + (max_value_bits - sub_bucket_bits - 1) * sub_bucket_count;
+
+  unsigned int most_significant_bit(uint64_t value)
+  {
+    unsigned int msb = 0;
+    while (value >>= 1)
+      ++msb;
+    return msb;
+  }
+}
+
+LatencyHistogram::LatencyHistogram()
+  : counts_(bucket_count, 0)
+{}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+  const uint64_t value = std::min(static_cast<uint64_t>(std::max(latency.count(), std::chrono::nanoseconds::rep(0))), max_trackable_value);
+
+  counts_[bucket_index(value)]++;
+
+  if ((total_count_ == 0) || (value < min_))
+    min_ = value;
+  if (value > max_)
+    max_ = value;
+
+  sum_ += value;
+  total_count_++;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+  if (other.total_count_ == 0)
+    return;
+
+  for (size_t i = 0; i < counts_.size(); ++i)
+    counts_[i] += other.counts_[i];
+
+  min_          = (total_count_ == 0 ? other.min_ : std::min(min_, other.min_));
+  max_          = std::max(max_, other.max_);
+  sum_         += other.sum_;
+  total_count_ += other.total_count_;
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(counts_.begin(), counts_.end(), 0);
+  total_count_ = 0;
+  min_         = 0;
+  max_         = 0;
+  sum_         = 0;
+}
+
+std::chrono::nanoseconds LatencyHistogram::min() const
+{
+  return std::chrono::nanoseconds(min_);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const
+{
+  return std::chrono::nanoseconds(max_);
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const
+{
+  if (total_count_ == 0)
+    return std::chrono::nanoseconds(0);
+
+  return std::chrono::nanoseconds(sum_ / total_count_);
+}
+
+std::chrono::nanoseconds LatencyHistogram::value_at_percentile(double percentile) const
+{
+  if (total_count_ == 0)
+    return std::chrono::nanoseconds(0);
+
+  const double   clamped_percentile = std::min(std::max(percentile, 0.0), 100.0);
+  const uint64_t target_count       = std::max(static_cast<uint64_t>(std::ceil(clamped_percentile / 100.0 * static_cast<double>(total_count_))), uint64_t(1));
+
+  uint64_t count = 0;
+  for (size_t i = 0; i < counts_.size(); ++i)
+  {
+    count += counts_[i];
+    if (count >= target_count)
+      return std::chrono::nanoseconds(std::min(highest_equivalent_value(i), max_));
+  }
+
+  return std::chrono::nanoseconds(max_);
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value)
+{
+  if (value < linear_range)
+    return static_cast<size_t>(value);
+
+  // Shift the value into [sub_bucket_count, 2 * sub_bucket_count) and count the shifts
+  const unsigned int shift      = most_significant_bit(value) - sub_bucket_bits;
+  const uint64_t     sub_bucket = (value >> shift) - sub_bucket_count;
+
+  return static_cast<size_t>(linear_range + (shift - 1) * sub_bucket_count + sub_bucket);
+}
+
+uint64_t LatencyHistogram::highest_equivalent_value(size_t index)
+{
+  if (index < linear_range)
+    return index;
+
+  const uint64_t shift      = (index - linear_range) / sub_bucket_count + 1;
+  const uint64_t sub_bucket = (index - linear_range) % sub_bucket_count + sub_bucket_count;
+
+  return (sub_bucket << shift) + ((uint64_t(1) << shift) - 1);
+}
@@ -0,0 +1,71 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief A latency histogram with HDR-style log-linear buckets
+ *
+ * Values are recorded in nanoseconds with a relative precision of about 0.1%
+ * (3 significant digits) over the whole range, so the tail percentiles are as
+ * exact as the median. Values below 2048 ns are recorded exactly, values
+ * above ~18 minutes are clamped.
+ *
+ * Recording is a few shifts and an increment; percentiles are computed by
+ * walking all buckets, so only query them from time to time.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+
+  void record(std::chrono::nanoseconds latency);
+
+  /**
+   * @brief Adds all values recorded by the other histogram to this one
+   */
+  void add(const LatencyHistogram& other);
+
+  void reset();
+
+  uint64_t count() const { return total_count_; }
+
+  std::chrono::nanoseconds min()  const;
+  std::chrono::nanoseconds max()  const;
+  std::chrono::nanoseconds mean() const;
+
+  /**
+   * @brief Returns the value that the given percentage of all recorded values is less than or equal to
+   *
+   * @param percentile The percentile in [0.0, 100.0], e.g. 99.99
+   */
+  std::chrono::nanoseconds value_at_percentile(double percentile) const;
+
+private:
+  static size_t   bucket_index(uint64_t value);
+  static uint64_t highest_equivalent_value(size_t index);
+
+private:
+  std::vector<uint64_t> counts_;
+  uint64_t              total_count_ {0};
+  uint64_t              min_         {0};
+  uint64_t              max_         {0};
+  uint64_t              sum_         {0};
+};
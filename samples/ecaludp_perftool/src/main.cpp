@@ -28,20 +28,45 @@
 
 #include <asio.hpp> // IWYU pragma: keep
 
+#include "ping_pong.h"
 #include "receiver.h"
 #include "receiver_async.h"
 #include "receiver_parameters.h"
+#include "receiver_pong.h"
 #include "receiver_sync.h"
 #include "sender.h"
 #include "sender_async.h"
 #include "sender_parameters.h"
 #include "sender_sync.h"
+#include "simulation_parameters.h"
+#include "sweep.h"
+#include "sweep_parameters.h"
 
 #if ECALUDP_UDPCAP_ENABLED
   #include "receiver_npcap_sync.h"
   #include "receiver_npcap_async.h"
 #endif // ECALUDP_UDPCAP_ENABLED
 
+#if ECALUDP_URING_ENABLED
+  #include "receiver_uring.h"
+  #include "sender_uring.h"
+#endif // ECALUDP_URING_ENABLED
+
+#if ECALUDP_PACKET_MMAP_ENABLED
+  #include "receiver_packet_mmap.h"
+  #include "sender_packet_mmap.h"
+#endif // ECALUDP_PACKET_MMAP_ENABLED
+
+#if ECALUDP_SHM_ENABLED
+  #include "receiver_shm.h"
+  #include "sender_shm.h"
+#endif // ECALUDP_SHM_ENABLED
+
+#if ECALUDP_TESTSUPPORT_ENABLED
+  #include "receiver_replay.h"
+  #include "simulation.h"
+#endif // ECALUDP_TESTSUPPORT_ENABLED
+
 enum class Implementation
 {
   NONE,
@@ -50,7 +75,18 @@ enum class Implementation
   RECEIVE,
   RECEIVEASYNC,
   RECEIVENPCAP,
-  RECEIVENPCAPASYNC
+  RECEIVENPCAPASYNC,
+  SENDURING,
+  RECEIVEURING,
+  SENDPACKETMMAP,
+  RECEIVEPACKETMMAP,
+  SENDSHM,
+  RECEIVESHM,
+  REPLAY,
+  SIMULATE,
+  PINGPONG,
+  PONG,
+  SWEEP
 };
 
 void printUsage(const std::string& arg0)
@@ -65,6 +101,17 @@ void printUsage(const std::string& arg0)
   std::cout << "  receiveasync        Asio-based receiver using async_receive_from\n";
   std::cout << "  receivenpcap        Npcap-based receiver using receive_from in a while-loop\n";
   std::cout << "  receivenpcapasync   Npcap-based receiver using async_receive_from\n";
+  std::cout << "  senduring           io_uring-based sender using async_send_to (Linux only)\n";
+  std::cout << "  receiveuring        io_uring-based receiver using async_receive_from (Linux only)\n";
+  std::cout << "  sendpacketmmap      AF_PACKET-based sender writing to a PACKET_TX_RING (Linux only)\n";
+  std::cout << "  receivepacketmmap   AF_PACKET-based receiver using receive_from in a while-loop (Linux only)\n";
+  std::cout << "  sendshm             Shared memory sender for receivers on the same host, using async_send_to (Linux only)\n";
+  std::cout << "  receiveshm          Shared memory receiver using async_receive_from (Linux only)\n";
+  std::cout << "  replay              Reassembles the ecaludp traffic of a pcap / pcapng file in a loop (requires --file)\n";
+  std::cout << "  pingpong            Sends a message to a pong receiver, waits for it to come back and prints round trip time percentiles\n";
+  std::cout << "  pong                Asio-based receiver that sends every message back to its sender\n";
+  std::cout << "  sweep               Runs sender and receiver over loopback for each combination of message size, max UDP datagram size and buffer size and writes CSV / JSON\n";
+  std::cout << "  simulate            Sends messages through a simulated network with loss, reordering, duplication and jitter\n";
   std::cout << '\n';
   std::cout << "Options:\n";
   std::cout << "  -h, --help  Show this help message and exit\n";
@@ -74,6 +121,29 @@ void printUsage(const std::string& arg0)
   std::cout << "  -s, --size <SIZE> Message size to send. Default to 0 (-> empty messages)\n";
   std::cout << "  -m, --max-udp-datagram-size <SIZE> Maximum UDP datagram size\n";
   std::cout << "  -b, --buffer-size <SIZE> Buffer size for sending & receiving messages\n";
+  std::cout << "  -r, --rate <BYTES/S> Pace the sender to the given rate (including headers). Default to 0 (-> unlimited)\n";
+  std::cout << "      --burst <SIZE> Burst size in bytes for the --rate pacing. Default to 65536\n";
+  std::cout << "      --gso Use UDP generic segmentation offload for sending (Linux only, send only)\n";
+  std::cout << "      --gro Use UDP generic receive offload for receiving (Linux only, receive only)\n";
+  std::cout << "      --zerocopy <SIZE> Send messages of at least SIZE bytes with MSG_ZEROCOPY (Linux only, sendasync only)\n";
+  std::cout << "      --threads <N> Number of sender threads or of threads running the io_context of the receiver. Default to 1 (send, sendasync and receiveasync only)\n";
+  std::cout << "      --sockets <N> Number of sockets per sender thread. Default to 1 (send and sendasync only)\n";
+  std::cout << "      --ports <N> Number of consecutive ports starting at --port. Senders spread their sockets across the ports, receivers open one socket per port. Default to 1 (send, sendasync, receive and receiveasync only)\n";
+  std::cout << "      --record <PATH> Record all received datagrams to a pcap file (receive, receiveasync, receivenpcap and receivenpcapasync only)\n";
+  std::cout << "      --reassembly-top <N> Print the N incomplete messages buffering the most bytes every second (receive and receiveasync only)\n";
+  std::cout << "  -f, --file <PATH> Capture file to replay (replay only)\n";
+  std::cout << "      --recorded-timing Replay with the timing of the capture instead of as fast as possible (replay only)\n";
+  std::cout << "      --sweep-size <VALUES> Message sizes, as list (1000,2000) or geometric range (START:END:FACTOR). Default to 1000,10000,100000,1000000 (sweep only)\n";
+  std::cout << "      --sweep-max-udp-datagram-size <VALUES> Max UDP datagram sizes, \"default\" for the default. Default to 1448,8972,65507 (sweep only)\n";
+  std::cout << "      --sweep-buffer-size <VALUES> Send and receive buffer sizes, \"default\" for the OS default. Default to default,1048576,8388608 (sweep only)\n";
+  std::cout << "      --duration <MS> Send duration of each point. Default to 2000 (sweep only)\n";
+  std::cout << "      --format <csv|json> Output format. Default to csv (sweep only)\n";
+  std::cout << "      --output <PATH> Write the results to a file instead of stdout (sweep only)\n";
+  std::cout << "      --profile <NAME> Impairment profile: none, loss, burst, reorder, duplicate, jitter, mixed or all. Default to all (simulate only)\n";
+  std::cout << "      --impairment <SPEC> Custom impairment instead of a profile, e.g. loss=0.01,burst=0.001/20,reorder=16,duplicate=0.01,delay=1000,jitter=500 (delay and jitter in us, simulate only)\n";
+  std::cout << "      --seed <N> Seed of the simulated network. Default to 1 (simulate only)\n";
+  std::cout << "      --messages <N> Number of messages per profile. Default to 10000 (simulate only)\n";
+  std::cout << "      --interval <US> Simulated time between two messages. Default to 1000 (simulate only)\n";
   std::cout << '\n';
 }
 
@@ -83,6 +153,8 @@ int main(int argc, char* argv[])
 
   ReceiverParameters receiver_parameters;
   SenderParameters   sender_parameters;
+  SimulationParameters simulation_parameters;
+  SweepParameters      sweep_parameters;
 
   // convert argc, argv to vector of strings
   std::vector<std::string> args;
@@ -127,6 +199,50 @@ int main(int argc, char* argv[])
     {
       implementation = Implementation::RECEIVENPCAPASYNC;
     }
+    else if (args[1] == "senduring")
+    {
+      implementation = Implementation::SENDURING;
+    }
+    else if (args[1] == "receiveuring")
+    {
+      implementation = Implementation::RECEIVEURING;
+    }
+    else if (args[1] == "sendpacketmmap")
+    {
+      implementation = Implementation::SENDPACKETMMAP;
+    }
+    else if (args[1] == "receivepacketmmap")
+    {
+      implementation = Implementation::RECEIVEPACKETMMAP;
+    }
+    else if (args[1] == "sendshm")
+    {
+      implementation = Implementation::SENDSHM;
+    }
+    else if (args[1] == "receiveshm")
+    {
+      implementation = Implementation::RECEIVESHM;
+    }
+    else if (args[1] == "replay")
+    {
+      implementation = Implementation::REPLAY;
+    }
+    else if (args[1] == "pingpong")
+    {
+      implementation = Implementation::PINGPONG;
+    }
+    else if (args[1] == "pong")
+    {
+      implementation = Implementation::PONG;
+    }
+    else if (args[1] == "sweep")
+    {
+      implementation = Implementation::SWEEP;
+    }
+    else if (args[1] == "simulate")
+    {
+      implementation = Implementation::SIMULATE;
+    }
     else
     {
       printUsage(args[0]);
@@ -278,10 +394,498 @@ int main(int argc, char* argv[])
     }
   }
 
+  // Check for -r / --rate
+  {
+    auto it = std::find(args.begin(), args.end(), "--rate");
+    if (it == args.end())
+    {
+      it = std::find(args.begin(), args.end(), "-r");
+    }
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --rate requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        sender_parameters.rate = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --rate requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Check for --burst
+  {
+    auto it = std::find(args.begin(), args.end(), "--burst");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --burst requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        sender_parameters.burst = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --burst requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Check for --gso
+  {
+    auto it = std::find(args.begin(), args.end(), "--gso");
+    if (it != args.end())
+    {
+      sender_parameters.udp_gso = true;
+    }
+  }
+
+  // Check for --zerocopy
+  {
+    auto it = std::find(args.begin(), args.end(), "--zerocopy");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --zerocopy requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        sender_parameters.zerocopy_threshold = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --zerocopy requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Check for --gro
+  {
+    auto it = std::find(args.begin(), args.end(), "--gro");
+    if (it != args.end())
+    {
+      receiver_parameters.udp_gro = true;
+    }
+  }
+
+  // Check for --threads
+  {
+    auto it = std::find(args.begin(), args.end(), "--threads");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --threads requires an argument\n";
+        return 1;
+      }
+
+      unsigned long threads {0};
+      try
+      {
+        threads = std::stoul(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --threads requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+
+      if (threads == 0)
+      {
+        std::cerr << "Error: --threads must be at least 1\n";
+        return 1;
+      }
+
+      if ((implementation != Implementation::SEND) && (implementation != Implementation::SENDASYNC) && (implementation != Implementation::RECEIVEASYNC))
+      {
+        std::cerr << "Error: --threads is only supported by send, sendasync and receiveasync\n";
+        return 1;
+      }
+
+      sender_parameters.threads   = threads;
+      receiver_parameters.threads = threads;
+    }
+  }
+
+  // Check for --sockets
+  {
+    auto it = std::find(args.begin(), args.end(), "--sockets");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --sockets requires an argument\n";
+        return 1;
+      }
+
+      unsigned long sockets {0};
+      try
+      {
+        sockets = std::stoul(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --sockets requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+
+      if (sockets == 0)
+      {
+        std::cerr << "Error: --sockets must be at least 1\n";
+        return 1;
+      }
+
+      if ((implementation != Implementation::SEND) && (implementation != Implementation::SENDASYNC))
+      {
+        std::cerr << "Error: --sockets is only supported by send and sendasync\n";
+        return 1;
+      }
+
+      sender_parameters.sockets = sockets;
+    }
+  }
+
+  // Check for --ports
+  {
+    auto it = std::find(args.begin(), args.end(), "--ports");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --ports requires an argument\n";
+        return 1;
+      }
+
+      unsigned long ports {0};
+      try
+      {
+        ports = std::stoul(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --ports requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+
+      if (ports == 0)
+      {
+        std::cerr << "Error: --ports must be at least 1\n";
+        return 1;
+      }
+
+      if ((implementation != Implementation::SEND) && (implementation != Implementation::SENDASYNC)
+          && (implementation != Implementation::RECEIVE) && (implementation != Implementation::RECEIVEASYNC))
+      {
+        std::cerr << "Error: --ports is only supported by send, sendasync, receive and receiveasync\n";
+        return 1;
+      }
+
+      if (sender_parameters.port + ports - 1 > std::numeric_limits<uint16_t>::max())
+      {
+        std::cerr << "Error: --ports out of range\n";
+        return 1;
+      }
+
+      sender_parameters.ports   = ports;
+      receiver_parameters.ports = ports;
+    }
+  }
+
+  // Check for --record
+  {
+    auto it = std::find(args.begin(), args.end(), "--record");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --record requires an argument\n";
+        return 1;
+      }
+      receiver_parameters.record_file = *(it + 1);
+
+      if (receiver_parameters.ports > 1)
+      {
+        std::cerr << "Error: --record only supports a single port\n";
+        return 1;
+      }
+    }
+  }
+
+  // Check for --reassembly-top
+  {
+    auto it = std::find(args.begin(), args.end(), "--reassembly-top");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --reassembly-top requires an argument\n";
+        return 1;
+      }
+
+      unsigned long reassembly_top {0};
+      try
+      {
+        reassembly_top = std::stoul(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --reassembly-top requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+
+      if ((implementation != Implementation::RECEIVE) && (implementation != Implementation::RECEIVEASYNC))
+      {
+        std::cerr << "Error: --reassembly-top is only supported by receive and receiveasync\n";
+        return 1;
+      }
+
+      receiver_parameters.reassembly_top = reassembly_top;
+    }
+  }
+
+  // Check for -f / --file
+  {
+    auto it = std::find(args.begin(), args.end(), "--file");
+    if (it == args.end())
+    {
+      it = std::find(args.begin(), args.end(), "-f");
+    }
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --file requires an argument\n";
+        return 1;
+      }
+      receiver_parameters.replay_file = *(it + 1);
+    }
+    else if (implementation == Implementation::REPLAY)
+    {
+      std::cerr << "Error: replay requires --file\n";
+      return 1;
+    }
+  }
+
+  // Check for --recorded-timing
+  {
+    auto it = std::find(args.begin(), args.end(), "--recorded-timing");
+    if (it != args.end())
+    {
+      receiver_parameters.replay_recorded_timing = true;
+    }
+  }
+
+  // Check for --sweep-size
+  {
+    auto it = std::find(args.begin(), args.end(), "--sweep-size");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --sweep-size requires an argument\n";
+        return 1;
+      }
+      sweep_parameters.message_sizes = *(it + 1);
+    }
+  }
+
+  // Check for --sweep-max-udp-datagram-size
+  {
+    auto it = std::find(args.begin(), args.end(), "--sweep-max-udp-datagram-size");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --sweep-max-udp-datagram-size requires an argument\n";
+        return 1;
+      }
+      sweep_parameters.max_udp_datagram_sizes = *(it + 1);
+    }
+  }
+
+  // Check for --sweep-buffer-size
+  {
+    auto it = std::find(args.begin(), args.end(), "--sweep-buffer-size");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --sweep-buffer-size requires an argument\n";
+        return 1;
+      }
+      sweep_parameters.buffer_sizes = *(it + 1);
+    }
+  }
+
+  // Check for --duration
+  {
+    auto it = std::find(args.begin(), args.end(), "--duration");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --duration requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        sweep_parameters.duration_ms = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --duration requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Check for --format
+  {
+    auto it = std::find(args.begin(), args.end(), "--format");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --format requires an argument\n";
+        return 1;
+      }
+      sweep_parameters.format = *(it + 1);
+    }
+  }
+
+  // Check for --output
+  {
+    auto it = std::find(args.begin(), args.end(), "--output");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --output requires an argument\n";
+        return 1;
+      }
+      sweep_parameters.output_file = *(it + 1);
+    }
+  }
+
+  // Check for --profile
+  {
+    auto it = std::find(args.begin(), args.end(), "--profile");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --profile requires an argument\n";
+        return 1;
+      }
+      simulation_parameters.profile = *(it + 1);
+    }
+  }
+
+  // Check for --impairment
+  {
+    auto it = std::find(args.begin(), args.end(), "--impairment");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --impairment requires an argument\n";
+        return 1;
+      }
+      simulation_parameters.impairment = *(it + 1);
+    }
+  }
+
+  // Check for --seed
+  {
+    auto it = std::find(args.begin(), args.end(), "--seed");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --seed requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        simulation_parameters.seed = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --seed requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Check for --messages
+  {
+    auto it = std::find(args.begin(), args.end(), "--messages");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --messages requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        simulation_parameters.messages = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --messages requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Check for --interval
+  {
+    auto it = std::find(args.begin(), args.end(), "--interval");
+    if (it != args.end())
+    {
+      if (it + 1 == args.end())
+      {
+        std::cerr << "Error: --interval requires an argument\n";
+        return 1;
+      }
+
+      try
+      {
+        simulation_parameters.message_interval_us = std::stoull(*(it + 1));
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: --interval requires a numeric argument: " << e.what() << '\n';
+        return 1;
+      }
+    }
+  }
 
   // Run the selected implementation
   std::shared_ptr<Sender>   sender;
   std::shared_ptr<Receiver> receiver;
+  std::shared_ptr<PingPong> ping_pong;
 
   switch (implementation)
   {
@@ -315,6 +919,77 @@ int main(int argc, char* argv[])
     std::cerr << "Error: Npcap-based receiver not enabled\n";
     return 1;
 #endif // ECALUDP_UDPCAP_ENABLED
+  case Implementation::SENDURING:
+#if ECALUDP_URING_ENABLED
+    sender = std::make_shared<SenderUring>(sender_parameters);
+    break;
+#else
+    std::cerr << "Error: io_uring-based sender not enabled\n";
+    return 1;
+#endif // ECALUDP_URING_ENABLED
+  case Implementation::RECEIVEURING:
+#if ECALUDP_URING_ENABLED
+    receiver = std::make_shared<ReceiverUring>(receiver_parameters);
+    break;
+#else
+    std::cerr << "Error: io_uring-based receiver not enabled\n";
+    return 1;
+#endif // ECALUDP_URING_ENABLED
+  case Implementation::SENDPACKETMMAP:
+#if ECALUDP_PACKET_MMAP_ENABLED
+    sender = std::make_shared<SenderPacketMmap>(sender_parameters);
+    break;
+#else
+    std::cerr << "Error: AF_PACKET-based sender not enabled\n";
+    return 1;
+#endif // ECALUDP_PACKET_MMAP_ENABLED
+  case Implementation::RECEIVEPACKETMMAP:
+#if ECALUDP_PACKET_MMAP_ENABLED
+    receiver = std::make_shared<ReceiverPacketMmap>(receiver_parameters);
+    break;
+#else
+    std::cerr << "Error: AF_PACKET-based receiver not enabled\n";
+    return 1;
+#endif // ECALUDP_PACKET_MMAP_ENABLED
+  case Implementation::SENDSHM:
+#if ECALUDP_SHM_ENABLED
+    sender = std::make_shared<SenderShm>(sender_parameters);
+    break;
+#else
+    std::cerr << "Error: Shared memory sender not enabled\n";
+    return 1;
+#endif // ECALUDP_SHM_ENABLED
+  case Implementation::RECEIVESHM:
+#if ECALUDP_SHM_ENABLED
+    receiver = std::make_shared<ReceiverShm>(receiver_parameters);
+    break;
+#else
+    std::cerr << "Error: Shared memory receiver not enabled\n";
+    return 1;
+#endif // ECALUDP_SHM_ENABLED
+  case Implementation::REPLAY:
+#if ECALUDP_TESTSUPPORT_ENABLED
+    receiver = std::make_shared<ReceiverReplay>(receiver_parameters);
+    break;
+#else
+    std::cerr << "Error: Replay requires ecaludp to be built as static library\n";
+    return 1;
+#endif // ECALUDP_TESTSUPPORT_ENABLED
+  case Implementation::PINGPONG:
+    ping_pong = std::make_shared<PingPong>(sender_parameters);
+    break;
+  case Implementation::PONG:
+    receiver = std::make_shared<ReceiverPong>(receiver_parameters);
+    break;
+  case Implementation::SWEEP:
+    return run_sweep(sender_parameters, sweep_parameters);
+  case Implementation::SIMULATE:
+#if ECALUDP_TESTSUPPORT_ENABLED
+    return run_simulation(sender_parameters, simulation_parameters);
+#else
+    std::cerr << "Error: Simulation requires ecaludp to be built as static library\n";
+    return 1;
+#endif // ECALUDP_TESTSUPPORT_ENABLED
   default:
     break;
   }
@@ -327,6 +1002,10 @@ int main(int argc, char* argv[])
   {
     receiver->start();
   }
+  else if (ping_pong)
+  {
+    ping_pong->start();
+  }
 
   while(true)
     std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -0,0 +1,221 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "ping_pong.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include <asio.hpp>
+
+#include <ecaludp/owning_buffer.h>
+
+#include "latency_histogram.h"
+#include "sender_parameters.h"
+#include "socket_builder_asio.h"
+
+namespace
+{
+  constexpr std::chrono::seconds reply_timeout(1);
+  constexpr int                  total_statistics_interval = 10;
+}
+
+PingPong::PingPong(const SenderParameters& parameters)
+  : parameters_    (parameters)
+  , reply_timer_   (io_context_)
+  , message_       (std::max(parameters.message_size, sizeof(uint64_t)), 'a')
+{
+  std::cout << parameters_.to_string();
+  std::cout << "Implementation: Ping-pong round trip via asio\n";
+
+  if (parameters_.message_size < sizeof(uint64_t))
+    std::cout << "Message size increased to " << message_.size() << " bytes for the sequence number\n";
+}
+
+PingPong::~PingPong()
+{
+  {
+    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+    is_stopped_ = true;
+    cv_.notify_all();
+  }
+
+  io_context_.stop();
+
+  if (io_context_thread_ && io_context_thread_->joinable())
+    io_context_thread_->join();
+
+  if (statistics_thread_ && statistics_thread_->joinable())
+    statistics_thread_->join();
+}
+
+void PingPong::start()
+{
+  try
+  {
+    socket_ = SocketBuilderAsio::CreateSendSocket(io_context_, parameters_);
+
+    // The replies are received with the same socket
+    if (parameters_.buffer_size > 0)
+      socket_->set_option(asio::socket_base::receive_buffer_size(parameters_.buffer_size));
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error creating socket: " << e.what() << '\n';
+    std::exit(1);
+  }
+
+  destination_ = asio::ip::udp::endpoint(asio::ip::make_address(parameters_.ip), parameters_.port);
+
+  // The first send implicitly binds the socket, so we can only start
+  // receiving afterwards
+  send_ping();
+  receive_pong();
+
+  statistics_thread_ = std::make_unique<std::thread>([this]() { print_statistics(); });
+  io_context_thread_ = std::make_unique<std::thread>([this]() { io_context_.run(); });
+}
+
+void PingPong::send_ping()
+{
+  ++sequence_number_;
+  std::memcpy(message_.data(), &sequence_number_, sizeof(sequence_number_));
+
+  ping_sent_time_ = std::chrono::steady_clock::now();
+
+  asio::error_code ec;
+  socket_->send_to(asio::buffer(message_), destination_, 0, ec);
+  if (ec)
+  {
+    std::cerr << "Error sending message: " << ec.message() << '\n';
+    io_context_.stop();
+    return;
+  }
+
+  // The handler may already be queued when the reply arrives, so it checks
+  // whether it still belongs to the message in flight
+  const uint64_t sequence_number = sequence_number_;
+  reply_timer_.expires_after(reply_timeout);
+  reply_timer_.async_wait([this, sequence_number](const asio::error_code& ec)
+                          {
+                            if (ec || (sequence_number != sequence_number_))
+                              return;
+
+                            {
+                              const std::lock_guard<std::mutex> lock(statistics_mutex_);
+                              messages_lost_++;
+                            }
+
+                            send_ping();
+                          });
+}
+
+void PingPong::receive_pong()
+{
+  socket_->async_receive_from(sender_endpoint_,
+                              [this](const std::shared_ptr<ecaludp::OwningBuffer>& message, const asio::error_code& ec)
+                              {
+                                if (ec)
+                                {
+                                  std::cerr << "Error receiving message: " << ec.message() << '\n';
+                                  return;
+                                }
+
+                                const auto now = std::chrono::steady_clock::now();
+
+                                uint64_t sequence_number = 0;
+                                if (message->size() >= sizeof(sequence_number))
+                                  std::memcpy(&sequence_number, message->data(), sizeof(sequence_number));
+
+                                // Replies to messages that have already been counted as lost are ignored
+                                if (sequence_number == sequence_number_)
+                                {
+                                  {
+                                    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+                                    round_trip_times_.record(now - ping_sent_time_);
+                                  }
+
+                                  reply_timer_.cancel();
+                                  send_ping();
+                                }
+
+                                receive_pong();
+                              });
+}
+
+void PingPong::print_statistics()
+{
+  LatencyHistogram round_trip_times;
+  LatencyHistogram total_round_trip_times;
+  long long        total_messages_lost {0};
+  int              interval_count      {0};
+
+  while (true)
+  {
+    long long messages_lost {0};
+
+    {
+      std::unique_lock<std::mutex> lock(statistics_mutex_);
+      cv_.wait_for(lock, std::chrono::seconds(1), [this]() -> bool { return is_stopped_; });
+
+      if (is_stopped_)
+        return;
+
+      std::swap(round_trip_times_, round_trip_times);
+      std::swap(messages_lost_, messages_lost);
+    }
+
+    print_histogram("rtt", round_trip_times, messages_lost);
+
+    total_round_trip_times.add(round_trip_times);
+    total_messages_lost += messages_lost;
+    round_trip_times.reset();
+
+    if (++interval_count % total_statistics_interval == 0)
+      print_histogram("total rtt", total_round_trip_times, total_messages_lost);
+  }
+}
+
+void PingPong::print_histogram(const char* label, const LatencyHistogram& histogram, long long lost)
+{
+  const auto to_us = [](std::chrono::nanoseconds value) { return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(value).count(); };
+
+  std::stringstream ss;
+  ss << "cnt: "  << histogram.count();
+  ss << " | ";
+  ss << "lost: " << lost;
+  ss << " | ";
+  ss << label << " us: " << std::fixed << std::setprecision(1);
+  ss << "min "     << to_us(histogram.min());
+  ss << " p50 "    << to_us(histogram.value_at_percentile(50.0));
+  ss << " p90 "    << to_us(histogram.value_at_percentile(90.0));
+  ss << " p99 "    << to_us(histogram.value_at_percentile(99.0));
+  ss << " p99.9 "  << to_us(histogram.value_at_percentile(99.9));
+  ss << " p99.99 " << to_us(histogram.value_at_percentile(99.99));
+  ss << " max "    << to_us(histogram.max());
+
+  std::cout << ss.str() << '\n';
+}
@@ -0,0 +1,93 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/socket.h>
+
+#include "latency_histogram.h"
+#include "sender_parameters.h"
+
+/**
+ * @brief Sends a message to a pong receiver, waits for it to come back and records the round trip time
+ *
+ * Only one message is in flight at a time. Each message carries a sequence
+ * number in its first 8 bytes, so late replies can be told apart. If no
+ * reply arrives within the reply timeout, the message is counted as lost and
+ * the next one is sent.
+ *
+ * Every second, the percentiles of the round trip times of that second are
+ * printed. Every 10 seconds, the percentiles of the whole run are printed, as
+ * the high percentiles need many samples to be meaningful.
+ */
+class PingPong
+{
+public:
+  PingPong(const SenderParameters& parameters);
+  ~PingPong();
+
+  // disable copy and move
+  PingPong(const PingPong&) = delete;
+  PingPong(PingPong&&) = delete;
+  PingPong& operator=(const PingPong&) = delete;
+  PingPong& operator=(PingPong&&) = delete;
+
+  void start();
+
+private:
+  void send_ping();
+  void receive_pong();
+
+  void print_statistics();
+
+  static void print_histogram(const char* label, const LatencyHistogram& histogram, long long lost);
+
+///////////////////////////////////////////////////////////
+// Member variables
+///////////////////////////////////////////////////////////
+
+private:
+  SenderParameters                          parameters_;
+
+  std::unique_ptr<std::thread>              io_context_thread_;
+  asio::io_context                          io_context_;
+  std::shared_ptr<ecaludp::Socket>          socket_;
+  asio::steady_timer                        reply_timer_;
+
+  asio::ip::udp::endpoint                   destination_;
+  asio::ip::udp::endpoint                   sender_endpoint_;
+  std::vector<char>                         message_;
+  uint64_t                                  sequence_number_ {0};
+  std::chrono::steady_clock::time_point     ping_sent_time_;
+
+  bool                                      is_stopped_         {false};
+  mutable std::mutex                        statistics_mutex_;
+  std::condition_variable                   cv_;
+
+  LatencyHistogram                          round_trip_times_;
+  long long                                 messages_lost_      {0};
+
+  std::unique_ptr<std::thread>              statistics_thread_;
+};
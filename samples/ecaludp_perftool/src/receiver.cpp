@@ -17,14 +17,20 @@
 #include "receiver.h"
 #include "receiver_parameters.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <sstream>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+#include <ecaludp/incomplete_message.h>
 
 Receiver::Receiver(const ReceiverParameters& parameters)
   : parameters_(parameters)
@@ -55,6 +61,7 @@ void Receiver::print_statistics()
   {
     long long bytes_payload     {0};
     long long messages_received {0};
+    std::string reassembly_top;
 
     {
       std::unique_lock<std::mutex> lock(statistics_mutex_);
@@ -65,6 +72,9 @@ void Receiver::print_statistics()
 
       std::swap(bytes_payload_, bytes_payload);
       std::swap(messages_received_, messages_received);
+
+      if (parameters_.reassembly_top > 0)
+        reassembly_top = reassembly_top_to_string();
     }
 
     auto now = std::chrono::steady_clock::now();
@@ -85,9 +95,52 @@ void Receiver::print_statistics()
       ss << " | ";
       ss << "freq: " << std::fixed << std::setprecision(1) << frequency;
 
-      std::cout << ss.str() << '\n';
+      std::cout << ss.str() << '\n' << reassembly_top;
     }
 
     last_statistics_run = now;
   }
 }
+
+std::string Receiver::reassembly_top_to_string() const
+{
+  std::vector<ecaludp::IncompleteMessage> incomplete_messages;
+  for (const auto& source : reassembly_snapshot_sources_)
+  {
+    auto snapshot = source.second();
+    incomplete_messages.insert(incomplete_messages.end(), snapshot.begin(), snapshot.end());
+  }
+
+  size_t buffered_bytes_total {0};
+  for (const auto& incomplete_message : incomplete_messages)
+    buffered_bytes_total += incomplete_message.buffered_bytes;
+
+  const size_t top_count = std::min(parameters_.reassembly_top, incomplete_messages.size());
+  std::partial_sort(incomplete_messages.begin()
+                  , incomplete_messages.begin() + static_cast<std::ptrdiff_t>(top_count)
+                  , incomplete_messages.end()
+                  , [](const ecaludp::IncompleteMessage& lhs, const ecaludp::IncompleteMessage& rhs)
+                    {
+                      return lhs.buffered_bytes > rhs.buffered_bytes;
+                    });
+
+  std::stringstream ss;
+  ss << "reassembly: " << incomplete_messages.size() << " incomplete | " << buffered_bytes_total << " bytes buffered\n";
+  for (size_t i = 0; i < top_count; ++i)
+  {
+    const auto& incomplete_message = incomplete_messages[i];
+    const auto age_ms = std::chrono::duration_cast<std::chrono::milliseconds>(incomplete_message.age).count();
+
+    ss << "  " << incomplete_message.sender_endpoint
+       << " | id: "    << incomplete_message.message_id
+       << " | frag: "  << incomplete_message.received_fragments << "/";
+    if (incomplete_message.total_fragments > 0)
+      ss << incomplete_message.total_fragments;
+    else
+      ss << "?";
+    ss << " | bytes: " << incomplete_message.buffered_bytes
+       << " | age: "   << age_ms << " ms\n";
+  }
+
+  return ss.str();
+}
@@ -17,9 +17,16 @@
 #pragma once
 
 #include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
+
+#include <ecaludp/incomplete_message.h>
 
 #include "receiver_parameters.h"
 
@@ -39,6 +46,7 @@ public:
 
 private:
   void print_statistics();
+  std::string reassembly_top_to_string() const;
 
 ///////////////////////////////////////////////////////////
 // Member variables
@@ -54,6 +62,11 @@ protected:
   long long bytes_payload_    {0};
   long long messages_received_{0};
 
+  // Reassembly snapshot of each socket, by port index (for --reassembly-top).
+  // Only called with the statistics_mutex_ locked, so a receiver can safely
+  // remove the entry before its socket is destroyed.
+  std::map<size_t, std::function<std::vector<ecaludp::IncompleteMessage>()>> reassembly_snapshot_sources_;
+
 private:
   std::unique_ptr<std::thread>  statistics_thread_;
 };
@@ -16,12 +16,15 @@
 
 #include "receiver_async.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <asio.hpp>
 
@@ -38,10 +41,16 @@ ReceiverAsync::ReceiverAsync(const ReceiverParameters& parameters)
 
 ReceiverAsync::~ReceiverAsync()
 {
-  if (socket_)
+  {
+    // The statistics thread outlives the sockets
+    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+    reassembly_snapshot_sources_.clear();
+  }
+
+  for (const auto& socket : sockets_)
   {
     asio::error_code ec;
-    socket_->cancel(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    socket->cancel(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
 
     if (ec)
       std::cerr << "Error cancelling socket: " << ec.message() << '\n';
@@ -50,15 +59,26 @@ ReceiverAsync::~ReceiverAsync()
   if(work_)
     work_.reset();
 
-  if (io_context_thread_->joinable())
-    io_context_thread_->join();
+  for (auto& io_context_thread : io_context_threads_)
+  {
+    if (io_context_thread->joinable())
+      io_context_thread->join();
+  }
 }
 
 void ReceiverAsync::start()
 {
+  // One socket per port. Each socket has one receive operation in flight,
+  // all threads share them.
   try
   {
-     socket_ = SocketBuilderAsio::CreateReceiveSocket(io_context_, parameters_);
+    for (size_t i = 0; i < parameters_.ports; ++i)
+    {
+      ReceiverParameters socket_parameters = parameters_;
+      socket_parameters.port = static_cast<uint16_t>(parameters_.port + i);
+
+      sockets_.push_back(SocketBuilderAsio::CreateReceiveSocket(io_context_, socket_parameters));
+    }
   }
   catch (const std::exception& e)
   {
@@ -66,36 +86,49 @@ void ReceiverAsync::start()
     std::exit(1);
   }
 
-  auto endpoint = asio::ip::udp::endpoint(asio::ip::make_address(parameters_.ip), parameters_.port);
+  {
+    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+    for (size_t i = 0; i < sockets_.size(); ++i)
+    {
+      ecaludp::Socket* socket = sockets_[i].get();
+      reassembly_snapshot_sources_[i] = [socket]() { return socket->get_reassembly_snapshot(); };
+    }
+  }
 
-  receive_message();
+  for (const auto& socket : sockets_)
+  {
+    receive_message(socket);
+  }
 
   work_ = std::make_unique<work_guard_t>(io_context_.get_executor());
 
-  io_context_thread_ = std::make_unique<std::thread>([this](){ io_context_.run(); });
+  for (size_t i = 0; i < parameters_.threads; ++i)
+  {
+    io_context_threads_.push_back(std::make_unique<std::thread>([this](){ io_context_.run(); }));
+  }
 }
 
-void ReceiverAsync::receive_message()
+void ReceiverAsync::receive_message(const std::shared_ptr<ecaludp::Socket>& socket)
 {
   auto endpoint = std::make_shared<asio::ip::udp::endpoint>();
 
-  socket_->async_receive_from(*endpoint,
-                              [this, endpoint](const std::shared_ptr<ecaludp::OwningBuffer>& message, const asio::error_code& ec)
-                              {
-                                if (ec)
-                                {
-                                  std::cerr << "Error sending: " << ec.message() << '\n';
-                                  socket_->close();
-                                  return;
-                                }
-
-                                {
-                                  const std::lock_guard<std::mutex> lock(statistics_mutex_);
-
-                                  bytes_payload_     += message->size();
-                                  messages_received_ ++;
-                                }
-
-                                receive_message();
-                              });
+  socket->async_receive_from(*endpoint,
+                             [this, socket, endpoint](const std::shared_ptr<ecaludp::OwningBuffer>& message, const asio::error_code& ec)
+                             {
+                               if (ec)
+                               {
+                                 std::cerr << "Error sending: " << ec.message() << '\n';
+                                 socket->close();
+                                 return;
+                               }
+
+                               {
+                                 const std::lock_guard<std::mutex> lock(statistics_mutex_);
+
+                                 bytes_payload_     += message->size();
+                                 messages_received_ ++;
+                               }
+
+                               receive_message(socket);
+                             });
 }
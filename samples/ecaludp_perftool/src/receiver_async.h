@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <asio.hpp>
 
@@ -41,12 +42,12 @@ class ReceiverAsync : public Receiver
     void start() override;
 
   private:
-    void receive_message();
+    void receive_message(const std::shared_ptr<ecaludp::Socket>& socket);
 
   private:
-    std::unique_ptr<std::thread>            io_context_thread_;
-    asio::io_context                        io_context_;
-    std::shared_ptr<ecaludp::Socket>        socket_;
+    std::vector<std::unique_ptr<std::thread>>     io_context_threads_;
+    asio::io_context                              io_context_;
+    std::vector<std::shared_ptr<ecaludp::Socket>> sockets_;
     using work_guard_t = asio::executor_work_guard<asio::io_context::executor_type>;
     std::unique_ptr<work_guard_t> work_;
 };
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <sstream>
 #include <string>
@@ -25,6 +26,16 @@ struct ReceiverParameters
   std::string ip          {"127.0.0.1"};
   uint16_t    port        {14000};
   int         buffer_size {-1};
+  bool        udp_gro     {false};
+  size_t      threads     {1};        ///< Number of threads running the io_context (async receivers only)
+  size_t      ports       {1};        ///< Number of ports to receive on, starting at port. One socket per port.
+
+  std::string record_file            {};
+  size_t      reassembly_top         {0};  ///< Print the N incomplete messages buffering the most bytes. 0 = off
+
+
+  std::string replay_file            {};
+  bool        replay_recorded_timing {false};
 
   std::string to_string() const
   {
@@ -34,6 +45,22 @@ struct ReceiverParameters
     ss << "  IP:          " << ip << '\n';
     ss << "  Port:        " << port << '\n';
     ss << "  Buffer Size: " << (buffer_size > 0 ? std::to_string(buffer_size) : "default") << '\n';
+    ss << "  UDP GRO:     " << (udp_gro ? "on" : "off") << '\n';
+    ss << "  Threads:     " << threads << '\n';
+    ss << "  Ports:       " << ports << '\n';
+    if (!record_file.empty())
+    {
+      ss << "  Record file: " << record_file << '\n';
+    }
+    if (reassembly_top > 0)
+    {
+      ss << "  Reassembly top: " << reassembly_top << '\n';
+    }
+    if (!replay_file.empty())
+    {
+      ss << "  Replay file: " << replay_file << '\n';
+      ss << "  Timing:      " << (replay_recorded_timing ? "recorded" : "as fast as possible") << '\n';
+    }
 
     return ss.str();
   }
@@ -0,0 +1,119 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#include "receiver_pong.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <asio.hpp>
+
+#include "ecaludp/socket.h"
+#include "receiver.h"
+#include "receiver_parameters.h"
+#include "socket_builder_asio.h"
+
+ReceiverPong::ReceiverPong(const ReceiverParameters& parameters)
+  : Receiver(parameters)
+{
+  std::cout << "Receiver implementation: Pong, sending every message back via asio\n";
+}
+
+ReceiverPong::~ReceiverPong()
+{
+  if (receive_thread_ && receive_thread_->joinable())
+  {
+    receive_thread_->join();
+  }
+}
+
+void ReceiverPong::start()
+{
+  receive_thread_ = std::make_unique<std::thread>(&ReceiverPong::receive_loop, this);
+}
+
+void ReceiverPong::receive_loop()
+{
+  asio::io_context io_context;
+
+  std::shared_ptr<ecaludp::Socket> receive_socket;
+  try
+  {
+     receive_socket = SocketBuilderAsio::CreateReceiveSocket(io_context, parameters_);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error creating socket: " << e.what() << '\n';
+    std::exit(1);
+  }
+
+  asio::ip::udp::endpoint sender_endpoint;
+
+  while (true)
+  {
+    {
+      asio::error_code ec;
+      auto payload_buffer = receive_socket->receive_from(sender_endpoint, 0, ec);
+
+      if (ec)
+      {
+        std::cerr << "Error receiving message: " << ec.message() << '\n';
+        break;
+      }
+
+      // Send the message back to where it came from
+      receive_socket->send_to(asio::buffer(payload_buffer->data(), payload_buffer->size()), sender_endpoint, 0, ec);
+
+      if (ec)
+      {
+        std::cerr << "Error sending message: " << ec.message() << '\n';
+        break;
+      }
+
+      {
+        const std::lock_guard<std::mutex> lock(statistics_mutex_);
+      
+        if (is_stopped_)
+          break;
+
+        bytes_payload_ += payload_buffer->size();
+        messages_received_ ++;
+      }
+    }
+  }
+
+  {
+    asio::error_code ec;
+    receive_socket->shutdown(asio::socket_base::shutdown_both, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    if (ec)
+    {
+      std::cerr << "Error shutting down socket: " << ec.message() << '\n';
+    }
+  }
+
+  {
+    asio::error_code ec;
+    receive_socket->close(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    if (ec)
+    {
+      std::cerr << "Error closing socket: " << ec.message() << '\n';
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "receiver_replay.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <asio.hpp>
+
+#include "ecaludp/error.h"
+#include "ecaludp_testsupport/pcap_replay.h"
+#include "receiver.h"
+#include "receiver_parameters.h"
+
+ReceiverReplay::ReceiverReplay(const ReceiverParameters& parameters)
+  : Receiver(parameters)
+{
+  std::cout << "Receiver implementation: pcap replay\n";
+}
+
+ReceiverReplay::~ReceiverReplay()
+{
+  if (receive_thread_ && receive_thread_->joinable())
+  {
+    receive_thread_->join();
+  }
+}
+
+void ReceiverReplay::start()
+{
+  receive_thread_ = std::make_unique<std::thread>(&ReceiverReplay::receive_loop, this);
+}
+
+void ReceiverReplay::receive_loop()
+{
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+  replay.set_timing(parameters_.replay_recorded_timing ? ecaludp::PcapReplay::Timing::RECORDED : ecaludp::PcapReplay::Timing::AS_FAST_AS_POSSIBLE);
+
+  asio::ip::udp::endpoint sender_endpoint;
+
+  // Replay the file over and over again, so the statistics keep running
+  while (true)
+  {
+    ecaludp::Error error = ecaludp::Error::OK;
+    if (!replay.open(parameters_.replay_file, error))
+    {
+      std::cerr << "Error opening capture file: " << error.ToString() << '\n';
+      std::exit(1);
+    }
+
+    long long messages_in_file {0};
+
+    while (true)
+    {
+      auto payload_buffer = replay.receive_from(sender_endpoint, error);
+
+      if (!payload_buffer)
+      {
+        if (error != ecaludp::Error::END_OF_FILE)
+        {
+          std::cerr << "Error reading capture file: " << error.ToString() << '\n';
+          std::exit(1);
+        }
+        break;
+      }
+
+      ++messages_in_file;
+
+      {
+        const std::lock_guard<std::mutex> lock(statistics_mutex_);
+
+        if (is_stopped_)
+          return;
+
+        bytes_payload_ += payload_buffer->size();
+        messages_received_ ++;
+      }
+    }
+
+    if (messages_in_file == 0)
+    {
+      std::cerr << "Error: The capture file does not contain any ecaludp messages\n";
+      std::exit(1);
+    }
+  }
+}
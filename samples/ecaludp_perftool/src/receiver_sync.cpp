@@ -16,12 +16,15 @@
 
 #include "receiver_sync.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <asio.hpp>
 
@@ -38,25 +41,35 @@ ReceiverSync::ReceiverSync(const ReceiverParameters& parameters)
 
 ReceiverSync::~ReceiverSync()
 {
-  if (receive_thread_ && receive_thread_->joinable())
+  for (auto& receive_thread : receive_threads_)
   {
-    receive_thread_->join();
+    if (receive_thread->joinable())
+    {
+      receive_thread->join();
+    }
   }
 }
 
 void ReceiverSync::start()
 {
-  receive_thread_ = std::make_unique<std::thread>(&ReceiverSync::receive_loop, this);
+  // One socket and thread per port
+  for (size_t i = 0; i < parameters_.ports; ++i)
+  {
+    receive_threads_.push_back(std::make_unique<std::thread>(&ReceiverSync::receive_loop, this, i));
+  }
 }
 
-void ReceiverSync::receive_loop()
+void ReceiverSync::receive_loop(size_t port_index)
 {
   asio::io_context io_context;
 
   std::shared_ptr<ecaludp::Socket> receive_socket;
   try
   {
-     receive_socket = SocketBuilderAsio::CreateReceiveSocket(io_context, parameters_);
+    ReceiverParameters socket_parameters = parameters_;
+    socket_parameters.port = static_cast<uint16_t>(parameters_.port + port_index);
+
+    receive_socket = SocketBuilderAsio::CreateReceiveSocket(io_context, socket_parameters);
   }
   catch (const std::exception& e)
   {
@@ -64,6 +77,12 @@ void ReceiverSync::receive_loop()
     std::exit(1);
   }
 
+  {
+    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+    ecaludp::Socket* socket = receive_socket.get();
+    reassembly_snapshot_sources_[port_index] = [socket]() { return socket->get_reassembly_snapshot(); };
+  }
+
   asio::ip::udp::endpoint destination;
 
   while (true)
@@ -90,6 +109,12 @@ void ReceiverSync::receive_loop()
     }
   }
 
+  {
+    // The socket dies with this thread
+    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+    reassembly_snapshot_sources_.erase(port_index);
+  }
+
   {
     asio::error_code ec;
     receive_socket->shutdown(asio::socket_base::shutdown_both, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
@@ -19,8 +19,10 @@
 #include "receiver.h"
 #include "receiver_parameters.h"
 
+#include <cstddef>
 #include <memory>
 #include <thread>
+#include <vector>
 
 class ReceiverSync : public Receiver
 {
@@ -37,8 +39,8 @@ class ReceiverSync : public Receiver
     void start() override;
 
   private:
-    void receive_loop();
+    void receive_loop(size_t port_index);
 
   private:
-    std::unique_ptr<std::thread> receive_thread_;
+    std::vector<std::unique_ptr<std::thread>> receive_threads_;
 };
@@ -16,6 +16,7 @@
 
 #include "sender.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <iostream>
@@ -54,9 +55,10 @@ void Sender::print_statistics()
 
   while(true)
   {
-    long long bytes_raw    {0};
-    long long bytes_payload{0};
-    long long messages_sent{0};
+    long long bytes_raw     {0};
+    long long bytes_payload {0};
+    long long messages_sent {0};
+    long long datagrams_sent{0};
 
 
     {
@@ -69,6 +71,7 @@ void Sender::print_statistics()
       std::swap(bytes_raw_, bytes_raw);
       std::swap(bytes_payload_, bytes_payload);
       std::swap(messages_sent_, messages_sent);
+      std::swap(datagrams_sent_, datagrams_sent);
     }
 
     auto now = std::chrono::steady_clock::now();
@@ -85,9 +88,22 @@ void Sender::print_statistics()
       std::stringstream ss;
       ss << "cnt: "   << messages_sent;
       ss << " | ";
-      //ss << "snt raw: " << bytes_raw << " pyld: " << bytes_payload; // TODO: The async send doesn't return the raw number of bytes sent
-      ss << "snt pyld: " << bytes_payload;
+      ss << "snt raw: " << bytes_raw << " pyld: " << bytes_payload;
       ss << " | ";
+
+      // Share of the bytes on the wire that is spent on ecaludp headers.
+      // Messages sent via shared memory have no headers at all.
+      if (bytes_raw > 0)
+      {
+        const double overhead = static_cast<double>(bytes_raw - bytes_payload) / static_cast<double>(bytes_raw);
+        ss << "ovh: " << std::fixed << std::setprecision(2) << (std::max(overhead, 0.0) * 100.0) << "%";
+        ss << " | ";
+      }
+      if (datagrams_sent > 0)
+      {
+        ss << "dgrm: " << datagrams_sent;
+        ss << " | ";
+      }
       ss << "freq: " << std::fixed << std::setprecision(1) << frequency;
 
       std::cout << ss.str() << '\n';
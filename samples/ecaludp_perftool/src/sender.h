@@ -51,9 +51,10 @@ protected:
   mutable std::mutex            statistics_mutex_;
   std::condition_variable       cv_;
 
-  long long bytes_raw_     {0};
-  long long bytes_payload_ {0};
-  long long messages_sent_ {0};
+  long long bytes_raw_      {0};   ///< Bytes on the wire including the ecaludp headers
+  long long bytes_payload_  {0};
+  long long messages_sent_  {0};
+  long long datagrams_sent_ {0};   ///< Only known for async senders, 0 otherwise
 
 private:
   std::unique_ptr<std::thread>  statistics_thread_;
@@ -16,6 +16,8 @@
 
 #include "sender_async.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
@@ -23,6 +25,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <asio.hpp>
 
@@ -38,24 +41,34 @@ SenderAsync::SenderAsync(const SenderParameters& parameters)
 
 SenderAsync::~SenderAsync()
 {
-  if (socket_)
+  for (const auto& socket : sockets_)
   {
     asio::error_code ec;
-    socket_->cancel(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+    socket->cancel(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
 
     if (ec)
       std::cerr << "Error cancelling socket: " << ec.message() << '\n';
   }
 
-  if(io_context_thread_->joinable())
-    io_context_thread_->join();
+  for (auto& io_context_thread : io_context_threads_)
+  {
+    if(io_context_thread->joinable())
+      io_context_thread->join();
+  }
 }
 
 void SenderAsync::start() 
 {
+  // All threads share the sockets, so there are threads * sockets sockets
+  // in total. Each socket sends to one port, spread evenly across the ports.
+  const size_t socket_count = parameters_.threads * parameters_.sockets;
+
   try
   {
-     socket_ = SocketBuilderAsio::CreateSendSocket(io_context_, parameters_);
+    for (size_t i = 0; i < socket_count; ++i)
+    {
+      sockets_.push_back(SocketBuilderAsio::CreateSendSocket(io_context_, parameters_));
+    }
   }
   catch (const std::exception& e)
   {
@@ -64,36 +77,49 @@ void SenderAsync::start()
   }
 
   auto message = std::make_shared<std::string>(parameters_.message_size, 'a');
-  auto endpoint = asio::ip::udp::endpoint(asio::ip::make_address(parameters_.ip), parameters_.port);
 
-  send_message(message, endpoint);
+  for (size_t i = 0; i < socket_count; ++i)
+  {
+    auto endpoint = asio::ip::udp::endpoint(asio::ip::make_address(parameters_.ip), static_cast<uint16_t>(parameters_.port + i % parameters_.ports));
+
+    // Keep multiple messages in the send queue, so the socket never runs idle
+    // while we are waiting for a completion handler
+    for (int j = 0; j < messages_in_queue; ++j)
+    {
+      send_message(sockets_[i], message, endpoint);
+    }
+  }
 
-  io_context_thread_ = std::make_unique<std::thread>([this](){ io_context_.run(); });
+  for (size_t i = 0; i < parameters_.threads; ++i)
+  {
+    io_context_threads_.push_back(std::make_unique<std::thread>([this](){ io_context_.run(); }));
+  }
 }
 
-void SenderAsync::send_message(const std::shared_ptr<const std::string>& message, const asio::ip::udp::endpoint& endpoint)
+void SenderAsync::send_message(const std::shared_ptr<ecaludp::Socket>& socket, const std::shared_ptr<const std::string>& message, const asio::ip::udp::endpoint& endpoint)
 {
 
-  socket_->async_send_to( asio::buffer(*message)
-                        , endpoint
-                        , [this, message, endpoint](asio::error_code ec)
-                          {
-                            if (ec)
-                            {
-                              std::cerr << "Error sending: " << ec.message() << '\n';
-                              socket_->close();
-                              return;
-                            }
-
-                            {
-                              const std::lock_guard<std::mutex> lock(statistics_mutex_);
-
-                              //bytes_raw_     += bytes_sent; // TODO: the current implementation doesn't return the raw number of bytes sent
-                              bytes_payload_ += message->size();
-                              messages_sent_ ++;
-                            }
-
-                            this->send_message(message, endpoint);
-                          });
+  socket->async_send_to( asio::buffer(*message)
+                       , endpoint
+                       , [this, socket, message, endpoint](asio::error_code ec, std::size_t bytes_sent, std::size_t datagrams_sent)
+                         {
+                           if (ec)
+                           {
+                             std::cerr << "Error sending: " << ec.message() << '\n';
+                             socket->close();
+                             return;
+                           }
+
+                           {
+                             const std::lock_guard<std::mutex> lock(statistics_mutex_);
+
+                             bytes_raw_      += bytes_sent;
+                             datagrams_sent_ += datagrams_sent;
+                             bytes_payload_ += message->size();
+                             messages_sent_ ++;
+                           }
+
+                           this->send_message(socket, message, endpoint);
+                         });
 
 }
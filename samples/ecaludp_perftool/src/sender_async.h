@@ -22,6 +22,7 @@
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <ecaludp/socket.h>
 
@@ -42,10 +43,12 @@ class SenderAsync : public Sender
     void start() override;
 
   private:
-    void send_message(const std::shared_ptr<const std::string>& message, const asio::ip::udp::endpoint& endpoint);
+    void send_message(const std::shared_ptr<ecaludp::Socket>& socket, const std::shared_ptr<const std::string>& message, const asio::ip::udp::endpoint& endpoint);
 
   private:
-    std::unique_ptr<std::thread>     io_context_thread_;
-    asio::io_context                 io_context_;
-    std::shared_ptr<ecaludp::Socket> socket_;
+    static constexpr int messages_in_queue = 8;
+
+    std::vector<std::unique_ptr<std::thread>>     io_context_threads_;
+    asio::io_context                              io_context_;
+    std::vector<std::shared_ptr<ecaludp::Socket>> sockets_;
 };
@@ -0,0 +1,114 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#include "sender_packet_mmap.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <asio.hpp>
+
+#include <ecaludp/sender_packet_mmap.h>
+
+#include "sender.h"
+#include "sender_parameters.h"
+#include "socket_builder_packet_mmap.h"
+
+SenderPacketMmap::SenderPacketMmap(const SenderParameters& parameters)
+  : Sender(parameters)
+{
+  std::cout << "Sender implementation: AF_PACKET (PACKET_TX_RING)\n";
+}
+
+SenderPacketMmap::~SenderPacketMmap()
+{
+  if (send_thread_ && send_thread_->joinable())
+  {
+    send_thread_->join();
+  }
+}
+
+void SenderPacketMmap::start()
+{
+  send_thread_ = std::make_unique<std::thread>(&SenderPacketMmap::send_loop, this);
+}
+
+void SenderPacketMmap::send_loop()
+{
+  std::shared_ptr<ecaludp::SenderPacketMmap> sender;
+  try
+  {
+     sender = SocketBuilderPacketMmap::CreateSender(parameters_);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error creating sender: " << e.what() << '\n';
+    std::exit(1);
+  }
+
+  const std::string message = std::string(parameters_.message_size, 'a');
+  const asio::ip::udp::endpoint destination(asio::ip::make_address(parameters_.ip), parameters_.port);
+
+  bool error = false;
+  while (!error)
+  {
+    // Write multiple messages to the ring, before handing them to the kernel
+    // with a single syscall
+    long long bytes_sent = 0;
+    for (int i = 0; i < messages_per_flush; ++i)
+    {
+      asio::error_code ec;
+      bytes_sent += static_cast<long long>(sender->enqueue_to(asio::buffer(message), destination, ec));
+
+      if (ec)
+      {
+        std::cerr << "Error sending message: " << ec.message() << '\n';
+        error = true;
+        break;
+      }
+    }
+
+    if (!error)
+    {
+      asio::error_code ec;
+      sender->flush(ec);
+
+      if (ec)
+      {
+        std::cerr << "Error sending message: " << ec.message() << '\n';
+        error = true;
+      }
+    }
+
+    {
+      const std::lock_guard<std::mutex> lock(statistics_mutex_);
+
+      if (is_stopped_)
+        break;
+
+      bytes_raw_     += bytes_sent;
+      bytes_payload_ += static_cast<long long>(message.size()) * messages_per_flush;
+      messages_sent_ += messages_per_flush;
+    }
+  }
+
+  sender->close();
+}
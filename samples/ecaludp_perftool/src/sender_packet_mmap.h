@@ -0,0 +1,46 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#pragma once
+
+#include "sender.h"
+#include "sender_parameters.h"
+
+#include <memory>
+#include <thread>
+
+class SenderPacketMmap : public Sender
+{
+  public:
+    SenderPacketMmap(const SenderParameters& parameters);
+    ~SenderPacketMmap() override;
+
+    // disable copy and move
+    SenderPacketMmap(const SenderPacketMmap&) = delete;
+    SenderPacketMmap(SenderPacketMmap&&) = delete;
+    SenderPacketMmap& operator=(const SenderPacketMmap&) = delete;
+    SenderPacketMmap& operator=(SenderPacketMmap&&) = delete;
+
+    void start() override;
+
+  private:
+    void send_loop();
+
+  private:
+    static constexpr int messages_per_flush = 64;
+
+    std::unique_ptr<std::thread> send_thread_;
+};
@@ -28,6 +28,13 @@ struct SenderParameters
   size_t      message_size          {0};
   int         max_udp_datagram_size {-1};
   int         buffer_size           {-1};
+  size_t      rate                  {0};    ///< Send rate limit in bytes/s. 0 means unlimited.
+  size_t      burst                 {0};    ///< Burst size for the rate limit in bytes. 0 means default.
+  bool        udp_gso               {false};
+  size_t      zerocopy_threshold    {0};    ///< Minimum message size for zerocopy sending with async_send_to. 0 means disabled.
+  size_t      threads               {1};    ///< Number of sender threads
+  size_t      sockets               {1};    ///< Number of sockets per thread
+  size_t      ports                 {1};    ///< Number of destination ports, starting at port
 
   std::string to_string() const
   {
@@ -39,6 +46,13 @@ struct SenderParameters
     ss << "  message_size:          " << message_size << '\n';
     ss << "  max_udp_datagram_size: " << (max_udp_datagram_size > 0 ? std::to_string(max_udp_datagram_size) : "default") << '\n';
     ss << "  buffer_size:           " << (buffer_size > 0 ? std::to_string(buffer_size) : "default") << '\n';
+    ss << "  rate:                  " << (rate > 0 ? std::to_string(rate) + " bytes/s" : "unlimited") << '\n';
+    ss << "  burst:                 " << (burst > 0 ? std::to_string(burst) + " bytes" : "default") << '\n';
+    ss << "  udp_gso:               " << (udp_gso ? "on" : "off") << '\n';
+    ss << "  zerocopy_threshold:    " << (zerocopy_threshold > 0 ? std::to_string(zerocopy_threshold) + " bytes" : "off") << '\n';
+    ss << "  threads:               " << threads << '\n';
+    ss << "  sockets per thread:    " << sockets << '\n';
+    ss << "  ports:                 " << ports << '\n';
 
     return ss.str();
   }
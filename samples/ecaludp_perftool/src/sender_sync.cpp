@@ -16,6 +16,8 @@
 
 #include "sender_sync.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
@@ -23,6 +25,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <asio.hpp>
 
@@ -39,25 +42,40 @@ SenderSync::SenderSync(const SenderParameters& parameters)
 
 SenderSync::~SenderSync()
 {
-  if (send_thread_ && send_thread_->joinable())
+  for (auto& send_thread : send_threads_)
   {
-    send_thread_->join();
+    if (send_thread->joinable())
+    {
+      send_thread->join();
+    }
   }
 }
 
 void SenderSync::start()
 {
-  send_thread_ = std::make_unique<std::thread>(&SenderSync::send_loop, this);
+  for (size_t i = 0; i < parameters_.threads; ++i)
+  {
+    send_threads_.push_back(std::make_unique<std::thread>(&SenderSync::send_loop, this, i));
+  }
 }
 
-void SenderSync::send_loop()
+void SenderSync::send_loop(size_t thread_index)
 {
   asio::io_context io_context;
 
-  std::shared_ptr<ecaludp::Socket> send_socket;
+  std::vector<std::shared_ptr<ecaludp::Socket>> send_sockets;
+  std::vector<asio::ip::udp::endpoint>          destinations;
   try
   {
-     send_socket = SocketBuilderAsio::CreateSendSocket(io_context, parameters_);
+    for (size_t i = 0; i < parameters_.sockets; ++i)
+    {
+      send_sockets.push_back(SocketBuilderAsio::CreateSendSocket(io_context, parameters_));
+
+      // Each socket sends to one port. The sockets of all threads are
+      // spread evenly across the ports.
+      const size_t socket_index = thread_index * parameters_.sockets + i;
+      destinations.emplace_back(asio::ip::make_address(parameters_.ip), static_cast<uint16_t>(parameters_.port + socket_index % parameters_.ports));
+    }
   }
   catch (const std::exception& e)
   {
@@ -66,17 +84,20 @@ void SenderSync::send_loop()
   }
 
   const std::string message = std::string(parameters_.message_size, 'a');
-  const asio::ip::udp::endpoint destination(asio::ip::make_address(parameters_.ip), parameters_.port);
 
-  while (true)
+  bool keep_sending = true;
+  while (keep_sending)
   {
+    // Send one message with each socket in turn
+    for (size_t i = 0; i < send_sockets.size(); ++i)
     {
       asio::error_code ec;
-      auto bytes_sent = send_socket->send_to(asio::buffer(message), destination, 0, ec);
+      auto bytes_sent = send_sockets[i]->send_to(asio::buffer(message), destinations[i], 0, ec);
 
       if (ec)
       {
         std::cerr << "Error sending message: " << ec.message() << '\n';
+        keep_sending = false;
         break;
       }
 
@@ -84,7 +105,10 @@ void SenderSync::send_loop()
         const std::lock_guard<std::mutex> lock(statistics_mutex_);
       
         if (is_stopped_)
+        {
+          keep_sending = false;
           break;
+        }
 
         bytes_raw_     += bytes_sent;
         bytes_payload_ += message.size();
@@ -93,21 +117,24 @@ void SenderSync::send_loop()
     }
   }
 
+  for (const auto& send_socket : send_sockets)
   {
-    asio::error_code ec;
-    send_socket->shutdown(asio::socket_base::shutdown_both, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
-    if (ec)
     {
-      std::cerr << "Error shutting down socket: " << ec.message() << '\n';
+      asio::error_code ec;
+      send_socket->shutdown(asio::socket_base::shutdown_both, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (ec)
+      {
+        std::cerr << "Error shutting down socket: " << ec.message() << '\n';
+      }
     }
-  }
 
-  {
-    asio::error_code ec;
-    send_socket->close(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
-    if (ec)
     {
-      std::cerr << "Error closing socket: " << ec.message() << '\n';
+      asio::error_code ec;
+      send_socket->close(ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (ec)
+      {
+        std::cerr << "Error closing socket: " << ec.message() << '\n';
+      }
     }
   }
 }
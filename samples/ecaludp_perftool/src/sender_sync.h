@@ -19,8 +19,10 @@
 #include "sender.h"
 #include "sender_parameters.h"
 
+#include <cstddef>
 #include <memory>
 #include <thread>
+#include <vector>
 
 class SenderSync : public Sender
 {
@@ -37,8 +39,8 @@ class SenderSync : public Sender
     void start() override;
 
   private:
-    void send_loop();
+    void send_loop(size_t thread_index);
 
   private:
-    std::unique_ptr<std::thread> send_thread_;
+    std::vector<std::unique_ptr<std::thread>> send_threads_;
 };
@@ -0,0 +1,53 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#pragma once
+
+#include "sender.h"
+#include "sender_parameters.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <ecaludp/socket_uring.h>
+
+#include <asio.hpp>
+
+class SenderUring : public Sender
+{
+  public:
+    SenderUring(const SenderParameters& parameters);
+    ~SenderUring() override;
+
+    // disable copy and move
+    SenderUring(const SenderUring&) = delete;
+    SenderUring(SenderUring&&) = delete;
+    SenderUring& operator=(const SenderUring&) = delete;
+    SenderUring& operator=(SenderUring&&) = delete;
+
+    void start() override;
+
+  private:
+    void send_message(const std::shared_ptr<const std::string>& message, const asio::ip::udp::endpoint& endpoint);
+
+  private:
+    static constexpr int messages_in_queue = 8;
+
+    std::unique_ptr<std::thread>     io_context_thread_;
+    asio::io_context                 io_context_;
+    std::shared_ptr<ecaludp::SocketUring> socket_;
+};
@@ -0,0 +1,232 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "simulation.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp>
+
+#include "ecaludp/error.h"
+#include "ecaludp_testsupport/simulated_network.h"
+#include "sender_parameters.h"
+#include "simulation_parameters.h"
+
+namespace
+{
+  using Impairment = ecaludp::SimulatedNetwork::Impairment;
+
+  std::vector<std::pair<std::string, Impairment>> builtin_profiles()
+  {
+    std::vector<std::pair<std::string, Impairment>> profiles;
+
+    profiles.emplace_back("none", Impairment());
+
+    Impairment loss;
+    loss.loss_probability = 0.01;
+    profiles.emplace_back("loss", loss);
+
+    Impairment burst;
+    burst.burst_loss_probability = 0.001;
+    burst.burst_loss_length      = 50;
+    profiles.emplace_back("burst", burst);
+
+    Impairment reorder;
+    reorder.reorder_window = 32;
+    profiles.emplace_back("reorder", reorder);
+
+    Impairment duplicate;
+    duplicate.duplication_probability = 0.05;
+    profiles.emplace_back("duplicate", duplicate);
+
+    Impairment jitter;
+    jitter.delay  = std::chrono::milliseconds(1);
+    jitter.jitter = std::chrono::milliseconds(2);
+    profiles.emplace_back("jitter", jitter);
+
+    Impairment mixed;
+    mixed.loss_probability        = 0.005;
+    mixed.burst_loss_probability  = 0.0005;
+    mixed.burst_loss_length       = 20;
+    mixed.reorder_window          = 8;
+    mixed.duplication_probability = 0.01;
+    mixed.delay                   = std::chrono::milliseconds(1);
+    mixed.jitter                  = std::chrono::milliseconds(1);
+    profiles.emplace_back("mixed", mixed);
+
+    return profiles;
+  }
+
+  // Parses "loss=0.01,burst=0.001/20,reorder=16,duplicate=0.01,delay=1000,jitter=500" (delay and jitter in us)
+  bool parse_impairment(const std::string& spec, Impairment& impairment)
+  {
+    std::stringstream spec_stream(spec);
+    std::string       item;
+    while (std::getline(spec_stream, item, ','))
+    {
+      const auto separator = item.find('=');
+      if (separator == std::string::npos)
+      {
+        std::cerr << "Error: Invalid impairment \"" << item << "\"\n";
+        return false;
+      }
+
+      const std::string key   = item.substr(0, separator);
+      const std::string value = item.substr(separator + 1);
+
+      try
+      {
+        if (key == "loss")
+        {
+          impairment.loss_probability = std::stod(value);
+        }
+        else if (key == "burst")
+        {
+          const auto length_separator = value.find('/');
+          impairment.burst_loss_probability = std::stod(value.substr(0, length_separator));
+          if (length_separator != std::string::npos)
+            impairment.burst_loss_length = std::stod(value.substr(length_separator + 1));
+        }
+        else if (key == "reorder")
+        {
+          impairment.reorder_window = std::stoul(value);
+        }
+        else if (key == "duplicate")
+        {
+          impairment.duplication_probability = std::stod(value);
+        }
+        else if (key == "delay")
+        {
+          impairment.delay = std::chrono::microseconds(std::stoull(value));
+        }
+        else if (key == "jitter")
+        {
+          impairment.jitter = std::chrono::microseconds(std::stoull(value));
+        }
+        else
+        {
+          std::cerr << "Error: Unknown impairment \"" << key << "\"\n";
+          return false;
+        }
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "Error: Invalid value for impairment \"" << key << "\": " << e.what() << '\n';
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void print_header()
+  {
+    std::cout << std::left  << std::setw(10) << "profile"
+              << std::right << std::setw(10) << "sent"
+              << std::setw(10) << "received"
+              << std::setw(10) << "lost dgr"
+              << std::setw(10) << "dup dgr"
+              << std::setw(12) << "msg/s"
+              << std::setw(12) << "cpu us/msg"
+              << std::setw(12) << "max incompl"
+              << std::setw(16) << "max reasm bytes"
+              << '\n';
+  }
+
+  void run_profile(const std::string& name, const Impairment& impairment, const SenderParameters& sender_parameters, const SimulationParameters& simulation_parameters)
+  {
+    ecaludp::SimulatedNetwork network({'E', 'C', 'A', 'L'}, simulation_parameters.seed);
+    network.set_impairment(impairment);
+    if (sender_parameters.max_udp_datagram_size > 0)
+      network.set_max_udp_datagram_size(static_cast<size_t>(sender_parameters.max_udp_datagram_size));
+
+    const std::vector<char>       message(sender_parameters.message_size, 'a');
+    const asio::ip::udp::endpoint sender_endpoint(asio::ip::make_address(sender_parameters.ip), sender_parameters.port);
+    asio::ip::udp::endpoint       received_sender_endpoint;
+
+    const std::clock_t cpu_start = std::clock();
+
+    // Receive everything that has arrived before the next message is sent,
+    // so the reassembly sees the time pass like a real receiver.
+    for (size_t i = 0; i < simulation_parameters.messages; ++i)
+    {
+      network.send(asio::buffer(message), sender_endpoint);
+      network.advance_time(std::chrono::microseconds(simulation_parameters.message_interval_us));
+
+      ecaludp::Error error = ecaludp::Error::OK;
+      while (network.receive_from(received_sender_endpoint, error) != nullptr) {}
+    }
+
+    const double cpu_seconds = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    const auto statistics = network.get_statistics();
+    std::cout << std::left  << std::setw(10) << name
+              << std::right << std::setw(10) << statistics.messages_sent
+              << std::setw(10) << statistics.messages_received
+              << std::setw(10) << statistics.datagrams_lost
+              << std::setw(10) << statistics.datagrams_duplicated
+              << std::setw(12) << std::fixed << std::setprecision(0) << (cpu_seconds > 0.0 ? static_cast<double>(statistics.messages_sent) / cpu_seconds : 0.0)
+              << std::setw(12) << std::fixed << std::setprecision(2) << (statistics.messages_sent > 0 ? cpu_seconds * 1e6 / static_cast<double>(statistics.messages_sent) : 0.0)
+              << std::setw(12) << statistics.max_incomplete_messages
+              << std::setw(16) << statistics.max_reassembly_buffered_bytes
+              << '\n';
+  }
+}
+
+int run_simulation(const SenderParameters& sender_parameters, const SimulationParameters& simulation_parameters)
+{
+  std::cout << sender_parameters.to_string();
+  std::cout << simulation_parameters.to_string();
+  std::cout << "Implementation: simulated network\n";
+
+  std::vector<std::pair<std::string, Impairment>> profiles;
+
+  if (!simulation_parameters.impairment.empty())
+  {
+    Impairment impairment;
+    if (!parse_impairment(simulation_parameters.impairment, impairment))
+      return 1;
+    profiles.emplace_back("custom", impairment);
+  }
+  else
+  {
+    for (const auto& profile : builtin_profiles())
+    {
+      if ((simulation_parameters.profile == "all") || (simulation_parameters.profile == profile.first))
+        profiles.push_back(profile);
+    }
+
+    if (profiles.empty())
+    {
+      std::cerr << "Error: Unknown profile \"" << simulation_parameters.profile << "\"\n";
+      return 1;
+    }
+  }
+
+  print_header();
+  for (const auto& profile : profiles)
+    run_profile(profile.first, profile.second, sender_parameters, simulation_parameters);
+
+  return 0;
+}
@@ -0,0 +1,43 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+struct SimulationParameters
+{
+  std::string profile             {"all"};   ///< Name of a built-in impairment profile or "all"
+  std::string impairment          {};        ///< Custom impairment, e.g. "loss=0.01,burst=0.001/20". Replaces the profile.
+  uint64_t    seed                {1};
+  size_t      messages            {10000};   ///< Messages sent per profile
+  size_t      message_interval_us {1000};    ///< Simulated time between two messages
+
+  std::string to_string() const
+  {
+    std::stringstream ss;
+
+    ss << "Simulation Parameters: \n";
+    ss << "  Profile:          " << (impairment.empty() ? profile : "custom (" + impairment + ")") << '\n';
+    ss << "  Seed:             " << seed << '\n';
+    ss << "  Messages:         " << messages << '\n';
+    ss << "  Message interval: " << message_interval_us << " us\n";
+
+    return ss.str();
+  }
+};
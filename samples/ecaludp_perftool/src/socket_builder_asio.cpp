@@ -15,6 +15,7 @@
  ********************************************************************************/
 
 #include "socket_builder_asio.h"
+#include "ecaludp/error.h"
 #include "ecaludp/socket.h"
 #include "receiver_parameters.h"
 #include "sender_parameters.h"
@@ -48,6 +49,15 @@ namespace SocketBuilderAsio
       socket->set_max_udp_datagram_size(parameters.max_udp_datagram_size);
     }
 
+    if (parameters.rate > 0)
+    {
+      constexpr size_t default_burst = 64 * 1024;
+      socket->set_send_rate_limit(parameters.rate, (parameters.burst > 0 ? parameters.burst : default_burst));
+    }
+
+    socket->set_udp_gso_enabled(parameters.udp_gso);
+    socket->set_zerocopy_threshold(parameters.zerocopy_threshold);
+
     {
       asio::error_code ec;
       socket->open(destination.protocol(), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
@@ -89,6 +99,8 @@ namespace SocketBuilderAsio
 
     const asio::ip::udp::endpoint destination(ip_address, parameters.port);
 
+    socket->set_udp_gro_enabled(parameters.udp_gro);
+
     {
       asio::error_code ec;
       socket->open(destination.protocol(), ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
@@ -174,6 +186,16 @@ namespace SocketBuilderAsio
       }
     }
 
+    // Record the received datagrams
+    if (!parameters.record_file.empty())
+    {
+      ecaludp::Error error = ecaludp::Error::OK;
+      if (!socket->start_recording(parameters.record_file, error))
+      {
+        throw std::runtime_error("Failed to start recording: " + error.ToString());
+      }
+    }
+
     return socket;
   }
 }
@@ -21,6 +21,7 @@
 #include <stdexcept>
 
 #include <asio.hpp>
+#include <ecaludp/error.h>
 #include <ecaludp/socket_npcap.h>
 
 #include "receiver_parameters.h"
@@ -90,6 +91,16 @@ namespace SocketBuilderNpcap
       }
     }
 
+    // Record the received datagrams
+    if (!parameters.record_file.empty())
+    {
+      ecaludp::Error error = ecaludp::Error::OK;
+      if (!socket->start_recording(parameters.record_file, error))
+      {
+        throw std::runtime_error("Failed to start recording: " + error.ToString());
+      }
+    }
+
     return socket;
   }
 }
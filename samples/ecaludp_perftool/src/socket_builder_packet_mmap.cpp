@@ -0,0 +1,178 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#include "socket_builder_packet_mmap.h"
+
+#include <memory>
+#include <array>
+#include <stdexcept>
+
+#include <asio.hpp>
+#include <ecaludp/sender_packet_mmap.h>
+#include <ecaludp/socket_packet_mmap.h>
+
+#include "receiver_parameters.h"
+#include "sender_parameters.h"
+
+namespace SocketBuilderPacketMmap
+{
+  std::shared_ptr<ecaludp::SenderPacketMmap> CreateSender(const SenderParameters& parameters)
+  {
+    auto sender = std::make_shared<ecaludp::SenderPacketMmap>(std::array<char, 4>{'E', 'C', 'A', 'L'});
+    if (!sender->is_valid())
+    {
+      throw std::runtime_error("Failed to create AF_PACKET socket (CAP_NET_RAW required)");
+    }
+
+    asio::ip::address ip_address {};
+    {
+      asio::error_code ec;
+      ip_address = asio::ip::make_address(parameters.ip, ec);
+      if (ec)
+      {
+        throw std::runtime_error("Invalid IP address: " + parameters.ip);
+      }
+    }
+
+    // only v4 is supported right now
+    if (!ip_address.is_v4())
+    {
+      throw std::runtime_error("Only IPv4 is supported");
+    }
+
+    const asio::ip::udp::endpoint destination(ip_address, parameters.port);
+
+    if (parameters.max_udp_datagram_size > 0)
+    {
+      const bool success = sender->set_max_udp_datagram_size(static_cast<std::size_t>(parameters.max_udp_datagram_size));
+      if (!success)
+      {
+        throw std::runtime_error("Failed to set max UDP datagram size");
+      }
+    }
+
+    // Set send buffer size
+    if (parameters.buffer_size > 0)
+    {
+      const bool success = sender->set_send_buffer_size(parameters.buffer_size);
+      if (!success)
+      {
+        throw std::runtime_error("Failed to set send buffer size");
+      }
+    }
+
+    // The frames bypass the routing, so we let a regular socket find the
+    // source address (and thus the interface) for the destination.
+    asio::ip::udp::endpoint source;
+    {
+      asio::io_context      io_context;
+      asio::ip::udp::socket route_socket(io_context);
+
+      asio::error_code ec;
+      route_socket.connect(destination, ec); // NOLINT(bugprone-unused-return-value) The function also returns the error_code, but we already got it via the parameter
+      if (ec)
+      {
+        throw std::runtime_error("Failed to find a route to " + parameters.ip + ": " + ec.message());
+      }
+
+      source = route_socket.local_endpoint(ec);
+      if (ec)
+      {
+        throw std::runtime_error("Failed to get the source address: " + ec.message());
+      }
+    }
+
+    {
+      const bool success = sender->bind(source);
+      if (!success)
+      {
+        throw std::runtime_error("Failed to bind sender to " + source.address().to_string());
+      }
+    }
+
+    return sender;
+  }
+
+  std::shared_ptr<ecaludp::SocketPacketMmap> CreateReceiveSocket(const ReceiverParameters& parameters)
+  {
+    auto socket = std::make_shared<ecaludp::SocketPacketMmap>(std::array<char, 4>{'E', 'C', 'A', 'L'});
+    if (!socket->is_valid())
+    {
+      throw std::runtime_error("Failed to create AF_PACKET socket (CAP_NET_RAW required)");
+    }
+    
+    asio::ip::address ip_address {};
+    {
+      asio::error_code ec;
+      ip_address = asio::ip::make_address(parameters.ip, ec);
+      if (ec)
+      {
+        throw std::runtime_error("Invalid IP address: " + parameters.ip);
+      }
+    }
+
+    // only v4 is supported right now
+    if (!ip_address.is_v4())
+    {
+      throw std::runtime_error("Only IPv4 is supported");
+    }
+
+    // Set receive buffer size
+    if (parameters.buffer_size > 0)
+    {
+      const bool success = socket->set_receive_buffer_size(parameters.buffer_size);
+      if (!success)
+      {
+        throw std::runtime_error("Failed to set receive buffer size");
+      }
+    }
+
+
+    if (ip_address.is_multicast())
+    {
+      socket->set_multicast_loopback_enabled(true);
+
+      // "Bind" multicast address
+      {
+        const asio::ip::udp::endpoint bind_endpoint = asio::ip::udp::endpoint(asio::ip::address_v4(), parameters.port);
+        const bool success = socket->bind(bind_endpoint);
+        if (!success)
+        {
+          throw std::runtime_error("Failed to bind socket");
+        }
+      }
+
+      {
+        const bool success = socket->join_multicast_group(ip_address.to_v4());
+        if (!success)
+        {
+          throw std::runtime_error("Failed to join multicast group");
+        }
+      }
+    }
+    else
+    {
+      const asio::ip::udp::endpoint destination(ip_address, parameters.port);
+      const bool success = socket->bind(destination);
+      if (!success)
+      {
+        throw std::runtime_error("Failed to bind socket");
+      }
+    }
+
+    return socket;
+  }
+}
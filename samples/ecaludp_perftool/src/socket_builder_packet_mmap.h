@@ -0,0 +1,31 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#pragma once
+
+#include <memory>
+
+#include <ecaludp/sender_packet_mmap.h>
+#include <ecaludp/socket_packet_mmap.h>
+
+#include "receiver_parameters.h"
+#include "sender_parameters.h"
+
+namespace SocketBuilderPacketMmap
+{
+  std::shared_ptr<ecaludp::SenderPacketMmap> CreateSender(const SenderParameters& parameters);
+  std::shared_ptr<ecaludp::SocketPacketMmap> CreateReceiveSocket(const ReceiverParameters& parameters);
+}
@@ -0,0 +1,441 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "sweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/socket.h>
+
+#include "receiver_parameters.h"
+#include "sender_parameters.h"
+#include "socket_builder_asio.h"
+#include "sweep_parameters.h"
+
+#ifdef __linux__
+  #include <sys/resource.h>
+  #include <sys/time.h>
+#endif // __linux__
+
+namespace
+{
+  // Time the receiver gets to process the datagrams that are still in its
+  // buffer after the sender has stopped
+  constexpr std::chrono::milliseconds drain_time(200);
+
+  struct ResourceUsage
+  {
+    bool   valid_          {false};
+    double user_seconds_   {0.0};
+    double system_seconds_ {0.0};
+    long   peak_rss_kib_   {0};
+  };
+
+  struct UdpCounters
+  {
+    bool     valid_          {false};
+    uint64_t out_datagrams_  {0};
+    uint64_t rcvbuf_errors_  {0};
+  };
+
+  struct SweepPoint
+  {
+    long long message_size_          {0};
+    long long max_udp_datagram_size_ {-1};
+    long long buffer_size_           {-1};
+  };
+
+  struct SweepResult
+  {
+    double   duration_seconds_  {0.0};
+    uint64_t messages_sent_     {0};
+    uint64_t messages_received_ {0};
+    uint64_t bytes_received_    {0};
+
+    ResourceUsage usage_before_;
+    ResourceUsage usage_after_;
+    UdpCounters   udp_before_;
+    UdpCounters   udp_after_;
+  };
+
+  ResourceUsage get_resource_usage()
+  {
+    ResourceUsage usage;
+#ifdef __linux__
+    struct rusage self_usage {};
+    if (getrusage(RUSAGE_SELF, &self_usage) == 0)
+    {
+      usage.valid_          = true;
+      usage.user_seconds_   = static_cast<double>(self_usage.ru_utime.tv_sec) + static_cast<double>(self_usage.ru_utime.tv_usec) / 1e6;
+      usage.system_seconds_ = static_cast<double>(self_usage.ru_stime.tv_sec) + static_cast<double>(self_usage.ru_stime.tv_usec) / 1e6;
+      usage.peak_rss_kib_   = self_usage.ru_maxrss;         // Peak of the whole process, so it never decreases between points
+    }
+#endif // __linux__
+    return usage;
+  }
+
+  // Reads the system wide UDP counters. The difference of the RcvbufErrors
+  // are the datagrams that the kernel had to drop, because a receive buffer
+  // was full. On loopback, that is where the fragments get lost.
+  UdpCounters get_udp_counters()
+  {
+    UdpCounters counters;
+#ifdef __linux__
+    std::ifstream snmp_file("/proc/net/snmp");
+    std::string   header_line;
+    std::string   value_line;
+    while (std::getline(snmp_file, header_line))
+    {
+      if (header_line.compare(0, 4, "Udp:") != 0)
+        continue;
+
+      if (!std::getline(snmp_file, value_line))
+        break;
+
+      std::stringstream header_stream(header_line);
+      std::stringstream value_stream(value_line);
+      std::string       name;
+      std::string       value;
+      while ((header_stream >> name) && (value_stream >> value))
+      {
+        if (name == "OutDatagrams")
+          counters.out_datagrams_ = std::stoull(value);
+        else if (name == "RcvbufErrors")
+          counters.rcvbuf_errors_ = std::stoull(value);
+      }
+      counters.valid_ = true;
+      break;
+    }
+#endif // __linux__
+    return counters;
+  }
+
+  // Parses a comma separated list ("1000,2000") or a geometric range
+  // ("start:end:factor"). "default" is returned as -1.
+  bool parse_values(const std::string& option, const std::string& spec, std::vector<long long>& values)
+  {
+    try
+    {
+      if (spec.find(':') != std::string::npos)
+      {
+        std::stringstream spec_stream(spec);
+        std::string       start;
+        std::string       end;
+        std::string       factor;
+        std::getline(spec_stream, start, ':');
+        std::getline(spec_stream, end, ':');
+        std::getline(spec_stream, factor, ':');
+
+        const long long start_value  = std::stoll(start);
+        const long long end_value    = std::stoll(end);
+        const double    factor_value = std::stod(factor);
+
+        if ((start_value <= 0) || (factor_value <= 1.0))
+        {
+          std::cerr << "Error: " << option << " range requires a positive start and a factor greater than 1\n";
+          return false;
+        }
+
+        for (double value = static_cast<double>(start_value); value <= static_cast<double>(end_value); value *= factor_value)
+          values.push_back(static_cast<long long>(value));
+      }
+      else
+      {
+        std::stringstream spec_stream(spec);
+        std::string       item;
+        while (std::getline(spec_stream, item, ','))
+          values.push_back(item == "default" ? -1 : std::stoll(item));
+      }
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Error: Invalid value for " << option << " \"" << spec << "\": " << e.what() << '\n';
+      return false;
+    }
+
+    if (values.empty())
+    {
+      std::cerr << "Error: " << option << " must contain at least one value\n";
+      return false;
+    }
+
+    return true;
+  }
+
+  bool run_point(const SenderParameters& sender_parameters, const SweepPoint& point, std::chrono::milliseconds duration, SweepResult& result)
+  {
+    SenderParameters point_sender_parameters = sender_parameters;
+    point_sender_parameters.message_size          = static_cast<size_t>(point.message_size_);
+    point_sender_parameters.max_udp_datagram_size = static_cast<int>(point.max_udp_datagram_size_);
+    point_sender_parameters.buffer_size           = static_cast<int>(point.buffer_size_);
+
+    ReceiverParameters receiver_parameters;
+    receiver_parameters.ip          = sender_parameters.ip;
+    receiver_parameters.port        = sender_parameters.port;
+    receiver_parameters.buffer_size = static_cast<int>(point.buffer_size_);
+
+    asio::io_context io_context;
+
+    std::shared_ptr<ecaludp::Socket> receive_socket;
+    std::shared_ptr<ecaludp::Socket> send_socket;
+    try
+    {
+      receive_socket = SocketBuilderAsio::CreateReceiveSocket(io_context, receiver_parameters);
+      send_socket    = SocketBuilderAsio::CreateSendSocket(io_context, point_sender_parameters);
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Error creating socket: " << e.what() << '\n';
+      return false;
+    }
+
+    std::atomic<bool> stop_receiving   {false};
+    std::atomic<bool> receiver_stopped {false};
+
+    std::thread receive_thread([&]()
+                               {
+                                 asio::ip::udp::endpoint sender_endpoint;
+                                 while (!stop_receiving)
+                                 {
+                                   asio::error_code ec;
+                                   auto message = receive_socket->receive_from(sender_endpoint, 0, ec);
+
+                                   if (ec || stop_receiving)
+                                     break;
+
+                                   result.messages_received_++;
+                                   result.bytes_received_ += message->size();
+                                 }
+                                 receiver_stopped = true;
+                               });
+
+    result.usage_before_ = get_resource_usage();
+    result.udp_before_   = get_udp_counters();
+
+    const std::string             message(static_cast<size_t>(point.message_size_), 'a');
+    const asio::ip::udp::endpoint destination(asio::ip::make_address(sender_parameters.ip), sender_parameters.port);
+
+    bool send_error = false;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto end   = start + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+      asio::error_code ec;
+      send_socket->send_to(asio::buffer(message), destination, 0, ec);
+      if (ec)
+      {
+        std::cerr << "Error sending message: " << ec.message() << '\n';
+        send_error = true;
+        break;
+      }
+      result.messages_sent_++;
+    }
+    result.duration_seconds_ = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start).count();
+
+    std::this_thread::sleep_for(drain_time);
+    stop_receiving = true;
+
+    // Wake up the receiver with empty messages, until it has noticed that it
+    // has to stop
+    while (!receiver_stopped)
+    {
+      asio::error_code ec;
+      send_socket->send_to(asio::buffer(message.data(), 0), destination, 0, ec);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    receive_thread.join();
+
+    result.usage_after_ = get_resource_usage();
+    result.udp_after_   = get_udp_counters();
+
+    return !send_error;
+  }
+
+  std::string format_double(double value, int precision)
+  {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(precision) << value;
+    return ss.str();
+  }
+
+  // Name and value of all columns of a result. Values that are not available
+  // on this platform are empty.
+  std::vector<std::pair<std::string, std::string>> to_columns(const SweepPoint& point, const SweepResult& result)
+  {
+    std::vector<std::pair<std::string, std::string>> columns;
+
+    const double message_loss = (result.messages_sent_ > 0 ? 1.0 - static_cast<double>(result.messages_received_) / static_cast<double>(result.messages_sent_) : 0.0);
+
+    columns.emplace_back("message_size",          std::to_string(point.message_size_));
+    columns.emplace_back("max_udp_datagram_size", point.max_udp_datagram_size_ > 0 ? std::to_string(point.max_udp_datagram_size_) : "");
+    columns.emplace_back("buffer_size",           point.buffer_size_ > 0 ? std::to_string(point.buffer_size_) : "");
+    columns.emplace_back("duration_s",            format_double(result.duration_seconds_, 3));
+    columns.emplace_back("messages_sent",         std::to_string(result.messages_sent_));
+    columns.emplace_back("messages_received",     std::to_string(result.messages_received_));
+    columns.emplace_back("message_loss",          format_double(std::max(message_loss, 0.0), 6));
+    columns.emplace_back("throughput_mb_s",       format_double(static_cast<double>(result.bytes_received_) / result.duration_seconds_ / 1e6, 3));
+    columns.emplace_back("messages_per_s",        format_double(static_cast<double>(result.messages_received_) / result.duration_seconds_, 1));
+
+    if (result.udp_before_.valid_ && result.udp_after_.valid_)
+    {
+      const uint64_t datagrams_sent    = result.udp_after_.out_datagrams_ - result.udp_before_.out_datagrams_;
+      const uint64_t datagrams_dropped = result.udp_after_.rcvbuf_errors_ - result.udp_before_.rcvbuf_errors_;
+
+      columns.emplace_back("datagrams_sent",    std::to_string(datagrams_sent));
+      columns.emplace_back("datagrams_dropped", std::to_string(datagrams_dropped));
+      columns.emplace_back("fragment_loss",     format_double(datagrams_sent > 0 ? static_cast<double>(datagrams_dropped) / static_cast<double>(datagrams_sent) : 0.0, 6));
+    }
+    else
+    {
+      columns.emplace_back("datagrams_sent",    "");
+      columns.emplace_back("datagrams_dropped", "");
+      columns.emplace_back("fragment_loss",     "");
+    }
+
+    if (result.usage_before_.valid_ && result.usage_after_.valid_)
+    {
+      const double user_seconds   = result.usage_after_.user_seconds_   - result.usage_before_.user_seconds_;
+      const double system_seconds = result.usage_after_.system_seconds_ - result.usage_before_.system_seconds_;
+
+      columns.emplace_back("cpu_user_s",         format_double(user_seconds, 3));
+      columns.emplace_back("cpu_system_s",       format_double(system_seconds, 3));
+      columns.emplace_back("cpu_us_per_message", format_double(result.messages_received_ > 0 ? (user_seconds + system_seconds) * 1e6 / static_cast<double>(result.messages_received_) : 0.0, 3));
+      columns.emplace_back("peak_rss_kib",       std::to_string(result.usage_after_.peak_rss_kib_));
+    }
+    else
+    {
+      columns.emplace_back("cpu_user_s",         "");
+      columns.emplace_back("cpu_system_s",       "");
+      columns.emplace_back("cpu_us_per_message", "");
+      columns.emplace_back("peak_rss_kib",       "");
+    }
+
+    return columns;
+  }
+
+  void write_csv(std::ostream& output, const std::vector<std::pair<std::string, std::string>>& columns, bool write_header)
+  {
+    if (write_header)
+    {
+      for (size_t i = 0; i < columns.size(); ++i)
+        output << (i > 0 ? "," : "") << columns[i].first;
+      output << '\n';
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i)
+      output << (i > 0 ? "," : "") << columns[i].second;
+    output << '\n';
+  }
+
+  void write_json(std::ostream& output, const std::vector<std::pair<std::string, std::string>>& columns, bool is_first)
+  {
+    output << (is_first ? "[\n" : ",\n") << "  {";
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+      output << (i > 0 ? ", " : "") << '"' << columns[i].first << "\": " << (columns[i].second.empty() ? "null" : columns[i].second);
+    }
+    output << "}";
+  }
+}
+
+int run_sweep(const SenderParameters& sender_parameters, const SweepParameters& sweep_parameters)
+{
+  // The results may go to stdout, so everything else goes to stderr
+  std::cerr << sweep_parameters.to_string();
+
+  std::vector<long long> message_sizes;
+  std::vector<long long> max_udp_datagram_sizes;
+  std::vector<long long> buffer_sizes;
+  if (!parse_values("--sweep-size", sweep_parameters.message_sizes, message_sizes)
+      || !parse_values("--sweep-max-udp-datagram-size", sweep_parameters.max_udp_datagram_sizes, max_udp_datagram_sizes)
+      || !parse_values("--sweep-buffer-size", sweep_parameters.buffer_sizes, buffer_sizes))
+  {
+    return 1;
+  }
+
+  const bool json = (sweep_parameters.format == "json");
+  if (!json && (sweep_parameters.format != "csv"))
+  {
+    std::cerr << "Error: Unknown format \"" << sweep_parameters.format << "\"\n";
+    return 1;
+  }
+
+  std::ofstream output_file;
+  if (!sweep_parameters.output_file.empty())
+  {
+    output_file.open(sweep_parameters.output_file);
+    if (!output_file)
+    {
+      std::cerr << "Error: Failed to open " << sweep_parameters.output_file << '\n';
+      return 1;
+    }
+  }
+  std::ostream& output = (output_file.is_open() ? output_file : std::cout);
+
+  const size_t point_count = message_sizes.size() * max_udp_datagram_sizes.size() * buffer_sizes.size();
+  size_t       point_index = 0;
+
+  for (const auto message_size : message_sizes)
+  {
+    for (const auto max_udp_datagram_size : max_udp_datagram_sizes)
+    {
+      for (const auto buffer_size : buffer_sizes)
+      {
+        const SweepPoint point {message_size, max_udp_datagram_size, buffer_size};
+
+        std::cerr << "Point " << (point_index + 1) << "/" << point_count
+                  << ": message_size " << message_size
+                  << ", max_udp_datagram_size " << (max_udp_datagram_size > 0 ? std::to_string(max_udp_datagram_size) : "default")
+                  << ", buffer_size " << (buffer_size > 0 ? std::to_string(buffer_size) : "default") << '\n';
+
+        SweepResult result;
+        if (!run_point(sender_parameters, point, std::chrono::milliseconds(sweep_parameters.duration_ms), result))
+          return 1;
+
+        const auto columns = to_columns(point, result);
+        if (json)
+          write_json(output, columns, point_index == 0);
+        else
+          write_csv(output, columns, point_index == 0);
+        output.flush();
+
+        ++point_index;
+      }
+    }
+  }
+
+  if (json)
+    output << "\n]\n";
+
+  return 0;
+}
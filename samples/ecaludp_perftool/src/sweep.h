@@ -0,0 +1,28 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include "sender_parameters.h"
+#include "sweep_parameters.h"
+
+/**
+ * @brief Runs a sender and a receiver over loopback for each combination of the swept parameters and writes the results as CSV or JSON
+ *
+ * The ip, port and rate of the sender parameters are used for all points.
+ *
+ * @return The exit code
+ */
+int run_sweep(const SenderParameters& sender_parameters, const SweepParameters& sweep_parameters);
@@ -0,0 +1,45 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+struct SweepParameters
+{
+  std::string message_sizes           {"1000,10000,100000,1000000"};  ///< List ("a,b,c") or geometric range ("start:end:factor")
+  std::string max_udp_datagram_sizes  {"1448,8972,65507"};
+  std::string buffer_sizes            {"default,1048576,8388608"};    ///< "default" keeps the buffer size of the OS
+  size_t      duration_ms             {2000};                         ///< Send duration of each point
+  std::string format                  {"csv"};                        ///< "csv" or "json"
+  std::string output_file             {};                             ///< Empty for stdout
+
+  std::string to_string() const
+  {
+    std::stringstream ss;
+
+    ss << "Sweep Parameters: \n";
+    ss << "  Message sizes:          " << message_sizes << '\n';
+    ss << "  Max UDP datagram sizes: " << max_udp_datagram_sizes << '\n';
+    ss << "  Buffer sizes:           " << buffer_sizes << '\n';
+    ss << "  Duration:               " << duration_ms << " ms\n";
+    ss << "  Format:                 " << format << '\n';
+    ss << "  Output:                 " << (output_file.empty() ? "stdout" : output_file) << '\n';
+
+    return ss.str();
+  }
+};
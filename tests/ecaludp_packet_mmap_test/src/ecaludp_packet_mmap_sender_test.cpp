@@ -0,0 +1,216 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/sender_packet_mmap.h>
+#include <ecaludp/socket_packet_mmap.h>
+
+#include "atomic_signalable.h"
+
+// Sending requires CAP_NET_RAW. The tests are skipped, if we don't have it.
+#define SKIP_IF_NO_CAPTURE_PERMISSION(socket) \
+  if (!(socket).is_valid()) { GTEST_SKIP() << "AF_PACKET sockets are not available (CAP_NET_RAW required)"; }
+
+// Frames that are injected into the loopback interface by a packet socket are
+// not routed to regular UDP sockets by the kernel (127.0.0.0/8 is a martian
+// address for incoming frames). Thus, the tests receive with a
+// SocketPacketMmap, which captures the frames directly from the interface.
+
+namespace
+{
+  // Receives messages on a background thread until it is destroyed
+  class MessageReceiver
+  {
+  public:
+    explicit MessageReceiver(ecaludp::SocketPacketMmap& socket)
+      : socket_          (socket)
+      , message_counter_ (0)
+      , receive_thread_  ([this]() { receive_loop(); })
+    {}
+
+    ~MessageReceiver()
+    {
+      socket_.close();
+      receive_thread_.join();
+    }
+
+    MessageReceiver(const MessageReceiver&)            = delete;
+    MessageReceiver& operator=(const MessageReceiver&) = delete;
+    MessageReceiver(MessageReceiver&&)                 = delete;
+    MessageReceiver& operator=(MessageReceiver&&)      = delete;
+
+    std::vector<std::pair<asio::ip::udp::endpoint, std::string>> wait_for_messages(int expected_messages, std::chrono::milliseconds timeout)
+    {
+      message_counter_.wait_for([expected_messages](int received) { return received >= expected_messages; }, timeout);
+
+      const std::lock_guard<std::mutex> lock(mutex_);
+      return received_messages_;
+    }
+
+    int message_count()
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      return static_cast<int>(received_messages_.size());
+    }
+
+  private:
+    void receive_loop()
+    {
+      while (true)
+      {
+        asio::ip::udp::endpoint sender_endpoint;
+        ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+        auto buffer = socket_.receive_from(sender_endpoint, error);
+        if (error)
+          return;
+
+        {
+          const std::lock_guard<std::mutex> lock(mutex_);
+          received_messages_.emplace_back(sender_endpoint, std::string(static_cast<const char*>(buffer->data()), buffer->size()));
+        }
+        message_counter_++;
+      }
+    }
+
+  private:
+    ecaludp::SocketPacketMmap& socket_;
+
+    std::mutex                                                    mutex_;
+    std::vector<std::pair<asio::ip::udp::endpoint, std::string>> received_messages_;
+    atomic_signalable<int>                                        message_counter_;
+
+    std::thread receive_thread_;
+  };
+}
+
+TEST(EcalUdpPacketMmapSender, RAII_unbound)
+{
+  // Create the sender and destroy it
+  ecaludp::SenderPacketMmap sender({'E', 'C', 'A', 'L'});
+}
+
+TEST(EcalUdpPacketMmapSender, RAII_bound)
+{
+  ecaludp::SenderPacketMmap sender({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(sender);
+
+  ASSERT_TRUE(sender.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14010)));
+  ASSERT_TRUE(sender.is_bound());
+
+  // The frames are sized at bind time, so this must fail now
+  ASSERT_FALSE(sender.set_max_udp_datagram_size(1000));
+}
+
+TEST(EcalUdpPacketMmapSender, HelloWorldMessage)
+{
+  ecaludp::SenderPacketMmap sender         ({'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(sender);
+
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+  ASSERT_TRUE(sender.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14010)));
+
+  MessageReceiver receiver(receiver_socket);
+
+  const std::string message_to_send = "Hello World!";
+  {
+    asio::error_code ec;
+    const std::size_t bytes_sent = sender.send_to(asio::buffer(message_to_send), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+    ASSERT_EQ(ec, asio::error_code());
+    ASSERT_GT(bytes_sent, message_to_send.size());
+  }
+
+  const auto received_messages = receiver.wait_for_messages(1, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.size(), 1);
+  ASSERT_EQ(received_messages[0].second, message_to_send);
+  ASSERT_EQ(received_messages[0].first, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14010));
+}
+
+TEST(EcalUdpPacketMmapSender, BigMessage)
+{
+  constexpr int message_size = 1024 * 1024;
+
+  ecaludp::SenderPacketMmap sender         ({'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(sender);
+
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+  ASSERT_TRUE(sender.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14010)));
+
+  MessageReceiver receiver(receiver_socket);
+
+  std::string message_to_send(message_size, 'a');
+  std::generate(message_to_send.begin(), message_to_send.end(), []() { return static_cast<char>(std::rand()); });
+
+  {
+    asio::error_code ec;
+    sender.send_to(asio::buffer(message_to_send), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  const auto received_messages = receiver.wait_for_messages(1, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.size(), 1);
+  ASSERT_EQ(received_messages[0].second, message_to_send);
+}
+
+TEST(EcalUdpPacketMmapSender, EnqueueAndFlush)
+{
+  constexpr int num_messages = 50;
+
+  ecaludp::SenderPacketMmap sender         ({'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(sender);
+
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+  ASSERT_TRUE(sender.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14010)));
+
+  MessageReceiver receiver(receiver_socket);
+
+  for (int i = 0; i < num_messages; ++i)
+  {
+    asio::error_code ec;
+    sender.enqueue_to(asio::buffer(std::to_string(i)), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Nothing must have been sent, yet
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(receiver.message_count(), 0);
+
+  {
+    asio::error_code ec;
+    sender.flush(ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // All messages must arrive in order
+  const auto received_messages = receiver.wait_for_messages(num_messages, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.size(), num_messages);
+  for (int i = 0; i < num_messages; ++i)
+  {
+    ASSERT_EQ(received_messages[i].second, std::to_string(i));
+  }
+}
@@ -0,0 +1,436 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/socket.h>
+#include <ecaludp/socket_packet_mmap.h>
+
+#include "atomic_signalable.h"
+
+// Capturing requires CAP_NET_RAW. The tests are skipped, if we don't have it.
+#define SKIP_IF_NO_CAPTURE_PERMISSION(socket) \
+  if (!(socket).is_valid()) { GTEST_SKIP() << "AF_PACKET sockets are not available (CAP_NET_RAW required)"; }
+
+TEST(EcalUdpPacketMmapSocket, RAII_unbound)
+{
+  // Create the socket and destroy it
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+}
+
+TEST(EcalUdpPacketMmapSocket, RAII_bound)
+{
+  // Create the socket, bind and destroy it
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+  ASSERT_TRUE(receiver_socket.is_bound());
+}
+
+TEST(EcalUdpPacketMmapSocket, RAII_close)
+{
+  // Create the socket, bind and close it
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+  receiver_socket.close();
+
+  // Receiving from a closed socket must fail immediately
+  asio::ip::udp::endpoint sender_endpoint;
+  ecaludp::Error error = ecaludp::Error::OK;
+  auto buffer = receiver_socket.receive_from(sender_endpoint, error);
+  ASSERT_EQ(buffer, nullptr);
+  ASSERT_EQ(error, ecaludp::Error::SOCKET_CLOSED);
+}
+
+TEST(EcalUdpPacketMmapSocket, RAII_close_while_receiving)
+{
+  atomic_signalable<int> completed_handlers(0);
+
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+
+  asio::ip::udp::endpoint sender_endpoint;
+  receiver_socket.async_receive_from(sender_endpoint
+                                    , [&completed_handlers](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, const ecaludp::Error& error)
+                                      {
+                                        ASSERT_EQ(buffer, nullptr);
+                                        ASSERT_EQ(error, ecaludp::Error::SOCKET_CLOSED);
+                                        completed_handlers++;
+                                      });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  receiver_socket.close();
+
+  completed_handlers.wait_for([](int completed_handlers) { return completed_handlers == 1; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(completed_handlers, 1);
+}
+
+TEST(EcalUdpPacketMmapSocket, HelloWorldMessage)
+{
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::Socket           sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  // Open the sender_socket
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Bind the receiver_socket
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+
+  // Send a message to a different port first, that must be filtered out
+  const std::string message_to_send = "Hello World!";
+  const std::string wrong_message   = "Wrong port";
+  {
+    asio::error_code ec;
+    sender_socket.send_to(asio::buffer(wrong_message),   asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14001), 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+    sender_socket.send_to(asio::buffer(message_to_send), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Receive the message
+  asio::ip::udp::endpoint sender_endpoint;
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  auto buffer = receiver_socket.receive_from(sender_endpoint, error);
+
+  ASSERT_FALSE(error);
+  ASSERT_NE(buffer, nullptr);
+  ASSERT_EQ(std::string(static_cast<const char*>(buffer->data()), buffer->size()), message_to_send);
+  ASSERT_EQ(sender_endpoint.port(), sender_socket.local_endpoint().port());
+}
+
+TEST(EcalUdpPacketMmapSocket, AsyncHelloWorldMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::Socket           sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  // Open the sender_socket
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Bind the receiver_socket
+  {
+    bool success = receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+    ASSERT_EQ(success, true);
+  }
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>("Hello World!");
+
+  // Wait for the next message
+  receiver_socket.async_receive_from(*sender_endpoint
+                                  , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, ecaludp::Error error)
+                                    {
+                                      // No error
+                                      if (error)
+                                      {
+                                        FAIL();
+                                      }
+
+                                      // compare the messages
+                                      std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                      ASSERT_EQ(received_string, *message_to_send);
+
+                                      // increment
+                                      received_messages++;
+                                    });
+
+  // Send a message
+  sender_socket.async_send_to(asio::buffer(*message_to_send)
+                      , asio::ip::udp::endpoint(asio::ip::address_v4::loopback()
+                      , 14000)
+                      , [message_to_send](asio::error_code ec)
+                        {
+                          // No error
+                          ASSERT_EQ(ec, asio::error_code());
+                        });
+
+  // Wait for the message to be received
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(100));
+
+  ASSERT_EQ(received_messages, 1);
+
+  work.reset();
+  io_thread.join();
+}
+
+TEST(EcalUdpPacketMmapSocket, AsyncBigMessage)
+{
+  constexpr int message_size = 1024 * 1024;
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::Socket           sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  // Open the sender_socket
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Bind the receiver_socket
+  {
+    bool success = receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+    ASSERT_EQ(success, true);
+  }
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>(message_size, 'a');
+
+  // Fill the message with random characters
+  std::generate(message_to_send->begin(), message_to_send->end(), []() { return static_cast<char>(std::rand()); });
+
+  // Wait for the next message
+  receiver_socket.async_receive_from(*sender_endpoint
+                                  , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, ecaludp::Error error)
+                                    {
+                                      // No error
+                                      if (error)
+                                      {
+                                        FAIL();
+                                      }
+
+                                      // compare the messages
+                                      std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                      ASSERT_EQ(received_string, *message_to_send);
+
+                                      // increment
+                                      received_messages++;
+                                    });
+
+  // Send a message
+  sender_socket.async_send_to(asio::buffer(*message_to_send)
+                              , asio::ip::udp::endpoint(asio::ip::address_v4::loopback()
+                              , 14000)
+                              , [message_to_send](asio::error_code ec)
+                                {
+                                  // No error
+                                  ASSERT_EQ(ec, asio::error_code());
+                                });
+
+  // Wait for the message to be received
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(1000));
+
+  ASSERT_EQ(received_messages, 1);
+
+  work.reset();
+  io_thread.join();
+}
+
+TEST(EcalUdpPacketMmapSocket, RecoverFromFullRing)
+{
+  // Flood a tiny ring, so fragments get lost and incomplete messages keep
+  // blocks of the ring referenced. The receiver must recover from that and
+  // receive the messages that are sent afterwards.
+  constexpr int flood_messages  = 2000;
+  constexpr int paced_messages  = 20;
+  constexpr int message_size    = 16 * 1024;
+
+  asio::io_context io_context;
+
+  ecaludp::Socket           sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Use a small ring of 4 blocks
+  ASSERT_TRUE(receiver_socket.set_receive_buffer_size(4 * 1024 * 1024));
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+
+  atomic_signalable<int> received_paced_messages(0);
+  int                    corrupted_messages = 0;
+
+  std::thread receive_thread([&receiver_socket, &received_paced_messages, &corrupted_messages]()
+                             {
+                               // Keep all buffers, like a slow user would
+                               std::vector<std::shared_ptr<ecaludp::OwningBuffer>> received_buffers;
+
+                               while (true)
+                               {
+                                 asio::ip::udp::endpoint sender_endpoint;
+                                 ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+                                 auto buffer = receiver_socket.receive_from(sender_endpoint, error);
+                                 if (error)
+                                   return;
+
+                                 const auto* data = static_cast<const char*>(buffer->data());
+                                 if ((buffer->size() != message_size) || !std::all_of(data, data + message_size, [data](char c) { return c == data[0]; }))
+                                   corrupted_messages++;
+                                 else if (data[0] == 'Z')
+                                   received_paced_messages++;
+
+                                 received_buffers.push_back(buffer);
+                               }
+                             });
+
+  auto send_message = [&sender_socket](char fill)
+                      {
+                        const std::string message(message_size, fill);
+                        asio::error_code ec;
+                        sender_socket.send_to(asio::buffer(message), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), 0, ec);
+                        return ec;
+                      };
+
+  // Flood
+  for (int i = 0; i < flood_messages; ++i)
+  {
+    ASSERT_EQ(send_message(static_cast<char>('a' + (i % 25))), asio::error_code());
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Send some more messages with enough time in between
+  for (int i = 0; i < paced_messages; ++i)
+  {
+    ASSERT_EQ(send_message('Z'), asio::error_code());
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  received_paced_messages.wait_for([](int received) { return received == paced_messages; }, std::chrono::milliseconds(1000));
+
+  receiver_socket.close();
+  receive_thread.join();
+
+  ASSERT_EQ(received_paced_messages, paced_messages);
+  ASSERT_EQ(corrupted_messages, 0);
+}
+
+TEST(EcalUdpPacketMmapSocket, PausingSender)
+{
+  // A sender that pauses in the middle of a message must not make the
+  // receiver drop the incomplete message, as the ring is not stalled.
+  constexpr int message_size = 16 * 1024;
+
+  asio::io_context io_context;
+
+  ecaludp::Socket           sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  asio::ip::udp::socket     relay_socket   (io_context);
+  ecaludp::SocketPacketMmap receiver_socket({'E', 'C', 'A', 'L'});
+  SKIP_IF_NO_CAPTURE_PERMISSION(receiver_socket);
+
+  // Capture the datagrams of the message with a plain UDP socket, so we can
+  // relay them to the receiver with a pause in between
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+    relay_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+    relay_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14001), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  const std::string message(message_size, 'a');
+  {
+    asio::error_code ec;
+    sender_socket.send_to(asio::buffer(message), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14001), 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  std::vector<std::vector<char>> datagrams;
+  while (relay_socket.available() > 0)
+  {
+    std::vector<char> datagram(relay_socket.available());
+    datagram.resize(relay_socket.receive(asio::buffer(datagram)));
+    datagrams.push_back(std::move(datagram));
+  }
+  ASSERT_GT(datagrams.size(), 2);
+
+  ASSERT_TRUE(receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)));
+
+  atomic_signalable<int> received_messages(0);
+  std::string            received_message;
+
+  std::thread receive_thread([&receiver_socket, &received_messages, &received_message]()
+                             {
+                               while (true)
+                               {
+                                 asio::ip::udp::endpoint sender_endpoint;
+                                 ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+                                 auto buffer = receiver_socket.receive_from(sender_endpoint, error);
+                                 if (error == ecaludp::Error::SOCKET_CLOSED)
+                                   return;
+                                 if (error)
+                                   continue;
+
+                                 received_message = std::string(static_cast<const char*>(buffer->data()), buffer->size());
+                                 received_messages++;
+                               }
+                             });
+
+  const asio::ip::udp::endpoint receiver_endpoint(asio::ip::address_v4::loopback(), 14000);
+  for (std::size_t i = 0; i < datagrams.size(); ++i)
+  {
+    if (i == datagrams.size() / 2)
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    relay_socket.send_to(asio::buffer(datagrams[i]), receiver_endpoint);
+  }
+
+  received_messages.wait_for([](int received) { return received == 1; }, std::chrono::milliseconds(1000));
+
+  receiver_socket.close();
+  receive_thread.join();
+
+  ASSERT_EQ(received_messages, 1);
+  ASSERT_EQ(received_message, message);
+}
@@ -0,0 +1,145 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/error.h>
+#include <ecaludp/raw_memory.h>
+
+#include <pcap_file_reader.h>
+#include <pcap_format.h>
+#include <pcap_recorder.h>
+#include <udp_packet.h>
+
+// Record many more datagrams than fit into the ring, so the ring wraps
+// around and the writer thread can't keep up. Each datagram must either be
+// in the file or be counted as dropped, and the file must stay consistent.
+TEST(PcapRecorderTest, RingWrapAround)
+{
+  const std::string file_path = ::testing::TempDir() + "ecaludp_recorder_wrap.pcap";
+
+  const asio::ip::udp::endpoint source     (asio::ip::make_address("192.168.0.1"), 5000);
+  const asio::ip::udp::endpoint destination(asio::ip::make_address("239.0.0.1"),   14000);
+
+  constexpr uint32_t datagram_count = 20000;
+  constexpr std::size_t datagram_size = 1001;  // Not a multiple of anything, so the records wrap at odd positions
+
+  uint64_t dropped_datagrams = 0;
+  {
+    ecaludp::PcapRecorder recorder(0);  // Uses the minimum ring size
+
+    ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+    ASSERT_TRUE(recorder.open(file_path, error)) << error.ToString();
+
+    std::vector<uint8_t> datagram(datagram_size);
+    for (uint32_t i = 0; i < datagram_count; ++i)
+    {
+      std::memcpy(datagram.data(), &i, sizeof(i));
+      datagram.back() = static_cast<uint8_t>(i);
+      recorder.record(datagram.data(), datagram.size(), source, destination);
+    }
+
+    dropped_datagrams = recorder.get_dropped_datagrams();
+    recorder.close();
+  }
+
+  ecaludp::PcapFileReader reader;
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(reader.open(file_path, error)) << error.ToString();
+
+  ecaludp::RawMemory     buffer;
+  ecaludp::CapturedPacket packet;
+  uint32_t recorded_datagrams = 0;
+  int64_t  last_index         = -1;
+  while (reader.read_packet(buffer, packet, error))
+  {
+    ASSERT_EQ(packet.link_type_, ecaludp::link_type_raw);
+
+    ecaludp::UdpPacketView udp_packet;
+    ASSERT_TRUE(ecaludp::parse_captured_udp_packet(packet.link_type_, buffer.data(), buffer.size(), udp_packet));
+    ASSERT_EQ(udp_packet.source_,       source);
+    ASSERT_EQ(udp_packet.destination_,  destination);
+    ASSERT_EQ(udp_packet.payload_size_, datagram_size);
+
+    // The datagrams are recorded in order, with gaps for the dropped ones
+    uint32_t index = 0;
+    std::memcpy(&index, udp_packet.payload_, sizeof(index));
+    ASSERT_GT(static_cast<int64_t>(index), last_index);
+    ASSERT_EQ(udp_packet.payload_[datagram_size - 1], static_cast<uint8_t>(index));
+    last_index = index;
+
+    ++recorded_datagrams;
+  }
+  ASSERT_FALSE(error) << error.ToString();
+
+  ASSERT_EQ(recorded_datagrams + dropped_datagrams, datagram_count);
+  ASSERT_GT(recorded_datagrams, 0);
+
+  reader.close();
+  std::remove(file_path.c_str());
+}
+
+// The largest datagram that fits into an IPv4 packet is recorded with
+// correct length fields, larger ones are not recorded at all.
+TEST(PcapRecorderTest, MaxDatagramSize)
+{
+  const std::string file_path = ::testing::TempDir() + "ecaludp_recorder_max_size.pcap";
+
+  const asio::ip::udp::endpoint source     (asio::ip::make_address("192.168.0.1"), 5000);
+  const asio::ip::udp::endpoint destination(asio::ip::make_address("239.0.0.1"),   14000);
+
+  constexpr std::size_t max_datagram_size = 65535 - 20 - 8;
+
+  {
+    ecaludp::PcapRecorder recorder(0);
+
+    ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+    ASSERT_TRUE(recorder.open(file_path, error)) << error.ToString();
+
+    const std::vector<uint8_t> datagram(max_datagram_size + 1, 'a');
+    recorder.record(datagram.data(), max_datagram_size + 1, source, destination);
+    recorder.record(datagram.data(), max_datagram_size,     source, destination);
+
+    ASSERT_EQ(recorder.get_dropped_datagrams(), 0);
+    recorder.close();
+  }
+
+  ecaludp::PcapFileReader reader;
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(reader.open(file_path, error)) << error.ToString();
+
+  ecaludp::RawMemory      buffer;
+  ecaludp::CapturedPacket packet;
+  ASSERT_TRUE(reader.read_packet(buffer, packet, error)) << error.ToString();
+
+  ecaludp::UdpPacketView udp_packet;
+  ASSERT_TRUE(ecaludp::parse_captured_udp_packet(packet.link_type_, buffer.data(), buffer.size(), udp_packet));
+  ASSERT_EQ(udp_packet.payload_size_, max_datagram_size);
+
+  ASSERT_FALSE(reader.read_packet(buffer, packet, error));
+  ASSERT_FALSE(error) << error.ToString();
+
+  reader.close();
+  std::remove(file_path.c_str());
+}
@@ -0,0 +1,474 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/error.h>
+#include <ecaludp/socket.h>
+#include <ecaludp_testsupport/pcap_replay.h>
+
+#include <protocol/datagram_builder_v5.h>
+#include <protocol/datagram_description.h>
+#include <udp_packet.h>
+
+namespace
+{
+  struct TestPacket
+  {
+    std::chrono::nanoseconds timestamp_;
+    std::vector<uint8_t>     data_;
+  };
+
+  // Creates the IPv4 / UDP packets of a message. With_ethernet decides
+  // whether the packets start with an ethernet header or with the IP header.
+  std::vector<TestPacket> create_packets(const std::string& message
+                                        , std::size_t max_datagram_size
+                                        , const asio::ip::udp::endpoint& source
+                                        , const asio::ip::udp::endpoint& destination
+                                        , std::chrono::nanoseconds timestamp
+                                        , bool with_ethernet)
+  {
+    std::vector<TestPacket> packets;
+
+    auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, max_datagram_size, {'E', 'C', 'A', 'L'});
+    for (const auto& datagram : datagram_list)
+    {
+      TestPacket packet;
+      packet.timestamp_ = timestamp;
+      packet.data_.resize(ecaludp::ethernet_header_size + ecaludp::ipv4_header_size + ecaludp::udp_header_size + datagram.size());
+
+      std::size_t offset = ecaludp::write_ethernet_ipv4_udp_headers(packet.data_.data(), {}, {}, source, destination, 0, 64, datagram.size());
+      for (const auto& buffer : datagram.asio_buffer_list_)
+      {
+        std::memcpy(packet.data_.data() + offset, buffer.data(), buffer.size());
+        offset += buffer.size();
+      }
+
+      if (!with_ethernet)
+        packet.data_.erase(packet.data_.begin(), packet.data_.begin() + ecaludp::ethernet_header_size);
+
+      packets.push_back(std::move(packet));
+    }
+    return packets;
+  }
+
+  template <typename T>
+  void write_value(std::ofstream& file, T value)
+  {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  // Writes a classic pcap file in host byte order
+  void write_pcap_file(const std::string& file_path, const std::vector<TestPacket>& packets, bool nanoseconds)
+  {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+
+    write_value<uint32_t>(file, nanoseconds ? 0xA1B23C4D : 0xA1B2C3D4);
+    write_value<uint16_t>(file, 2);
+    write_value<uint16_t>(file, 4);
+    write_value<int32_t> (file, 0);
+    write_value<uint32_t>(file, 0);
+    write_value<uint32_t>(file, 262144);
+    write_value<uint32_t>(file, 1);     // Ethernet
+
+    for (const auto& packet : packets)
+    {
+      const auto seconds  = std::chrono::duration_cast<std::chrono::seconds>(packet.timestamp_);
+      const auto fraction = packet.timestamp_ - seconds;
+      write_value<uint32_t>(file, static_cast<uint32_t>(seconds.count()));
+      write_value<uint32_t>(file, static_cast<uint32_t>(nanoseconds ? fraction.count() : std::chrono::duration_cast<std::chrono::microseconds>(fraction).count()));
+      write_value<uint32_t>(file, static_cast<uint32_t>(packet.data_.size()));
+      write_value<uint32_t>(file, static_cast<uint32_t>(packet.data_.size()));
+      file.write(reinterpret_cast<const char*>(packet.data_.data()), static_cast<std::streamsize>(packet.data_.size()));
+    }
+  }
+
+  void write_pcapng_block(std::ofstream& file, uint32_t type, const std::vector<uint8_t>& body)
+  {
+    const auto padded_size = (body.size() + 3) & ~static_cast<std::size_t>(3);
+    const auto block_size  = static_cast<uint32_t>(padded_size + 12);
+
+    write_value<uint32_t>(file, type);
+    write_value<uint32_t>(file, block_size);
+    file.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+    for (std::size_t i = body.size(); i < padded_size; ++i)
+      write_value<uint8_t>(file, 0);
+    write_value<uint32_t>(file, block_size);
+  }
+
+  template <typename T>
+  void append_value(std::vector<uint8_t>& body, T value)
+  {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    body.insert(body.end(), bytes, bytes + sizeof(value));
+  }
+
+  // Writes a pcapng file in host byte order with raw IP packets and a nanosecond resolution
+  void write_pcapng_file(const std::string& file_path, const std::vector<TestPacket>& packets)
+  {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+
+    // Section header
+    std::vector<uint8_t> section_header;
+    append_value<uint32_t>(section_header, 0x1A2B3C4D);
+    append_value<uint16_t>(section_header, 1);
+    append_value<uint16_t>(section_header, 0);
+    append_value<int64_t> (section_header, -1);
+    write_pcapng_block(file, 0x0A0D0D0A, section_header);
+
+    // Interface description with if_tsresol = 9
+    std::vector<uint8_t> interface;
+    append_value<uint16_t>(interface, 101);   // Raw IP
+    append_value<uint16_t>(interface, 0);
+    append_value<uint32_t>(interface, 262144);
+    append_value<uint16_t>(interface, 9);
+    append_value<uint16_t>(interface, 1);
+    append_value<uint8_t> (interface, 9);
+    append_value<uint8_t> (interface, 0);
+    append_value<uint16_t>(interface, 0);
+    append_value<uint16_t>(interface, 0);     // End of options
+    append_value<uint16_t>(interface, 0);
+    write_pcapng_block(file, 0x00000001, interface);
+
+    // Some block that must be skipped (Interface statistics)
+    write_pcapng_block(file, 0x00000005, std::vector<uint8_t>(12, 0));
+
+    for (const auto& packet : packets)
+    {
+      const auto ticks = static_cast<uint64_t>(packet.timestamp_.count());
+
+      std::vector<uint8_t> enhanced_packet;
+      append_value<uint32_t>(enhanced_packet, 0);
+      append_value<uint32_t>(enhanced_packet, static_cast<uint32_t>(ticks >> 32));
+      append_value<uint32_t>(enhanced_packet, static_cast<uint32_t>(ticks & 0xFFFFFFFF));
+      append_value<uint32_t>(enhanced_packet, static_cast<uint32_t>(packet.data_.size()));
+      append_value<uint32_t>(enhanced_packet, static_cast<uint32_t>(packet.data_.size()));
+      enhanced_packet.insert(enhanced_packet.end(), packet.data_.begin(), packet.data_.end());
+      write_pcapng_block(file, 0x00000006, enhanced_packet);
+    }
+  }
+
+  std::string temp_file_path(const std::string& name)
+  {
+    return ::testing::TempDir() + "ecaludp_" + name;
+  }
+
+  const asio::ip::udp::endpoint source_endpoint     (asio::ip::make_address("192.168.0.1"), 5000);
+  const asio::ip::udp::endpoint destination_endpoint(asio::ip::make_address("239.0.0.1"),   14000);
+
+  const std::chrono::nanoseconds start_time = std::chrono::seconds(1700000000);
+}
+
+// Replay non-fragmented messages from a classic pcap file
+TEST(PcapReplayTest, NonFragmentedMessages)
+{
+  std::vector<TestPacket> packets;
+  for (int i = 0; i < 3; ++i)
+  {
+    auto message_packets = create_packets("Hello World " + std::to_string(i), 1448, source_endpoint, destination_endpoint, start_time + std::chrono::milliseconds(i), true);
+    packets.insert(packets.end(), message_packets.begin(), message_packets.end());
+  }
+
+  const auto file_path = temp_file_path("non_fragmented.pcap");
+  write_pcap_file(file_path, packets, false);
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+
+  for (int i = 0; i < 3; ++i)
+  {
+    asio::ip::udp::endpoint sender_endpoint;
+    auto message = replay.receive_from(sender_endpoint, error);
+    ASSERT_NE(message, nullptr) << error.ToString();
+    ASSERT_EQ(error, ecaludp::Error::OK);
+
+    const std::string expected = "Hello World " + std::to_string(i);
+    ASSERT_EQ(std::string(static_cast<const char*>(message->data()), message->size()), expected);
+    ASSERT_EQ(sender_endpoint, source_endpoint);
+    ASSERT_EQ(replay.get_packet_timestamp(), start_time + std::chrono::milliseconds(i));
+  }
+
+  asio::ip::udp::endpoint sender_endpoint;
+  ASSERT_EQ(replay.receive_from(sender_endpoint, error), nullptr);
+  ASSERT_EQ(error, ecaludp::Error::END_OF_FILE);
+
+  std::remove(file_path.c_str());
+}
+
+// Replay a fragmented message whose fragments have been captured in reverse order
+TEST(PcapReplayTest, FragmentedMessageReversed)
+{
+  std::string message_to_send;
+  for (int i = 0; i < 1000; ++i)
+    message_to_send += std::to_string(i) + " ";
+
+  auto packets = create_packets(message_to_send, 100, source_endpoint, destination_endpoint, start_time, true);
+  ASSERT_GT(packets.size(), 2);
+  std::reverse(packets.begin(), packets.end());
+
+  const auto file_path = temp_file_path("fragmented.pcap");
+  write_pcap_file(file_path, packets, true);
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+
+  asio::ip::udp::endpoint sender_endpoint;
+  auto message = replay.receive_from(sender_endpoint, error);
+  ASSERT_NE(message, nullptr) << error.ToString();
+  ASSERT_EQ(std::string(static_cast<const char*>(message->data()), message->size()), message_to_send);
+
+  ASSERT_EQ(replay.receive_from(sender_endpoint, error), nullptr);
+  ASSERT_EQ(error, ecaludp::Error::END_OF_FILE);
+
+  std::remove(file_path.c_str());
+}
+
+// Replay a pcapng file with raw IP packets and a non-default timestamp resolution
+TEST(PcapReplayTest, PcapngRawIp)
+{
+  auto packets = create_packets("Hello pcapng", 1448, source_endpoint, destination_endpoint, start_time + std::chrono::nanoseconds(123), false);
+
+  const auto file_path = temp_file_path("raw_ip.pcapng");
+  write_pcapng_file(file_path, packets);
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+
+  asio::ip::udp::endpoint sender_endpoint;
+  auto message = replay.receive_from(sender_endpoint, error);
+  ASSERT_NE(message, nullptr) << error.ToString();
+  ASSERT_EQ(std::string(static_cast<const char*>(message->data()), message->size()), "Hello pcapng");
+  ASSERT_EQ(sender_endpoint, source_endpoint);
+  ASSERT_EQ(replay.get_packet_timestamp(), start_time + std::chrono::nanoseconds(123));
+
+  ASSERT_EQ(replay.receive_from(sender_endpoint, error), nullptr);
+  ASSERT_EQ(error, ecaludp::Error::END_OF_FILE);
+
+  std::remove(file_path.c_str());
+}
+
+// Only replay the traffic to the bound endpoint
+TEST(PcapReplayTest, BindFiltersDestination)
+{
+  const asio::ip::udp::endpoint other_destination(destination_endpoint.address(), 14001);
+
+  auto packets       = create_packets("Wrong port", 1448, source_endpoint, other_destination,    start_time, true);
+  auto right_packets = create_packets("Right port", 1448, source_endpoint, destination_endpoint, start_time, true);
+  packets.insert(packets.end(), right_packets.begin(), right_packets.end());
+
+  const auto file_path = temp_file_path("bind.pcap");
+  write_pcap_file(file_path, packets, false);
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+  replay.bind(asio::ip::udp::endpoint(asio::ip::address_v4::any(), destination_endpoint.port()));
+
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+
+  asio::ip::udp::endpoint sender_endpoint;
+  auto message = replay.receive_from(sender_endpoint, error);
+  ASSERT_NE(message, nullptr) << error.ToString();
+  ASSERT_EQ(std::string(static_cast<const char*>(message->data()), message->size()), "Right port");
+
+  ASSERT_EQ(replay.receive_from(sender_endpoint, error), nullptr);
+  ASSERT_EQ(error, ecaludp::Error::END_OF_FILE);
+
+  std::remove(file_path.c_str());
+}
+
+// The max reassembly age is applied to the recorded time, not to the replay time
+TEST(PcapReplayTest, MaxReassemblyAgeUsesRecordedTime)
+{
+  std::string message_to_send(300, 'x');
+
+  auto packets = create_packets(message_to_send, 100, source_endpoint, destination_endpoint, start_time, true);
+  ASSERT_GT(packets.size(), 2);
+
+  // The last fragment arrives 10 seconds after the others
+  packets.back().timestamp_ += std::chrono::seconds(10);
+
+  const auto file_path = temp_file_path("max_age.pcap");
+  write_pcap_file(file_path, packets, false);
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  asio::ip::udp::endpoint sender_endpoint;
+
+  // With the default age of 5 seconds, the message has been dropped
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+  ASSERT_EQ(replay.receive_from(sender_endpoint, error), nullptr);
+  ASSERT_EQ(error, ecaludp::Error::END_OF_FILE);
+
+  // With an age of 20 seconds it is complete
+  replay.set_max_reassembly_age(std::chrono::seconds(20));
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+  auto message = replay.receive_from(sender_endpoint, error);
+  ASSERT_NE(message, nullptr) << error.ToString();
+  ASSERT_EQ(message->size(), message_to_send.size());
+
+  std::remove(file_path.c_str());
+}
+
+// Replay the messages with the recorded timing
+TEST(PcapReplayTest, RecordedTiming)
+{
+  auto packets        = create_packets("First",  1448, source_endpoint, destination_endpoint, start_time, true);
+  auto second_packets = create_packets("Second", 1448, source_endpoint, destination_endpoint, start_time + std::chrono::milliseconds(200), true);
+  packets.insert(packets.end(), second_packets.begin(), second_packets.end());
+
+  const auto file_path = temp_file_path("timing.pcap");
+  write_pcap_file(file_path, packets, false);
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+  replay.set_timing(ecaludp::PcapReplay::Timing::RECORDED);
+
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+
+  asio::ip::udp::endpoint sender_endpoint;
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_NE(replay.receive_from(sender_endpoint, error), nullptr) << error.ToString();
+  ASSERT_NE(replay.receive_from(sender_endpoint, error), nullptr) << error.ToString();
+  ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+
+  std::remove(file_path.c_str());
+}
+
+// Files that are neither pcap nor pcapng are rejected
+TEST(PcapReplayTest, InvalidFile)
+{
+  const auto file_path = temp_file_path("invalid.pcap");
+  {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    file << "This is not a capture file";
+  }
+
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+
+  ecaludp::Error error = ecaludp::Error::OK;
+  ASSERT_FALSE(replay.open(file_path, error));
+  ASSERT_NE(error, ecaludp::Error::OK);
+  ASSERT_FALSE(replay.is_open());
+
+  ASSERT_FALSE(replay.open(temp_file_path("does_not_exist.pcap"), error));
+  ASSERT_NE(error, ecaludp::Error::OK);
+
+  std::remove(file_path.c_str());
+}
+
+// Record the received datagrams and replay the recording
+TEST(PcapReplayTest, SocketRecordAndReplay)
+{
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const std::string file_path = ::testing::TempDir() + "ecaludp_record_and_replay.pcap";
+
+  std::vector<std::string> messages_to_send { "Hello World!", std::string(1024 * 64, 'a') };
+  std::generate(messages_to_send[1].begin(), messages_to_send[1].end(), []() { return static_cast<char>(std::rand()); });
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket and start recording
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+
+    ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+    ASSERT_TRUE(rcv_socket.start_recording(file_path, error)) << error.ToString();
+    ASSERT_TRUE(rcv_socket.is_recording());
+  }
+
+  // Send the messages. They are buffered by the receive socket.
+  send_socket.open(destination.protocol());
+  for (const auto& message : messages_to_send)
+  {
+    asio::error_code ec;
+    send_socket.send_to(asio::buffer(message), destination, 0, ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Receive the messages
+  asio::ip::udp::endpoint received_sender_endpoint;
+  for (const auto& message : messages_to_send)
+  {
+    asio::error_code ec;
+    auto received_buffer = rcv_socket.receive_from(received_sender_endpoint, 0, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::string(static_cast<const char*>(received_buffer->data()), received_buffer->size()), message);
+  }
+
+  ASSERT_EQ(rcv_socket.get_recording_dropped_datagrams(), 0);
+  rcv_socket.stop_recording();
+  ASSERT_FALSE(rcv_socket.is_recording());
+
+  // Replay the recording
+  ecaludp::PcapReplay replay({'E', 'C', 'A', 'L'});
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+  ASSERT_TRUE(replay.open(file_path, error)) << error.ToString();
+
+  for (const auto& message : messages_to_send)
+  {
+    asio::ip::udp::endpoint sender_endpoint;
+    auto replayed_buffer = replay.receive_from(sender_endpoint, error);
+    ASSERT_NE(replayed_buffer, nullptr) << error.ToString();
+    ASSERT_EQ(std::string(static_cast<const char*>(replayed_buffer->data()), replayed_buffer->size()), message);
+    ASSERT_EQ(sender_endpoint, received_sender_endpoint);
+  }
+
+  {
+    asio::ip::udp::endpoint sender_endpoint;
+    ASSERT_EQ(replay.receive_from(sender_endpoint, error), nullptr);
+    ASSERT_EQ(error, ecaludp::Error::END_OF_FILE);
+  }
+
+  replay.close();
+  std::remove(file_path.c_str());
+
+  {
+    asio::error_code ec;
+    send_socket.close(ec);
+    rcv_socket.close(ec);
+  }
+}
@@ -0,0 +1,755 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/error.h>
+#include <ecaludp/partial_message.h>
+#include <ecaludp/reassembly_limits.h>
+
+#include <memory_datagram_source.h>
+#include <protocol/datagram_builder_v5.h>
+#include <protocol/datagram_description.h>
+#include <protocol/header_v5.h>
+#include <protocol/portable_endian.h>
+#include <receive_engine.h>
+
+namespace
+{
+  // Returns the raw bytes of a datagram
+  std::vector<char> to_bytes(const ecaludp::DatagramDescription& datagram)
+  {
+    std::vector<char> data;
+    for (const auto& buffer : datagram.asio_buffer_list_)
+      data.insert(data.end(), static_cast<const char*>(buffer.data()), static_cast<const char*>(buffer.data()) + buffer.size());
+    return data;
+  }
+
+  // Overwrites the fragment count and message size of a raw fragment info datagram
+  void set_fragment_info(std::vector<char>& fragment_info, uint32_t num, uint32_t len)
+  {
+    ecaludp::v5::Header header{};
+    std::memcpy(&header, fragment_info.data(), sizeof(header));
+    header.num = htole32(num);
+    header.len = htole32(len);
+    std::memcpy(fragment_info.data(), &header, sizeof(header));
+  }
+
+  // Adds the datagrams of a message to the source
+  void add_message(ecaludp::MemoryDatagramSource& source
+                  , const std::string& message
+                  , std::size_t max_datagram_size
+                  , const asio::ip::udp::endpoint& sender_endpoint
+                  , bool reversed = false)
+  {
+    auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, max_datagram_size, {'E', 'C', 'A', 'L'});
+    if (reversed)
+      std::reverse(datagram_list.begin(), datagram_list.end());
+
+    for (const auto& datagram : datagram_list)
+    {
+      const std::vector<char> data = to_bytes(datagram);
+      source.add_datagram(data.data(), data.size(), sender_endpoint);
+    }
+  }
+
+  std::string to_string(const std::shared_ptr<ecaludp::OwningBuffer>& message)
+  {
+    return std::string(static_cast<const char*>(message->data()), message->size());
+  }
+
+  // Hands the next count datagrams of the source to the engine and returns the last result
+  std::shared_ptr<ecaludp::OwningBuffer> hand_in(ecaludp::ReceiveEngine& engine, ecaludp::MemoryDatagramSource& source, std::size_t count, ecaludp::Error& error)
+  {
+    std::shared_ptr<ecaludp::OwningBuffer> message;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      ecaludp::ReceivedDatagram datagram;
+      if (!source(datagram, error))
+        return nullptr;
+      message = engine.handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, error);
+    }
+    return message;
+  }
+
+  const asio::ip::udp::endpoint sender_endpoint_1(asio::ip::make_address("192.168.0.1"), 5000);
+  const asio::ip::udp::endpoint sender_endpoint_2(asio::ip::make_address("192.168.0.2"), 5000);
+}
+
+// Interleaved fragments of two senders are reassembled, malformed datagrams are skipped
+TEST(ReceiveEngineTest, MemorySourceInterleavedSenders)
+{
+  ecaludp::MemoryDatagramSource source_1;
+  ecaludp::MemoryDatagramSource source_2;
+  const std::string message_1(5000, 'a');
+  const std::string message_2(3000, 'b');
+  add_message(source_1, message_1, 1000, sender_endpoint_1);
+  add_message(source_2, message_2, 1000, sender_endpoint_2, true);
+
+  // Interleave both sources and put some garbage in between
+  ecaludp::MemoryDatagramSource source;
+  const std::string garbage = "garbage";
+  for (std::size_t i = 0; i < std::max(source_1.size(), source_2.size()); ++i)
+  {
+    ecaludp::ReceivedDatagram datagram;
+    ecaludp::Error error = ecaludp::Error::OK;
+    if (source_1(datagram, error))
+      source.add_datagram(datagram.data_, datagram.size_, *datagram.sender_endpoint_);
+    if (source_2(datagram, error))
+      source.add_datagram(datagram.data_, datagram.size_, *datagram.sender_endpoint_);
+    source.add_datagram(garbage.data(), garbage.size(), sender_endpoint_1);
+  }
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  asio::ip::udp::endpoint sender_endpoint;
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+
+  // The reversed message is complete first, as it is shorter
+  auto message = engine.receive_from(source, sender_endpoint, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_FALSE(error);
+  EXPECT_EQ(to_string(message), message_2);
+  EXPECT_EQ(sender_endpoint, sender_endpoint_2);
+
+  message = engine.receive_from(source, sender_endpoint, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(to_string(message), message_1);
+  EXPECT_EQ(sender_endpoint, sender_endpoint_1);
+
+  message = engine.receive_from(source, sender_endpoint, error);
+  EXPECT_EQ(message, nullptr);
+  EXPECT_EQ(error, ecaludp::Error::END_OF_FILE);
+
+  // The same datagrams can be handed out again
+  source.rewind();
+  for (int i = 0; i < 2; ++i)
+  {
+    message = engine.receive_from(source, sender_endpoint, error);
+    ASSERT_NE(message, nullptr);
+  }
+}
+
+// Non-fragmented messages only point to the datagram, unless copying is enabled
+TEST(ReceiveEngineTest, CopyNonFragmentedMessages)
+{
+  ecaludp::MemoryDatagramSource source;
+  add_message(source, "Hello World", 1448, sender_endpoint_1);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  asio::ip::udp::endpoint sender_endpoint;
+  ecaludp::Error error = ecaludp::Error::GENERIC_ERROR;
+
+  ecaludp::ReceivedDatagram datagram;
+  ASSERT_TRUE(source(datagram, error));
+  auto message = engine.handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(to_string(message), "Hello World");
+  EXPECT_GE(message->data(), datagram.data_);
+  EXPECT_LT(message->data(), static_cast<const char*>(datagram.data_) + datagram.size_);
+
+  engine.set_copy_non_fragmented_messages(true);
+  message = engine.handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(to_string(message), "Hello World");
+  EXPECT_TRUE((message->data() < datagram.data_) || (message->data() >= static_cast<const char*>(datagram.data_) + datagram.size_));
+}
+
+// Incomplete messages are dropped based on the clock of the engine
+TEST(ReceiveEngineTest, MaxReassemblyAgeUsesClock)
+{
+  ecaludp::MemoryDatagramSource source;
+  add_message(source, std::string(3000, 'a'), 1000, sender_endpoint_1);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  engine.set_max_reassembly_age(std::chrono::seconds(1));
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  std::vector<ecaludp::ReceivedDatagram> datagrams(source.size());
+  ecaludp::Error error = ecaludp::Error::OK;
+  for (auto& datagram : datagrams)
+    ASSERT_TRUE(source(datagram, error));
+
+  // Hand in all but the last datagram, then let the time pass
+  for (std::size_t i = 0; i + 1 < datagrams.size(); ++i)
+    EXPECT_EQ(engine.handle_datagram(datagrams[i].data_, datagrams[i].size_, datagrams[i].owner_, datagrams[i].sender_endpoint_, error), nullptr);
+
+  now += std::chrono::seconds(2);
+  EXPECT_EQ(engine.handle_datagram(datagrams.back().data_, datagrams.back().size_, datagrams.back().owner_, datagrams.back().sender_endpoint_, error), nullptr);
+
+  // Within the max age, the message is complete. The last datagram has
+  // started a new incomplete message, which is dropped first.
+  engine.drop_incomplete_messages();
+  for (std::size_t i = 0; i + 1 < datagrams.size(); ++i)
+    engine.handle_datagram(datagrams[i].data_, datagrams[i].size_, datagrams[i].owner_, datagrams[i].sender_endpoint_, error);
+  auto message = engine.handle_datagram(datagrams.back().data_, datagrams.back().size_, datagrams.back().owner_, datagrams.back().sender_endpoint_, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(message->size(), 3000);
+
+  // Dropped incomplete messages are not completed anymore
+  for (std::size_t i = 0; i + 1 < datagrams.size(); ++i)
+    engine.handle_datagram(datagrams[i].data_, datagrams[i].size_, datagrams[i].owner_, datagrams[i].sender_endpoint_, error);
+  engine.drop_incomplete_messages();
+  EXPECT_EQ(engine.handle_datagram(datagrams.back().data_, datagrams.back().size_, datagrams.back().owner_, datagrams.back().sender_endpoint_, error), nullptr);
+}
+
+// The snapshot shows the state of all incomplete messages
+TEST(ReceiveEngineTest, ReassemblySnapshot)
+{
+  ecaludp::MemoryDatagramSource source_1;
+  ecaludp::MemoryDatagramSource source_2;
+  add_message(source_1, std::string(5000, 'a'), 1000, sender_endpoint_1);
+  add_message(source_2, std::string(3000, 'b'), 1000, sender_endpoint_2, true);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  EXPECT_TRUE(engine.get_reassembly_snapshot().empty());
+
+  // Sender 1: fragment info and the first two fragments
+  ecaludp::Error error = ecaludp::Error::OK;
+  for (int i = 0; i < 3; ++i)
+  {
+    ecaludp::ReceivedDatagram datagram;
+    ASSERT_TRUE(source_1(datagram, error));
+    EXPECT_EQ(engine.handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, error), nullptr);
+  }
+
+  now += std::chrono::milliseconds(500);
+
+  // Sender 2: only the last fragment, so the fragment info is still missing
+  {
+    ecaludp::ReceivedDatagram datagram;
+    ASSERT_TRUE(source_2(datagram, error));
+    EXPECT_EQ(engine.handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, error), nullptr);
+  }
+
+  auto snapshot = engine.get_reassembly_snapshot();
+  ASSERT_EQ(snapshot.size(), 2);
+  std::sort(snapshot.begin(), snapshot.end(), [](const ecaludp::IncompleteMessage& lhs, const ecaludp::IncompleteMessage& rhs) { return lhs.sender_endpoint < rhs.sender_endpoint; });
+
+  EXPECT_EQ(snapshot[0].sender_endpoint,    sender_endpoint_1);
+  EXPECT_EQ(snapshot[0].received_fragments, 2);
+  EXPECT_GT(snapshot[0].total_fragments,    2);
+  EXPECT_EQ(snapshot[0].total_size_bytes,   5000);
+  EXPECT_EQ(snapshot[0].age,                std::chrono::milliseconds(500));
+
+  EXPECT_EQ(snapshot[1].sender_endpoint,    sender_endpoint_2);
+  EXPECT_EQ(snapshot[1].received_fragments, 1);
+  EXPECT_EQ(snapshot[1].total_fragments,    0);
+  EXPECT_EQ(snapshot[1].total_size_bytes,   0);
+  EXPECT_EQ(snapshot[1].age,                std::chrono::milliseconds(0));
+
+  EXPECT_EQ(snapshot[0].buffered_bytes + snapshot[1].buffered_bytes, engine.get_reassembly_buffered_bytes());
+
+  engine.drop_incomplete_messages();
+  EXPECT_TRUE(engine.get_reassembly_snapshot().empty());
+}
+
+// Exceeding the max buffered bytes evicts the least recently used message
+TEST(ReceiveEngineTest, ReassemblyLimitsEvictLeastRecentlyUsed)
+{
+  // 5000 bytes are 5 full fragments of 976 bytes and one with 120 bytes
+  ecaludp::MemoryDatagramSource source_a;
+  ecaludp::MemoryDatagramSource source_b;
+  add_message(source_a, std::string(5000, 'a'), 1000, sender_endpoint_1);
+  add_message(source_b, std::string(5000, 'b'), 1000, sender_endpoint_2);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  ecaludp::ReassemblyLimits limits;
+  limits.max_buffered_bytes = 6000;
+  engine.set_reassembly_limits(limits);
+
+  // Fragment info + 3 fragments of a, then fragment info + 4 fragments of b
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source_a, 4, error), nullptr);
+  now += std::chrono::milliseconds(1);
+  EXPECT_EQ(hand_in(engine, source_b, 5, error), nullptr);
+  EXPECT_FALSE(error);
+
+  auto snapshot = engine.get_reassembly_snapshot();
+  ASSERT_EQ(snapshot.size(), 1);
+  EXPECT_EQ(snapshot[0].sender_endpoint, sender_endpoint_2);
+  EXPECT_LE(engine.get_reassembly_buffered_bytes(), limits.max_buffered_bytes);
+
+  auto counters = engine.get_reassembly_eviction_counters();
+  EXPECT_EQ(counters.evicted_messages,  1U);
+  EXPECT_EQ(counters.evicted_bytes,     3U * 976U);
+  EXPECT_EQ(counters.rejected_messages, 0U);
+
+  // The remaining fragments of the evicted message are dropped
+  EXPECT_EQ(hand_in(engine, source_a, 1, error), nullptr);
+  EXPECT_EQ(error, ecaludp::Error::REASSEMBLY_LIMIT_EXCEEDED);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 1);
+
+  // The other message fits into the limit
+  auto message = hand_in(engine, source_b, 2, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(to_string(message), std::string(5000, 'b'));
+}
+
+// The per-sender limit only evicts messages of that sender, the largest one first
+TEST(ReceiveEngineTest, ReassemblyLimitsEvictLargestPerSender)
+{
+  ecaludp::MemoryDatagramSource source_a;
+  ecaludp::MemoryDatagramSource source_b;
+  ecaludp::MemoryDatagramSource source_c;
+  add_message(source_a, std::string(5000, 'a'), 1000, sender_endpoint_1);
+  add_message(source_b, std::string(5000, 'b'), 1000, sender_endpoint_2);
+  add_message(source_c, std::string(5000, 'c'), 1000, sender_endpoint_1);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+
+  ecaludp::ReassemblyLimits limits;
+  limits.max_buffered_bytes_per_sender = 4000;
+  limits.eviction_policy               = ecaludp::ReassemblyEvictionPolicy::LARGEST_FIRST;
+  engine.set_reassembly_limits(limits);
+
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source_a, 4, error), nullptr);   // 2928 bytes
+  EXPECT_EQ(hand_in(engine, source_b, 5, error), nullptr);   // 3904 bytes of the other sender
+  EXPECT_EQ(hand_in(engine, source_c, 2, error), nullptr);   //  976 bytes
+  EXPECT_EQ(engine.get_incomplete_message_count(), 3);
+
+  // The second fragment of c exceeds the limit of sender 1
+  EXPECT_EQ(hand_in(engine, source_c, 1, error), nullptr);
+  EXPECT_FALSE(error);
+
+  auto snapshot = engine.get_reassembly_snapshot();
+  ASSERT_EQ(snapshot.size(), 2);
+  for (const auto& incomplete_message : snapshot)
+    EXPECT_EQ(incomplete_message.buffered_bytes, (incomplete_message.sender_endpoint == sender_endpoint_1 ? 2U * 976U : 4U * 976U));
+
+  auto counters = engine.get_reassembly_eviction_counters();
+  EXPECT_EQ(counters.evicted_messages, 1U);
+  EXPECT_EQ(counters.evicted_bytes,    3U * 976U);
+}
+
+// Messages larger than the max message size are dropped, with or without fragment info
+TEST(ReceiveEngineTest, ReassemblyLimitsMaxMessageSize)
+{
+  ecaludp::MemoryDatagramSource source_a;
+  ecaludp::MemoryDatagramSource source_b;
+  ecaludp::MemoryDatagramSource source_c;
+  add_message(source_a, std::string(5000, 'a'), 1000, sender_endpoint_1);
+  add_message(source_b, std::string(3000, 'b'), 1000, sender_endpoint_1);
+  add_message(source_c, std::string(5000, 'c'), 1000, sender_endpoint_2, true);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+
+  ecaludp::ReassemblyLimits limits;
+  limits.max_message_size = 4000;
+  engine.set_reassembly_limits(limits);
+
+  // The fragment info already tells that a is too large
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source_a, 1, error), nullptr);
+  EXPECT_EQ(error, ecaludp::Error::REASSEMBLY_LIMIT_EXCEEDED);
+  EXPECT_EQ(hand_in(engine, source_a, source_a.size() - 1, error), nullptr);
+  EXPECT_EQ(error, ecaludp::Error::REASSEMBLY_LIMIT_EXCEEDED);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+
+  // Smaller messages still work
+  auto message = hand_in(engine, source_b, source_b.size(), error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(message->size(), 3000);
+
+  // Reversed, the fragment info comes last. The 5th fragment exceeds the max message size.
+  EXPECT_EQ(hand_in(engine, source_c, 4, error), nullptr);
+  EXPECT_FALSE(error);
+  EXPECT_EQ(hand_in(engine, source_c, 1, error), nullptr);
+  EXPECT_EQ(error, ecaludp::Error::REASSEMBLY_LIMIT_EXCEEDED);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+
+  EXPECT_EQ(engine.get_reassembly_eviction_counters().rejected_messages, 2U);
+}
+
+// A fragment info must not announce more fragments than bytes. A fragment info
+// that announces fewer fragments than already received drops the others.
+TEST(ReceiveEngineTest, ReassemblyBogusFragmentCount)
+{
+  const std::string message(5000, 'a');
+  auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, 1000, {'E', 'C', 'A', 'L'});
+  ASSERT_EQ(datagram_list.size(), 7);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  ecaludp::Error error = ecaludp::Error::OK;
+
+  // 4 billion fragments for 5000 bytes
+  {
+    auto fragment_info = to_bytes(datagram_list[0]);
+    set_fragment_info(fragment_info, 0xFFFFFFFF, 5000);
+    ecaludp::MemoryDatagramSource fragment_info_source;
+    fragment_info_source.add_datagram(fragment_info.data(), fragment_info.size(), sender_endpoint_1);
+    EXPECT_EQ(hand_in(engine, fragment_info_source, 1, error), nullptr);
+    EXPECT_EQ(error, ecaludp::Error::MALFORMED_DATAGRAM);
+    EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+  }
+
+  // 4 billion fragments for 4 billion bytes, without any reassembly limits
+  {
+    auto fragment_info = to_bytes(datagram_list[0]);
+    set_fragment_info(fragment_info, 0xFFFFFFFF, 0xFFFFFFFF);
+    ecaludp::MemoryDatagramSource fragment_info_source;
+    fragment_info_source.add_datagram(fragment_info.data(), fragment_info.size(), sender_endpoint_1);
+    EXPECT_EQ(hand_in(engine, fragment_info_source, 1, error), nullptr);
+    EXPECT_EQ(error, ecaludp::Error::MALFORMED_DATAGRAM);
+    EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+  }
+
+  // A fragment with a huge fragment number
+  {
+    auto fragment = to_bytes(datagram_list[1]);
+    set_fragment_info(fragment, 0xFFFFFFFF, static_cast<uint32_t>(fragment.size() - sizeof(ecaludp::v5::Header)));
+    ecaludp::MemoryDatagramSource fragment_source;
+    fragment_source.add_datagram(fragment.data(), fragment.size(), sender_endpoint_1);
+    EXPECT_EQ(hand_in(engine, fragment_source, 1, error), nullptr);
+    EXPECT_EQ(error, ecaludp::Error::MALFORMED_DATAGRAM);
+    EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+  }
+
+  // The malformed datagrams did not discard the package, so the valid
+  // datagrams of it are still reassembled
+  {
+    ecaludp::MemoryDatagramSource valid_source;
+    for (const auto& datagram : datagram_list)
+    {
+      const std::vector<char> data = to_bytes(datagram);
+      valid_source.add_datagram(data.data(), data.size(), sender_endpoint_1);
+    }
+    auto valid_message = hand_in(engine, valid_source, valid_source.size(), error);
+    ASSERT_NE(valid_message, nullptr);
+    EXPECT_FALSE(error);
+    EXPECT_EQ(to_string(valid_message), message);
+  }
+
+  // All 6 fragments arrive before a fragment info that only announces 3 of
+  // them. The message is then complete with the first 3 fragments.
+  ecaludp::MemoryDatagramSource source;
+  for (std::size_t i = 1; i < datagram_list.size(); ++i)
+  {
+    const std::vector<char> data = to_bytes(datagram_list[i]);
+    source.add_datagram(data.data(), data.size(), sender_endpoint_2);
+  }
+  EXPECT_EQ(hand_in(engine, source, source.size(), error), nullptr);
+  EXPECT_EQ(engine.get_reassembly_buffered_bytes(), 5000);
+
+  {
+    auto fragment_info = to_bytes(datagram_list[0]);
+    set_fragment_info(fragment_info, 3, 3 * 976);
+    ecaludp::MemoryDatagramSource fragment_info_source;
+    fragment_info_source.add_datagram(fragment_info.data(), fragment_info.size(), sender_endpoint_2);
+    auto truncated_message = hand_in(engine, fragment_info_source, 1, error);
+    ASSERT_NE(truncated_message, nullptr);
+    EXPECT_EQ(to_string(truncated_message), message.substr(0, 3 * 976));
+  }
+
+  EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+  EXPECT_EQ(engine.get_reassembly_buffered_bytes(), 0);
+}
+
+// A completed message abandons the older incomplete messages of the same sender
+TEST(ReceiveEngineTest, AbandonSupersededMessages)
+{
+  ecaludp::MemoryDatagramSource source_a;
+  ecaludp::MemoryDatagramSource source_b;
+  ecaludp::MemoryDatagramSource source_c;
+  ecaludp::MemoryDatagramSource source_d;
+  add_message(source_a, std::string(5000, 'a'), 1000, sender_endpoint_1);
+  add_message(source_b, std::string(3000, 'b'), 1000, sender_endpoint_1);
+  add_message(source_c, std::string(5000, 'c'), 1000, sender_endpoint_2);
+  add_message(source_d, std::string(3000, 'd'), 1000, sender_endpoint_2);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+
+  ecaludp::ReassemblyLimits limits;
+  limits.abandon_superseded_messages = true;
+  engine.set_reassembly_limits(limits);
+
+  // a lost its remaining fragments, then b has been sent completely
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source_a, 3, error), nullptr);
+  EXPECT_NE(hand_in(engine, source_b, source_b.size(), error), nullptr);
+
+  auto counters = engine.get_reassembly_eviction_counters();
+  EXPECT_EQ(counters.abandoned_messages, 1U);
+  EXPECT_EQ(counters.abandoned_bytes,    2U * 976U);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+
+  // Interleaved messages are not abandoned
+  EXPECT_EQ(hand_in(engine, source_c, 2, error), nullptr);
+  EXPECT_EQ(hand_in(engine, source_d, 2, error), nullptr);
+  EXPECT_EQ(hand_in(engine, source_c, 1, error), nullptr);
+  EXPECT_NE(hand_in(engine, source_d, source_d.size() - 2, error), nullptr);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 1);
+
+  auto message = hand_in(engine, source_c, source_c.size() - 3, error);
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(to_string(message), std::string(5000, 'c'));
+  EXPECT_EQ(engine.get_reassembly_eviction_counters().abandoned_messages, 1U);
+}
+
+// A message that misses a fragment for too long is abandoned
+TEST(ReceiveEngineTest, AbandonMessagesWithFragmentGap)
+{
+  ecaludp::MemoryDatagramSource source_a;
+  ecaludp::MemoryDatagramSource source_b;
+  add_message(source_a, std::string(5000, 'a'), 1000, sender_endpoint_1);
+  add_message(source_b, std::string(5000, 'b'), 1000, sender_endpoint_2);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  ecaludp::ReassemblyLimits limits;
+  limits.max_fragment_gap_age = std::chrono::milliseconds(100);
+  engine.set_reassembly_limits(limits);
+
+  // Fragment info and fragment 0 of a, then fragment 1 is lost
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source_a, 2, error), nullptr);
+  {
+    ecaludp::ReceivedDatagram lost_datagram;
+    ASSERT_TRUE(source_a(lost_datagram, error));
+  }
+  EXPECT_EQ(hand_in(engine, source_a, 1, error), nullptr);
+
+  // b has no gap, so it survives
+  EXPECT_EQ(hand_in(engine, source_b, 2, error), nullptr);
+
+  now += std::chrono::milliseconds(50);
+  EXPECT_EQ(hand_in(engine, source_a, 1, error), nullptr);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 2);
+
+  now += std::chrono::milliseconds(100);
+  EXPECT_EQ(hand_in(engine, source_b, 1, error), nullptr);
+
+  auto snapshot = engine.get_reassembly_snapshot();
+  ASSERT_EQ(snapshot.size(), 1);
+  EXPECT_EQ(snapshot[0].sender_endpoint, sender_endpoint_2);
+
+  auto counters = engine.get_reassembly_eviction_counters();
+  EXPECT_EQ(counters.abandoned_messages, 1U);
+  EXPECT_EQ(counters.abandoned_bytes,    3U * 976U);
+
+  // The remaining fragments of a are dropped
+  EXPECT_EQ(hand_in(engine, source_a, 1, error), nullptr);
+  EXPECT_EQ(error, ecaludp::Error::REASSEMBLY_LIMIT_EXCEEDED);
+}
+
+// Expired and evicted messages are delivered with zeros for the missing fragments
+TEST(ReceiveEngineTest, PartialMessageDelivery)
+{
+  std::string payload_a;
+  for (int i = 0; i < 5000; ++i)
+    payload_a.push_back(static_cast<char>('a' + (i % 26)));
+
+  ecaludp::MemoryDatagramSource source_a;
+  ecaludp::MemoryDatagramSource source_b;
+  ecaludp::MemoryDatagramSource source_c;
+  add_message(source_a, payload_a,              1000, sender_endpoint_1);
+  add_message(source_b, std::string(5000, 'b'), 1000, sender_endpoint_2);
+  add_message(source_c, std::string(5000, 'c'), 1000, sender_endpoint_2, true);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  engine.set_max_reassembly_age(std::chrono::seconds(1));
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  std::vector<ecaludp::PartialMessage> partial_messages;
+  engine.set_partial_message_callback([&partial_messages](const ecaludp::PartialMessage& partial_message) { partial_messages.push_back(partial_message); });
+
+  // Fragment 1 and 4 of a are lost
+  ecaludp::Error error = ecaludp::Error::OK;
+  std::vector<bool> received_fragments_a;
+  {
+    ecaludp::ReceivedDatagram fragment_info;
+    ASSERT_TRUE(source_a(fragment_info, error));
+    engine.handle_datagram(fragment_info.data_, fragment_info.size_, fragment_info.owner_, fragment_info.sender_endpoint_, error);
+  }
+  for (std::size_t i = 0; i + 1 < source_a.size(); ++i)
+  {
+    ecaludp::ReceivedDatagram datagram;
+    ASSERT_TRUE(source_a(datagram, error));
+    received_fragments_a.push_back((i != 1) && (i != 4));
+    if (received_fragments_a.back())
+      engine.handle_datagram(datagram.data_, datagram.size_, datagram.owner_, datagram.sender_endpoint_, error);
+  }
+
+  // c has no fragment info, so it cannot be delivered
+  EXPECT_EQ(hand_in(engine, source_c, 2, error), nullptr);
+
+  now += std::chrono::seconds(2);
+  EXPECT_EQ(hand_in(engine, source_b, 2, error), nullptr);
+
+  ASSERT_EQ(partial_messages.size(), 1);
+  const auto& partial_a = partial_messages[0];
+  EXPECT_EQ(partial_a.sender_endpoint,    sender_endpoint_1);
+  EXPECT_EQ(partial_a.reason,             ecaludp::PartialMessageReason::EXPIRED);
+  EXPECT_EQ(partial_a.fragment_size,      976);
+  EXPECT_EQ(partial_a.received_fragments, received_fragments_a);
+  ASSERT_EQ(partial_a.payload->size(),    payload_a.size());
+
+  const std::string partial_payload_a = to_string(partial_a.payload);
+  for (std::size_t i = 0; i < received_fragments_a.size(); ++i)
+  {
+    const std::size_t offset = i * partial_a.fragment_size;
+    const std::size_t length = std::min(partial_a.fragment_size, payload_a.size() - offset);
+    const std::string expected = (received_fragments_a[i] ? payload_a.substr(offset, length) : std::string(length, '\0'));
+    EXPECT_EQ(partial_payload_a.substr(offset, length), expected);
+  }
+
+  // Evicted messages are delivered, too
+  ecaludp::ReassemblyLimits limits;
+  limits.max_buffered_bytes = 1000;
+  engine.set_reassembly_limits(limits);
+  EXPECT_EQ(hand_in(engine, source_b, 1, error), nullptr);
+
+  ASSERT_EQ(partial_messages.size(), 2);
+  EXPECT_EQ(partial_messages[1].sender_endpoint,    sender_endpoint_2);
+  EXPECT_EQ(partial_messages[1].reason,             ecaludp::PartialMessageReason::EVICTED);
+  EXPECT_EQ(partial_messages[1].received_fragments, std::vector<bool>({true, true, false, false, false, false}));
+  EXPECT_EQ(to_string(partial_messages[1].payload), std::string(2 * 976, 'b') + std::string(5000 - 2 * 976, '\0'));
+
+  // Dropping the incomplete messages does not deliver them
+  limits.max_buffered_bytes = 0;
+  engine.set_reassembly_limits(limits);
+  EXPECT_EQ(hand_in(engine, source_a, 1, error), nullptr);
+  engine.drop_incomplete_messages();
+  EXPECT_EQ(partial_messages.size(), 2);
+}
+
+// Fragments that have been dropped by a fragment info announcing fewer
+// fragments must not end up in a partial message
+TEST(ReceiveEngineTest, PartialMessageDeliveryAfterTruncatingFragmentInfo)
+{
+  const std::string message(5000, 'a');
+  auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, 1000, {'E', 'C', 'A', 'L'});
+  ASSERT_EQ(datagram_list.size(), 7);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  engine.set_max_reassembly_age(std::chrono::seconds(1));
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  std::vector<ecaludp::PartialMessage> partial_messages;
+  engine.set_partial_message_callback([&partial_messages](const ecaludp::PartialMessage& partial_message) { partial_messages.push_back(partial_message); });
+
+  // Only the last 2 fragments arrive, followed by a fragment info that only
+  // announces the first 3 fragments
+  ecaludp::MemoryDatagramSource source;
+  for (std::size_t i = 5; i < datagram_list.size(); ++i)
+  {
+    const std::vector<char> data = to_bytes(datagram_list[i]);
+    source.add_datagram(data.data(), data.size(), sender_endpoint_1);
+  }
+
+  auto fragment_info = to_bytes(datagram_list[0]);
+  set_fragment_info(fragment_info, 3, 3 * 976);
+  source.add_datagram(fragment_info.data(), fragment_info.size(), sender_endpoint_1);
+
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source, source.size(), error), nullptr);
+  EXPECT_FALSE(error);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 1);
+  EXPECT_EQ(engine.get_reassembly_buffered_bytes(), 0);
+
+  // The expired message has no fragments left, so nothing is delivered
+  now += std::chrono::seconds(2);
+  ecaludp::MemoryDatagramSource source_b;
+  add_message(source_b, std::string(5000, 'b'), 1000, sender_endpoint_2);
+  EXPECT_EQ(hand_in(engine, source_b, 1, error), nullptr);
+
+  EXPECT_EQ(engine.get_incomplete_message_count(), 1);
+  EXPECT_TRUE(partial_messages.empty());
+}
+
+// A fragment info with a message size that does not fit the fragment count
+// must not make the partial message delivery allocate that size
+TEST(ReceiveEngineTest, PartialMessageDeliveryOversizedFragmentInfo)
+{
+  const std::string message(5000, 'a');
+  auto datagram_list = ecaludp::v5::create_datagram_list({asio::buffer(message)}, 1000, {'E', 'C', 'A', 'L'});
+  ASSERT_EQ(datagram_list.size(), 7);
+
+  ecaludp::ReceiveEngine engine({'E', 'C', 'A', 'L'});
+  engine.set_max_reassembly_age(std::chrono::seconds(1));
+
+  std::chrono::steady_clock::time_point now(std::chrono::hours(1));
+  engine.set_clock([&now]() { return now; });
+
+  std::vector<ecaludp::PartialMessage> partial_messages;
+  engine.set_partial_message_callback([&partial_messages](const ecaludp::PartialMessage& partial_message) { partial_messages.push_back(partial_message); });
+
+  // 2 fragments for 4 GiB. Only the first fragment arrives, which matches
+  // that fragment info, as it is not the last fragment.
+  ecaludp::MemoryDatagramSource source;
+
+  auto fragment_info = to_bytes(datagram_list[0]);
+  set_fragment_info(fragment_info, 2, 0xFFFFFFFF);
+  source.add_datagram(fragment_info.data(), fragment_info.size(), sender_endpoint_1);
+
+  const std::vector<char> first_fragment = to_bytes(datagram_list[1]);
+  source.add_datagram(first_fragment.data(), first_fragment.size(), sender_endpoint_1);
+
+  ecaludp::Error error = ecaludp::Error::OK;
+  EXPECT_EQ(hand_in(engine, source, source.size(), error), nullptr);
+  EXPECT_FALSE(error);
+  EXPECT_EQ(engine.get_incomplete_message_count(), 1);
+
+  // The expired message cannot be delivered, as the fragments don't fit the message size
+  now += std::chrono::seconds(2);
+  ecaludp::MemoryDatagramSource source_b;
+  add_message(source_b, std::string(5000, 'b'), 1000, sender_endpoint_2);
+  EXPECT_EQ(hand_in(engine, source_b, 1, error), nullptr);
+
+  EXPECT_EQ(engine.get_incomplete_message_count(), 1);
+  EXPECT_TRUE(partial_messages.empty());
+
+  // The same applies to evicted messages
+  ecaludp::MemoryDatagramSource source_c;
+  add_message(source_c, std::string(5000, 'c'), 1000, sender_endpoint_1);
+  EXPECT_EQ(hand_in(engine, source_c, 2, error), nullptr);
+
+  ecaludp::ReassemblyLimits limits;
+  limits.max_buffered_bytes = 500;
+  engine.set_reassembly_limits(limits);
+  EXPECT_EQ(hand_in(engine, source_b, 1, error), nullptr);
+
+  EXPECT_EQ(engine.get_incomplete_message_count(), 0);
+  for (const auto& partial_message : partial_messages)
+    EXPECT_LE(partial_message.payload->size(), 5000U);
+}
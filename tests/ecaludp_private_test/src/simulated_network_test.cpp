@@ -0,0 +1,170 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <ecaludp/error.h>
+#include <ecaludp_testsupport/simulated_network.h>
+
+namespace
+{
+  const asio::ip::udp::endpoint sender_endpoint_1(asio::ip::make_address("192.168.0.1"), 5000);
+
+  // Sends the messages 1ms apart and receives everything afterwards.
+  // Returns the received messages.
+  std::vector<std::string> send_and_receive(ecaludp::SimulatedNetwork& network, std::size_t message_count, std::size_t message_size)
+  {
+    for (std::size_t i = 0; i < message_count; ++i)
+    {
+      std::string message(message_size, static_cast<char>('a' + (i % 26)));
+      message.replace(0, std::min(message_size, std::to_string(i).size()), std::to_string(i).substr(0, message_size));
+      network.send(asio::buffer(message), sender_endpoint_1);
+      network.advance_time(std::chrono::milliseconds(1));
+    }
+
+    std::vector<std::string> received_messages;
+    asio::ip::udp::endpoint sender_endpoint;
+    ecaludp::Error error = ecaludp::Error::OK;
+    while (auto message = network.receive_from(sender_endpoint, error))
+    {
+      EXPECT_EQ(sender_endpoint, sender_endpoint_1);
+      received_messages.emplace_back(static_cast<const char*>(message->data()), message->size());
+    }
+    EXPECT_EQ(error, ecaludp::Error::NO_PENDING_DATAGRAMS);
+
+    return received_messages;
+  }
+}
+
+// Without impairment, all messages arrive in order
+TEST(SimulatedNetworkTest, NoImpairment)
+{
+  ecaludp::SimulatedNetwork network({'E', 'C', 'A', 'L'}, 1);
+  network.set_max_udp_datagram_size(1000);
+
+  const auto received_messages = send_and_receive(network, 100, 5000);
+  ASSERT_EQ(received_messages.size(), 100);
+  for (std::size_t i = 0; i < received_messages.size(); ++i)
+    EXPECT_EQ(received_messages[i].substr(0, std::to_string(i).size()), std::to_string(i));
+
+  const auto statistics = network.get_statistics();
+  EXPECT_EQ(statistics.messages_sent,       100);
+  EXPECT_EQ(statistics.messages_received,   100);
+  EXPECT_EQ(statistics.datagrams_lost,      0);
+  EXPECT_EQ(statistics.datagrams_delivered, statistics.datagrams_sent);
+  EXPECT_EQ(statistics.max_incomplete_messages, 1);
+  EXPECT_EQ(network.get_time(), std::chrono::milliseconds(100));
+}
+
+// The same seed leads to the same result, a different seed doesn't
+TEST(SimulatedNetworkTest, Deterministic)
+{
+  ecaludp::SimulatedNetwork::Impairment impairment;
+  impairment.loss_probability        = 0.01;
+  impairment.burst_loss_probability  = 0.005;
+  impairment.burst_loss_length       = 10;
+  impairment.reorder_window          = 8;
+  impairment.duplication_probability = 0.01;
+  impairment.jitter                  = std::chrono::microseconds(500);
+
+  std::vector<std::vector<std::string>>              results;
+  std::vector<ecaludp::SimulatedNetwork::Statistics> statistics;
+  for (const uint64_t seed : {42, 42, 43})
+  {
+    ecaludp::SimulatedNetwork network({'E', 'C', 'A', 'L'}, seed);
+    network.set_max_udp_datagram_size(1000);
+    network.set_impairment(impairment);
+
+    results.push_back(send_and_receive(network, 200, 3000));
+    statistics.push_back(network.get_statistics());
+  }
+
+  EXPECT_EQ(results[0], results[1]);
+  EXPECT_EQ(statistics[0].datagrams_lost,       statistics[1].datagrams_lost);
+  EXPECT_EQ(statistics[0].datagrams_duplicated, statistics[1].datagrams_duplicated);
+  EXPECT_GT(statistics[0].datagrams_lost, 0);
+  EXPECT_LT(results[0].size(), 200);
+
+  EXPECT_NE(statistics[0].datagrams_lost, statistics[2].datagrams_lost);
+}
+
+// Reordering and jitter don't lose messages, the order of the messages changes
+TEST(SimulatedNetworkTest, ReorderAndJitter)
+{
+  ecaludp::SimulatedNetwork::Impairment impairment;
+  impairment.reorder_window = 16;
+  impairment.delay          = std::chrono::milliseconds(10);
+  impairment.jitter         = std::chrono::milliseconds(5);
+
+  ecaludp::SimulatedNetwork network({'E', 'C', 'A', 'L'}, 7);
+  network.set_max_udp_datagram_size(1000);
+  network.set_impairment(impairment);
+
+  const auto received_messages = send_and_receive(network, 100, 2500);
+  ASSERT_EQ(received_messages.size(), 100);
+
+  bool reordered = false;
+  for (std::size_t i = 0; i < received_messages.size(); ++i)
+    reordered = reordered || (received_messages[i].substr(0, std::to_string(i).size()) != std::to_string(i));
+  EXPECT_TRUE(reordered);
+
+  EXPECT_GT(network.get_statistics().max_incomplete_messages, 1);
+  EXPECT_GE(network.get_time(), std::chrono::milliseconds(110));
+}
+
+// Fragments of messages that lost a datagram are held until the max reassembly age
+TEST(SimulatedNetworkTest, BurstLossHoldsFragments)
+{
+  ecaludp::SimulatedNetwork::Impairment impairment;
+  impairment.burst_loss_probability = 0.05;
+  impairment.burst_loss_length      = 5;
+
+  std::vector<std::size_t> max_buffered_bytes;
+  for (const auto max_reassembly_age : {std::chrono::milliseconds(10), std::chrono::milliseconds(1000)})
+  {
+    ecaludp::SimulatedNetwork network({'E', 'C', 'A', 'L'}, 3);
+    network.set_max_udp_datagram_size(1000);
+    network.set_max_reassembly_age(max_reassembly_age);
+    network.set_impairment(impairment);
+
+    // Receive while sending, so the reassembly sees the time pass
+    asio::ip::udp::endpoint sender_endpoint;
+    ecaludp::Error error = ecaludp::Error::OK;
+    const std::string message(10000, 'x');
+    for (int i = 0; i < 500; ++i)
+    {
+      network.send(asio::buffer(message), sender_endpoint_1);
+      network.advance_time(std::chrono::milliseconds(1));
+      while (network.receive_from(sender_endpoint, error) != nullptr) {}
+    }
+
+    const auto statistics = network.get_statistics();
+    EXPECT_GT(statistics.datagrams_lost, 0);
+    EXPECT_LT(statistics.messages_received, 500);
+    max_buffered_bytes.push_back(statistics.max_reassembly_buffered_bytes);
+  }
+
+  // The longer the fragments are kept, the more memory they hold
+  EXPECT_GT(max_buffered_bytes[1], 10 * max_buffered_bytes[0]);
+}
@@ -0,0 +1,374 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <asio.hpp>
+
+#include <ecaludp/socket.h>
+#include <ecaludp/socket_shm.h>
+
+#include "atomic_signalable.h"
+
+TEST(EcalUdpShmSocket, RAII_unbound)
+{
+  asio::io_context io_context;
+
+  // Create the socket and destroy it
+  ecaludp::SocketShm socket(io_context, {'E', 'C', 'A', 'L'});
+}
+
+TEST(EcalUdpShmSocket, RAII_close_while_receiving)
+{
+  atomic_signalable<int> aborted_receives(0);
+
+  asio::io_context io_context;
+
+  ecaludp::SocketShm receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+
+  auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &aborted_receives](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        ASSERT_EQ(buffer, nullptr);
+                                        ASSERT_EQ(ec, asio::error::operation_aborted);
+                                        aborted_receives++;
+                                      });
+
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  receiver_socket.close();
+
+  aborted_receives.wait_for([](int value) { return value == 1; }, std::chrono::milliseconds(500));
+  ASSERT_EQ(aborted_receives, 1);
+
+  io_thread.join();
+}
+
+TEST(EcalUdpShmSocket, AsyncHelloWorldMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::SocketShm sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketShm receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open the sender_socket
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Open and bind the receiver_socket
+  {
+    asio::error_code ec;
+    receiver_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+    receiver_socket.bind(destination, ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>("Hello World!");
+
+  // Wait for the next message
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        // No error
+                                        ASSERT_EQ(ec, asio::error_code());
+
+                                        // compare the messages
+                                        std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                        ASSERT_EQ(received_string, *message_to_send);
+
+                                        // increment
+                                        received_messages++;
+                                      });
+
+  // Send a message
+  sender_socket.async_send_to(asio::buffer(*message_to_send)
+                            , destination
+                            , [message_to_send](asio::error_code ec)
+                              {
+                                // No error
+                                ASSERT_EQ(ec, asio::error_code());
+                              });
+
+  // Wait for the message to be received
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(500));
+
+  ASSERT_EQ(received_messages, 1);
+
+  // The message must have taken the shared memory path. The sender has been
+  // bound implicitly and is reported with its actual port.
+  ASSERT_TRUE(sender_socket.is_shm_channel_open(destination));
+  ASSERT_EQ(sender_endpoint->address(), asio::ip::address_v4::loopback());
+  ASSERT_EQ(sender_endpoint->port(), sender_socket.local_endpoint().port());
+
+  work.reset();
+  receiver_socket.close();
+  sender_socket.close();
+  io_thread.join();
+}
+
+TEST(EcalUdpShmSocket, BigMessage)
+{
+  constexpr std::size_t message_size = 16 * 1024 * 1024;
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::SocketShm sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketShm receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  sender_socket.open(asio::ip::udp::v4());
+
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.bind(destination);
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>(message_size, 'a');
+  for (std::size_t i = 0; i < message_to_send->size(); ++i)
+    (*message_to_send)[i] = static_cast<char>('a' + (i % 26));
+
+  // Wait for the next message
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        // No error
+                                        ASSERT_EQ(ec, asio::error_code());
+
+                                        // compare the messages
+                                        std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                        ASSERT_EQ(received_string, *message_to_send);
+
+                                        // increment
+                                        received_messages++;
+                                      });
+
+  // Send the message synchronously. It is sent as a whole, without any
+  // fragmentation.
+  {
+    asio::error_code ec;
+    const std::size_t bytes_sent = sender_socket.send_to(asio::buffer(*message_to_send), destination, 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+    ASSERT_EQ(bytes_sent, message_size);
+  }
+
+  // Wait for the message to be received
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(1000));
+
+  ASSERT_EQ(received_messages, 1);
+  ASSERT_TRUE(sender_socket.is_shm_channel_open(destination));
+
+  work.reset();
+  receiver_socket.close();
+  sender_socket.close();
+  io_thread.join();
+}
+
+TEST(EcalUdpShmSocket, AsyncManyMessagesRingWrap)
+{
+  constexpr int         num_messages       = 2000;
+  constexpr int         max_messages_ahead = 100;
+  constexpr std::size_t message_size       = 1000;
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  ecaludp::SocketShm sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketShm receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // A small ring, so it wraps around many times
+  sender_socket.set_shm_buffer_size(256 * 1024);
+  sender_socket.open(asio::ip::udp::v4());
+
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.bind(destination);
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  // Receive all messages and check that they arrive in order
+  auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)> receive_handler
+        = [&receive_handler, &receiver_socket, sender_endpoint, &received_messages, message_size](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+          {
+            if (ec)
+              return;
+
+            ASSERT_EQ(buffer->size(), message_size);
+
+            const std::string received_string(static_cast<const char*>(buffer->data()));
+            ASSERT_EQ(received_string, std::to_string(received_messages.get()));
+
+            received_messages++;
+            receiver_socket.async_receive_from(*sender_endpoint, receive_handler);
+          };
+  receiver_socket.async_receive_from(*sender_endpoint, receive_handler);
+
+  for (int i = 0; i < num_messages; ++i)
+  {
+    // Don't overrun the receiver, as the ring would drop the messages
+    received_messages.wait_for([i](int received_messages) { return i - received_messages < max_messages_ahead; }, std::chrono::milliseconds(1000));
+
+    std::string message = std::to_string(i);
+    message.resize(message_size, '\0');
+
+    asio::error_code ec;
+    const std::size_t bytes_sent = sender_socket.send_to(asio::buffer(message), destination, 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+    ASSERT_EQ(bytes_sent, message_size);
+  }
+
+  received_messages.wait_for([](int received_messages) { return received_messages == num_messages; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages, num_messages);
+  ASSERT_TRUE(sender_socket.is_shm_channel_open(destination));
+
+  work.reset();
+  receiver_socket.close();
+  sender_socket.close();
+  io_thread.join();
+}
+
+TEST(EcalUdpShmSocket, FallbackToUdp)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // A regular ecaludp socket doesn't offer a shared memory channel, so the
+  // message must be sent via UDP
+  ecaludp::SocketShm sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket    receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  sender_socket.open(asio::ip::udp::v4());
+
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.bind(destination);
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  auto message_to_send = std::make_shared<std::string>("Hello World!");
+
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        ASSERT_EQ(ec, asio::error_code());
+
+                                        std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                        ASSERT_EQ(received_string, *message_to_send);
+
+                                        received_messages++;
+                                      });
+
+  {
+    asio::error_code ec;
+    sender_socket.send_to(asio::buffer(*message_to_send), destination, 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(500));
+
+  ASSERT_EQ(received_messages, 1);
+  ASSERT_FALSE(sender_socket.is_shm_channel_open(destination));
+
+  work.reset();
+  receiver_socket.close();
+  sender_socket.close();
+  io_thread.join();
+}
+
+TEST(EcalUdpShmSocket, ReconnectToNewReceiver)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  ecaludp::SocketShm sender_socket(io_context, {'E', 'C', 'A', 'L'});
+  sender_socket.open(asio::ip::udp::v4());
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  // Send one message to two receivers that are bound to the same endpoint
+  // one after another
+  for (int i = 0; i < 2; ++i)
+  {
+    ecaludp::SocketShm receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+    receiver_socket.open(asio::ip::udp::v4());
+    receiver_socket.bind(destination);
+
+    auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+    receiver_socket.async_receive_from(*sender_endpoint
+                                      , [sender_endpoint, &received_messages](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                        {
+                                          if (ec)
+                                            return;
+
+                                          ASSERT_EQ(std::string(static_cast<const char*>(buffer->data()), buffer->size()), "Hello World!");
+                                          received_messages++;
+                                        });
+
+    asio::error_code ec;
+    sender_socket.send_to(asio::buffer(std::string("Hello World!")), destination, 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+
+    received_messages.wait_for([i](int received_messages) { return received_messages == i + 1; }, std::chrono::milliseconds(500));
+    ASSERT_EQ(received_messages, i + 1);
+    ASSERT_TRUE(sender_socket.is_shm_channel_open(destination));
+
+    receiver_socket.close();
+
+    // The sender notices that the receiver is gone
+    ASSERT_FALSE(sender_socket.is_shm_channel_open(destination));
+  }
+
+  work.reset();
+  sender_socket.close();
+  io_thread.join();
+}
@@ -23,11 +23,15 @@
 #include "atomic_signalable.h"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 // Cancel a pending async receive
 TEST(EcalUdpSocket, CancelAsyncReceive)
@@ -478,3 +482,1069 @@ TEST(EcalUdpSocket, SyncBigMessage)
 
   rcv_thread.join();
 }
+
+// Send a big message with UDP GSO enabled. If the kernel doesn't support GSO,
+// the socket falls back to the regular send path, so the test always works.
+TEST(EcalUdpSocket, SyncGsoBigMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  // Create a send and recieve socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+    
+  // Create the message to send and fill it with random characters
+  std::string message_to_send(1024 * 256 + 17, 'a'); // The last fragment is smaller than the others
+  std::generate(message_to_send.begin(), message_to_send.end(), []() { return static_cast<char>(std::rand()); });
+
+  // Create a thread that will receive a message
+  std::thread rcv_thread([&rcv_socket, &message_to_send, &received_messages]()
+                          {
+                            // Open the socket
+                            {
+                              asio::error_code ec;
+                              rcv_socket.open(asio::ip::udp::v4(), ec);
+                              ASSERT_FALSE(ec);
+                            }
+      
+                            // Bind the socket
+                            {
+                              asio::error_code ec;
+                              rcv_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+                              ASSERT_FALSE(ec);
+                            }
+
+                            // Set a big receive buffer size, so we will not lose incoming fragments
+                            {
+                              asio::error_code ec;
+                              rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+                              ASSERT_FALSE(ec);
+                            }
+      
+                            asio::ip::udp::endpoint sender_endpoint;
+      
+                            // Receive a message
+                            asio::error_code ec;
+                            auto received_buffer = rcv_socket.receive_from(sender_endpoint, 0, ec);
+
+                            received_messages++;
+      
+                            ASSERT_FALSE(ec);
+
+                            // compare the messages
+                            std::string received_string(static_cast<const char*>(received_buffer->data()), received_buffer->size());
+                            ASSERT_EQ(received_string, message_to_send);
+                          });
+
+  // Wait 10 milliseconds to make sure that the receiver is ready
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  // Create destination endpoint
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+  send_socket.open(destination.protocol());
+
+  // Set a big send buffer size, so we will not lose outgoing fragments
+  {
+    asio::error_code ec;
+    send_socket.set_option(asio::socket_base::send_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  send_socket.set_udp_gso_enabled(true);
+  ASSERT_TRUE(send_socket.is_udp_gso_enabled());
+
+  // Send a message
+  {
+    asio::error_code ec;
+    const std::size_t bytes_sent = send_socket.send_to(asio::buffer(message_to_send), destination, 0, ec);
+    if (ec)
+      std::cerr << ec.message() << '\n';
+    ASSERT_FALSE(ec);
+
+    // The message plus one 24 byte v5 header for each fragment and the fragment info
+    const std::size_t payload_per_fragment = send_socket.get_max_udp_datagram_size() - 24;
+    const std::size_t fragment_count       = (message_to_send.size() + payload_per_fragment - 1) / payload_per_fragment;
+    ASSERT_EQ(bytes_sent, message_to_send.size() + (fragment_count + 1) * 24);
+  }
+
+  // Wait up to 1 second for the message to be received
+  received_messages.wait_for([](int v) { return v == 1; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.get(), 1);
+
+  // Close the sockets
+  {
+    asio::error_code ec;
+    send_socket.shutdown(asio::socket_base::shutdown_both, ec);
+    rcv_socket.shutdown(asio::socket_base::shutdown_both, ec);
+    send_socket.close(ec);
+    rcv_socket.close(ec);
+  }
+
+  rcv_thread.join();
+}
+
+#ifdef __linux__
+// Send big messages with UDP GSO enabled on a socket that has UDP checksums
+// disabled. The kernel refuses to segment messages without checksums, so the
+// socket must fall back to the regular send path without sending anything
+// twice.
+TEST(EcalUdpSocket, SyncGsoRejectedFallback)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  // Create a send and recieve socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket and disable UDP checksums, which makes the kernel reject GSO
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    send_socket.set_option(asio::socket_base::send_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+    send_socket.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_NO_CHECK>(true), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  send_socket.set_udp_gso_enabled(true);
+
+  // Create the message to send and fill it with random characters
+  std::string message_to_send(1024 * 128 + 17, 'a');
+  std::generate(message_to_send.begin(), message_to_send.end(), []() { return static_cast<char>(std::rand()); });
+
+  constexpr int num_messages = 2;
+
+  std::thread rcv_thread([&rcv_socket, &message_to_send, &received_messages]()
+                          {
+                            for (int i = 0; i < num_messages; i++)
+                            {
+                              asio::ip::udp::endpoint sender_endpoint;
+                              asio::error_code ec;
+                              auto received_buffer = rcv_socket.receive_from(sender_endpoint, 0, ec);
+
+                              ASSERT_FALSE(ec);
+
+                              // compare the messages
+                              std::string received_string(static_cast<const char*>(received_buffer->data()), received_buffer->size());
+                              ASSERT_EQ(received_string, message_to_send);
+
+                              received_messages++;
+                            }
+                          });
+
+  // The first message detects the rejection, the second one directly uses
+  // the regular send path
+  for (int i = 0; i < num_messages; i++)
+  {
+    asio::error_code ec;
+    const std::size_t bytes_sent = send_socket.send_to(asio::buffer(message_to_send), destination, 0, ec);
+    ASSERT_FALSE(ec);
+
+    // The message plus one 24 byte v5 header for each fragment and the
+    // fragment info. Nothing must have been sent twice.
+    const std::size_t payload_per_fragment = send_socket.get_max_udp_datagram_size() - 24;
+    const std::size_t fragment_count       = (message_to_send.size() + payload_per_fragment - 1) / payload_per_fragment;
+    ASSERT_EQ(bytes_sent, message_to_send.size() + (fragment_count + 1) * 24);
+  }
+
+  // Wait up to 1 second for the messages to be received
+  received_messages.wait_for([](int v) { return v == num_messages; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.get(), num_messages);
+
+  rcv_thread.join();
+}
+#endif // __linux__
+
+// Receive multiple big messages with UDP GRO enabled. The messages are sent
+// with UDP GSO, so on loopback the receiver gets coalesced buffers containing
+// many fragments. Without kernel support, both sockets fall back to the
+// regular paths.
+TEST(EcalUdpSocket, SyncGroBigMessages)
+{
+  constexpr int message_count = 3;
+
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  // Create a send and recieve socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  send_socket.set_udp_gso_enabled(true);
+  rcv_socket.set_udp_gro_enabled(true);
+  ASSERT_TRUE(rcv_socket.is_udp_gro_enabled());
+
+  // Create the messages to send and fill them with random characters
+  std::vector<std::string> messages_to_send;
+  for (int i = 0; i < message_count; i++)
+  {
+    messages_to_send.emplace_back(1024 * 100 + i, 'a');
+    std::generate(messages_to_send.back().begin(), messages_to_send.back().end(), []() { return static_cast<char>(std::rand()); });
+  }
+
+  // Open the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Bind the socket
+  {
+    asio::error_code ec;
+    rcv_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Set a big receive buffer size, so we will not lose incoming fragments
+  {
+    asio::error_code ec;
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Create a thread that will receive the messages
+  std::thread rcv_thread([&rcv_socket, &messages_to_send, &received_messages]()
+                          {
+                            for (const auto& message_to_send : messages_to_send)
+                            {
+                              asio::ip::udp::endpoint sender_endpoint;
+
+                              // Receive a message
+                              asio::error_code ec;
+                              auto received_buffer = rcv_socket.receive_from(sender_endpoint, 0, ec);
+
+                              ASSERT_FALSE(ec);
+                              ASSERT_NE(received_buffer, nullptr);
+
+                              // compare the messages
+                              std::string received_string(static_cast<const char*>(received_buffer->data()), received_buffer->size());
+                              ASSERT_EQ(received_string, message_to_send);
+
+                              received_messages++;
+                            }
+                          });
+
+  // Wait 10 milliseconds to make sure that the receiver is ready
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  // Create destination endpoint
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+  send_socket.open(destination.protocol());
+
+  // Set a big send buffer size, so we will not lose outgoing fragments
+  {
+    asio::error_code ec;
+    send_socket.set_option(asio::socket_base::send_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Send the messages
+  for (const auto& message_to_send : messages_to_send)
+  {
+    asio::error_code ec;
+    send_socket.send_to(asio::buffer(message_to_send), destination, 0, ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Wait up to 1 second for the messages to be received
+  received_messages.wait_for([](int v) { return v == message_count; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.get(), message_count);
+
+  // Close the sockets
+  {
+    asio::error_code ec;
+    send_socket.shutdown(asio::socket_base::shutdown_both, ec);
+    rcv_socket.shutdown(asio::socket_base::shutdown_both, ec);
+    send_socket.close(ec);
+    rcv_socket.close(ec);
+  }
+
+  rcv_thread.join();
+}
+
+// Receive multiple big messages with UDP GRO enabled using the async API
+TEST(EcalUdpSocket, AsyncGroBigMessages)
+{
+  constexpr int message_count = 3;
+
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create a send and recieve socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  send_socket.set_udp_gso_enabled(true);
+  rcv_socket.set_udp_gro_enabled(true);
+
+  // Create the messages to send and fill them with random characters
+  std::vector<std::string> messages_to_send;
+  for (int i = 0; i < message_count; i++)
+  {
+    messages_to_send.emplace_back(1024 * 100 + i, 'a');
+    std::generate(messages_to_send.back().begin(), messages_to_send.back().end(), []() { return static_cast<char>(std::rand()); });
+  }
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  // Receive the messages one after another
+  asio::ip::udp::endpoint sender_endpoint;
+  std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)> receive_handler
+              = [&](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                {
+                  ASSERT_FALSE(ec);
+
+                  // compare the messages
+                  const std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                  ASSERT_EQ(received_string, messages_to_send[static_cast<size_t>(received_messages.get())]);
+
+                  received_messages++;
+
+                  if (received_messages.get() < message_count)
+                    rcv_socket.async_receive_from(sender_endpoint, receive_handler);
+                };
+
+  rcv_socket.async_receive_from(sender_endpoint, receive_handler);
+
+  // Send the messages
+  {
+    const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+    send_socket.open(destination.protocol());
+
+    asio::error_code ec;
+    send_socket.set_option(asio::socket_base::send_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+
+    for (const auto& message_to_send : messages_to_send)
+    {
+      send_socket.send_to(asio::buffer(message_to_send), destination, 0, ec);
+      ASSERT_FALSE(ec);
+    }
+  }
+
+  // Wait for the messages to be received
+  received_messages.wait_for([](int v) { return v == message_count; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages.get(), message_count);
+
+  work.reset();
+  io_thread.join();
+}
+
+// Send one fragmented message to multiple destinations using the async API
+TEST(EcalUdpSocket, AsyncFanOutMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create one send and two receive sockets
+  ecaludp::Socket send_socket (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket_1(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket_2(io_context, {'E', 'C', 'A', 'L'});
+
+  const std::vector<asio::ip::udp::endpoint> destinations{ asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)
+                                                         , asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14001) };
+
+  // Open and bind the receive sockets
+  {
+    asio::error_code ec;
+    rcv_socket_1.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket_1.bind(destinations[0], ec);
+    ASSERT_FALSE(ec);
+
+    rcv_socket_2.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket_2.bind(destinations[1], ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>(1024 * 64, 'a');
+  std::generate(message_to_send->begin(), message_to_send->end(), []() { return static_cast<char>(std::rand()); });
+
+  auto receive_handler = [&received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                          {
+                            // No error
+                            if (ec)
+                            {
+                              FAIL();
+                            }
+
+                            // compare the messages
+                            std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                            ASSERT_EQ(received_string, *message_to_send);
+
+                            // increment
+                            received_messages++;
+                          };
+
+  asio::ip::udp::endpoint sender_endpoint_1;
+  asio::ip::udp::endpoint sender_endpoint_2;
+  rcv_socket_1.async_receive_from(sender_endpoint_1, receive_handler);
+  rcv_socket_2.async_receive_from(sender_endpoint_2, receive_handler);
+
+  // Send the message to both receivers
+  send_socket.async_send_to(asio::buffer(*message_to_send)
+                            , destinations
+                            , [message_to_send](asio::error_code ec)
+                              {
+                                // No error
+                                ASSERT_EQ(ec, asio::error_code());
+                              });
+
+  // Wait for the message to be received by both receivers
+  received_messages.wait_for([](int received_messages) { return received_messages == 2; }, std::chrono::milliseconds(1000));
+
+  ASSERT_EQ(received_messages, 2);
+
+  work.reset();
+  io_thread.join();
+}
+
+// Send one fragmented message to multiple destinations using the sync API (sendmmsg on Linux)
+TEST(EcalUdpSocket, SyncFanOutMessage)
+{
+  constexpr std::size_t num_receivers = 3;
+
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  std::vector<std::unique_ptr<ecaludp::Socket>> rcv_sockets;
+  std::vector<asio::ip::udp::endpoint>          destinations;
+
+  // Open and bind the receive sockets before sending, so no datagram is lost
+  for (std::size_t i = 0; i < num_receivers; ++i)
+  {
+    destinations.emplace_back(asio::ip::address_v4::loopback(), static_cast<unsigned short>(14000 + i));
+    rcv_sockets.push_back(std::make_unique<ecaludp::Socket>(io_context, std::array<char, 4>{'E', 'C', 'A', 'L'}));
+
+    asio::error_code ec;
+    rcv_sockets.back()->open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_sockets.back()->bind(destinations.back(), ec);
+    ASSERT_FALSE(ec);
+    rcv_sockets.back()->set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Large enough to be fragmented into many datagrams
+  std::string message_to_send(1024 * 128, 'a');
+  std::generate(message_to_send.begin(), message_to_send.end(), []() { return static_cast<char>(std::rand()); });
+
+  std::vector<std::thread> rcv_threads;
+  for (const auto& rcv_socket : rcv_sockets)
+  {
+    rcv_threads.emplace_back([&rcv_socket, &message_to_send, &received_messages]()
+                              {
+                                asio::ip::udp::endpoint sender_endpoint;
+                                asio::error_code ec;
+                                auto received_buffer = rcv_socket->receive_from(sender_endpoint, 0, ec);
+
+                                ASSERT_FALSE(ec);
+
+                                // compare the messages
+                                std::string received_string(static_cast<const char*>(received_buffer->data()), received_buffer->size());
+                                ASSERT_EQ(received_string, message_to_send);
+
+                                received_messages++;
+                              });
+  }
+
+  // Open the send socket with a big send buffer, so we will not lose outgoing fragments
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    send_socket.set_option(asio::socket_base::send_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Send the message to all receivers with one call
+  {
+    asio::error_code ec;
+    const std::size_t bytes_sent = send_socket.send_to(asio::buffer(message_to_send), destinations, 0, ec);
+    ASSERT_FALSE(ec);
+
+    // Each receiver gets the entire message plus the headers
+    ASSERT_GT(bytes_sent, num_receivers * message_to_send.size());
+  }
+
+  // Wait up to 1 second for the message to be received by all receivers
+  received_messages.wait_for([](int v) { return v == static_cast<int>(num_receivers); }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages, static_cast<int>(num_receivers));
+
+  for (auto& rcv_thread : rcv_threads)
+    rcv_thread.join();
+}
+
+// The async completion handler reports the bytes and datagrams that actually
+// went over the wire, which must match what the sync API reports.
+TEST(EcalUdpSocket, AsyncSendReportsBytesAndDatagrams)
+{
+  asio::io_context io_context;
+
+  ecaludp::Socket send_socket (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket_1(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket_2(io_context, {'E', 'C', 'A', 'L'});
+
+  const std::vector<asio::ip::udp::endpoint> destinations{ asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)
+                                                         , asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14001) };
+
+  // Open and bind the receive sockets, so the datagrams have somewhere to go
+  {
+    asio::error_code ec;
+    rcv_socket_1.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket_1.bind(destinations[0], ec);
+    ASSERT_FALSE(ec);
+
+    rcv_socket_2.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket_2.bind(destinations[1], ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+  send_socket.set_max_udp_datagram_size(1448);
+
+  const std::string message_to_send(10000, 'a');
+
+  // The sync API tells us how many bytes the fragmented message takes
+  std::size_t expected_bytes = 0;
+  {
+    asio::error_code ec;
+    expected_bytes = send_socket.send_to(asio::buffer(message_to_send), destinations, 0, ec);
+    ASSERT_FALSE(ec);
+  }
+
+  std::size_t bytes_sent     = 0;
+  std::size_t datagrams_sent = 0;
+
+  send_socket.async_send_to(asio::buffer(message_to_send)
+                            , destinations
+                            , [&bytes_sent, &datagrams_sent](asio::error_code ec, std::size_t bytes, std::size_t datagrams)
+                              {
+                                ASSERT_EQ(ec, asio::error_code());
+                                bytes_sent     = bytes;
+                                datagrams_sent = datagrams;
+                              });
+
+  io_context.run();
+
+  // 10000 bytes don't fit into less than 7 fragments of 1448 bytes
+  ASSERT_EQ(bytes_sent, expected_bytes);
+  ASSERT_GT(bytes_sent, 2 * message_to_send.size());
+  ASSERT_GE(datagrams_sent, 2 * 7);
+  ASSERT_EQ(datagrams_sent % 2, 0);
+}
+
+// Queue many messages at once and check that they are completed and received in order
+TEST(EcalUdpSocket, AsyncSendQueueOrder)
+{
+  constexpr int num_messages = 100;
+
+  atomic_signalable<int> sent_messages(0);
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create a send and receive socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Only send few datagrams at once, so the queue is actually used
+  send_socket.set_max_datagrams_in_flight(4);
+
+  // Create the messages. Each message is fragmented into multiple datagrams.
+  std::vector<std::shared_ptr<std::string>> messages;
+  for (int i = 0; i < num_messages; ++i)
+  {
+    messages.push_back(std::make_shared<std::string>(4000, static_cast<char>('a' + (i % 26))));
+  }
+
+  // Receive all messages and check the order
+  std::function<void()> receive_next;
+  asio::ip::udp::endpoint sender_endpoint;
+  receive_next = [&]()
+                {
+                  rcv_socket.async_receive_from(sender_endpoint
+                                              , [&](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                                {
+                                                  if (ec)
+                                                    return;
+
+                                                  std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                                  EXPECT_EQ(received_string, *messages[received_messages.get()]);
+                                                  received_messages++;
+
+                                                  if (received_messages.get() < num_messages)
+                                                    receive_next();
+                                                });
+                };
+  receive_next();
+
+  // Queue all messages at once
+  for (int i = 0; i < num_messages; ++i)
+  {
+    send_socket.async_send_to(asio::buffer(*messages[i])
+                              , destination
+                              , [i, &sent_messages](asio::error_code ec)
+                                {
+                                  EXPECT_FALSE(ec);
+
+                                  // The completion handlers must be called in order
+                                  EXPECT_EQ(sent_messages.get(), i);
+                                  sent_messages++;
+                                });
+  }
+
+  EXPECT_GT(send_socket.get_send_queue_bytes(), 0);
+
+  // Multiple threads complete the datagrams, the handlers must still be called in order
+  std::vector<std::thread> io_threads;
+  for (int i = 0; i < 4; ++i)
+    io_threads.emplace_back([&io_context]() { io_context.run(); });
+
+  sent_messages.wait_for    ([](int v) { return v == num_messages; }, std::chrono::milliseconds(1000));
+  received_messages.wait_for([](int v) { return v == num_messages; }, std::chrono::milliseconds(1000));
+
+  ASSERT_EQ(sent_messages,     num_messages);
+  ASSERT_EQ(received_messages, num_messages);
+
+  ASSERT_EQ(send_socket.get_send_queue_bytes(),    0);
+  ASSERT_EQ(send_socket.get_send_queue_messages(), 0);
+
+  for (auto& io_thread : io_threads)
+    io_thread.join();
+}
+
+// Destroy a socket while a paced message is still being sent. The handler
+// must be called with operation_aborted and the pending operations must not
+// touch the destroyed socket anymore.
+TEST(EcalUdpSocket, AsyncSendQueueDestroyedWhileSending)
+{
+  asio::io_context io_context;
+
+  auto send_socket = std::make_unique<ecaludp::Socket>(io_context, std::array<char, 4>{'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  {
+    asio::error_code ec;
+    send_socket->open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // 64 KiB with 16 KiB/s would take seconds
+  send_socket->set_send_rate_limit(1024 * 16, 1024 * 4);
+
+  const std::string message_to_send(1024 * 64, 'a');
+
+  int              handler_calls = 0;
+  asio::error_code handler_ec;
+  send_socket->async_send_to(asio::buffer(message_to_send)
+                            , destination
+                            , [&handler_calls, &handler_ec](asio::error_code ec)
+                              {
+                                handler_calls++;
+                                handler_ec = ec;
+                              });
+
+  // Issue the first datagrams, so there are operations and a timer pending
+  io_context.poll();
+  EXPECT_EQ(handler_calls, 0);
+
+  send_socket.reset();
+  io_context.run();
+
+  EXPECT_EQ(handler_calls, 1);
+  EXPECT_EQ(handler_ec,    asio::error::operation_aborted);
+}
+
+// Send a big message with a rate limit and check that the datagrams are spread over time
+TEST(EcalUdpSocket, AsyncPacedBigMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create a send and receive socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // 256 KiB with 2 MiB/s and 16 KiB burst should take at least 110 ms
+  send_socket.set_send_rate_limit(1024 * 1024 * 2, 1024 * 16);
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>(1024 * 256, 'a');
+  std::generate(message_to_send->begin(), message_to_send->end(), []() { return static_cast<char>(std::rand()); });
+
+  asio::ip::udp::endpoint sender_endpoint;
+  rcv_socket.async_receive_from(sender_endpoint
+                              , [&received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                {
+                                  // No error
+                                  if (ec)
+                                  {
+                                    FAIL();
+                                  }
+
+                                  // compare the messages
+                                  std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                  ASSERT_EQ(received_string, *message_to_send);
+
+                                  // increment
+                                  received_messages++;
+                                });
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  send_socket.async_send_to(asio::buffer(*message_to_send)
+                            , destination
+                            , [message_to_send](asio::error_code ec)
+                              {
+                                // No error
+                                ASSERT_EQ(ec, asio::error_code());
+                              });
+
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(1000));
+
+  const auto duration = std::chrono::steady_clock::now() - start_time;
+
+  ASSERT_EQ(received_messages, 1);
+  ASSERT_GE(duration, std::chrono::milliseconds(100));
+
+  work.reset();
+  io_thread.join();
+}
+
+// Send a big message with a rate limit using the sync API. The send call must
+// block until all datagrams have been paced out.
+TEST(EcalUdpSocket, SyncPacedBigMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  // Create a send and receive socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // 256 KiB with 2 MiB/s and 16 KiB burst should take at least 110 ms
+  send_socket.set_send_rate_limit(1024 * 1024 * 2, 1024 * 16);
+
+  std::string message_to_send(1024 * 256, 'a');
+  std::generate(message_to_send.begin(), message_to_send.end(), []() { return static_cast<char>(std::rand()); });
+
+  std::thread rcv_thread([&rcv_socket, &message_to_send, &received_messages]()
+                          {
+                            asio::ip::udp::endpoint sender_endpoint;
+                            asio::error_code ec;
+                            auto received_buffer = rcv_socket.receive_from(sender_endpoint, 0, ec);
+
+                            ASSERT_FALSE(ec);
+
+                            // compare the messages
+                            std::string received_string(static_cast<const char*>(received_buffer->data()), received_buffer->size());
+                            ASSERT_EQ(received_string, message_to_send);
+
+                            received_messages++;
+                          });
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  {
+    asio::error_code ec;
+    const std::size_t bytes_sent = send_socket.send_to(asio::buffer(message_to_send), destination, 0, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_GT(bytes_sent, message_to_send.size());
+  }
+
+  const auto duration = std::chrono::steady_clock::now() - start_time;
+  ASSERT_GE(duration, std::chrono::milliseconds(100));
+
+  // As the datagrams are paced, the receiver can easily keep up
+  received_messages.wait_for([](int v) { return v == 1; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages, 1);
+
+  rcv_thread.join();
+}
+
+// Send big messages with MSG_ZEROCOPY mixed with a small regular message. The
+// completion handlers must be called in order and only after the kernel has
+// released the memory. On loopback, the kernel copies the data anyways, but
+// still sends the completion notifications.
+TEST(EcalUdpSocket, AsyncZeroCopyMessages)
+{
+  atomic_signalable<int> received_messages(0);
+  atomic_signalable<int> sent_messages(0);
+
+  asio::io_context io_context;
+
+  // Create a send and receive socket
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    send_socket.set_option(asio::socket_base::send_buffer_size(1024 * 1024 * 5), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  send_socket.set_zerocopy_threshold(1024 * 64);
+  ASSERT_EQ(send_socket.get_zerocopy_threshold(), 1024 * 64);
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  // Big, small, big
+  std::vector<std::string> messages_to_send;
+  for (const size_t size : {size_t(1024 * 256), size_t(100), size_t(1024 * 256 + 1)})
+  {
+    messages_to_send.emplace_back(size, 'a');
+    std::generate(messages_to_send.back().begin(), messages_to_send.back().end(), []() { return static_cast<char>(std::rand()); });
+  }
+
+  // Receive the messages one after another
+  asio::ip::udp::endpoint sender_endpoint;
+  std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)> receive_handler
+              = [&](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                {
+                  ASSERT_FALSE(ec);
+
+                  const std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                  ASSERT_EQ(received_string, messages_to_send[static_cast<size_t>(received_messages.get())]);
+
+                  received_messages++;
+
+                  if (received_messages.get() < static_cast<int>(messages_to_send.size()))
+                    rcv_socket.async_receive_from(sender_endpoint, receive_handler);
+                };
+
+  rcv_socket.async_receive_from(sender_endpoint, receive_handler);
+
+  for (size_t i = 0; i < messages_to_send.size(); i++)
+  {
+    send_socket.async_send_to(asio::buffer(messages_to_send[i])
+                              , destination
+                              , [i, &sent_messages](asio::error_code ec)
+                                {
+                                  ASSERT_EQ(ec, asio::error_code());
+                                  ASSERT_EQ(sent_messages.get(), static_cast<int>(i));
+                                  sent_messages++;
+                                });
+  }
+
+  sent_messages.wait_for([&messages_to_send](int v) { return v == static_cast<int>(messages_to_send.size()); }, std::chrono::milliseconds(1000));
+  received_messages.wait_for([&messages_to_send](int v) { return v == static_cast<int>(messages_to_send.size()); }, std::chrono::milliseconds(1000));
+
+  ASSERT_EQ(sent_messages.get(), static_cast<int>(messages_to_send.size()));
+  ASSERT_EQ(received_messages.get(), static_cast<int>(messages_to_send.size()));
+  ASSERT_EQ(send_socket.get_send_queue_messages(), 0);
+
+  // Closing the sockets finishes the pending error queue wait operation
+  {
+    asio::error_code ec;
+    send_socket.close(ec);
+    rcv_socket.close(ec);
+  }
+
+  work.reset();
+  io_thread.join();
+}
+
+#ifdef ECALUDP_PROFILING_ENABLED
+// Receive a fragmented message and check that all stages it went through
+// have been measured
+TEST(EcalUdpSocket, SyncReceiveProfile)
+{
+  asio::io_context io_context; // Will never be started, as we are using the sync API exclusively
+
+  ecaludp::Socket send_socket(io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::Socket rcv_socket (io_context, {'E', 'C', 'A', 'L'});
+
+  const asio::ip::udp::endpoint destination(asio::ip::address_v4::loopback(), 14000);
+
+  // Open and bind the receive socket
+  {
+    asio::error_code ec;
+    rcv_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.bind(destination, ec);
+    ASSERT_FALSE(ec);
+    rcv_socket.set_option(asio::socket_base::receive_buffer_size(1024 * 1024), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // Open the send socket
+  {
+    asio::error_code ec;
+    send_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_FALSE(ec);
+  }
+
+  // The datagrams wait in the receive buffer, so we can send first and
+  // receive afterwards from the same thread
+  const std::string message_to_send(10000, 'a');
+  {
+    asio::error_code ec;
+    send_socket.send_to(asio::buffer(message_to_send), destination, 0, ec);
+    ASSERT_FALSE(ec);
+  }
+
+  {
+    asio::ip::udp::endpoint sender_endpoint;
+    asio::error_code ec;
+    auto received_buffer = rcv_socket.receive_from(sender_endpoint, 0, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(received_buffer->size(), message_to_send.size());
+  }
+
+  const ecaludp::ReceiveProfile profile = rcv_socket.get_receive_profile();
+
+  // 10000 bytes are at least 7 fragments plus the fragment info
+  ASSERT_GE(profile[ecaludp::ReceiveStage::RECEIVE_SYSCALL]  .count, 8U);
+  ASSERT_GE(profile[ecaludp::ReceiveStage::HEADER_CHECK]     .count, 8U);
+  ASSERT_GE(profile[ecaludp::ReceiveStage::REASSEMBLY_LOOKUP].count, 8U);
+  ASSERT_EQ(profile[ecaludp::ReceiveStage::REASSEMBLY_COPY]  .count, 1U);
+  ASSERT_EQ(profile[ecaludp::ReceiveStage::POOL_RELEASE]     .count, 1U);
+  ASSERT_EQ(profile[ecaludp::ReceiveStage::USER_CALLBACK]    .count, 0U);
+  ASSERT_GT(profile.ticks_per_second, 0.0);
+
+  // The histogram must account for every sample
+  const auto& syscall_histogram = profile[ecaludp::ReceiveStage::RECEIVE_SYSCALL];
+  uint64_t bucket_sum = 0;
+  for (const auto bucket : syscall_histogram.buckets)
+    bucket_sum += bucket;
+  ASSERT_EQ(bucket_sum, syscall_histogram.count);
+  ASSERT_LE(syscall_histogram.ticks_at_percentile(50.0), syscall_histogram.ticks_at_percentile(100.0));
+
+  rcv_socket.reset_receive_profile();
+  ASSERT_EQ(rcv_socket.get_receive_profile()[ecaludp::ReceiveStage::HEADER_CHECK].count, 0U);
+}
+#endif // ECALUDP_PROFILING_ENABLED
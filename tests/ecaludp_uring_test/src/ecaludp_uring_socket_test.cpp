@@ -0,0 +1,254 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <asio.hpp>
+
+#include <ecaludp/socket.h>
+#include <ecaludp/socket_uring.h>
+
+#include "atomic_signalable.h"
+
+TEST(EcalUdpUringSocket, RAII_unbound)
+{
+  asio::io_context io_context;
+
+  // Create the socket and destroy it
+  ecaludp::SocketUring socket(io_context, {'E', 'C', 'A', 'L'});
+  ASSERT_TRUE(socket.is_valid());
+}
+
+TEST(EcalUdpUringSocket, RAII_close_while_receiving)
+{
+  atomic_signalable<int> aborted_receives(0);
+
+  asio::io_context io_context;
+
+  ecaludp::SocketUring receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+
+  auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &aborted_receives](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        ASSERT_EQ(buffer, nullptr);
+                                        ASSERT_EQ(ec, asio::error::operation_aborted);
+                                        aborted_receives++;
+                                      });
+
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  receiver_socket.close();
+
+  aborted_receives.wait_for([](int value) { return value == 1; }, std::chrono::milliseconds(500));
+  ASSERT_EQ(aborted_receives, 1);
+
+  io_thread.join();
+}
+
+TEST(EcalUdpUringSocket, AsyncHelloWorldMessage)
+{
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::SocketUring sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketUring receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  // Open the sender_socket
+  {
+    asio::error_code ec;
+    sender_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  // Open and bind the receiver_socket
+  {
+    asio::error_code ec;
+    receiver_socket.open(asio::ip::udp::v4(), ec);
+    ASSERT_EQ(ec, asio::error_code());
+    receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>("Hello World!");
+
+  // Wait for the next message
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        // No error
+                                        ASSERT_EQ(ec, asio::error_code());
+
+                                        // compare the messages
+                                        std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                        ASSERT_EQ(received_string, *message_to_send);
+
+                                        // The sender address must be known
+                                        ASSERT_EQ(sender_endpoint->address(), asio::ip::address_v4::loopback());
+
+                                        // increment
+                                        received_messages++;
+                                      });
+
+  // Send a message
+  sender_socket.async_send_to(asio::buffer(*message_to_send)
+                            , asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)
+                            , [message_to_send](asio::error_code ec)
+                              {
+                                // No error
+                                ASSERT_EQ(ec, asio::error_code());
+                              });
+
+  // Wait for the message to be received
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(500));
+
+  ASSERT_EQ(received_messages, 1);
+
+  work.reset();
+  receiver_socket.close();
+  sender_socket.close();
+  io_thread.join();
+}
+
+TEST(EcalUdpUringSocket, AsyncBigMessage)
+{
+  constexpr std::size_t message_size = 1024 * 1024;
+  atomic_signalable<int> received_messages(0);
+  atomic_signalable<int> sent_messages(0);
+
+  asio::io_context io_context;
+
+  // Create the sockets
+  ecaludp::SocketUring sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketUring receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  sender_socket.open(asio::ip::udp::v4());
+
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.set_option(asio::socket_base::receive_buffer_size(4 * 1024 * 1024));
+  receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::shared_ptr<asio::ip::udp::endpoint> sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::shared_ptr<std::string> message_to_send = std::make_shared<std::string>(message_size, 'a');
+  for (std::size_t i = 0; i < message_to_send->size(); ++i)
+    (*message_to_send)[i] = static_cast<char>('a' + (i % 26));
+
+  // Wait for the next message
+  receiver_socket.async_receive_from(*sender_endpoint
+                                    , [sender_endpoint, &received_messages, message_to_send](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+                                      {
+                                        // No error
+                                        ASSERT_EQ(ec, asio::error_code());
+
+                                        // compare the messages
+                                        std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+                                        ASSERT_EQ(received_string, *message_to_send);
+
+                                        // increment
+                                        received_messages++;
+                                      });
+
+  // Send a message
+  sender_socket.async_send_to(asio::buffer(*message_to_send)
+                            , asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000)
+                            , [message_to_send, &sent_messages](asio::error_code ec)
+                              {
+                                // No error
+                                ASSERT_EQ(ec, asio::error_code());
+                                sent_messages++;
+                              });
+
+  // Wait for the message to be sent and received
+  sent_messages    .wait_for([](int sent_messages)     { return sent_messages == 1; },     std::chrono::milliseconds(1000));
+  received_messages.wait_for([](int received_messages) { return received_messages == 1; }, std::chrono::milliseconds(1000));
+
+  ASSERT_EQ(sent_messages, 1);
+  ASSERT_EQ(received_messages, 1);
+
+  work.reset();
+  receiver_socket.close();
+  sender_socket.close();
+  io_thread.join();
+}
+
+TEST(EcalUdpUringSocket, AsyncManyMessagesFromRegularSocket)
+{
+  constexpr int num_messages = 1000;
+  atomic_signalable<int> received_messages(0);
+
+  asio::io_context io_context;
+
+  // The uring socket must be able to receive from a regular ecaludp socket
+  ecaludp::Socket      sender_socket  (io_context, {'E', 'C', 'A', 'L'});
+  ecaludp::SocketUring receiver_socket(io_context, {'E', 'C', 'A', 'L'});
+
+  sender_socket.open(asio::ip::udp::v4());
+
+  receiver_socket.open(asio::ip::udp::v4());
+  receiver_socket.set_option(asio::socket_base::receive_buffer_size(4 * 1024 * 1024));
+  receiver_socket.bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000));
+
+  auto work = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  // Receive all messages and check that they arrive in order
+  auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
+  std::function<void(const std::shared_ptr<ecaludp::OwningBuffer>&, asio::error_code)> receive_handler
+        = [&receive_handler, &receiver_socket, sender_endpoint, &received_messages](const std::shared_ptr<ecaludp::OwningBuffer>& buffer, asio::error_code ec)
+          {
+            if (ec)
+              return;
+
+            const std::string received_string(static_cast<const char*>(buffer->data()), buffer->size());
+            ASSERT_EQ(received_string, std::to_string(received_messages.get()));
+
+            received_messages++;
+            receiver_socket.async_receive_from(*sender_endpoint, receive_handler);
+          };
+  receiver_socket.async_receive_from(*sender_endpoint, receive_handler);
+
+  for (int i = 0; i < num_messages; ++i)
+  {
+    asio::error_code ec;
+    const std::string message = std::to_string(i);
+    sender_socket.send_to(asio::buffer(message), asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 14000), 0, ec);
+    ASSERT_EQ(ec, asio::error_code());
+  }
+
+  received_messages.wait_for([](int received_messages) { return received_messages == num_messages; }, std::chrono::milliseconds(1000));
+  ASSERT_EQ(received_messages, num_messages);
+
+  work.reset();
+  receiver_socket.close();
+  io_thread.join();
+}
@@ -0,0 +1,161 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+// IWYU pragma: begin_exports
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+// IWYU pragma: end_exports
+
+namespace ecaludp
+{
+  class PcapFileReader;
+  class ReceiveEngine;
+  struct ReceivedDatagram;
+
+  /**
+   * @brief Replays ecaludp traffic from a pcap or pcapng capture file
+   *
+   * The UDP datagrams of the capture are handed to the same reassembly that
+   * the sockets use, so complete messages come out of receive_from() just
+   * like from a socket. This makes it possible to benchmark and debug the
+   * reassembly with real-world traffic (including loss and reordering)
+   * without a network.
+   *
+   * - Classic pcap (microsecond and nanosecond resolution) and pcapng files
+   *   of both byte orders are read without libpcap.
+   *
+   * - Ethernet (with VLAN tags), raw IP, loopback and Linux cooked captures
+   *   are supported. Only unfragmented IPv4 UDP packets are evaluated,
+   *   everything else is skipped.
+   *
+   * - The reassembly runs on the recorded time, so the max reassembly age
+   *   drops incomplete messages the same way it would have during the
+   *   recording, independent of the replay speed.
+   *
+   * The class is not thread safe.
+   */
+  class PcapReplay
+  {
+  /////////////////////////////////////////////////////////////////
+  // Public types
+  /////////////////////////////////////////////////////////////////
+  public:
+    enum class Timing
+    {
+      AS_FAST_AS_POSSIBLE,  ///< Hand out the messages without waiting
+      RECORDED,             ///< Wait between the packets as long as they were apart in the capture
+    };
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    PcapReplay(std::array<char, 4> magic_header_bytes);
+
+    // Destructor
+    ~PcapReplay();
+
+    // Disable copy constructor and assignment operator
+    PcapReplay(const PcapReplay&)             = delete;
+    PcapReplay& operator=(const PcapReplay&)  = delete;
+
+    // Disable move constructor and assignment operator
+    PcapReplay(PcapReplay&&)            = delete;
+    PcapReplay& operator=(PcapReplay&&) = delete;
+
+  /////////////////////////////////////////////////////////////////
+  // File handling
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Opens the capture file and resets the reassembly
+     */
+    bool open(const std::string& file_path, ecaludp::Error& error);
+    bool is_open() const;
+    void close();
+
+    /**
+     * @brief Only replays packets to the given destination
+     *
+     * An unspecified address matches all addresses and port 0 matches all
+     * ports. By default, all packets are replayed.
+     */
+    void bind(const asio::ip::udp::endpoint& endpoint);
+    asio::ip::udp::endpoint local_endpoint() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
+    std::chrono::steady_clock::duration get_max_reassembly_age() const;
+
+    void set_timing(Timing timing);
+    Timing get_timing() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Reads packets from the file until a message is complete
+     *
+     * @param sender_endpoint  The source of the message
+     * @param error            END_OF_FILE at the end of the capture, or an
+     *                         error if the file is malformed
+     *
+     * @return The message or nullptr, if no more messages can be read
+     */
+    std::shared_ptr<ecaludp::OwningBuffer> receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error);
+
+    /**
+     * @brief Returns the capture time of the packet that has been read last (since the unix epoch)
+     */
+    std::chrono::nanoseconds get_packet_timestamp() const;
+
+  private:
+    /**
+     * @brief Reads packets until the next UDP datagram to the local endpoint
+     */
+    bool read_datagram(ecaludp::ReceivedDatagram& datagram, ecaludp::Error& error);
+
+    void wait_for_recorded_time();
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    std::unique_ptr<PcapFileReader>           file_reader_;
+    std::unique_ptr<ecaludp::ReceiveEngine>   receive_engine_;
+
+    asio::ip::udp::endpoint                   local_endpoint_;
+    Timing                                    timing_;
+
+    std::chrono::nanoseconds                  first_packet_timestamp_;
+    std::chrono::nanoseconds                  packet_timestamp_;            ///< The timestamp of the last packet, also the clock of the reassembly
+    std::chrono::steady_clock::time_point     replay_start_;                ///< The wall clock time at which the first packet has been read
+    bool                                      first_packet_read_;
+  };
+}
@@ -0,0 +1,205 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+// IWYU pragma: begin_exports
+#include <ecaludp/error.h>
+#include <ecaludp/owning_buffer.h>
+#include <ecaludp/raw_memory.h>
+// IWYU pragma: end_exports
+
+namespace ecaludp
+{
+  class ReceiveEngine;
+
+  /**
+   * @brief An in-process network with a single receiver that loses, reorders, duplicates and delays datagrams
+   *
+   * The messages are fragmented exactly like the ecaludp::Socket does it and
+   * the datagrams are handed to the same reassembly that the sockets use.
+   * This makes it possible to measure the reassembly under impairments
+   * without a network, e.g. how much memory incomplete messages hold under
+   * burst loss.
+   *
+   * - The network runs on a simulated clock. Sending happens at the current
+   *   time, which only moves forward by advance_time() and by receiving
+   *   datagrams that have been delayed. The reassembly uses the same clock,
+   *   so the max reassembly age works independent of the CPU speed.
+   *
+   * - All random decisions are made by a generator seeded in the
+   *   constructor, so the same seed and the same calls always produce the
+   *   same datagrams in the same order.
+   *
+   * The class is not thread safe.
+   */
+  class SimulatedNetwork
+  {
+  /////////////////////////////////////////////////////////////////
+  // Public types
+  /////////////////////////////////////////////////////////////////
+  public:
+    struct Impairment
+    {
+      double                    loss_probability        {0.0};  ///< Probability that a single datagram is lost
+      double                    burst_loss_probability  {0.0};  ///< Probability that a burst loss starts at a datagram
+      double                    burst_loss_length       {1.0};  ///< Mean number of datagrams that are lost in a burst
+      std::size_t               reorder_window          {0};    ///< A datagram may be overtaken by up to this many datagrams sent after it
+      double                    duplication_probability {0.0};  ///< Probability that a datagram is delivered twice
+      std::chrono::nanoseconds  delay                   {0};    ///< Constant delay of all datagrams
+      std::chrono::nanoseconds  jitter                  {0};    ///< Additional random delay between 0 and this value
+    };
+
+    struct Statistics
+    {
+      uint64_t    messages_sent                     {0};
+      uint64_t    messages_received                 {0};
+      uint64_t    datagrams_sent                    {0};
+      uint64_t    datagrams_lost                    {0};
+      uint64_t    datagrams_duplicated              {0};
+      uint64_t    datagrams_delivered               {0};
+
+      std::size_t max_incomplete_messages           {0};  ///< High-water mark of the messages waiting for fragments
+      std::size_t max_reassembly_buffered_bytes     {0};  ///< High-water mark of the fragment bytes held by the reassembly
+      std::size_t max_pending_datagrams             {0};  ///< High-water mark of the datagrams in flight
+    };
+
+  private:
+    struct PendingDatagram;
+
+  /////////////////////////////////////////////////////////////////
+  // Constructor
+  /////////////////////////////////////////////////////////////////
+  public:
+    SimulatedNetwork(std::array<char, 4> magic_header_bytes, uint64_t seed);
+
+    // Destructor
+    ~SimulatedNetwork();
+
+    // Disable copy constructor and assignment operator
+    SimulatedNetwork(const SimulatedNetwork&)             = delete;
+    SimulatedNetwork& operator=(const SimulatedNetwork&)  = delete;
+
+    // Disable move constructor and assignment operator
+    SimulatedNetwork(SimulatedNetwork&&)            = delete;
+    SimulatedNetwork& operator=(SimulatedNetwork&&) = delete;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  public:
+    void set_impairment(const Impairment& impairment);
+    Impairment get_impairment() const;
+
+    void set_max_udp_datagram_size(std::size_t max_udp_datagram_size);
+    std::size_t get_max_udp_datagram_size() const;
+
+    void set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age);
+    std::chrono::steady_clock::duration get_max_reassembly_age() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Simulated time
+  /////////////////////////////////////////////////////////////////
+  public:
+    void advance_time(std::chrono::nanoseconds duration);
+
+    /**
+     * @brief Returns the simulated time since the network has been created
+     */
+    std::chrono::nanoseconds get_time() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Fragments the message and puts the datagrams on the network
+     *
+     * @return The number of bytes sent (including headers), regardless of
+     *         whether the datagrams will be lost
+     */
+    std::size_t send(const std::vector<asio::const_buffer>& buffer_sequence, const asio::ip::udp::endpoint& sender_endpoint);
+
+    inline std::size_t send(const asio::const_buffer& buffer, const asio::ip::udp::endpoint& sender_endpoint)
+    {
+      return send(std::vector<asio::const_buffer>{buffer}, sender_endpoint);
+    }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  public:
+    /**
+     * @brief Delivers datagrams in the order of their arrival until a message is complete
+     *
+     * The simulated time advances to the arrival of each delivered datagram.
+     *
+     * @return The message or nullptr with NO_PENDING_DATAGRAMS, if all
+     *         datagrams have been delivered
+     */
+    std::shared_ptr<ecaludp::OwningBuffer> receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error);
+
+    std::size_t get_pending_datagram_count() const;
+
+  /////////////////////////////////////////////////////////////////
+  // Statistics
+  /////////////////////////////////////////////////////////////////
+  public:
+    Statistics get_statistics() const;
+    void reset_statistics();
+
+  private:
+    void put_on_network(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint);
+    void schedule_arrival(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint);
+    void flush_reorder_buffer();
+
+    void update_high_water_marks();
+
+    bool is_lost();
+    double random_probability();
+
+    static bool arrives_later(const PendingDatagram& lhs, const PendingDatagram& rhs);
+
+  /////////////////////////////////////////////////////////////////
+  // Member Variables
+  /////////////////////////////////////////////////////////////////
+  private:
+    std::unique_ptr<ecaludp::ReceiveEngine>   receive_engine_;
+
+    std::array<char, 4>                       magic_header_bytes_;
+    std::size_t                               max_udp_datagram_size_;
+    Impairment                                impairment_;
+
+    std::mt19937_64                           random_generator_;
+    bool                                      in_burst_loss_;
+
+    std::chrono::nanoseconds                  now_;
+    uint64_t                                  next_sequence_number_;        ///< Keeps the order of datagrams that arrive at the same time
+    std::vector<PendingDatagram>              pending_datagrams_;           ///< A heap ordered by the arrival time
+    std::vector<PendingDatagram>              reorder_buffer_;              ///< Datagrams that are held back, until they are overtaken
+
+    Statistics                                statistics_;
+  };
+}
@@ -0,0 +1,483 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include "pcap_file_reader.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <string>
+#include <vector>
+
+#include "pcap_format.h"
+#include "udp_packet.h"
+
+#include <ecaludp/error.h>
+#include <ecaludp/raw_memory.h>
+
+namespace ecaludp
+{
+  namespace
+  {
+    constexpr uint32_t pcapng_block_type_section_header   = 0x0A0D0D0A;
+    constexpr uint32_t pcapng_block_type_interface        = 0x00000001;
+    constexpr uint32_t pcapng_block_type_simple_packet    = 0x00000003;
+    constexpr uint32_t pcapng_block_type_enhanced_packet  = 0x00000006;
+    constexpr uint32_t pcapng_byte_order_magic            = 0x1A2B3C4D;
+    constexpr uint16_t pcapng_option_end                  = 0;
+    constexpr uint16_t pcapng_option_if_tsresol           = 9;
+    constexpr std::size_t pcapng_block_header_size        = 8;    // Type + total length
+    constexpr std::size_t pcapng_block_trailer_size       = 4;    // Total length
+    constexpr std::size_t pcapng_enhanced_packet_header_size = 20;
+    constexpr std::size_t pcapng_simple_packet_header_size   = 4;
+
+    // Protects us from allocating insane amounts of memory for broken files.
+    // Captures of GSO / GRO traffic can contain packets of up to 256 KiB.
+    constexpr std::size_t max_block_size  = 16 * 1024 * 1024;
+
+    constexpr std::size_t file_buffer_size = 1024 * 1024;
+
+    constexpr uint16_t ethertype_ipv4     = 0x0800;
+    constexpr std::size_t null_header_size       = 4;
+    constexpr std::size_t linux_sll_header_size  = 16;
+    constexpr std::size_t linux_sll2_header_size = 20;
+
+    uint16_t byte_swap(uint16_t value)
+    {
+      return static_cast<uint16_t>((value >> 8) | (value << 8));
+    }
+
+    uint32_t byte_swap(uint32_t value)
+    {
+      return ((value >> 24) & 0x000000FF)
+           | ((value >>  8) & 0x0000FF00)
+           | ((value <<  8) & 0x00FF0000)
+           | ((value << 24) & 0xFF000000);
+    }
+
+    uint16_t read_uint16_be(const uint8_t* data)
+    {
+      return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8) | data[1]);
+    }
+
+    std::size_t padded_to_32_bit(std::size_t size)
+    {
+      return (size + 3) & ~static_cast<std::size_t>(3);
+    }
+
+    std::chrono::nanoseconds ticks_to_nanoseconds(uint64_t ticks, uint64_t ticks_per_second)
+    {
+      const uint64_t seconds   = ticks / ticks_per_second;
+      const uint64_t remainder = ticks % ticks_per_second;
+
+      // The remainder is smaller than ticks_per_second, so this only loses
+      // precision for resolutions finer than a nanosecond.
+      const auto fraction = static_cast<uint64_t>(static_cast<long double>(remainder) * 1000000000.0L / static_cast<long double>(ticks_per_second));
+
+      return std::chrono::seconds(seconds) + std::chrono::nanoseconds(fraction);
+    }
+  }
+
+  PcapFileReader::PcapFileReader()
+    : file_buffer_(file_buffer_size)
+    , format_     (Format::PCAP)
+    , swap_bytes_ (false)
+  {}
+
+  bool PcapFileReader::open(const std::string& file_path, ecaludp::Error& error)
+  {
+    close();
+
+    // The buffer must be set before the file is opened
+    file_.rdbuf()->pubsetbuf(file_buffer_.data(), static_cast<std::streamsize>(file_buffer_.size()));
+    file_.open(file_path, std::ios::in | std::ios::binary);
+    if (!file_.is_open())
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Unable to open " + file_path);
+      return false;
+    }
+
+    uint32_t magic = 0;
+    if (!read_bytes(&magic, sizeof(magic)))
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, file_path + " is empty");
+      close();
+      return false;
+    }
+
+    if ((magic == pcap_magic_microseconds) || (magic == byte_swap(pcap_magic_microseconds))
+        || (magic == pcap_magic_nanoseconds) || (magic == byte_swap(pcap_magic_nanoseconds)))
+    {
+      format_     = Format::PCAP;
+      swap_bytes_ = (magic == byte_swap(pcap_magic_microseconds)) || (magic == byte_swap(pcap_magic_nanoseconds));
+
+      std::array<uint8_t, pcap_file_header_size - sizeof(magic)> header{};
+      if (!read_bytes(header.data(), header.size()))
+      {
+        error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, file_path + ": Truncated pcap file header");
+        close();
+        return false;
+      }
+
+      Interface interface;
+      interface.link_type_        = read_uint32(&header[16]);
+      interface.ticks_per_second_ = (to_host(magic) == pcap_magic_nanoseconds ? 1000000000 : 1000000);
+      interfaces_.push_back(interface);
+    }
+    else if (magic == pcapng_block_type_section_header)
+    {
+      format_ = Format::PCAPNG;
+
+      // Only check the byte order magic here. The section header is read
+      // like any other block, so we rewind to the beginning.
+      std::array<uint8_t, 8> header{};
+      uint32_t byte_order_magic = 0;
+      if (!read_bytes(header.data(), header.size()))
+      {
+        error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, file_path + ": Truncated section header");
+        close();
+        return false;
+      }
+      std::memcpy(&byte_order_magic, &header[4], sizeof(byte_order_magic));
+      if ((byte_order_magic != pcapng_byte_order_magic) && (byte_order_magic != byte_swap(pcapng_byte_order_magic)))
+      {
+        error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, file_path + ": Invalid byte order magic in section header");
+        close();
+        return false;
+      }
+      file_.seekg(0);
+    }
+    else
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, file_path + " is neither a pcap nor a pcapng file");
+      close();
+      return false;
+    }
+
+    error = ecaludp::Error::OK;
+    return true;
+  }
+
+  bool PcapFileReader::is_open() const
+  {
+    return file_.is_open();
+  }
+
+  void PcapFileReader::close()
+  {
+    if (file_.is_open())
+      file_.close();
+    file_.clear();
+    interfaces_.clear();
+    swap_bytes_ = false;
+  }
+
+  bool PcapFileReader::read_packet(ecaludp::RawMemory& buffer, CapturedPacket& packet, ecaludp::Error& error)
+  {
+    error = ecaludp::Error::OK;
+
+    if (!file_.is_open())
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "File not open");
+      return false;
+    }
+
+    if (format_ == Format::PCAP)
+      return read_pcap_packet(buffer, packet, error);
+    else
+      return read_pcapng_packet(buffer, packet, error);
+  }
+
+  bool PcapFileReader::read_pcap_packet(ecaludp::RawMemory& buffer, CapturedPacket& packet, ecaludp::Error& error)
+  {
+    std::array<uint8_t, pcap_record_header_size> header{};
+    if (!read_bytes(header.data(), header.size()))
+      return false; // End of file
+
+    const uint32_t    timestamp_seconds  = read_uint32(&header[0]);
+    const uint32_t    timestamp_fraction = read_uint32(&header[4]);
+    const std::size_t captured_size      = read_uint32(&header[8]);
+    const std::size_t original_size      = read_uint32(&header[12]);
+
+    if (captured_size > max_block_size)
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Packet too big (" + std::to_string(captured_size) + " bytes)");
+      return false;
+    }
+
+    buffer.resize(captured_size);
+    if (!read_bytes(buffer.data(), captured_size))
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Truncated packet");
+      return false;
+    }
+
+    const Interface& interface = interfaces_.front();
+    packet.timestamp_     = std::chrono::seconds(timestamp_seconds) + ticks_to_nanoseconds(timestamp_fraction, interface.ticks_per_second_);
+    packet.link_type_     = interface.link_type_;
+    packet.original_size_ = original_size;
+    return true;
+  }
+
+  bool PcapFileReader::read_pcapng_packet(ecaludp::RawMemory& buffer, CapturedPacket& packet, ecaludp::Error& error)
+  {
+    std::vector<uint8_t> body;
+
+    // Skip all blocks until the next packet
+    for (;;)
+    {
+      std::array<uint8_t, pcapng_block_header_size> block_header{};
+      if (!read_bytes(block_header.data(), block_header.size()))
+        return false; // End of file
+
+      uint32_t block_type = 0;
+      std::memcpy(&block_type, block_header.data(), sizeof(block_type));
+
+      // The section header determines the byte order of the section, so we
+      // have to evaluate it before reading the length.
+      if (block_type == pcapng_block_type_section_header)
+      {
+        uint32_t byte_order_magic = 0;
+        if (!read_bytes(&byte_order_magic, sizeof(byte_order_magic)))
+        {
+          error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Truncated section header");
+          return false;
+        }
+        if (byte_order_magic == pcapng_byte_order_magic)
+        {
+          swap_bytes_ = false;
+        }
+        else if (byte_order_magic == byte_swap(pcapng_byte_order_magic))
+        {
+          swap_bytes_ = true;
+        }
+        else
+        {
+          error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Invalid byte order magic in section header");
+          return false;
+        }
+
+        // The byte order magic is part of the body
+        file_.seekg(-static_cast<std::streamoff>(sizeof(byte_order_magic)), std::ios::cur);
+      }
+      else
+      {
+        block_type = to_host(block_type);
+      }
+
+      const std::size_t block_size = read_uint32(&block_header[4]);
+      if ((block_size < pcapng_block_header_size + pcapng_block_trailer_size)
+          || (block_size % 4 != 0)
+          || (block_size > max_block_size))
+      {
+        error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Invalid block size (" + std::to_string(block_size) + " bytes)");
+        return false;
+      }
+
+      const std::size_t body_size = block_size - pcapng_block_header_size - pcapng_block_trailer_size;
+
+      if ((block_type == pcapng_block_type_enhanced_packet) || (block_type == pcapng_block_type_simple_packet))
+      {
+        // Read the packet data directly into the buffer to avoid copying it
+        const std::size_t packet_header_size = (block_type == pcapng_block_type_enhanced_packet ? pcapng_enhanced_packet_header_size : pcapng_simple_packet_header_size);
+        std::array<uint8_t, pcapng_enhanced_packet_header_size> packet_header{};
+        if ((body_size < packet_header_size) || !read_bytes(packet_header.data(), packet_header_size))
+        {
+          error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Truncated packet block");
+          return false;
+        }
+
+        uint32_t    interface_id  = 0;
+        std::size_t captured_size = 0;
+        std::size_t original_size = 0;
+        if (block_type == pcapng_block_type_enhanced_packet)
+        {
+          interface_id  = read_uint32(&packet_header[0]);
+          const uint64_t timestamp_ticks = (static_cast<uint64_t>(read_uint32(&packet_header[4])) << 32) | read_uint32(&packet_header[8]);
+          captured_size = read_uint32(&packet_header[12]);
+          original_size = read_uint32(&packet_header[16]);
+
+          if (interface_id < interfaces_.size())
+            packet.timestamp_ = ticks_to_nanoseconds(timestamp_ticks, interfaces_[interface_id].ticks_per_second_);
+        }
+        else
+        {
+          // Simple packets don't have a timestamp, so we keep the one of the
+          // previous packet. The captured size is implied by the block size.
+          original_size = read_uint32(&packet_header[0]);
+          captured_size = std::min(original_size, body_size - packet_header_size);
+        }
+
+        if ((interface_id >= interfaces_.size())
+            || (padded_to_32_bit(captured_size) > body_size - packet_header_size))
+        {
+          error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Malformed packet block");
+          return false;
+        }
+
+        buffer.resize(captured_size);
+        if (!read_bytes(buffer.data(), captured_size))
+        {
+          error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Truncated packet block");
+          return false;
+        }
+
+        // Skip the padding, the options and the trailing block length
+        file_.ignore(static_cast<std::streamsize>(body_size - packet_header_size - captured_size + pcapng_block_trailer_size));
+
+        packet.link_type_     = interfaces_[interface_id].link_type_;
+        packet.original_size_ = original_size;
+        return true;
+      }
+
+      body.resize(body_size);
+      if (!read_bytes(body.data(), body.size()) || !file_.ignore(pcapng_block_trailer_size))
+      {
+        error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Truncated block");
+        return false;
+      }
+
+      if (block_type == pcapng_block_type_section_header)
+      {
+        // Interface IDs are only valid within their section
+        interfaces_.clear();
+      }
+      else if (block_type == pcapng_block_type_interface)
+      {
+        if (!read_pcapng_interface(body, error))
+          return false;
+      }
+      // All other blocks are not interesting for us
+    }
+  }
+
+  bool PcapFileReader::read_pcapng_interface(const std::vector<uint8_t>& body, ecaludp::Error& error)
+  {
+    constexpr std::size_t interface_header_size = 8;    // Link type + reserved + snap length
+    if (body.size() < interface_header_size)
+    {
+      error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Truncated interface description");
+      return false;
+    }
+
+    Interface interface;
+    interface.link_type_ = read_uint16(&body[0]);
+
+    // Evaluate the options. We only care about the timestamp resolution.
+    std::size_t offset = interface_header_size;
+    while (offset + 4 <= body.size())
+    {
+      const uint16_t    option_code = read_uint16(&body[offset]);
+      const std::size_t option_size = read_uint16(&body[offset + 2]);
+      offset += 4;
+
+      if ((option_code == pcapng_option_end) || (offset + option_size > body.size()))
+        break;
+
+      if ((option_code == pcapng_option_if_tsresol) && (option_size >= 1))
+      {
+        // The MSB decides whether the resolution is a power of 10 or of 2
+        const uint8_t resolution = body[offset];
+        const uint8_t exponent   = (resolution & 0x7F);
+
+        uint64_t ticks_per_second = 1;
+        for (uint8_t i = 0; i < exponent; ++i)
+        {
+          const uint64_t factor = ((resolution & 0x80) != 0 ? 2 : 10);
+          if (ticks_per_second > UINT64_MAX / factor)
+          {
+            error = ecaludp::Error(ecaludp::Error::GENERIC_ERROR, "Unsupported timestamp resolution");
+            return false;
+          }
+          ticks_per_second *= factor;
+        }
+        interface.ticks_per_second_ = ticks_per_second;
+      }
+
+      offset += padded_to_32_bit(option_size);
+    }
+
+    interfaces_.push_back(interface);
+    return true;
+  }
+
+  bool PcapFileReader::read_bytes(void* data, std::size_t size)
+  {
+    file_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    return (static_cast<std::size_t>(file_.gcount()) == size);
+  }
+
+  uint16_t PcapFileReader::to_host(uint16_t value) const
+  {
+    return (swap_bytes_ ? byte_swap(value) : value);
+  }
+
+  uint32_t PcapFileReader::to_host(uint32_t value) const
+  {
+    return (swap_bytes_ ? byte_swap(value) : value);
+  }
+
+  uint16_t PcapFileReader::read_uint16(const uint8_t* data) const
+  {
+    uint16_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return to_host(value);
+  }
+
+  uint32_t PcapFileReader::read_uint32(const uint8_t* data) const
+  {
+    uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return to_host(value);
+  }
+
+  bool parse_captured_udp_packet(uint32_t link_type, const uint8_t* data, std::size_t size, UdpPacketView& packet)
+  {
+    switch (link_type)
+    {
+    case link_type_ethernet:
+      return parse_ethernet_udp_packet(data, size, packet);
+
+    case link_type_raw:
+    case link_type_ipv4:
+      return parse_ipv4_udp_packet(data, size, packet);
+
+    case link_type_null:
+    case link_type_loop:
+      // The address family is written in different byte orders, so we rely on
+      // the version field of the IP header instead.
+      if (size < null_header_size)
+        return false;
+      return parse_ipv4_udp_packet(data + null_header_size, size - null_header_size, packet);
+
+    case link_type_linux_sll:
+      if ((size < linux_sll_header_size) || (read_uint16_be(data + 14) != ethertype_ipv4))
+        return false;
+      return parse_ipv4_udp_packet(data + linux_sll_header_size, size - linux_sll_header_size, packet);
+
+    case link_type_linux_sll2:
+      if ((size < linux_sll2_header_size) || (read_uint16_be(data) != ethertype_ipv4))
+        return false;
+      return parse_ipv4_udp_packet(data + linux_sll2_header_size, size - linux_sll2_header_size, packet);
+
+    default:
+      return false;
+    }
+  }
+}
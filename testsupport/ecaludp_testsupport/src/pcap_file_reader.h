@@ -0,0 +1,118 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <ecaludp/error.h>
+#include <ecaludp/raw_memory.h>
+
+#include "pcap_format.h"
+#include "udp_packet.h"
+
+namespace ecaludp
+{
+  /**
+   * @brief Meta information about a packet read from a capture file
+   */
+  struct CapturedPacket
+  {
+    std::chrono::nanoseconds timestamp_     {0};   ///< Since the unix epoch
+    uint32_t                 link_type_     {0};
+    std::size_t              original_size_ {0};   ///< The size on the wire. The captured size may be smaller.
+  };
+
+  /**
+   * @brief Reads the packets of a pcap or pcapng capture file
+   *
+   * Both byte orders and microsecond and nanosecond timestamps are supported.
+   * For pcapng files, the link type and timestamp resolution of each
+   * interface are evaluated. Blocks other than interface descriptions and
+   * (enhanced / simple) packets are skipped.
+   */
+  class PcapFileReader
+  {
+  private:
+    enum class Format
+    {
+      PCAP,
+      PCAPNG,
+    };
+
+    struct Interface
+    {
+      uint32_t link_type_        {0};
+      uint64_t ticks_per_second_ {1000000};
+    };
+
+  public:
+    PcapFileReader();
+
+    // Disable copy and move
+    PcapFileReader(const PcapFileReader&)            = delete;
+    PcapFileReader& operator=(const PcapFileReader&) = delete;
+    PcapFileReader(PcapFileReader&&)                 = delete;
+    PcapFileReader& operator=(PcapFileReader&&)      = delete;
+
+    ~PcapFileReader() = default;
+
+    bool open(const std::string& file_path, ecaludp::Error& error);
+    bool is_open() const;
+    void close();
+
+    /**
+     * @brief Reads the next packet into the buffer
+     *
+     * @return false at the end of the file (error is OK) or if the file is
+     *         malformed (error is set)
+     */
+    bool read_packet(ecaludp::RawMemory& buffer, CapturedPacket& packet, ecaludp::Error& error);
+
+  private:
+    bool read_pcap_packet  (ecaludp::RawMemory& buffer, CapturedPacket& packet, ecaludp::Error& error);
+    bool read_pcapng_packet(ecaludp::RawMemory& buffer, CapturedPacket& packet, ecaludp::Error& error);
+
+    bool read_pcapng_interface(const std::vector<uint8_t>& body, ecaludp::Error& error);
+
+    bool read_bytes(void* data, std::size_t size);
+
+    uint16_t to_host(uint16_t value) const;
+    uint32_t to_host(uint32_t value) const;
+
+    uint16_t read_uint16(const uint8_t* data) const;
+    uint32_t read_uint32(const uint8_t* data) const;
+
+  private:
+    std::ifstream          file_;
+    std::vector<char>      file_buffer_;          ///< Large buffer for the ifstream, as the packets are read in small pieces
+    Format                 format_;
+    bool                   swap_bytes_;           ///< Whether the file has been written on a machine with a different byte order
+    std::vector<Interface> interfaces_;           ///< pcap files have exactly one interface
+  };
+
+  /**
+   * @brief Parses a captured packet of the given link type that carries an IPv4 UDP packet
+   *
+   * @return false, if the link type is not supported or the packet doesn't
+   *         carry a complete and unfragmented IPv4 UDP packet
+   */
+  bool parse_captured_udp_packet(uint32_t link_type, const uint8_t* data, std::size_t size, UdpPacketView& packet);
+}
@@ -0,0 +1,180 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <ecaludp_testsupport/pcap_replay.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "ecaludp/error.h"
+#include "ecaludp/raw_memory.h"
+#include "pcap_file_reader.h"
+#include "receive_engine.h"
+#include "udp_packet.h"
+
+#include <ecaludp/owning_buffer.h>
+
+namespace ecaludp
+{
+  PcapReplay::PcapReplay(std::array<char, 4> magic_header_bytes)
+    : file_reader_            (std::make_unique<ecaludp::PcapFileReader>())
+    , receive_engine_         (std::make_unique<ecaludp::ReceiveEngine>(magic_header_bytes))
+    , timing_                 (Timing::AS_FAST_AS_POSSIBLE)
+    , first_packet_timestamp_ (0)
+    , packet_timestamp_       (0)
+    , first_packet_read_      (false)
+  {
+    // The reassembly runs on the recorded time
+    receive_engine_->set_clock([this]() { return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(packet_timestamp_)); });
+  }
+
+  PcapReplay::~PcapReplay() = default;
+
+  /////////////////////////////////////////////////////////////////
+  // File handling
+  /////////////////////////////////////////////////////////////////
+  bool PcapReplay::open(const std::string& file_path, ecaludp::Error& error)
+  {
+    close();
+    return file_reader_->open(file_path, error);
+  }
+
+  bool PcapReplay::is_open() const
+  {
+    return file_reader_->is_open();
+  }
+
+  void PcapReplay::close()
+  {
+    file_reader_->close();
+
+    // Fragments of the previous file must not be mixed with the next one
+    receive_engine_->drop_incomplete_messages();
+
+    first_packet_timestamp_ = std::chrono::nanoseconds(0);
+    packet_timestamp_       = std::chrono::nanoseconds(0);
+    first_packet_read_      = false;
+  }
+
+  void PcapReplay::bind(const asio::ip::udp::endpoint& endpoint)
+  {
+    local_endpoint_ = endpoint;
+  }
+
+  asio::ip::udp::endpoint PcapReplay::local_endpoint() const
+  {
+    return local_endpoint_;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  void PcapReplay::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
+  {
+    receive_engine_->set_max_reassembly_age(max_reassembly_age);
+  }
+
+  std::chrono::steady_clock::duration PcapReplay::get_max_reassembly_age() const
+  {
+    return receive_engine_->get_max_reassembly_age();
+  }
+
+  void PcapReplay::set_timing(Timing timing)
+  {
+    timing_ = timing;
+  }
+
+  PcapReplay::Timing PcapReplay::get_timing() const
+  {
+    return timing_;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  std::shared_ptr<ecaludp::OwningBuffer> PcapReplay::receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error)
+  {
+    // Malformed datagrams and foreign traffic are skipped, just like a socket would do
+    return receive_engine_->receive_from([this](ecaludp::ReceivedDatagram& datagram, ecaludp::Error& read_error) { return read_datagram(datagram, read_error); }
+                                        , sender_endpoint
+                                        , error);
+  }
+
+  std::chrono::nanoseconds PcapReplay::get_packet_timestamp() const
+  {
+    return packet_timestamp_;
+  }
+
+  bool PcapReplay::read_datagram(ecaludp::ReceivedDatagram& datagram, ecaludp::Error& error)
+  {
+    for (;;)
+    {
+      // The reassembly keeps the packet buffers alive as long as they contain
+      // fragments of incomplete messages, so each packet gets its own buffer.
+      auto buffer = receive_engine_->allocate_buffer();
+
+      ecaludp::CapturedPacket captured_packet;
+      if (!file_reader_->read_packet(*buffer, captured_packet, error))
+      {
+        if (!error)
+          error = ecaludp::Error::END_OF_FILE;
+        return false;
+      }
+
+      packet_timestamp_ = captured_packet.timestamp_;
+      if (!first_packet_read_)
+      {
+        first_packet_timestamp_ = packet_timestamp_;
+        replay_start_           = std::chrono::steady_clock::now();
+        first_packet_read_      = true;
+      }
+
+      ecaludp::UdpPacketView udp_packet;
+      if (!ecaludp::parse_captured_udp_packet(captured_packet.link_type_, buffer->data(), buffer->size(), udp_packet))
+        continue;
+
+      // Only replay the packets that a socket bound to the local endpoint would have received
+      if ((!local_endpoint_.address().is_unspecified() && (udp_packet.destination_.address() != local_endpoint_.address()))
+          || ((local_endpoint_.port() != 0) && (udp_packet.destination_.port() != local_endpoint_.port())))
+      {
+        continue;
+      }
+
+      if (timing_ == Timing::RECORDED)
+        wait_for_recorded_time();
+
+      datagram.data_            = udp_packet.payload_;
+      datagram.size_            = udp_packet.payload_size_;
+      datagram.owner_           = buffer;
+      datagram.sender_endpoint_ = std::make_shared<asio::ip::udp::endpoint>(udp_packet.source_);
+      return true;
+    }
+  }
+
+  void PcapReplay::wait_for_recorded_time()
+  {
+    // Captures may contain packets that are slightly out of order, so the
+    // offset can be negative. Those packets are replayed immediately.
+    const auto offset = packet_timestamp_ - first_packet_timestamp_;
+    if (offset > std::chrono::nanoseconds(0))
+      std::this_thread::sleep_until(replay_start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+  }
+}
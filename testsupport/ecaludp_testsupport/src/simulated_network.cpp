@@ -0,0 +1,305 @@
+/********************************************************************************
+ * Copyright (c) 2024 Continental Corporation
+ * 
+ * This program and the accompanying materials are made available under the
+ * terms of the Apache License, Version 2.0 which is available at
+ * https://www.apache.org/licenses/LICENSE-2.0.
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ * 
+ * SPDX-License-Identifier: Apache-2.0
+ ********************************************************************************/
+#include <ecaludp_testsupport/simulated_network.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp> // IWYU pragma: keep
+
+#include "ecaludp/error.h"
+#include "ecaludp/raw_memory.h"
+#include "protocol/datagram_builder_v5.h"
+#include "protocol/datagram_description.h"
+#include "receive_engine.h"
+
+#include <ecaludp/owning_buffer.h>
+
+namespace ecaludp
+{
+  struct SimulatedNetwork::PendingDatagram
+  {
+    std::chrono::nanoseconds                  arrival_time_;
+    uint64_t                                  sequence_number_;
+    std::shared_ptr<ecaludp::RawMemory>       buffer_;
+    std::shared_ptr<asio::ip::udp::endpoint>  sender_endpoint_;
+  };
+
+  SimulatedNetwork::SimulatedNetwork(std::array<char, 4> magic_header_bytes, uint64_t seed)
+    : receive_engine_       (std::make_unique<ecaludp::ReceiveEngine>(magic_header_bytes))
+    , magic_header_bytes_   (magic_header_bytes)
+    , max_udp_datagram_size_(1448)
+    , random_generator_     (seed)
+    , in_burst_loss_        (false)
+    , now_                  (0)
+    , next_sequence_number_ (0)
+  {
+    // The reassembly runs on the simulated time
+    receive_engine_->set_clock([this]() { return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(now_)); });
+  }
+
+  SimulatedNetwork::~SimulatedNetwork() = default;
+
+  /////////////////////////////////////////////////////////////////
+  // Settings
+  /////////////////////////////////////////////////////////////////
+  void SimulatedNetwork::set_impairment(const Impairment& impairment)
+  {
+    impairment_ = impairment;
+
+    // Datagrams that are held back for reordering would never be overtaken
+    if (impairment_.reorder_window == 0)
+      flush_reorder_buffer();
+  }
+
+  SimulatedNetwork::Impairment SimulatedNetwork::get_impairment() const
+  {
+    return impairment_;
+  }
+
+  void SimulatedNetwork::set_max_udp_datagram_size(std::size_t max_udp_datagram_size)
+  {
+    max_udp_datagram_size_ = max_udp_datagram_size;
+  }
+
+  std::size_t SimulatedNetwork::get_max_udp_datagram_size() const
+  {
+    return max_udp_datagram_size_;
+  }
+
+  void SimulatedNetwork::set_max_reassembly_age(std::chrono::steady_clock::duration max_reassembly_age)
+  {
+    receive_engine_->set_max_reassembly_age(max_reassembly_age);
+  }
+
+  std::chrono::steady_clock::duration SimulatedNetwork::get_max_reassembly_age() const
+  {
+    return receive_engine_->get_max_reassembly_age();
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Simulated time
+  /////////////////////////////////////////////////////////////////
+  void SimulatedNetwork::advance_time(std::chrono::nanoseconds duration)
+  {
+    if (duration > std::chrono::nanoseconds(0))
+      now_ += duration;
+  }
+
+  std::chrono::nanoseconds SimulatedNetwork::get_time() const
+  {
+    return now_;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Sending
+  /////////////////////////////////////////////////////////////////
+  std::size_t SimulatedNetwork::send(const std::vector<asio::const_buffer>& buffer_sequence, const asio::ip::udp::endpoint& sender_endpoint)
+  {
+    const DatagramList datagram_list = ecaludp::v5::create_datagram_list(buffer_sequence, max_udp_datagram_size_, magic_header_bytes_);
+
+    auto shared_sender_endpoint = std::make_shared<asio::ip::udp::endpoint>(sender_endpoint);
+
+    std::size_t bytes_sent = 0;
+
+    for (const auto& datagram : datagram_list)
+    {
+      // Each datagram gets its own buffer, just like a datagram received by a socket
+      auto buffer = receive_engine_->allocate_buffer();
+      buffer->resize(datagram.size());
+
+      std::size_t offset = 0;
+      for (const auto& part : datagram.asio_buffer_list_)
+      {
+        if (part.size() > 0)
+          memcpy(buffer->data() + offset, part.data(), part.size());
+        offset += part.size();
+      }
+
+      bytes_sent += buffer->size();
+      ++statistics_.datagrams_sent;
+
+      if (is_lost())
+      {
+        ++statistics_.datagrams_lost;
+        continue;
+      }
+
+      put_on_network(buffer, shared_sender_endpoint);
+
+      if ((impairment_.duplication_probability > 0.0) && (random_probability() < impairment_.duplication_probability))
+      {
+        ++statistics_.datagrams_duplicated;
+        put_on_network(buffer, shared_sender_endpoint);
+      }
+    }
+
+    ++statistics_.messages_sent;
+    update_high_water_marks();
+
+    return bytes_sent;
+  }
+
+  void SimulatedNetwork::put_on_network(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint)
+  {
+    if (impairment_.reorder_window == 0)
+    {
+      schedule_arrival(buffer, sender_endpoint);
+      return;
+    }
+
+    // The datagrams wait in a buffer of window + 1 datagrams, from which a
+    // random one is released each time it is full. A datagram can thus be
+    // overtaken by up to reorder_window datagrams sent after it (more only
+    // with a low probability).
+    reorder_buffer_.push_back(PendingDatagram{std::chrono::nanoseconds(0), 0, buffer, sender_endpoint});
+
+    if (reorder_buffer_.size() > impairment_.reorder_window)
+    {
+      const auto index = static_cast<std::size_t>(random_generator_() % reorder_buffer_.size());
+      std::swap(reorder_buffer_[index], reorder_buffer_.back());
+
+      const PendingDatagram released = std::move(reorder_buffer_.back());
+      reorder_buffer_.pop_back();
+      schedule_arrival(released.buffer_, released.sender_endpoint_);
+    }
+  }
+
+  void SimulatedNetwork::schedule_arrival(const std::shared_ptr<ecaludp::RawMemory>& buffer, const std::shared_ptr<asio::ip::udp::endpoint>& sender_endpoint)
+  {
+    std::chrono::nanoseconds arrival_time = now_ + impairment_.delay;
+    if (impairment_.jitter > std::chrono::nanoseconds(0))
+      arrival_time += std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(random_probability() * static_cast<double>(impairment_.jitter.count())));
+
+    pending_datagrams_.push_back(PendingDatagram{arrival_time, next_sequence_number_++, buffer, sender_endpoint});
+    std::push_heap(pending_datagrams_.begin(), pending_datagrams_.end(), &SimulatedNetwork::arrives_later);
+  }
+
+  void SimulatedNetwork::flush_reorder_buffer()
+  {
+    // Releases the remaining datagrams in a random order
+    while (!reorder_buffer_.empty())
+    {
+      const auto index = static_cast<std::size_t>(random_generator_() % reorder_buffer_.size());
+      std::swap(reorder_buffer_[index], reorder_buffer_.back());
+
+      schedule_arrival(reorder_buffer_.back().buffer_, reorder_buffer_.back().sender_endpoint_);
+      reorder_buffer_.pop_back();
+    }
+  }
+
+  bool SimulatedNetwork::is_lost()
+  {
+    // Gilbert model: Once a burst has started, all datagrams are lost until
+    // it ends, which happens after burst_loss_length datagrams on average.
+    if (!in_burst_loss_ && (impairment_.burst_loss_probability > 0.0) && (random_probability() < impairment_.burst_loss_probability))
+      in_burst_loss_ = true;
+
+    if (in_burst_loss_)
+    {
+      if (random_probability() * impairment_.burst_loss_length < 1.0)
+        in_burst_loss_ = false;
+      return true;
+    }
+
+    return ((impairment_.loss_probability > 0.0) && (random_probability() < impairment_.loss_probability));
+  }
+
+  double SimulatedNetwork::random_probability()
+  {
+    // 53 random bits, so the result is the same on all platforms (unlike std::uniform_real_distribution)
+    return static_cast<double>(random_generator_() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  bool SimulatedNetwork::arrives_later(const PendingDatagram& lhs, const PendingDatagram& rhs)
+  {
+    if (lhs.arrival_time_ != rhs.arrival_time_)
+      return lhs.arrival_time_ > rhs.arrival_time_;
+    return lhs.sequence_number_ > rhs.sequence_number_;
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Receiving
+  /////////////////////////////////////////////////////////////////
+  std::shared_ptr<ecaludp::OwningBuffer> SimulatedNetwork::receive_from(asio::ip::udp::endpoint& sender_endpoint, ecaludp::Error& error)
+  {
+    for (;;)
+    {
+      // Nothing is sent anymore, so the held back datagrams are not overtaken anymore
+      if (pending_datagrams_.empty())
+        flush_reorder_buffer();
+
+      if (pending_datagrams_.empty())
+      {
+        error = ecaludp::Error::NO_PENDING_DATAGRAMS;
+        return nullptr;
+      }
+
+      std::pop_heap(pending_datagrams_.begin(), pending_datagrams_.end(), &SimulatedNetwork::arrives_later);
+      const PendingDatagram datagram = std::move(pending_datagrams_.back());
+      pending_datagrams_.pop_back();
+
+      now_ = std::max(now_, datagram.arrival_time_);
+      ++statistics_.datagrams_delivered;
+
+      // Malformed and duplicate datagrams are dropped, just like a socket would do
+      ecaludp::Error datagram_error = ecaludp::Error::OK;
+      auto message = receive_engine_->handle_datagram(datagram.buffer_, datagram.sender_endpoint_, datagram_error);
+
+      update_high_water_marks();
+
+      if (message != nullptr)
+      {
+        ++statistics_.messages_received;
+        sender_endpoint = *datagram.sender_endpoint_;
+        error = ecaludp::Error::OK;
+        return message;
+      }
+    }
+  }
+
+  std::size_t SimulatedNetwork::get_pending_datagram_count() const
+  {
+    return pending_datagrams_.size() + reorder_buffer_.size();
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Statistics
+  /////////////////////////////////////////////////////////////////
+  SimulatedNetwork::Statistics SimulatedNetwork::get_statistics() const
+  {
+    return statistics_;
+  }
+
+  void SimulatedNetwork::reset_statistics()
+  {
+    statistics_ = Statistics();
+  }
+
+  void SimulatedNetwork::update_high_water_marks()
+  {
+    statistics_.max_incomplete_messages       = std::max(statistics_.max_incomplete_messages,       receive_engine_->get_incomplete_message_count());
+    statistics_.max_reassembly_buffered_bytes = std::max(statistics_.max_reassembly_buffered_bytes, receive_engine_->get_reassembly_buffered_bytes());
+    statistics_.max_pending_datagrams         = std::max(statistics_.max_pending_datagrams,         get_pending_datagram_count());
+  }
+}